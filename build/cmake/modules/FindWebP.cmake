@@ -19,29 +19,26 @@
 #  CMake scripts for TerraLib Web Services
 #
 #  Author: Gilberto Ribeiro de Queiroz
+#  Description: Find libwebp include directory and library.
 #
-#  Description: Find LibGD include directory and library.
-#
-#  LIBGD_INCLUDE_DIR    -> where to find gd.h and other header files.
-#  LIBGD_LIBRARY        -> LibGD library to link to.
-#  LIBGD_FOUND          -> True if LibGD is found.
+#  WEBP_INCLUDE_DIR    -> where to find webp/encode.h and other header files.
+#  WEBP_LIBRARY        -> libwebp library to link to.
+#  WEBP_FOUND          -> True if libwebp is found.
 #
 
-find_path(LIBGD_INCLUDE_DIR gd.h
+find_path(WEBP_INCLUDE_DIR webp/encode.h
           PATHS /usr
                 /usr/local
-          PATH_SUFFIXES include
-                        libgd/include)
+          PATH_SUFFIXES include)
 
-find_library(LIBGD_LIBRARY
-             NAMES gd
+find_library(WEBP_LIBRARY
+             NAMES webp
              PATHS /usr
                    /usr/local
-             PATH_SUFFIXES lib
-                           libgd/lib)
+             PATH_SUFFIXES lib)
 
 include(FindPackageHandleStandardArgs)
 
-FIND_PACKAGE_HANDLE_STANDARD_ARGS(LibGD DEFAULT_MSG LIBGD_LIBRARY LIBGD_INCLUDE_DIR)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(WebP DEFAULT_MSG WEBP_LIBRARY WEBP_INCLUDE_DIR)
 
-mark_as_advanced(LIBGD_INCLUDE_DIR LIBGD_LIBRARY)
+mark_as_advanced(WEBP_INCLUDE_DIR WEBP_LIBRARY)
@@ -270,16 +270,29 @@ else
 fi
 
 #
-# libgd
+# libjpeg
 #
-libgd_test=`dpkg -s libgd-dev | grep Status`
+libjpeg_test=`dpkg -s libjpeg-dev | grep Status`
 
-if [ "$libgd_test" != "Status: install ok installed" ]; then
-  sudo apt-get -y install libgd-dev
-  valid $? "Error: could not install libgd-dev! Please, install libgd-dev: sudo apt-get -y install libgd-dev"
-  echo "libgd-dev installed!"
+if [ "$libjpeg_test" != "Status: install ok installed" ]; then
+  sudo apt-get -y install libjpeg-dev
+  valid $? "Error: could not install libjpeg-dev! Please, install libjpeg-dev: sudo apt-get -y install libjpeg-dev"
+  echo "libjpeg-dev installed!"
 else
-  echo "libgd-dev already installed!"
+  echo "libjpeg-dev already installed!"
+fi
+
+#
+# libwebp
+#
+libwebp_test=`dpkg -s libwebp-dev | grep Status`
+
+if [ "$libwebp_test" != "Status: install ok installed" ]; then
+  sudo apt-get -y install libwebp-dev
+  valid $? "Error: could not install libwebp-dev! Please, install libwebp-dev: sudo apt-get -y install libwebp-dev"
+  echo "libwebp-dev installed!"
+else
+  echo "libwebp-dev already installed!"
 fi
 
 
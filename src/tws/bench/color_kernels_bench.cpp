@@ -0,0 +1,215 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/bench/color_kernels_bench.cpp
+
+  \brief Measures the WMS color kernels for each instruction set supported by the CPU.
+
+  Three styles are rendered from synthetic bands, with a share of missing
+  and NaN cells: a gray stretch, an RGB stretch and a color map. The
+  output of each instruction set is checked against the scalar kernels.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "../core/simd.hpp"
+#include "../wms/color_kernels.hpp"
+
+// STL
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/chrono.hpp>
+#include <boost/program_options.hpp>
+
+struct bench_image
+{
+  std::size_t width;
+  std::size_t height;
+  std::vector<double> bands[3];
+};
+
+// render a whole image, row by row, as the WMS render functions do
+static void render(const tws::wms::color_kernels& k, const std::string& style, const bench_image& img,
+                   const tws::wms::band_stretch_t& s, const tws::wms::color_lut_t& lut,
+                   std::vector<uint8_t>& rgba)
+{
+  std::vector<uint8_t> c[3];
+  std::vector<uint8_t> alpha(img.width);
+
+  for(int b = 0; b != 3; ++b)
+    c[b].resize(img.width);
+
+  for(std::size_t i = 0; i != img.height; ++i)
+  {
+    std::size_t offset = i * img.width;
+
+    uint8_t* out = &rgba[4 * offset];
+
+    std::fill(alpha.begin(), alpha.end(), 255);
+
+    if(style == "gray")
+    {
+      k.stretch(&img.bands[0][offset], img.width, s, &c[0][0], &alpha[0]);
+      k.interleave(&c[0][0], &c[0][0], &c[0][0], &alpha[0], img.width, out);
+    }
+    else if(style == "rgb")
+    {
+      for(int b = 0; b != 3; ++b)
+        k.stretch(&img.bands[b][offset], img.width, s, &c[b][0], &alpha[0]);
+
+      k.interleave(&c[0][0], &c[1][0], &c[2][0], &alpha[0], img.width, out);
+    }
+    else
+    {
+      k.stretch(&img.bands[0][offset], img.width, s, &c[0][0], &alpha[0]);
+      k.color_map(&c[0][0], &alpha[0], img.width, lut, out);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t width = 0;
+  std::size_t height = 0;
+  std::size_t iterations = 0;
+  double missing_ratio = 0.0;
+
+  boost::program_options::options_description options("Options");
+
+  options.add_options()
+    ("help", "show this help message")
+    ("width", boost::program_options::value<std::size_t>(&width)->default_value(2048), "image width")
+    ("height", boost::program_options::value<std::size_t>(&height)->default_value(2048), "image height")
+    ("iterations", boost::program_options::value<std::size_t>(&iterations)->default_value(20), "renders per style and instruction set")
+    ("missing", boost::program_options::value<double>(&missing_ratio)->default_value(0.1), "share of missing cells");
+
+  boost::program_options::variables_map vm;
+
+  try
+  {
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options), vm);
+
+    boost::program_options::notify(vm);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl << options << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cout << options << std::endl;
+
+    return EXIT_SUCCESS;
+  }
+
+// MODIS-like NDVI values: [-2000, 10000] with a scale factor of 0.0001 and -3000 as missing value
+  const double missing_value = -3000.0;
+
+  bench_image img;
+
+  img.width = width;
+  img.height = height;
+
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> value(-2000.0, 10000.0);
+  std::uniform_real_distribution<double> draw(0.0, 1.0);
+
+  for(int b = 0; b != 3; ++b)
+  {
+    img.bands[b].resize(width * height);
+
+    for(double& v : img.bands[b])
+    {
+      double d = draw(gen);
+
+      v = (d < missing_ratio * 0.5) ? missing_value
+        : (d < missing_ratio) ? std::numeric_limits<double>::quiet_NaN()
+        : std::floor(value(gen));
+    }
+  }
+
+  tws::geoarray::numeric_range_t range = { -0.2, 1.0 };
+
+  tws::wms::band_stretch_t s = tws::wms::make_band_stretch(range, 0.0001, missing_value);
+
+  std::vector<tws::wms::color_stop_t> color_map = { { -0.2, 165, 0, 38, 255 },
+                                                    { 0.4, 255, 255, 191, 255 },
+                                                    { 1.0, 0, 104, 55, 255 } };
+
+  tws::wms::color_lut_t lut = tws::wms::make_color_lut(color_map, range);
+
+  const char* styles[] = { "gray", "rgb", "color map" };
+  const int isas[] = { tws::core::simd_isa_t::scalar, tws::core::simd_isa_t::sse2, tws::core::simd_isa_t::avx2 };
+
+  std::cout << std::setw(12) << "style"
+            << std::setw(10) << "isa"
+            << std::setw(14) << "ms/image"
+            << std::setw(14) << "Mpixels/s"
+            << std::setw(10) << "check" << std::endl;
+
+  bool all_equal = true;
+
+  for(const char* style : styles)
+  {
+    std::vector<uint8_t> reference(4 * width * height);
+
+    render(tws::wms::get_color_kernels(tws::core::simd_isa_t::scalar), style, img, s, lut, reference);
+
+    for(int isa : isas)
+    {
+      if(!tws::core::is_supported(isa))
+        continue;
+
+      const tws::wms::color_kernels& k = tws::wms::get_color_kernels(isa);
+
+      std::vector<uint8_t> rgba(4 * width * height);
+
+      boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+      for(std::size_t it = 0; it != iterations; ++it)
+        render(k, style, img, s, lut, rgba);
+
+      double elapsed = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count();
+
+      bool equal = (std::memcmp(&rgba[0], &reference[0], rgba.size()) == 0);
+
+      all_equal = all_equal && equal;
+
+      std::cout << std::setw(12) << style
+                << std::setw(10) << k.name
+                << std::setw(14) << std::fixed << std::setprecision(3) << (elapsed * 1000.0 / iterations)
+                << std::setw(14) << std::fixed << std::setprecision(1) << (width * height * iterations / elapsed / 1.0e6)
+                << std::setw(10) << (equal ? "ok" : "MISMATCH") << std::endl;
+    }
+  }
+
+  return all_equal ? EXIT_SUCCESS : EXIT_FAILURE;
+}
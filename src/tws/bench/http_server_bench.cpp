@@ -0,0 +1,314 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/bench/http_server_bench.cpp
+
+  \brief Measures the Mongoose server throughput for a varying number of reactors.
+
+  For each reactor count an in-process server is started and hammered by
+  a set of keep-alive client connections requesting a cheap operation
+  (by default /wtss/list_coverages) for a fixed amount of time.
+
+  The max_connections entry of share/tws/config/mongoose_web_server.json
+  is sized for production and would cap the load below what the reactors
+  can serve: the bench servers accept the client connections plus one for
+  the probe that waits for the server to start.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "../core/utils.hpp"
+#include "../mongoose/server.hpp"
+
+// TerraLib
+#include <terralib/common/TerraLib.h>
+#include <terralib/plugin/PluginInfo.h>
+#include <terralib/plugin/PluginManager.h>
+#include <terralib/plugin/Utils.h>
+
+// STL
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/algorithm/string.hpp>
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+struct bench_counters
+{
+  std::atomic<uint64_t> nrequests;
+  std::atomic<uint64_t> nerrors;
+};
+
+static uint16_t read_server_port()
+{
+  std::string config_file = tws::core::find_in_app_path("share/tws/config/mongoose_web_server.json");
+
+  std::unique_ptr<rapidjson::Document> doc(tws::core::open_json_file(config_file));
+
+  return static_cast<uint16_t>((*doc)["listening_port"].GetUint());
+}
+
+static bool wait_server(uint16_t port)
+{
+  boost::asio::io_service io;
+
+  boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address_v4::loopback(), port);
+
+  for(int i = 0; i != 100; ++i)
+  {
+    boost::asio::ip::tcp::socket sock(io);
+
+    boost::system::error_code ec;
+
+    sock.connect(ep, ec);
+
+    if(!ec)
+      return true;
+
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(50));
+  }
+
+  return false;
+}
+
+// issue requests over a keep-alive connection until the deadline
+static void client_loop(uint16_t port, const std::string& uri,
+                        boost::chrono::steady_clock::time_point deadline,
+                        bench_counters* counters)
+{
+  const std::string request = "GET " + uri + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+  boost::asio::io_service io;
+
+  boost::asio::ip::tcp::endpoint ep(boost::asio::ip::address_v4::loopback(), port);
+
+  std::unique_ptr<boost::asio::ip::tcp::socket> sock;
+
+  boost::asio::streambuf buf;
+
+  while(boost::chrono::steady_clock::now() < deadline)
+  {
+    try
+    {
+      if(!sock)
+      {
+        sock.reset(new boost::asio::ip::tcp::socket(io));
+
+        sock->connect(ep);
+
+        buf.consume(buf.size());
+      }
+
+      boost::asio::write(*sock, boost::asio::buffer(request));
+
+      std::size_t header_size = boost::asio::read_until(*sock, buf, "\r\n\r\n");
+
+      std::string header(boost::asio::buffers_begin(buf.data()),
+                         boost::asio::buffers_begin(buf.data()) + header_size);
+
+      buf.consume(header_size);
+
+      std::size_t content_length = 0;
+
+      std::istringstream istr(header);
+
+      std::string line;
+
+      std::getline(istr, line);
+
+      bool ok = line.find(" 200 ") != std::string::npos;
+
+      while(std::getline(istr, line))
+      {
+        if(boost::istarts_with(line, "Content-Length:"))
+          content_length = boost::lexical_cast<std::size_t>(boost::trim_copy(line.substr(15)));
+      }
+
+      if(buf.size() < content_length)
+        boost::asio::read(*sock, buf, boost::asio::transfer_exactly(content_length - buf.size()));
+
+      buf.consume(content_length);
+
+      if(ok)
+        ++(counters->nrequests);
+      else
+        ++(counters->nerrors);
+    }
+    catch(...)
+    {
+      ++(counters->nerrors);
+
+      sock.reset();
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  std::string reactors_list;
+  std::string uri;
+  std::size_t nconnections = 0;
+  std::size_t duration = 0;
+
+  boost::program_options::options_description options("Options");
+
+  options.add_options()
+    ("help", "show this help message")
+    ("reactors", boost::program_options::value<std::string>(&reactors_list)->default_value("1,2,4,8"), "comma separated list of reactor counts")
+    ("connections", boost::program_options::value<std::size_t>(&nconnections)->default_value(64), "number of concurrent client connections")
+    ("duration", boost::program_options::value<std::size_t>(&duration)->default_value(10), "seconds to run each reactor count")
+    ("uri", boost::program_options::value<std::string>(&uri)->default_value("/wtss/list_coverages"), "operation to request");
+
+  boost::program_options::variables_map vm;
+
+  try
+  {
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options), vm);
+
+    boost::program_options::notify(vm);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl << options << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cout << options << std::endl;
+
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<std::string> reactors_tokens;
+
+  boost::split(reactors_tokens, reactors_list, boost::is_any_of(","));
+
+  try
+  {
+    TerraLib::getInstance().initialize();
+
+    tws::core::init_terralib_web_services();
+
+    std::string plugins_path = tws::core::find_in_app_path("share/tws/plugins");
+
+    std::unique_ptr<te::plugin::PluginInfo> info(te::plugin::GetInstalledPlugin(plugins_path + "/tws.wtss.teplg"));
+
+    te::plugin::PluginManager::getInstance().load(*info);
+
+    uint16_t port = read_server_port();
+
+    if(nconnections == 0)
+    {
+      std::cerr << "--connections must be at least 1." << std::endl;
+
+      return EXIT_FAILURE;
+    }
+
+    std::cout << std::setw(10) << "reactors"
+              << std::setw(14) << "requests"
+              << std::setw(10) << "errors"
+              << std::setw(14) << "req/s" << std::endl;
+
+    for(const std::string& token : reactors_tokens)
+    {
+      std::size_t nreactors = boost::lexical_cast<std::size_t>(boost::trim_copy(token));
+
+      tws::mongoose::server server(nreactors, nconnections + 1);
+
+      boost::thread server_thread(boost::bind(&tws::mongoose::server::start, &server));
+
+      if(!wait_server(port))
+      {
+        std::cerr << "could not connect to the server at port " << port << "." << std::endl;
+
+        server.stop();
+        server_thread.join();
+
+        return EXIT_FAILURE;
+      }
+
+      bench_counters counters;
+
+      counters.nrequests = 0;
+      counters.nerrors = 0;
+
+      boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+      boost::chrono::steady_clock::time_point deadline = start + boost::chrono::seconds(duration);
+
+      boost::thread_group clients;
+
+      for(std::size_t i = 0; i != nconnections; ++i)
+        clients.create_thread(boost::bind(&client_loop, port, uri, deadline, &counters));
+
+      clients.join_all();
+
+      double elapsed = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count();
+
+      server.stop();
+
+      server_thread.join();
+
+      std::cout << std::setw(10) << nreactors
+                << std::setw(14) << counters.nrequests
+                << std::setw(10) << counters.nerrors
+                << std::setw(14) << std::fixed << std::setprecision(1)
+                << (static_cast<double>(counters.nrequests) / elapsed) << std::endl;
+    }
+
+    te::plugin::PluginManager::getInstance().unloadAll();
+
+    TerraLib::getInstance().finalize();
+  }
+  catch(const boost::exception& e)
+  {
+    if(const std::string* d = boost::get_error_info<tws::error_description>(e))
+      std::cerr << "the following error has occurred: " << *d << std::endl;
+    else
+      std::cerr << "an unknown error has occurred." << std::endl;
+
+    return EXIT_FAILURE;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "the following error has occurred: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/bench/wtss_output_bench.cpp
+
+  \brief Compares the payload size and the encoding time of the WTSS output formats.
+
+  A time_series_batch result is made of synthetic MOD13Q1-like int16 series,
+  with a scale factor of 0.0001 and a share of missing values, and it is
+  written in JSON, MessagePack and Arrow IPC as the WTSS streamed responses
+  are.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "../wtss/arrow_writer.hpp"
+#include "../wtss/json_writer.hpp"
+#include "../wtss/msgpack_writer.hpp"
+#include "../wtss/output_buffer.hpp"
+#include "../wtss/time_series.hpp"
+#include "../wtss/time_series_writers.hpp"
+
+// STL
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+
+// the destination of the streamed response: the chunks are appended to the payload
+static void send_chunk(std::string& payload, const char* data, std::size_t size)
+{
+  payload.append(data, size);
+}
+
+static void encode(const tws::wtss::time_series_result_t& result, int format, std::string& payload)
+{
+  payload.clear();
+
+  tws::wtss::output_buffer out(boost::bind(&send_chunk, boost::ref(payload), _1, _2), 65536);
+
+  switch(format)
+  {
+    case tws::wtss::output_format_t::msgpack:
+    {
+      tws::wtss::msgpack_writer writer(out);
+      tws::wtss::write_time_series_batch(result, writer);
+      break;
+    }
+
+    case tws::wtss::output_format_t::arrow:
+    {
+      tws::wtss::arrow_stream_writer writer(out);
+      tws::wtss::write_time_series_batch(result, writer);
+      break;
+    }
+
+    default:
+    {
+      tws::wtss::json_writer writer(out, 9);
+      tws::wtss::write_time_series_batch(result, writer);
+    }
+  }
+
+  out.flush();
+}
+
+int main(int argc, char* argv[])
+{
+  std::size_t npoints = 0;
+  std::size_t ntime_pts = 0;
+  std::size_t nattributes = 0;
+  std::size_t iterations = 0;
+  double missing_ratio = 0.0;
+  std::string dump;
+
+  boost::program_options::options_description options("Options");
+
+  options.add_options()
+    ("help", "show this help message")
+    ("points", boost::program_options::value<std::size_t>(&npoints)->default_value(1000), "number of points in the batch")
+    ("timeline", boost::program_options::value<std::size_t>(&ntime_pts)->default_value(400), "number of time points")
+    ("attributes", boost::program_options::value<std::size_t>(&nattributes)->default_value(2), "number of attributes")
+    ("iterations", boost::program_options::value<std::size_t>(&iterations)->default_value(10), "responses encoded per format")
+    ("missing", boost::program_options::value<double>(&missing_ratio)->default_value(0.1), "share of missing values")
+    ("dump", boost::program_options::value<std::string>(&dump), "write the payload of each format to files with this prefix");
+
+  boost::program_options::variables_map vm;
+
+  try
+  {
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options), vm);
+
+    boost::program_options::notify(vm);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl << options << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cout << options << std::endl;
+
+    return EXIT_SUCCESS;
+  }
+
+  if((npoints == 0) || (ntime_pts == 0) || (nattributes == 0) || (iterations == 0))
+  {
+    std::cerr << "points, timeline, attributes and iterations must be positive." << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+// MOD13Q1-like attributes: int16 values in [-2000, 10000] with a scale factor of 0.0001 and -3000 as missing value
+  const double missing_value = -3000.0;
+
+  tws::wtss::time_series_result_t result;
+
+  result.coverage = "mod13q1_512";
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+  {
+    tws::geoarray::attribute_t attr;
+
+    attr.name = (boost::format("attr_%1%") % i).str();
+    attr.valid_range.min_val = -2000.0;
+    attr.valid_range.max_val = 10000.0;
+    attr.scale_factor = 0.0001;
+    attr.missing_value = missing_value;
+    attr.datatype = tws::geoarray::datatype_t::int16_dt;
+
+    result.attributes.push_back(attr);
+  }
+
+// a 16-day timeline
+  for(std::size_t i = 0; i != ntime_pts; ++i)
+    result.timeline.push_back((boost::format("%04d-%02d-%02d") % (2000 + i / 23) % (1 + (i % 23) / 2) % (1 + (i % 2) * 16)).str());
+
+// every tenth point is out of the coverage extent
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> value(-2000.0, 10000.0);
+  std::uniform_real_distribution<double> draw(0.0, 1.0);
+
+  std::size_t npixels = 0;
+
+  for(std::size_t i = 0; i != npoints; ++i)
+  {
+    tws::wtss::time_series_point_t point = { -54.0 + draw(gen), -12.0 + draw(gen), (i % 10) != 9, 0.0, 0.0, 0 };
+
+    if(point.valid)
+    {
+      point.center_longitude = point.longitude + 0.001;
+      point.center_latitude = point.latitude - 0.001;
+      point.pixel_pos = npixels++;
+    }
+
+    result.points.push_back(point);
+  }
+
+  std::vector<std::unique_ptr<tws::wtss::time_series_values> > values;
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+  {
+    values.push_back(tws::wtss::make_time_series_values(attr.datatype, npixels * ntime_pts, missing_value));
+
+    for(std::size_t i = 0; i != npixels * ntime_pts; ++i)
+      if(draw(gen) >= missing_ratio)
+        values.back()->set(i, std::floor(value(gen)));
+
+    result.values.push_back(values.back().get());
+  }
+
+  const char* names[] = { "json", "msgpack", "arrow" };
+  const int formats[] = { tws::wtss::output_format_t::json, tws::wtss::output_format_t::msgpack, tws::wtss::output_format_t::arrow };
+
+  std::cout << std::setw(10) << "format"
+            << std::setw(14) << "bytes"
+            << std::setw(10) << "ratio"
+            << std::setw(14) << "ms/response"
+            << std::setw(12) << "MB/s" << std::endl;
+
+  std::size_t json_size = 0;
+
+  for(int format : formats)
+  {
+    std::string payload;
+
+    boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+
+    for(std::size_t it = 0; it != iterations; ++it)
+      encode(result, format, payload);
+
+    double elapsed = boost::chrono::duration<double>(boost::chrono::steady_clock::now() - start).count();
+
+    if(format == tws::wtss::output_format_t::json)
+      json_size = payload.size();
+
+    std::cout << std::setw(10) << names[format]
+              << std::setw(14) << payload.size()
+              << std::setw(10) << std::fixed << std::setprecision(3) << (static_cast<double>(payload.size()) / json_size)
+              << std::setw(14) << std::fixed << std::setprecision(3) << (elapsed * 1000.0 / iterations)
+              << std::setw(12) << std::fixed << std::setprecision(1) << (payload.size() * iterations / elapsed / 1.0e6) << std::endl;
+
+    if(!dump.empty())
+    {
+      std::ofstream f((dump + "." + names[format]).c_str(), std::ios::binary);
+
+      f.write(payload.data(), payload.size());
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,77 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/cached_response.cpp
+
+  \brief A pre-serialized response for operations whose output never changes.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "cached_response.hpp"
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "utils.hpp"
+
+// STL
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// Boost
+#include <boost/format.hpp>
+
+tws::core::cached_response
+tws::core::make_cached_response(std::string content,
+                                const std::string& content_type)
+{
+// 64-bit FNV-1a: cheap and good enough to tell two versions of a document apart
+  uint64_t h = fnv1a_hash(content);
+
+  cached_response cresponse;
+
+  cresponse.etag = (boost::format("\"%016x-%x\"") % h % content.size()).str();
+  cresponse.content_type = content_type;
+  cresponse.content = std::make_shared<const std::string>(std::move(content));
+
+  return cresponse;
+}
+
+void
+tws::core::send_cached_response(const cached_response& cresponse,
+                                const http_request& request,
+                                http_response& response)
+{
+  const char* if_none_match = request.get_header("If-None-Match");
+
+  response.add_header("ETag", cresponse.etag.c_str());
+  response.add_header("Access-Control-Allow-Origin", "*");
+
+  if((if_none_match != nullptr) &&
+     ((std::strstr(if_none_match, cresponse.etag.c_str()) != nullptr) || (std::strcmp(if_none_match, "*") == 0)))
+  {
+    response.set_status(304);
+
+    return;
+  }
+
+  response.add_header("Content-Type", cresponse.content_type.c_str());
+  response.set_content(cresponse.content);
+}
@@ -0,0 +1,69 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/cached_response.hpp
+
+  \brief A pre-serialized response for operations whose output never changes.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_CORE_CACHED_RESPONSE_HPP__
+#define __TWS_CORE_CACHED_RESPONSE_HPP__
+
+// TWS
+#include "config.hpp"
+
+// STL
+#include <memory>
+#include <string>
+
+namespace tws
+{
+  namespace core
+  {
+// forward declarations
+    class http_request;
+    class http_response;
+
+    //! A response body serialized once and shared by all requests.
+    struct cached_response
+    {
+      std::shared_ptr<const std::string> content;
+      std::string content_type;
+      std::string etag;                             //!< A quoted strong entity tag computed from the content.
+    };
+
+    //! Build a cached response computing its entity tag.
+    cached_response make_cached_response(std::string content,
+                                         const std::string& content_type);
+
+    //! Answer a request with a cached response.
+    /*!
+      If the request If-None-Match header matches the entity tag
+      the answer is a 304 (Not Modified) without a body.
+     */
+    void send_cached_response(const cached_response& cresponse,
+                              const http_request& request,
+                              http_response& response);
+
+  }   // end namespace core
+}     // end namespace tws
+
+#endif  // __TWS_CORE_CACHED_RESPONSE_HPP__
@@ -61,8 +61,8 @@ namespace tws
         //! The base URI (already decoded) without the query string part.
         virtual const char* base_uri() const = 0;
 
-        //! The query string part in the URI (the URI part after '?' not including '?'). May be NULL.
-        virtual std::string query_string() const = 0;
+        //! The query string part in the URI (the URI part after '?' not including '?'), still encoded. May be empty.
+        virtual const std::string& query_string() const = 0;
 
         //! The request content.
         virtual const char* content() const = 0;
@@ -72,6 +72,9 @@ namespace tws
 
         //! Get a specific variable inside the request.
         virtual const char* get_var(const char* value) const = 0;
+
+        //! The value of a request header (case-insensitive name) or NULL if it is not present.
+        virtual const char* get_header(const char* name) const = 0;
     };
 
   }   // end namespace core
@@ -30,6 +30,11 @@
 // TWS
 #include "config.hpp"
 
+// STL
+#include <cstddef>
+#include <memory>
+#include <string>
+
 // Boost
 #include <boost/noncopyable.hpp>
 
@@ -54,6 +59,47 @@ namespace tws
 
         //! Set the content in the response.
         virtual void set_content(const char* value, const std::size_t size) = 0;
+
+        //! Set a content shared with other responses: implementations may avoid copying it.
+        virtual void set_content(const std::shared_ptr<const std::string>& value)
+        {
+          set_content(value->data(), value->size());
+        }
+
+        //! Set the HTTP status code of the response (default: 200).
+        virtual void set_status(int status) = 0;
+
+        //! Start a response whose body is written in pieces, after the status and headers set so far.
+        /*!
+          Implementations able to stream send the pieces as they are written,
+          with the HTTP/1.1 chunked transfer encoding. The default one keeps
+          them in memory and sets them as the response content at end().
+         */
+        virtual void begin()
+        {
+          stream_buffer_.clear();
+        }
+
+        //! Write the next piece of the body of a streamed response: it may block while the client is slow to receive the previous ones.
+        /*!
+          \exception tws::exception Implementations may throw if the client has closed the connection.
+         */
+        virtual void write_chunk(const char* data, const std::size_t size)
+        {
+          stream_buffer_.append(data, size);
+        }
+
+        //! Finish the body of a streamed response.
+        virtual void end()
+        {
+          set_content(stream_buffer_.data(), stream_buffer_.size());
+
+          std::string().swap(stream_buffer_);
+        }
+
+      private:
+
+        std::string stream_buffer_;
     };
 
   }   // end namespace core
@@ -0,0 +1,153 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/query_string.cpp
+
+  \brief A single pass parser for the query string of a request.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "query_string.hpp"
+#include "exception.hpp"
+
+// STL
+#include <cctype>
+
+// Boost
+#include <boost/algorithm/string/predicate.hpp>
+
+//! The value of an hexadecimal digit or -1 if it is not one.
+static inline int
+tws_core_hex_value(char c)
+{
+  if((c >= '0') && (c <= '9'))
+    return c - '0';
+
+  if((c >= 'a') && (c <= 'f'))
+    return c - 'a' + 10;
+
+  if((c >= 'A') && (c <= 'F'))
+    return c - 'A' + 10;
+
+  return -1;
+}
+
+tws::core::query_string_t::const_iterator
+tws::core::query_string_t::find(boost::string_ref key) const
+{
+  const_iterator first = begin();
+
+  for(std::size_t i = size_; i != 0; --i)
+  {
+    const value_type& kv = first[i - 1];
+
+    if(boost::algorithm::iequals(kv.first, key))
+      return first + (i - 1);
+  }
+
+  return end();
+}
+
+void
+tws::core::query_string_t::insert(boost::string_ref key, boost::string_ref value)
+{
+  if(size_ < inline_size)
+  {
+    pairs_[size_].first = key;
+    pairs_[size_].second = value;
+  }
+  else
+  {
+    if(overflow_.empty())
+      overflow_.assign(pairs_, pairs_ + inline_size);
+
+    overflow_.push_back(value_type(key, value));
+  }
+
+  ++size_;
+}
+
+tws::core::query_string_t
+tws::core::expand(std::string& buffer)
+{
+  query_string_t result;
+
+  if(buffer.empty())
+    return result;
+
+// the decoded text is never longer than the encoded one:
+// it is written over the buffer just behind the read position
+  char* const first = &buffer[0];
+  const char* const last = first + buffer.size();
+
+  const char* rd = first;
+  char* wr = first;
+
+  while(rd != last)
+  {
+    char* key = wr;
+    char* value = nullptr;
+
+    for(; (rd != last) && (*rd != '&'); ++rd)
+    {
+      char c = *rd;
+
+      if((c == '=') && (value == nullptr))
+      {
+        value = wr;
+        continue;
+      }
+
+      if(c == '+')
+      {
+        c = ' ';
+      }
+      else if(c == '%')
+      {
+        int hi = ((last - rd) > 2) ? tws_core_hex_value(rd[1]) : -1;
+        int lo = (hi != -1) ? tws_core_hex_value(rd[2]) : -1;
+
+        if(lo == -1)
+          throw tws::parse_error() << tws::error_description("invalid percent-encoding in query string!");
+
+        c = static_cast<char>((hi << 4) | lo);
+
+        rd += 2;
+      }
+
+      *wr++ = c;
+    }
+
+    if(rd != last)
+      ++rd;   // skip '&'
+
+// empty pairs ("a=1&&b=2" or a trailing '&') are skipped
+    if((value == nullptr) && (wr == key))
+      continue;
+
+    if((value == nullptr) || (value == key))
+      throw tws::parse_error() << tws::error_description("invalid key-value pair format in query string!");
+
+    result.insert(boost::string_ref(key, value - key), boost::string_ref(value, wr - value));
+  }
+
+  return result;
+}
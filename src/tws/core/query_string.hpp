@@ -0,0 +1,110 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/query_string.hpp
+
+  \brief A single pass parser for the query string of a request.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_CORE_QUERY_STRING_HPP__
+#define __TWS_CORE_QUERY_STRING_HPP__
+
+// TWS
+#include "config.hpp"
+
+// STL
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Boost
+#include <boost/utility/string_ref.hpp>
+
+namespace tws
+{
+  namespace core
+  {
+
+    /*!
+      \brief The key-value pairs of a query string.
+
+      A small flat map whose keys and values refer to the buffer the query string
+      was decoded in: it must outlive the map. The pairs are kept in their order
+      of appearance in a fixed size array, so building and searching the map does
+      not allocate memory unless the query string has more than inline_size pairs:
+      they are then moved to a vector.
+
+      Keys are compared without regard to case, as OGC services require. If a key
+      is repeated, find returns its last value; the others can still be reached
+      by iterating over the map.
+     */
+    class query_string_t
+    {
+      public:
+
+        typedef std::pair<boost::string_ref, boost::string_ref> value_type;
+
+        typedef const value_type* const_iterator;
+
+        //! The number of key-value pairs stored without allocating memory.
+        static const std::size_t inline_size = 32;
+
+        query_string_t()
+          : size_(0)
+        {
+        }
+
+        const_iterator begin() const { return overflow_.empty() ? pairs_ : overflow_.data(); }
+
+        const_iterator end() const { return begin() + size_; }
+
+        std::size_t size() const { return size_; }
+
+        bool empty() const { return size_ == 0; }
+
+        //! Returns the last pair with the given key (case-insensitive) or end() if there is none.
+        const_iterator find(boost::string_ref key) const;
+
+        //! Append a key-value pair.
+        void insert(boost::string_ref key, boost::string_ref value);
+
+      private:
+
+        value_type pairs_[inline_size];
+        std::vector<value_type> overflow_;  //!< All the pairs, once there are more than inline_size of them.
+        std::size_t size_;
+    };
+
+    //! Split a query string into its key-value pairs, decoding them in place.
+    /*!
+      Percent-encoded octets and '+' signs are decoded, so the buffer is rewritten
+      and the returned map refers to it. Empty values are allowed ("STYLES=") but
+      a pair without a '=' or with an empty key is not.
+
+      \exception tws::parse_error If the query string is malformed.
+     */
+    query_string_t expand(std::string& buffer);
+
+  }   // end namespace core
+}     // end namespace tws
+
+#endif  // __TWS_CORE_QUERY_STRING_HPP__
@@ -76,6 +76,9 @@ namespace tws
 
         //! Return an operation handle.
         /*!
+          The operation is found by its identifier, /service/operation, which may
+          be followed by extra path segments handled by the operation itself.
+
           \exception tws::item_not_found_error It may throws an exception if operation is not found.
          */
         service_operation_handler_t& get(const std::string& op_id);
@@ -114,6 +117,18 @@ namespace tws
     {
         std::map<std::string, service_operation_handler_t>::iterator it = operations_idx_.find(op_id);
 
+// a path with extra segments after the operation name: /service/operation/...
+        if(it == operations_idx_.end())
+        {
+          std::string::size_type pos = op_id.find('/', 1);
+
+          if(pos != std::string::npos)
+            pos = op_id.find('/', pos + 1);
+
+          if(pos != std::string::npos)
+            it = operations_idx_.find(op_id.substr(0, pos));
+        }
+
         if(it == operations_idx_.end())
         {
           boost::format err_msg("could not find requested service operation: %1%.");
@@ -0,0 +1,61 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/simd.cpp
+
+  \brief The instruction sets of the SIMD kernels and their detection in the running CPU.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "simd.hpp"
+
+bool
+tws::core::is_supported(int isa)
+{
+  switch(isa)
+  {
+    case simd_isa_t::scalar:
+      return true;
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    case simd_isa_t::sse2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+
+    case simd_isa_t::avx2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+
+    default:
+      return false;
+  }
+}
+
+int
+tws::core::select_isa()
+{
+  static const int best = is_supported(simd_isa_t::avx2) ? simd_isa_t::avx2
+                        : is_supported(simd_isa_t::sse2) ? simd_isa_t::sse2
+                        : simd_isa_t::scalar;
+
+  return best;
+}
@@ -0,0 +1,54 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/simd.hpp
+
+  \brief The instruction sets of the SIMD kernels and their detection in the running CPU.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_CORE_SIMD_HPP__
+#define __TWS_CORE_SIMD_HPP__
+
+namespace tws
+{
+  namespace core
+  {
+    //! The instruction sets with an implementation of the SIMD kernels of the services.
+    struct simd_isa_t
+    {
+      enum
+      {
+        scalar,
+        sse2,
+        avx2
+      };
+    };
+
+    //! Tells if code for a given instruction set can run in this CPU: SSE2 and AVX2 also require an x86 build with GCC or Clang.
+    bool is_supported(int isa);
+
+    //! The fastest instruction set supported by the running CPU.
+    int select_isa();
+
+  }   // end namespace core
+}     // end namespace tws
+
+#endif  // __TWS_CORE_SIMD_HPP__
@@ -0,0 +1,301 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/thread_pool.cpp
+
+  \brief A fixed size pool of worker threads with a bounded task queue.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "thread_pool.hpp"
+
+// STL
+#include <algorithm>
+#include <deque>
+#include <exception>
+#include <memory>
+
+// Boost
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+namespace tws
+{
+  namespace core
+  {
+
+    //! The items of a parallel_for call: it outlives the call if some of its helpers are still queued.
+    struct parallel_for_state
+    {
+      const boost::function1<void, std::size_t>* f;
+      std::size_t n;
+      std::size_t next;
+      std::size_t running;             //!< Helpers that have started and not yet finished.
+      bool closed;                     //!< The calling thread is done: the helpers starting now must not touch f.
+      std::exception_ptr error;
+      boost::mutex mtx;
+      boost::condition_variable finished;
+
+      //! Run the items not yet taken by other threads.
+      void run_items();
+    };
+
+  }  // end namespace core
+}    // end namespace tws
+
+void
+tws::core::parallel_for_state::run_items()
+{
+  while(true)
+  {
+    std::size_t i = 0;
+
+    {
+      boost::lock_guard<boost::mutex> lock(mtx);
+
+      if(error || (next == n))
+        return;
+
+      i = next++;
+    }
+
+    try
+    {
+      (*f)(i);
+    }
+    catch(...)
+    {
+      boost::lock_guard<boost::mutex> lock(mtx);
+
+      if(!error)
+        error = std::current_exception();
+    }
+  }
+}
+
+static void
+tws_core_parallel_for_helper(const std::shared_ptr<tws::core::parallel_for_state>& state)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(state->mtx);
+
+    if(state->closed)
+      return;
+
+    ++(state->running);
+  }
+
+  state->run_items();
+
+  {
+    boost::lock_guard<boost::mutex> lock(state->mtx);
+
+    --(state->running);
+  }
+
+  state->finished.notify_all();
+}
+
+struct tws::core::thread_pool::impl
+{
+  std::deque<task_t> tasks;
+  std::size_t max_queued_tasks;
+  std::size_t running;
+  bool stopped;
+  mutable boost::mutex mtx;
+  boost::condition_variable task_available;
+  boost::condition_variable room_available;
+  boost::thread_group workers;
+
+  impl(std::size_t max_queued);
+
+  void run();
+};
+
+tws::core::thread_pool::impl::impl(std::size_t max_queued)
+  : max_queued_tasks(max_queued),
+    running(0),
+    stopped(false)
+{
+}
+
+void
+tws::core::thread_pool::impl::run()
+{
+  while(true)
+  {
+    task_t t;
+
+    {
+      boost::unique_lock<boost::mutex> lock(mtx);
+
+      while(!stopped && tasks.empty())
+        task_available.wait(lock);
+
+// a stopped pool still runs the tasks already queued
+      if(tasks.empty())
+        return;
+
+      t.swap(tasks.front());
+
+      tasks.pop_front();
+
+      ++running;
+    }
+
+    room_available.notify_one();
+
+// tasks must report their own errors: a worker never dies because of one
+    try
+    {
+      t();
+    }
+    catch(...)
+    {
+    }
+
+    boost::lock_guard<boost::mutex> lock(mtx);
+
+    --running;
+  }
+}
+
+tws::core::thread_pool::thread_pool(std::size_t nthreads,
+                                    std::size_t max_queued_tasks)
+  : pimpl_(nullptr)
+{
+  pimpl_ = new impl(std::max<std::size_t>(max_queued_tasks, 1));
+
+  nthreads = std::max<std::size_t>(nthreads, 1);
+
+  for(std::size_t i = 0; i != nthreads; ++i)
+    pimpl_->workers.create_thread(boost::bind(&impl::run, pimpl_));
+}
+
+tws::core::thread_pool::~thread_pool()
+{
+  stop();
+
+  pimpl_->workers.join_all();
+
+  delete pimpl_;
+}
+
+bool
+tws::core::thread_pool::try_submit(const task_t& t)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    if(pimpl_->stopped || (pimpl_->tasks.size() >= pimpl_->max_queued_tasks))
+      return false;
+
+    pimpl_->tasks.push_back(t);
+  }
+
+  pimpl_->task_available.notify_one();
+
+  return true;
+}
+
+bool
+tws::core::thread_pool::submit(const task_t& t)
+{
+  {
+    boost::unique_lock<boost::mutex> lock(pimpl_->mtx);
+
+    while(!pimpl_->stopped && (pimpl_->tasks.size() >= pimpl_->max_queued_tasks))
+      pimpl_->room_available.wait(lock);
+
+    if(pimpl_->stopped)
+      return false;
+
+    pimpl_->tasks.push_back(t);
+  }
+
+  pimpl_->task_available.notify_one();
+
+  return true;
+}
+
+void
+tws::core::thread_pool::stop()
+{
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    pimpl_->stopped = true;
+  }
+
+  pimpl_->task_available.notify_all();
+  pimpl_->room_available.notify_all();
+}
+
+bool
+tws::core::thread_pool::busy() const
+{
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  return !pimpl_->tasks.empty() || (pimpl_->running != 0);
+}
+
+std::size_t
+tws::core::thread_pool::size() const
+{
+  return pimpl_->workers.size();
+}
+
+void
+tws::core::parallel_for(thread_pool& pool,
+                        std::size_t n,
+                        std::size_t max_helpers,
+                        const boost::function1<void, std::size_t>& f)
+{
+  std::shared_ptr<parallel_for_state> state = std::make_shared<parallel_for_state>();
+
+  state->f = &f;
+  state->n = n;
+  state->next = 0;
+  state->running = 0;
+  state->closed = false;
+
+  std::size_t nhelpers = std::min(max_helpers, (n == 0) ? 0 : n - 1);
+
+  for(std::size_t i = 0; i != nhelpers; ++i)
+    if(!pool.try_submit(boost::bind(&tws_core_parallel_for_helper, state)))
+      break;
+
+  state->run_items();
+
+// wait for the helpers running items: the ones still queued will find the state closed
+  boost::unique_lock<boost::mutex> lock(state->mtx);
+
+  state->closed = true;
+
+  while(state->running != 0)
+    state->finished.wait(lock);
+
+  if(state->error)
+    std::rethrow_exception(state->error);
+}
@@ -0,0 +1,107 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/core/thread_pool.hpp
+
+  \brief A fixed size pool of worker threads with a bounded task queue.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_CORE_THREAD_POOL_HPP__
+#define __TWS_CORE_THREAD_POOL_HPP__
+
+// TWS
+#include "config.hpp"
+
+// STL
+#include <cstddef>
+
+// Boost
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace core
+  {
+
+    //! A fixed size pool of worker threads with a bounded task queue.
+    class thread_pool : public boost::noncopyable
+    {
+      public:
+
+        //! The type of a task executed by the pool.
+        typedef boost::function0<void> task_t;
+
+        //! Start the worker threads.
+        /*!
+          \param nthreads         The number of worker threads (at least one thread is created).
+          \param max_queued_tasks The maximum number of tasks waiting for a worker (at least one).
+         */
+        thread_pool(std::size_t nthreads, std::size_t max_queued_tasks);
+
+        //! Stop the pool and wait for the queued and running tasks.
+        ~thread_pool();
+
+        //! Enqueue a task if there is room for it.
+        /*!
+          \return False if the queue is full or the pool is stopped.
+         */
+        bool try_submit(const task_t& t);
+
+        //! Enqueue a task, blocking while the queue is full.
+        /*!
+          \return False if the pool is stopped.
+         */
+        bool submit(const task_t& t);
+
+        //! Stop accepting tasks. The queued tasks are still run: a task may own resources only released when it runs.
+        void stop();
+
+        //! Tells if there are tasks queued or running.
+        bool busy() const;
+
+        //! The number of worker threads.
+        std::size_t size() const;
+
+      private:
+
+        struct impl;
+
+        impl* pimpl_;
+    };
+
+    //! Run f(0), ..., f(n - 1) in the calling thread helped by at most max_helpers tasks of a shared pool.
+    /*!
+      The helpers are enqueued only if the pool has room for them and a helper
+      not yet started when the calling thread runs out of items does nothing:
+      the call never waits for a task queued behind the work of other requests.
+
+      \exception Rethrows the first exception thrown by f, once the items being run are finished.
+     */
+    void parallel_for(thread_pool& pool,
+                      std::size_t n,
+                      std::size_t max_helpers,
+                      const boost::function1<void, std::size_t>& f);
+
+  }   // end namespace core
+}     // end namespace tws
+
+#endif  // __TWS_CORE_THREAD_POOL_HPP__
@@ -31,7 +31,15 @@
 #include "http_server_builder.hpp"
 #include "service_operations_manager.hpp"
 
+// STL
+#include <cstdlib>
+
 // Boost
+#include <boost/algorithm/string/case_conv.hpp>
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
 
 // rapidJSON
@@ -163,3 +171,77 @@ rapidjson::Document* tws::core::open_json_file(const std::string &path)
   }
 }
 
+std::size_t
+tws::core::negotiate_media_type(const char* accept, const std::vector<std::string>& offered)
+{
+  if((accept == nullptr) || offered.empty())
+    return 0;
+
+// the quality of each offered type: the one of the most specific media range matching it
+  std::vector<double> quality(offered.size(), 0.0);
+  std::vector<int> specificity(offered.size(), -1);
+
+  std::vector<std::string> media_ranges;
+
+  boost::split(media_ranges, accept, boost::is_any_of(","));
+
+  for(const std::string& media_range : media_ranges)
+  {
+    std::vector<std::string> params;
+
+    boost::split(params, media_range, boost::is_any_of(";"));
+
+    std::string range = boost::algorithm::to_lower_copy(boost::algorithm::trim_copy(params[0]));
+
+    double q = 1.0;
+
+    for(std::size_t i = 1; i < params.size(); ++i)
+    {
+      std::string param = boost::algorithm::trim_copy(params[i]);
+
+      if(boost::algorithm::istarts_with(param, "q="))
+        q = std::atof(param.c_str() + 2);
+    }
+
+    for(std::size_t i = 0; i != offered.size(); ++i)
+    {
+      int s = -1;
+
+      if(range == offered[i])
+        s = 2;
+      else if(range == "*/*")
+        s = 0;
+      else if((range.size() > 2) && boost::algorithm::ends_with(range, "/*") &&
+              boost::algorithm::starts_with(offered[i], range.substr(0, range.size() - 1)))
+        s = 1;
+
+      if(s > specificity[i])
+      {
+        specificity[i] = s;
+        quality[i] = q;
+      }
+    }
+  }
+
+  std::size_t best = 0;
+
+  for(std::size_t i = 1; i != offered.size(); ++i)
+    if(quality[i] > quality[best])
+      best = i;
+
+  return best;
+}
+
+uint64_t
+tws::core::fnv1a_hash(const std::string& data)
+{
+  uint64_t h = 14695981039346656037ULL;
+
+  for(unsigned char c : data)
+  {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+
+  return h;
+}
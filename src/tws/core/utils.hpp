@@ -32,10 +32,10 @@
 #include "exception.hpp"
 
 // STL
+#include <cstddef>
+#include <cstdint>
 #include <string>
-
-// Boost
-#include <boost/tokenizer.hpp>
+#include <vector>
 
 // RapidJSON
 #include <rapidjson/document.h>
@@ -44,60 +44,6 @@ namespace tws
 {
   namespace core
   {
-    //! Query string.
-    typedef std::map<std::string, std::string> query_string_t;
-
-    //! Split a query string into its components (the query string must be hex encoded).
-    /*!
-      \exception tws::parser_error If a parser error occurs during decomposition of query string.
-     */
-    inline query_string_t expand(const std::string& query_str)
-    {
-      query_string_t result;
-
-      boost::char_separator<char> kvp_sep("&");
-
-      boost::tokenizer<boost::char_separator<char> > key_value_pairs(query_str, kvp_sep);
-
-      boost::tokenizer<boost::char_separator<char> >::iterator ikv_pair = key_value_pairs.begin();
-
-      while(ikv_pair != key_value_pairs.end())
-      {
-        std::string kv = *ikv_pair;
-
-        boost::char_separator<char> kv_sep("=");
-
-        boost::tokenizer<boost::char_separator<char> > key_value_pair(kv, kv_sep);
-
-        boost::tokenizer<boost::char_separator<char> >::iterator ikv = key_value_pair.begin();
-
-        if(ikv == key_value_pair.end())
-          throw tws::parse_error() << tws::error_description("invalid key-value pair format in query string!");
-
-        std::string k = *ikv;
-
-        ++ikv;
-
-        if(ikv == key_value_pair.end())
-          throw tws::parse_error() << error_description("invalid key-value pair format in query string!");
-
-        std::string v = *ikv;
-
-        //std::string decoded_k;
-        //std::string decoded_v;
-
-        //boost::network::uri::decode(k.begin(), k.end(), std::back_inserter(decoded_k));
-        //boost::network::uri::decode(v.begin(), v.end(), std::back_inserter(decoded_v));
-
-        //result[decoded_k] = decoded_v;
-        result[k] = v;
-
-        ++ikv_pair;
-      }
-
-      return result;
-    }
-
     //! This routine must be called once at application startup in order to initialize TWS.
     /*!
       \exception tws::exception It may throw exceptions.
@@ -120,6 +66,19 @@ namespace tws
      */
     std::string find_in_app_path(const std::string& p);
 
+    //! Choose the media type of a response from the Accept header of its request.
+    /*!
+      \param accept  The value of the Accept header or NULL if the request has none.
+      \param offered The media types the operation can answer with, the preferred one first.
+
+      \return The position of the offered media type with the highest quality in the
+              header. The first one if the header is missing or none of them is acceptable.
+     */
+    std::size_t negotiate_media_type(const char* accept, const std::vector<std::string>& offered);
+
+    //! The 64-bit FNV-1a hash of a string: cheap, but not meant to resist collisions on purpose.
+    uint64_t fnv1a_hash(const std::string& data);
+
     /*!
       \brief It tries to open a json file from path.
 
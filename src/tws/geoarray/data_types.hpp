@@ -222,6 +222,19 @@ namespace tws
       geo_extent_t geo_extent;
     };
 
+    /*!
+      \brief An overview (pyramid level) of a geo-array.
+
+      The overview is materialized in its own array: its cell (c, r, t) holds
+      the source array cell (col_min + c * factor, row_min + r * factor, t).
+     */
+    struct overview_t
+    {
+      std::string source;   //!< The name of the array summarized by the overview.
+      std::size_t factor;   //!< The sampling step along each spatial dimension of the source array.
+      geoarray_t array;     //!< The overview metadata: dimensions and resolution are derived from the source array.
+    };
+
   }  // end namespace geoarray
 }    // end namespace tws
 
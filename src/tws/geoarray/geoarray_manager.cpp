@@ -31,6 +31,7 @@
 #include "utils.hpp"
 
 // STL
+#include <algorithm>
 #include <iterator>
 #include <map>
 #include <utility>
@@ -41,6 +42,7 @@
 struct tws::geoarray::geoarray_manager::impl
 {
   std::map<std::string, geoarray_t> arrays;
+  std::map<std::string, std::vector<overview_t> > overviews;  //!< the overviews of each array sorted by factor.
 };
 
 void
@@ -86,6 +88,63 @@ tws::geoarray::geoarray_manager::get(const std::string& array_name) const
   return it->second;
 }
 
+void
+tws::geoarray::geoarray_manager::insert(const overview_t& ov)
+{
+  get(ov.source);
+
+  std::vector<overview_t>& array_overviews = pimpl_->overviews[ov.source];
+
+  std::vector<overview_t>::iterator it = std::find_if(array_overviews.begin(), array_overviews.end(),
+                                                      [&ov](const overview_t& o) { return o.factor >= ov.factor; });
+
+  if((it != array_overviews.end()) && (it->factor == ov.factor))
+  {
+    boost::format err_msg("geo-array '%1%' already has an overview with factor %2%.");
+
+    throw tws::item_already_exists_error() << tws::error_description((err_msg % ov.source % ov.factor).str());
+  }
+
+  array_overviews.insert(it, ov);
+}
+
+std::vector<tws::geoarray::overview_t>
+tws::geoarray::geoarray_manager::overviews(const std::string& array_name) const
+{
+  std::map<std::string, std::vector<overview_t> >::const_iterator it = pimpl_->overviews.find(array_name);
+
+  if(it == std::end(pimpl_->overviews))
+    return std::vector<overview_t>();
+
+  return it->second;
+}
+
+const tws::geoarray::geoarray_t&
+tws::geoarray::geoarray_manager::select(const std::string& array_name, double cell_size) const
+{
+  const geoarray_t& source = get(array_name);
+
+  std::map<std::string, std::vector<overview_t> >::const_iterator it = pimpl_->overviews.find(array_name);
+
+  if(it == std::end(pimpl_->overviews))
+    return source;
+
+  const geoarray_t* selected = &source;
+
+// the overviews are sorted from the finest to the coarsest one
+  for(const overview_t& ov : it->second)
+  {
+    const spatial_resolution_t& resolution = ov.array.geo_extent.spatial.resolution;
+
+    if(std::max(resolution.x, resolution.y) > cell_size)
+      break;
+
+    selected = &(ov.array);
+  }
+
+  return *selected;
+}
+
 tws::geoarray::geoarray_manager&
 tws::geoarray::geoarray_manager::instance()
 {
@@ -100,6 +159,8 @@ tws::geoarray::geoarray_manager::geoarray_manager()
   pimpl_ = new impl;
   
   load_geoarrays(pimpl_->arrays);
+
+  load_overviews(pimpl_->overviews, pimpl_->arrays);
 }
 
 tws::geoarray::geoarray_manager::~geoarray_manager()
@@ -44,6 +44,7 @@ namespace tws
   
     //! Forward declaration
     struct geoarray_t;
+    struct overview_t;
 
     //! A singleton for managing geo-arrays.
     class geoarray_manager : public boost::noncopyable
@@ -56,6 +57,28 @@ namespace tws
 
         const geoarray_t& get(const std::string& array_name) const;
 
+        //! Register an overview of an array already managed.
+        /*!
+          \exception tws::item_not_found_error      If the overview source array is not registered.
+          \exception tws::item_already_exists_error If the array already has an overview with the same factor.
+         */
+        void insert(const overview_t& ov);
+
+        //! Returns the overviews of an array sorted from the finest to the coarsest one.
+        std::vector<overview_t> overviews(const std::string& array_name) const;
+
+        /*!
+          \brief Returns the coarsest representation of an array whose cells are not larger than a given size.
+
+          \param array_name The name of the source array.
+          \param cell_size  The size of the cells required, in the array SRS units.
+
+          \return The array itself or one of its overviews.
+
+          \exception tws::item_not_found_error If the array is not registered.
+         */
+        const geoarray_t& select(const std::string& array_name, double cell_size) const;
+
         static geoarray_manager& instance();
 
       private:
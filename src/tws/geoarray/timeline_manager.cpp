@@ -33,20 +33,131 @@
 #include "utils.hpp"
 
 // STL
+#include <cassert>
+#include <ctime>
 #include <map>
+#include <vector>
 
 // Boost
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/format.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+namespace tws
+{
+  namespace geoarray
+  {
+    //! The file a timeline was read from.
+    struct timeline_source
+    {
+      std::string file_name;
+      std::time_t last_write_time;
+    };
+
+  }  // end namespace geoarray
+}    // end namespace tws
 
 struct tws::geoarray::timeline_manager::impl
 {
-  std::map<std::string, timeline > timelines;
+  std::map<std::string, std::shared_ptr<const timeline> > timelines;
+  std::map<std::string, timeline_source> sources;
+  std::vector<timeline_change_handler_t> change_handlers;
+  uint64_t generation;
+  boost::chrono::milliseconds reload_interval;
+  bool stopped;
+  boost::mutex mtx;
+  boost::mutex reload_mtx;                          //!< Serializes the reloads.
+  boost::condition_variable stop_requested;
+  boost::thread watcher;
+
+  impl() : generation(0), reload_interval(60000), stopped(false) { }
+
+  void watch(timeline_manager* manager);
 };
 
+// the timelines are rewritten by external processes: a file that can not be read is tried again in the next round
+void
+tws::geoarray::timeline_manager::impl::watch(timeline_manager* manager)
+{
+  boost::unique_lock<boost::mutex> lock(mtx);
+
+  while(!stopped)
+  {
+    stop_requested.wait_for(lock, reload_interval);
+
+    if(stopped)
+      return;
+
+    lock.unlock();
+
+    try
+    {
+      manager->reload();
+    }
+    catch(...)
+    {
+    }
+
+    lock.lock();
+  }
+}
+
+// the list of timeline files and the optional reload interval
+static std::vector<std::pair<std::string, std::string> >
+tws_geoarray_read_timelines_config(boost::chrono::milliseconds* reload_interval)
+{
+  std::string timelines = tws::core::find_in_app_path("share/tws/config/timelines.json");
+
+  if(timelines.empty())
+    throw  tws::file_exists_error() << tws::error_description("could not locate file: 'share/tws/config/timelines.json'.");
+
+  if(reload_interval != nullptr)
+  {
+    std::unique_ptr<rapidjson::Document> doc(tws::core::open_json_file(timelines));
+
+    if(doc->HasMember("reload_interval_ms"))
+    {
+      const rapidjson::Value& jinterval = (*doc)["reload_interval_ms"];
+
+      if(!jinterval.IsUint() || jinterval.IsNull())
+        throw tws::parse_error() << tws::error_description("timelines.json entry 'reload_interval_ms' must be a non-negative integer.");
+
+      *reload_interval = boost::chrono::milliseconds(jinterval.GetUint());
+    }
+  }
+
+  return tws::geoarray::read_timelines_file_name(timelines);
+}
+
+static std::string
+tws_geoarray_find_timeline_file(const std::pair<std::string, std::string>& tf)
+{
+  std::string input_file = tws::core::find_in_app_path("share/tws/config/" + tf.second);
+
+  if(input_file.empty())
+  {
+    boost::format err_msg("timeline file: '%1%', not found for array '%2%'.");
+
+    throw tws::file_exists_error() << tws::error_description((err_msg % tf.second % tf.first).str());
+  }
+
+  return input_file;
+}
+
 void
 tws::geoarray::timeline_manager::insert(const std::string& geoarray_name,
                                         const timeline& t)
 {
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
   if(pimpl_->timelines.find(geoarray_name) != pimpl_->timelines.end())
   {
     boost::format err_msg("a timeline for the array named '%1%' is already registered.");
@@ -54,13 +165,116 @@ tws::geoarray::timeline_manager::insert(const std::string& geoarray_name,
     throw tws::item_already_exists_error() << tws::error_description((err_msg % geoarray_name).str());
   }
 
-  pimpl_->timelines[geoarray_name] = t;
+  pimpl_->timelines[geoarray_name] = std::make_shared<const timeline>(t);
+}
+
+void
+tws::geoarray::timeline_manager::update(const std::string& geoarray_name,
+                                        const timeline& t)
+{
+  std::shared_ptr<const timeline> new_timeline = std::make_shared<const timeline>(t);
+
+  std::vector<timeline_change_handler_t> handlers;
+
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    std::map<std::string, std::shared_ptr<const timeline> >::iterator it = pimpl_->timelines.find(geoarray_name);
+
+    if(it == pimpl_->timelines.end())
+    {
+      boost::format err_msg("could not find a timeline for array named: %1%.");
+
+      throw tws::item_not_found_error() << tws::error_description((err_msg % geoarray_name).str());
+    }
+
+// the readers of the old timeline keep their own reference to it
+    it->second.swap(new_timeline);
+
+    ++(pimpl_->generation);
+
+    handlers = pimpl_->change_handlers;
+  }
+
+// the handlers are called without the lock: they may look up the new timeline
+  for(const timeline_change_handler_t& h : handlers)
+    h(geoarray_name);
+}
+
+std::size_t
+tws::geoarray::timeline_manager::reload()
+{
+  boost::lock_guard<boost::mutex> reload_lock(pimpl_->reload_mtx);
+
+  std::vector<std::pair<std::string, std::string> > timelines_files = tws_geoarray_read_timelines_config(nullptr);
+
+  geoarray_manager& gmanager = geoarray_manager::instance();
+
+  std::size_t nupdated = 0;
+
+  for(const auto& tf : timelines_files)
+  {
+    std::shared_ptr<const timeline> current;
+
+    timeline_source source;
+
+    {
+      boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+      std::map<std::string, std::shared_ptr<const timeline> >::const_iterator it = pimpl_->timelines.find(tf.first);
+
+// only the timelines of the arrays already served can be replaced
+      if(it == pimpl_->timelines.end())
+        continue;
+
+      current = it->second;
+
+      source = pimpl_->sources[tf.first];
+    }
+
+    std::string input_file = tws_geoarray_find_timeline_file(tf);
+
+    std::time_t last_write_time = boost::filesystem::last_write_time(input_file);
+
+    if((input_file == source.file_name) && (last_write_time == source.last_write_time))
+      continue;
+
+    std::vector<std::string> str_timeline = read_timeline(input_file);
+
+    if(str_timeline != current->time_points())
+    {
+      const geoarray_t& garray = gmanager.get(tf.first);
+
+      update(tf.first, timeline(str_timeline, garray.dimensions[2]));
+
+      ++nupdated;
+    }
+
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    timeline_source& s = pimpl_->sources[tf.first];
+
+    s.file_name = input_file;
+    s.last_write_time = last_write_time;
+  }
+
+  return nupdated;
+}
+
+void
+tws::geoarray::timeline_manager::add_change_handler(const timeline_change_handler_t& h)
+{
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  pimpl_->change_handlers.push_back(h);
 }
 
-const tws::geoarray::timeline&
+std::shared_ptr<const tws::geoarray::timeline>
 tws::geoarray::timeline_manager::get(const std::string& geoarray_name) const
 {
-  std::map<std::string, timeline >::iterator it = pimpl_->timelines.find(geoarray_name);
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  std::map<std::string, std::shared_ptr<const timeline> >::const_iterator it = pimpl_->timelines.find(geoarray_name);
 
   if(it == pimpl_->timelines.end())
   {
@@ -72,6 +286,14 @@ tws::geoarray::timeline_manager::get(const std::string& geoarray_name) const
   return it->second;
 }
 
+uint64_t
+tws::geoarray::timeline_manager::generation() const
+{
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  return pimpl_->generation;
+}
+
 tws::geoarray::timeline_manager&
 tws::geoarray::timeline_manager::instance()
 {
@@ -87,23 +309,13 @@ tws::geoarray::timeline_manager::timeline_manager()
 
   geoarray_manager& gmanager = geoarray_manager::instance();
 
-  std::string timelines = tws::core::find_in_app_path("share/tws/config/timelines.json");
-
-  if(timelines.empty())
-    throw  tws::file_exists_error() << tws::error_description("could not locate file: 'share/tws/config/wtss_timelines.json'.");
-
-  std::vector<std::pair<std::string, std::string> > timelines_files = read_timelines_file_name(timelines);
+  std::vector<std::pair<std::string, std::string> > timelines_files = tws_geoarray_read_timelines_config(&pimpl_->reload_interval);
 
   for(const auto& tf : timelines_files)
   {
-    std::string input_file = tws::core::find_in_app_path("share/tws/config/" + tf.second);
-
-    if(input_file.empty())
-    {
-      boost::format err_msg("timeline file: '%1%', not found for array '%2%'.");
+    std::string input_file = tws_geoarray_find_timeline_file(tf);
 
-      throw tws::file_exists_error() << tws::error_description((err_msg % tf.second % tf.first).str());
-    }
+    timeline_source source = { input_file, boost::filesystem::last_write_time(input_file) };
 
     std::vector<std::string> str_timeline = read_timeline(input_file);
 
@@ -114,11 +326,26 @@ tws::geoarray::timeline_manager::timeline_manager()
     timeline t(str_timeline, garray.dimensions[2]);
 
     insert(tf.first, t);
+
+    pimpl_->sources[tf.first] = source;
   }
+
+  if(pimpl_->reload_interval.count() != 0)
+    pimpl_->watcher = boost::thread(boost::bind(&impl::watch, pimpl_, this));
 }
 
 tws::geoarray::timeline_manager::~timeline_manager()
 {
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    pimpl_->stopped = true;
+  }
+
+  pimpl_->stop_requested.notify_all();
+
+  if(pimpl_->watcher.joinable())
+    pimpl_->watcher.join();
+
   delete pimpl_;
 }
-
@@ -28,6 +28,8 @@
 #define __TWS_GEOARRAY_TIMELINE_MANAGER_HPP__
 
 // STL
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -41,7 +43,20 @@ namespace tws
   {
     class timeline;
 
-    //! A singleton for managing the timeline of arrays.
+    //! The type of a function notified with the name of an array whose timeline has changed.
+    typedef boost::function1<void, const std::string&> timeline_change_handler_t;
+
+    /*!
+      \brief A singleton for managing the timeline of arrays.
+
+      The timelines are read from the files listed in share/tws/config/timelines.json.
+      A background thread checks these files every reload_interval_ms milliseconds
+      (an optional entry of timelines.json, 60000 by default and 0 to disable it)
+      and replaces the timelines whose files have changed.
+
+      A replaced timeline stays alive while the requests that got it before
+      the replacement are still using it.
+     */
     class timeline_manager : public boost::noncopyable
     {
       public:
@@ -53,11 +68,33 @@ namespace tws
         void insert(const std::string& geoarray_name,
                     const timeline& t);
 
+        //! Replace the timeline of an array and notify the registered change handlers.
+        /*!
+          \exception tws::item_not_found_error If a timeline for the given array is not found.
+         */
+        void update(const std::string& geoarray_name,
+                    const timeline& t);
+
+        //! Read again the timeline files that have changed since they were last read, updating the timelines whose time points differ.
+        /*!
+          \return The number of timelines updated.
+
+          \exception tws::file_exists_error If the file 'share/tws/config/timelines.json' is not found.
+          \exception tws::parse_error       If the timelines file can not be parsed.
+         */
+        std::size_t reload();
+
+        //! Register a function to be notified whenever a timeline is updated.
+        void add_change_handler(const timeline_change_handler_t& h);
+
         //! Find a timeline for a given array.
         /*!
           \exception tws::item_not_found_error If a timeline for the given array is not found.
          */
-        const timeline& get(const std::string& geoarray_name) const;
+        std::shared_ptr<const timeline> get(const std::string& geoarray_name) const;
+
+        //! The number of timeline updates so far: it is incremented before the change handlers are notified.
+        uint64_t generation() const;
 
         //! Access the singleton.
         static timeline_manager& instance();
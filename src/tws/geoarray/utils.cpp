@@ -30,6 +30,7 @@
 #include "exception.hpp"
 
 // STL
+#include <algorithm>
 #include <cstdio>
 
 // Boost
@@ -90,6 +91,130 @@ tws::geoarray::load_geoarrays(std::map<std::string, geoarray_t>& arrays,
 
 }
 
+void
+tws::geoarray::load_overviews(std::map<std::string, std::vector<overview_t> >& overviews,
+                              const std::map<std::string, geoarray_t>& arrays)
+{
+  overviews.clear();
+
+// overviews are optional
+  std::string input_file = tws::core::find_in_app_path("share/tws/config/overviews.json");
+
+  if(input_file.empty())
+    return;
+
+  std::unique_ptr<rapidjson::Document> doc(tws::core::open_json_file(input_file));
+
+  const rapidjson::Value& joverviews = (*doc)["overviews"];
+
+  if(!joverviews.IsArray())
+  {
+    boost::format err_msg("error parsing input file '%1%': expected a vector of array overviews.");
+
+    throw tws::parse_error() << tws::error_description((err_msg % input_file).str());
+  }
+
+  const rapidjson::SizeType nelements = joverviews.Size();
+
+  for(rapidjson::SizeType i = 0; i != nelements; ++i)
+  {
+    const rapidjson::Value& joverview = joverviews[i];
+
+    if(joverview.IsNull())
+      continue;
+
+    if(!joverview.IsObject())
+      throw tws::parse_error() << tws::error_description("error in overviews file: expected an object describing the overviews of an array.");
+
+    const rapidjson::Value& jarray_name = joverview["array"];
+
+    if(!jarray_name.IsString() || jarray_name.IsNull())
+      throw tws::parse_error() << tws::error_description("error in overviews file: entry 'array' must be a string.");
+
+    std::string array_name = jarray_name.GetString();
+
+    std::map<std::string, geoarray_t>::const_iterator it = arrays.find(array_name);
+
+    if(it == arrays.end())
+    {
+      boost::format err_msg("overviews file refers to an unknown array: %1%.");
+
+      throw tws::item_not_found_error() << tws::error_description((err_msg % array_name).str());
+    }
+
+    const rapidjson::Value& jlevels = joverview["levels"];
+
+    if(!jlevels.IsArray() || jlevels.IsNull())
+      throw tws::parse_error() << tws::error_description("error in overviews file: entry 'levels' must be an array.");
+
+    std::vector<overview_t>& array_overviews = overviews[array_name];
+
+    const rapidjson::SizeType nlevels = jlevels.Size();
+
+    for(rapidjson::SizeType j = 0; j != nlevels; ++j)
+    {
+      const rapidjson::Value& jlevel = jlevels[j];
+
+      const rapidjson::Value& jname = jlevel["name"];
+
+      if(!jname.IsString() || jname.IsNull())
+        throw tws::parse_error() << tws::error_description("error in overviews file: each level must have a 'name' entry.");
+
+      const rapidjson::Value& jfactor = jlevel["factor"];
+
+      if(!jfactor.IsNumber() || jfactor.IsNull() || (jfactor.GetUint() < 2))
+        throw tws::parse_error() << tws::error_description("error in overviews file: each level must have a 'factor' entry greater than one.");
+
+      array_overviews.push_back(make_overview(it->second, jname.GetString(), jfactor.GetUint()));
+    }
+
+// keep the levels from the finest to the coarsest one
+    std::sort(array_overviews.begin(), array_overviews.end(),
+              [](const overview_t& lhs, const overview_t& rhs) { return lhs.factor < rhs.factor; });
+  }
+}
+
+tws::geoarray::overview_t
+tws::geoarray::make_overview(const geoarray_t& source,
+                             const std::string& name,
+                             std::size_t factor)
+{
+  overview_t ov;
+
+  ov.source = source.name;
+  ov.factor = factor;
+  ov.array = source;
+  ov.array.name = name;
+
+  spatial_extent_t& spatial = ov.array.geo_extent.spatial;
+
+// the overview keeps the cells at source positions min_idx, min_idx + factor, ...
+  dimension_t& col_dim = ov.array.dimensions[0];
+  dimension_t& row_dim = ov.array.dimensions[1];
+
+  int64_t ncols = (col_dim.max_idx - col_dim.min_idx) / static_cast<int64_t>(factor) + 1;
+  int64_t nrows = (row_dim.max_idx - row_dim.min_idx) / static_cast<int64_t>(factor) + 1;
+
+  col_dim.min_idx = 0;
+  col_dim.max_idx = ncols - 1;
+  row_dim.min_idx = 0;
+  row_dim.max_idx = nrows - 1;
+
+// the overview cells are centered on the sampled source cells
+  double res_x = spatial.resolution.x;
+  double res_y = spatial.resolution.y;
+
+  spatial.resolution.x = res_x * factor;
+  spatial.resolution.y = res_y * factor;
+
+  spatial.extent.xmin -= 0.5 * (factor - 1) * res_x;
+  spatial.extent.ymax += 0.5 * (factor - 1) * res_y;
+  spatial.extent.xmax = spatial.extent.xmin + ncols * spatial.resolution.x;
+  spatial.extent.ymin = spatial.extent.ymax - nrows * spatial.resolution.y;
+
+  return ov;
+}
+
 std::vector<std::pair<std::string, std::string> >
 tws::geoarray::read_timelines_file_name(const std::string& input_file)
 {
@@ -53,6 +53,19 @@ namespace tws
     void load_geoarrays(std::map<std::string, geoarray_t>& arrays,
                         const std::string& input_file);
 
+    //! Read the overviews listed in 'share/tws/config/overviews.json', if any, for the given arrays.
+    /*!
+      \exception tws::parse_error          If the file has any syntax error.
+      \exception tws::item_not_found_error If an overview refers to an unknown array.
+     */
+    void load_overviews(std::map<std::string, std::vector<overview_t> >& overviews,
+                        const std::map<std::string, geoarray_t>& arrays);
+
+    //! Derive the metadata of an overview that samples every factor-th cell of an array along the spatial dimensions.
+    overview_t make_overview(const geoarray_t& source,
+                             const std::string& name,
+                             std::size_t factor);
+
     geoarray_t read_array_metadata(const rapidjson::Value& jmetadata);
 
     std::vector<attribute_t> read_array_attributes(const rapidjson::Value& jattributes);
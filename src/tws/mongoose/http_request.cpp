@@ -30,13 +30,25 @@
 // STL
 #include <cassert>
 
+// Boost
+#include <boost/algorithm/string/predicate.hpp>
+
 // Mongoose
 #include "mongoose.h"
 
-tws::mongoose::http_request::http_request(http_message* msg)
-  : msg_(msg)
+tws::mongoose::http_request::http_request(const http_message* msg)
 {
-  assert(msg_);
+  assert(msg);
+
+  method_.assign(msg->method.p, msg->method.len);
+  version_.assign(msg->proto.p, msg->proto.len);
+  uri_.assign(msg->uri.p, msg->uri.len);
+  query_string_.assign(msg->query_string.p, msg->query_string.len);
+  content_.assign(msg->body.p, msg->body.len);
+
+  for(int i = 0; (i != MG_MAX_HTTP_HEADERS) && (msg->header_names[i].len != 0); ++i)
+    headers_.push_back(std::make_pair(std::string(msg->header_names[i].p, msg->header_names[i].len),
+                                      std::string(msg->header_values[i].p, msg->header_values[i].len)));
 }
 
 tws::mongoose::http_request::~http_request()
@@ -46,38 +58,37 @@ tws::mongoose::http_request::~http_request()
 const char*
 tws::mongoose::http_request::method() const
 {
-  return nullptr;
+  return method_.c_str();
 }
 
 const char*
 tws::mongoose::http_request::version() const
 {
-  return nullptr;
+  return version_.c_str();
 }
 
 const char*
 tws::mongoose::http_request::base_uri() const
 {
-  return nullptr;
+  return uri_.c_str();
 }
 
-std::string
+const std::string&
 tws::mongoose::http_request::query_string() const
 {
-  std::string query_str(msg_->query_string.p, msg_->query_string.len);
-  return query_str;
+  return query_string_;
 }
 
 const char*
 tws::mongoose::http_request::content() const
 {
-  return nullptr;
+  return content_.c_str();
 }
 
 std::size_t
 tws::mongoose::http_request::content_length() const
 {
-  return 0;
+  return content_.size();
 }
 
 const char*
@@ -85,3 +96,13 @@ tws::mongoose::http_request::get_var(const char* value) const
 {
   return nullptr;
 }
+
+const char*
+tws::mongoose::http_request::get_header(const char* name) const
+{
+  for(const auto& h : headers_)
+    if(boost::iequals(h.first, name))
+      return h.second.c_str();
+
+  return nullptr;
+}
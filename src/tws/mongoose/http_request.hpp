@@ -30,6 +30,11 @@
 // TWS
 #include "../core/http_request.hpp"
 
+// STL
+#include <string>
+#include <utility>
+#include <vector>
+
 // Forward declaration
 extern "C" { struct http_message; }
 
@@ -39,11 +44,15 @@ namespace tws
   {
 
     //! HTTP request implementation for Mongoose
+    /*!
+      The request data is copied from the Mongoose message buffer so that
+      it can outlive the event that delivered it and be served by a worker thread.
+     */
     class http_request : public tws::core::http_request
     {
       public:
 
-        http_request(http_message *msg);
+        http_request(const http_message *msg);
 
         ~http_request();
 
@@ -53,7 +62,7 @@ namespace tws
 
         const char* base_uri() const;
 
-        std::string query_string() const;
+        const std::string& query_string() const;
 
         const char* content() const;
 
@@ -61,9 +70,16 @@ namespace tws
   
         const char* get_var(const char* value) const;
 
+        const char* get_header(const char* name) const;
+
       private:
 
-        http_message* msg_;
+        std::string method_;
+        std::string version_;
+        std::string uri_;
+        std::string query_string_;
+        std::string content_;
+        std::vector<std::pair<std::string, std::string> > headers_;
     };
 
   }   // end namespace mongoose
@@ -26,18 +26,23 @@
 
 // TWS
 #include "http_response.hpp"
+#include "exception.hpp"
 
 // STL
 #include <cassert>
+#include <cstdio>
+
+// Boost
+#include <boost/thread/locks.hpp>
 
 // Mongoose
 #include "mongoose.h"
 
-tws::mongoose::http_response::http_response(mg_connection* conn)
-  : conn_(conn),
-    headers_("")
+tws::mongoose::http_response::http_response()
+  : status_(200),
+    headers_(""),
+    max_pending_(0)
 {
-  assert(conn_);
 }
 
 tws::mongoose::http_response::~http_response()
@@ -58,6 +63,225 @@ void
 tws::mongoose::http_response::set_content(const char* value,
                                           const std::size_t size)
 {
-  mg_send_head(conn_, 200, size, headers_.c_str());
-  mg_send(conn_, value, size);
+  shared_content_.reset();
+
+  content_.assign(value, size);
+}
+
+void
+tws::mongoose::http_response::set_content(const std::shared_ptr<const std::string>& value)
+{
+  content_.clear();
+
+  shared_content_ = value;
+}
+
+void
+tws::mongoose::http_response::set_status(int status)
+{
+  status_ = status;
+}
+
+void
+tws::mongoose::http_response::set_error(int status, const std::string& msg)
+{
+// the status line is gone: all that is left is to tell the client the body is incomplete
+  if(stream_)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(stream_->mtx);
+
+      if(stream_->closed)
+        return;
+
+      stream_->closed = true;
+      stream_->aborted = true;
+    }
+
+    notifier_(stream_);
+
+    return;
+  }
+
+  status_ = status;
+  headers_ = "Content-Type: text/plain";
+  content_ = msg;
+  shared_content_.reset();
+}
+
+void
+tws::mongoose::http_response::send(mg_connection* conn) const
+{
+  assert(conn);
+
+  const std::string& content = shared_content_ ? *shared_content_ : content_;
+
+// a 304 (Not Modified) answer must not carry a body
+  if(status_ == 304)
+  {
+    mg_send_response_line(conn, status_, headers_.c_str());
+    mg_send(conn, "\r\n", 2);
+    return;
+  }
+
+  mg_send_head(conn, status_, content.size(), headers_.c_str());
+  mg_send(conn, content.data(), content.size());
+}
+
+void
+tws::mongoose::http_response::set_stream_notifier(const stream_notifier_t& notifier,
+                                                  std::size_t max_pending)
+{
+  notifier_ = notifier;
+  max_pending_ = max_pending;
+}
+
+void
+tws::mongoose::http_response::begin()
+{
+  assert(notifier_ && !stream_);
+
+  stream_.reset(new response_stream);
+
+  stream_->status = status_;
+
+// a client pipelining requests could see the next response before the end of the body: don't keep the connection
+  stream_->headers = headers_.empty() ? std::string("Connection: close") : headers_ + "\r\nConnection: close";
+  stream_->pending = 0;
+  stream_->max_pending = max_pending_;
+  stream_->head_sent = false;
+  stream_->closed = false;
+  stream_->aborted = false;
+  stream_->cancelled = false;
+
+  notifier_(stream_);
+}
+
+void
+tws::mongoose::http_response::write_chunk(const char* data,
+                                          const std::size_t size)
+{
+  assert(stream_);
+
+// an empty chunk would end the body
+  if(size == 0)
+    return;
+
+  char chunk_size[32];
+
+  int chunk_size_len = std::snprintf(chunk_size, sizeof(chunk_size), "%zx\r\n", size);
+
+  std::string chunk;
+
+  chunk.reserve(chunk_size_len + size + 2);
+  chunk.append(chunk_size, chunk_size_len);
+  chunk.append(data, size);
+  chunk.append("\r\n", 2);
+
+  bool was_empty = false;
+
+  {
+    boost::unique_lock<boost::mutex> lock(stream_->mtx);
+
+    while((stream_->max_pending != 0) && (stream_->pending >= stream_->max_pending) && !stream_->cancelled)
+      stream_->drained.wait(lock);
+
+    if(stream_->cancelled)
+      throw tws::mongoose::exception() << tws::error_description("the client closed the connection.");
+
+    was_empty = stream_->chunks.empty();
+
+    stream_->pending += chunk.size();
+    stream_->chunks.push_back(std::move(chunk));
+  }
+
+  if(was_empty)
+    notifier_(stream_);
+}
+
+void
+tws::mongoose::http_response::end()
+{
+  assert(stream_);
+
+  {
+    boost::lock_guard<boost::mutex> lock(stream_->mtx);
+
+    if(stream_->closed)
+      return;
+
+    stream_->closed = true;
+
+    stream_->chunks.push_back("0\r\n\r\n");
+    stream_->pending += 5;
+  }
+
+  notifier_(stream_);
+}
+
+void
+tws::mongoose::http_response::close()
+{
+  if(stream_)
+    end();
+}
+
+bool
+tws::mongoose::http_response::streaming() const
+{
+  return static_cast<bool>(stream_);
+}
+
+bool
+tws::mongoose::http_response::pump(mg_connection* conn,
+                                   response_stream& stream,
+                                   std::size_t high_water)
+{
+  assert(conn);
+
+  bool finished = false;
+
+  {
+    boost::lock_guard<boost::mutex> lock(stream.mtx);
+
+    if(!stream.head_sent)
+    {
+      mg_send_head(conn, stream.status, -1, stream.headers.c_str());
+
+      stream.head_sent = true;
+    }
+
+    while(!stream.chunks.empty() && (conn->send_mbuf.len < high_water))
+    {
+      const std::string& chunk = stream.chunks.front();
+
+      mg_send(conn, chunk.data(), chunk.size());
+
+      stream.pending -= chunk.size();
+      stream.chunks.pop_front();
+    }
+
+    finished = stream.closed && (stream.chunks.empty() || stream.aborted);
+  }
+
+  stream.drained.notify_all();
+
+  if(finished)
+    conn->flags |= MG_F_SEND_AND_CLOSE;
+
+  return finished;
+}
+
+void
+tws::mongoose::http_response::cancel(response_stream& stream)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(stream.mtx);
+
+    stream.cancelled = true;
+    stream.chunks.clear();
+    stream.pending = 0;
+  }
+
+  stream.drained.notify_all();
 }
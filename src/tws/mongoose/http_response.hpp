@@ -34,8 +34,16 @@
 #include "../core/http_response.hpp"
 
 // STL
+#include <cstddef>
+#include <deque>
+#include <memory>
 #include <string>
 
+// Boost
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
 // Forward declaration
 extern "C" { struct mg_connection; }
 
@@ -43,19 +51,97 @@ namespace tws
 {
   namespace mongoose
   {
+    /*!
+      \brief The body of a streamed response, on its way from a worker to the polling thread.
+
+      The worker queues the body pieces already framed as HTTP chunks and the
+      polling thread moves them to the connection while its send buffer is below
+      a high-water mark. The worker blocks while more than max_pending bytes
+      are queued.
+     */
+    struct response_stream
+    {
+      int status;
+      std::string headers;
+      std::deque<std::string> chunks;
+      std::size_t pending;          //!< The number of bytes in the queued chunks.
+      std::size_t max_pending;      //!< The queue limit: zero means no limit.
+      bool head_sent;               //!< Only touched by the polling thread.
+      bool closed;                  //!< All the chunks were queued.
+      bool aborted;                 //!< The operation failed after begin(): the connection is closed without finishing the body.
+      bool cancelled;               //!< The client closed the connection: no more chunks are accepted.
+      boost::mutex mtx;
+      boost::condition_variable drained;
+    };
+
     //! HTTP response implementaton for Moongose.
+    /*!
+      Service operations may run in a worker thread and only the thread polling
+      the Mongoose manager is allowed to write to the connection. So a response
+      is either buffered and written by send(), or streamed: begin() hands a
+      response_stream to the polling thread through the stream notifier and
+      each chunk written afterwards is queued there.
+     */
     class http_response : public tws::core::http_response
     {
      public:
-      http_response(mg_connection* conn);
+
+      //! Called by begin() and whenever an empty stream receives a chunk, to wake up the polling thread.
+      typedef boost::function<void (const std::shared_ptr<response_stream>&)> stream_notifier_t;
+
+      http_response();
 
       ~http_response();
       void add_header(const char* key, const char* value);
       void set_content(const char* value, const std::size_t size);
 
+      //! Keep a reference to the shared content instead of copying it.
+      void set_content(const std::shared_ptr<const std::string>& value);
+
+      void set_status(int status);
+
+      //! Replace the response by a plain text error message: a streamed response is aborted instead.
+      void set_error(int status, const std::string& msg);
+
+      //! Set how streams reach the polling thread and the number of bytes queued before write_chunk() blocks (zero means no limit).
+      void set_stream_notifier(const stream_notifier_t& notifier, std::size_t max_pending);
+
+      //! Start streaming the body with the chunked transfer encoding; the connection is closed at the end of the body.
+      void begin();
+
+      /*!
+        \exception tws::mongoose::exception If the client has closed the connection.
+       */
+      void write_chunk(const char* data, const std::size_t size);
+
+      void end();
+
+      //! Finish a stream left open by the service operation.
+      void close();
+
+      //! Tells if begin() was called.
+      bool streaming() const;
+
+      //! Write the buffered response to the connection. Must be called from the polling thread.
+      void send(mg_connection* conn) const;
+
+      //! Move the queued chunks of a stream to its connection while its send buffer holds less than high_water bytes. Must be called from the polling thread.
+      /*!
+        \return True if the whole body was moved to the connection or if the stream was aborted.
+       */
+      static bool pump(mg_connection* conn, response_stream& stream, std::size_t high_water);
+
+      //! Discard a stream whose client closed the connection, releasing a blocked worker.
+      static void cancel(response_stream& stream);
+
      private:
-      mg_connection* conn_;
+      int status_;
       std::string headers_;
+      std::string content_;
+      std::shared_ptr<const std::string> shared_content_;
+      std::shared_ptr<response_stream> stream_;
+      stream_notifier_t notifier_;
+      std::size_t max_pending_;
     };
 
   }  // end namespace mongoose
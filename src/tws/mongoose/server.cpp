@@ -30,18 +30,31 @@
 // TWS
 #include "server.hpp"
 #include "../core/service_operations_manager.hpp"
+#include "../core/thread_pool.hpp"
 #include "../core/utils.hpp"
 #include "exception.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
 
 // STL
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
 
 // Boost
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 // Mongoose
 #include "mongoose.h"
@@ -53,6 +66,9 @@
 static void tws_mongoose_event_handler(mg_connection* conn, int ev,
                                        void* ev_data);
 
+static void tws_mongoose_wakeup_handler(mg_connection* conn, int ev,
+                                        void* ev_data);
+
 struct tws_mongoose_http_config
 {
   std::string log_file;
@@ -60,83 +76,483 @@ struct tws_mongoose_http_config
   uint32_t listening_port;
   uint32_t max_threads;
   uint32_t max_connections;
+  uint32_t reactors;
+  std::size_t stream_buffer_size;   //!< The bytes of a streamed response queued by a worker or buffered by a connection.
 };
 
 tws_mongoose_http_config tws_mongoose_read_config_file();
 
+//! A request being served by a worker thread.
+struct tws_mongoose_job
+{
+  uintptr_t conn_id;
+  std::unique_ptr<tws::mongoose::http_request> request;
+  tws::mongoose::http_response response;
+};
+
+//! The state shared by all reactors of a server.
+struct tws_mongoose_context
+{
+  tws_mongoose_http_config conf;
+  std::unique_ptr<tws::core::thread_pool> workers;
+  std::atomic<std::size_t> nconnections;
+  const std::atomic<bool>* stop;
+};
+
+/*!
+  \brief A reactor: a Mongoose manager with its own polling thread.
+
+  Only the polling thread touches the Mongoose manager and its connections:
+  workers run the service operations over a copy of the request, buffer the
+  response and hand it back through the completed queue. Streamed responses
+  are handed over through the ready streams queue as soon as they begin and
+  their chunks are moved to the connections whenever these drain.
+ */
+struct tws_mongoose_dispatcher
+{
+  typedef std::shared_ptr<tws::mongoose::response_stream> stream_ptr;
+
+  mg_mgr mgr;
+  tws_mongoose_context* ctx;
+  std::map<uintptr_t, mg_connection*> connections;
+  std::map<uintptr_t, stream_ptr> streams;
+  uintptr_t next_conn_id;
+  std::deque<tws_mongoose_job*> completed;
+  std::deque<std::pair<uintptr_t, stream_ptr> > ready_streams;
+  boost::mutex completed_mtx;
+
+  void dispatch(tws_mongoose_job* job);
+
+  void run(tws_mongoose_job* job);
+
+  void stream_ready(uintptr_t conn_id, const stream_ptr& stream);
+
+  void pump(uintptr_t conn_id);
+
+  void flush_completed();
+
+  void poll();
+};
+
+static void tws_mongoose_process(const tws::mongoose::http_request& request,
+                                 tws::mongoose::http_response& response);
+
+static void tws_mongoose_send_error(mg_connection* conn, int status,
+                                    const std::string& msg);
+
+static mg_connection* tws_mongoose_bind(mg_mgr* mgr, uint32_t port,
+                                        bool reuse_port);
+
 struct tws::mongoose::server::impl
 {
-  bool stop_;
+  std::atomic<bool> stop_;
+  std::size_t nreactors_;
+  std::size_t max_connections_;
 
   impl();
 
   ~impl();
 };
 
-tws::mongoose::server::impl::impl() : stop_(true) {}
+tws::mongoose::server::impl::impl() : stop_(true), nreactors_(0), max_connections_(0) {}
 tws::mongoose::server::impl::~impl() {}
 tws::mongoose::server::server() : pimpl_(nullptr) { pimpl_ = new impl; }
+
+tws::mongoose::server::server(std::size_t nreactors, std::size_t max_connections)
+  : pimpl_(nullptr)
+{
+  pimpl_ = new impl;
+  pimpl_->nreactors_ = nreactors;
+  pimpl_->max_connections_ = max_connections;
+}
+
 tws::mongoose::server::~server() { delete pimpl_; }
 void tws::mongoose::server::start()
 {
   pimpl_->stop_ = false;
 
-  struct mg_mgr server_;
-  struct mg_connection* conn_;
+  tws_mongoose_context ctx;
 
-  tws_mongoose_http_config conf = tws_mongoose_read_config_file();
+  ctx.conf = tws_mongoose_read_config_file();
+  ctx.nconnections = 0;
+  ctx.stop = &(pimpl_->stop_);
 
-  mg_mgr_init(&server_, NULL);
+  if(pimpl_->nreactors_ != 0)
+    ctx.conf.reactors = static_cast<uint32_t>(pimpl_->nreactors_);
 
-  conn_ = mg_bind(&server_,
-                  boost::lexical_cast<std::string>(conf.listening_port).c_str(),
-                  tws_mongoose_event_handler);
+  if(pimpl_->max_connections_ != 0)
+    ctx.conf.max_connections = static_cast<uint32_t>(pimpl_->max_connections_);
 
-  mg_set_protocol_http_websocket(conn_);
+#ifndef SO_REUSEPORT
+// without SO_REUSEPORT the kernel can not balance a port among many listeners
+  ctx.conf.reactors = 1;
+#endif
 
-  if(conf.max_threads > 1)
-    mg_enable_multithreading(conn_);\
+  if(ctx.conf.reactors == 0)
+    ctx.conf.reactors = std::max(boost::thread::hardware_concurrency(), 1u);
 
-  while(pimpl_->stop_ == false)
+// bind all the reactors before starting any of them
+  std::vector<std::unique_ptr<tws_mongoose_dispatcher> > reactors;
+
+  for(uint32_t i = 0; i != ctx.conf.reactors; ++i)
   {
-    mg_mgr_poll(&server_, 1000);
+    std::unique_ptr<tws_mongoose_dispatcher> reactor(new tws_mongoose_dispatcher);
+
+    reactor->ctx = &ctx;
+    reactor->next_conn_id = 0;
+
+    mg_mgr_init(&reactor->mgr, reactor.get());
+
+    mg_connection* conn = tws_mongoose_bind(&reactor->mgr, ctx.conf.listening_port,
+                                            ctx.conf.reactors > 1);
+
+    if(conn == nullptr)
+    {
+      mg_mgr_free(&reactor->mgr);
+
+      for(std::size_t j = 0; j != reactors.size(); ++j)
+        mg_mgr_free(&reactors[j]->mgr);
+
+      boost::format err_msg("could not bind web server to port: %1%.");
+
+      throw tws::mongoose::exception() << tws::error_description((err_msg % ctx.conf.listening_port).str());
+    }
+
+    mg_set_protocol_http_websocket(conn);
+
+    reactors.push_back(std::move(reactor));
   }
-  mg_mgr_free(&server_);
+
+// with a single thread the operations run straight in the polling threads
+  if(ctx.conf.max_threads > 1)
+    ctx.workers.reset(new tws::core::thread_pool(ctx.conf.max_threads,
+                                                 ctx.conf.max_connections));
+
+// the calling thread runs the first reactor
+  boost::thread_group reactor_threads;
+
+  for(std::size_t i = 1; i < reactors.size(); ++i)
+    reactor_threads.create_thread(boost::bind(&tws_mongoose_dispatcher::poll, reactors[i].get()));
+
+  reactors[0]->poll();
+
+  reactor_threads.join_all();
+
+  ctx.workers.reset();
 }
 
 void tws::mongoose::server::stop() { pimpl_->stop_ = true; }
+
+void tws_mongoose_dispatcher::dispatch(tws_mongoose_job* job)
+{
+  if(!ctx->workers)
+  {
+    run(job);
+    return;
+  }
+
+  if(!ctx->workers->try_submit(boost::bind(&tws_mongoose_dispatcher::run, this, job)))
+  {
+    job->response.set_error(503, "Error: server is too busy, try again later.");
+
+    boost::lock_guard<boost::mutex> lock(completed_mtx);
+
+    completed.push_back(job);
+  }
+}
+
+void tws_mongoose_dispatcher::run(tws_mongoose_job* job)
+{
+  tws_mongoose_process(*job->request, job->response);
+
+  {
+    boost::lock_guard<boost::mutex> lock(completed_mtx);
+
+    completed.push_back(job);
+  }
+
+// wake up the polling thread so the response doesn't wait for the poll timeout
+  if(ctx->workers)
+  {
+    char dummy = 0;
+
+    mg_broadcast(&mgr, tws_mongoose_wakeup_handler, &dummy, sizeof(dummy));
+  }
+}
+
+void tws_mongoose_dispatcher::stream_ready(uintptr_t conn_id, const stream_ptr& stream)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(completed_mtx);
+
+    ready_streams.push_back(std::make_pair(conn_id, stream));
+  }
+
+  if(ctx->workers)
+  {
+    char dummy = 0;
+
+    mg_broadcast(&mgr, tws_mongoose_wakeup_handler, &dummy, sizeof(dummy));
+  }
+}
+
+void tws_mongoose_dispatcher::pump(uintptr_t conn_id)
+{
+  std::map<uintptr_t, stream_ptr>::iterator it = streams.find(conn_id);
+
+  if(it == streams.end())
+    return;
+
+  std::map<uintptr_t, mg_connection*>::iterator iconn = connections.find(conn_id);
+
+  if(iconn == connections.end())
+  {
+    tws::mongoose::http_response::cancel(*(it->second));
+
+    streams.erase(it);
+
+    return;
+  }
+
+  if(tws::mongoose::http_response::pump(iconn->second, *(it->second), ctx->conf.stream_buffer_size))
+    streams.erase(it);
+}
+
+void tws_mongoose_dispatcher::flush_completed()
+{
+  std::deque<tws_mongoose_job*> jobs;
+
+  std::deque<std::pair<uintptr_t, stream_ptr> > ready;
+
+  {
+    boost::lock_guard<boost::mutex> lock(completed_mtx);
+
+    jobs.swap(completed);
+
+    ready.swap(ready_streams);
+  }
+
+// streams with new chunks: a stream is registered when it begins and stays until its body is sent
+  for(std::pair<uintptr_t, stream_ptr>& r : ready)
+  {
+    streams[r.first] = r.second;
+
+    pump(r.first);
+  }
+
+  for(tws_mongoose_job* job : jobs)
+  {
+// the client may have gone away while the request was being served
+    std::map<uintptr_t, mg_connection*>::iterator it = connections.find(job->conn_id);
+
+    if((it != connections.end()) && !job->response.streaming())
+      job->response.send(it->second);
+
+    delete job;
+  }
+}
+
+void tws_mongoose_dispatcher::poll()
+{
+  while(*(ctx->stop) == false)
+  {
+    mg_mgr_poll(&mgr, 1000);
+
+    flush_completed();
+  }
+
+// the queued requests are still served and workers may be blocked handing back a response: keep polling until they finish
+  if(ctx->workers)
+  {
+    ctx->workers->stop();
+
+    while(ctx->workers->busy())
+    {
+      mg_mgr_poll(&mgr, 10);
+
+      flush_completed();
+    }
+  }
+
+  connections.clear();
+
+  flush_completed();
+
+  for(std::pair<const uintptr_t, stream_ptr>& s : streams)
+    tws::mongoose::http_response::cancel(*s.second);
+
+  streams.clear();
+
+  mg_mgr_free(&mgr);
+}
+
 void tws_mongoose_event_handler(struct mg_connection* conn, int ev,
                                 void* ev_data)
 {
-  if(ev == MG_EV_HTTP_REQUEST)
+  tws_mongoose_dispatcher* dispatcher = static_cast<tws_mongoose_dispatcher*>(conn->mgr->user_data);
+
+  switch(ev)
   {
-    try
+    case MG_EV_ACCEPT:
     {
-      struct http_message* hm = (struct http_message*)ev_data;
+      if(++(dispatcher->ctx->nconnections) > dispatcher->ctx->conf.max_connections)
+      {
+        --(dispatcher->ctx->nconnections);
+
+        conn->user_data = nullptr;
 
-      tws::core::service_operation_handler_t& op =
-          tws::core::service_operations_manager::instance().get(
-              std::string(hm->uri.p, hm->uri.len));
+        tws_mongoose_send_error(conn, 503, "Error: too many connections, try again later.");
 
-      tws::mongoose::http_request sg_request(hm);
-      tws::mongoose::http_response sg_response(conn);
+        conn->flags |= MG_F_SEND_AND_CLOSE;
 
-      op(sg_request, sg_response);
+        return;
+      }
+
+      uintptr_t conn_id = ++(dispatcher->next_conn_id);
+
+      conn->user_data = reinterpret_cast<void*>(conn_id);
+
+      dispatcher->connections[conn_id] = conn;
     }
-    catch(const boost::exception& e)
+    break;
+
+    case MG_EV_SEND:
+// the connection has drained part of its send buffer: give it more of its streamed response
+      if(conn->user_data != nullptr)
+        dispatcher->pump(reinterpret_cast<uintptr_t>(conn->user_data));
+    break;
+
+    case MG_EV_CLOSE:
+      if(conn->user_data != nullptr)
+      {
+        dispatcher->connections.erase(reinterpret_cast<uintptr_t>(conn->user_data));
+
+// a worker may be blocked writing to a stream nobody will receive
+        dispatcher->pump(reinterpret_cast<uintptr_t>(conn->user_data));
+
+        --(dispatcher->ctx->nconnections);
+      }
+    break;
+
+    case MG_EV_HTTP_REQUEST:
     {
-      std::string err_msg = "Error: ";
+      if(conn->user_data == nullptr)
+        return;
+
+      std::unique_ptr<tws_mongoose_job> job(new tws_mongoose_job);
 
-      if(const std::string* d =
-             boost::get_error_info<tws::error_description>(e))
-        err_msg += *d;
-      else
-        err_msg += "unknown";
+      job->conn_id = reinterpret_cast<uintptr_t>(conn->user_data);
+      job->request.reset(new tws::mongoose::http_request(static_cast<struct http_message*>(ev_data)));
 
-      mg_send_head(conn, 400, err_msg.size(), "Content-Type: text/plain");
-      mg_send(conn, err_msg.c_str(), err_msg.size());
+// operations running in the polling thread can't wait for it to send their chunks
+      job->response.set_stream_notifier(boost::bind(&tws_mongoose_dispatcher::stream_ready, dispatcher, job->conn_id, _1),
+                                        dispatcher->ctx->workers ? dispatcher->ctx->conf.stream_buffer_size : 0);
+
+      dispatcher->dispatch(job.release());
+
+// a request served in the polling thread can be answered right away
+      if(!dispatcher->ctx->workers)
+        dispatcher->flush_completed();
     }
+    break;
+
+    default:
+    break;
+  }
+}
+
+void tws_mongoose_wakeup_handler(struct mg_connection* conn, int ev,
+                                 void* ev_data)
+{
+}
+
+void tws_mongoose_process(const tws::mongoose::http_request& request,
+                          tws::mongoose::http_response& response)
+{
+  try
+  {
+    tws::core::service_operation_handler_t& op =
+        tws::core::service_operations_manager::instance().get(request.base_uri());
+
+    op(request, response);
+
+    response.close();
+  }
+  catch(const boost::exception& e)
+  {
+    std::string err_msg = "Error: ";
+
+    if(const std::string* d =
+           boost::get_error_info<tws::error_description>(e))
+      err_msg += *d;
+    else
+      err_msg += "unknown";
+
+    response.set_error(400, err_msg);
+  }
+  catch(const std::exception& e)
+  {
+    std::string err_msg = "Error: ";
+
+    err_msg += e.what();
+
+    response.set_error(500, err_msg);
+  }
+}
+
+void tws_mongoose_send_error(mg_connection* conn, int status,
+                             const std::string& msg)
+{
+  mg_send_head(conn, status, msg.size(), "Content-Type: text/plain");
+  mg_send(conn, msg.c_str(), msg.size());
+}
+
+mg_connection* tws_mongoose_bind(mg_mgr* mgr, uint32_t port, bool reuse_port)
+{
+  if(!reuse_port)
+    return mg_bind(mgr, boost::lexical_cast<std::string>(port).c_str(),
+                   tws_mongoose_event_handler);
+
+#ifdef SO_REUSEPORT
+// Mongoose doesn't know about SO_REUSEPORT: open the listening socket ourselves
+  sock_t sock = socket(AF_INET, SOCK_STREAM, 0);
+
+  if(sock == INVALID_SOCKET)
+    return nullptr;
+
+  int on = 1;
+
+  struct sockaddr_in sa;
+
+  memset(&sa, 0, sizeof(sa));
+
+  sa.sin_family = AF_INET;
+  sa.sin_addr.s_addr = htonl(INADDR_ANY);
+  sa.sin_port = htons(static_cast<uint16_t>(port));
+
+  if(setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+     setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0 ||
+     bind(sock, reinterpret_cast<struct sockaddr*>(&sa), sizeof(sa)) != 0 ||
+     listen(sock, SOMAXCONN) != 0)
+  {
+    closesocket(sock);
+    return nullptr;
+  }
+
+  mg_connection* conn = mg_add_sock(mgr, sock, tws_mongoose_event_handler);
+
+  if(conn == nullptr)
+  {
+    closesocket(sock);
+    return nullptr;
   }
+
+  conn->flags |= MG_F_LISTENING;
+
+  return conn;
+#else
+  return nullptr;
+#endif
 }
 
 tws_mongoose_http_config tws_mongoose_read_config_file()
@@ -234,6 +650,42 @@ tws_mongoose_http_config tws_mongoose_read_config_file()
 
     result.max_connections = jmax_connections.GetUint();
 
+    result.reactors = 1;
+
+    result.stream_buffer_size = 1024 * 1024;
+
+    if(doc.HasMember("stream_buffer_size"))
+    {
+      const rapidjson::Value& jstream_buffer_size = doc["stream_buffer_size"];
+
+      if(!jstream_buffer_size.IsNumber() || jstream_buffer_size.IsNull() || (jstream_buffer_size.GetUint() == 0))
+      {
+        boost::format err_msg(
+            "error parsing input file '%1%': stream_buffer_size must be a positive number.");
+
+        throw tws::parse_error()
+            << tws::error_description((err_msg % input_file).str());
+      }
+
+      result.stream_buffer_size = jstream_buffer_size.GetUint();
+    }
+
+    if(doc.HasMember("reactors"))
+    {
+      const rapidjson::Value& jreactors = doc["reactors"];
+
+      if(!jreactors.IsNumber() || jreactors.IsNull())
+      {
+        boost::format err_msg(
+            "error parsing input file '%1%': reactors must be a number.");
+
+        throw tws::parse_error()
+            << tws::error_description((err_msg % input_file).str());
+      }
+
+      result.reactors = jreactors.GetUint();
+    }
+
     const rapidjson::Value& jlog_file = doc["log_file"];
 
     if(!jlog_file.IsString() || jlog_file.IsNull())
@@ -30,17 +30,32 @@
 // TWS
 #include "../core/http_server.hpp"
 
+// STL
+#include <cstddef>
+
 namespace tws
 {
   namespace mongoose
   {
 
+    //! An HTTP server built on top of Mongoose.
+    /*!
+      The server runs one or more reactors, each one a Mongoose manager polled
+      by its own thread. When more than one reactor is used they all listen
+      on the same port through SO_REUSEPORT and the kernel balances the
+      incoming connections among them. Service operations are executed by
+      a shared pool of worker threads.
+     */
     class server : public tws::core::http_server
     {
       public:
 
+        //! Use the number of reactors informed in the config file.
         server();
 
+        //! Override the number of reactors and of connections in the config file (0 keeps the configured value).
+        explicit server(std::size_t nreactors, std::size_t max_connections = 0);
+
         ~server();
 
         void start();
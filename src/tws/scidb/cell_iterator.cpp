@@ -26,10 +26,12 @@
  
 // TWS
 #include "cell_iterator.hpp"
+#include "chunk_decoder.hpp"
 
 // STL
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 class tws::scidb::cell_iterator::impl
@@ -42,58 +44,92 @@ class tws::scidb::cell_iterator::impl
 
     const ::scidb::Coordinates& get_position();
 
-    //std::string get_str(const std::size_t attr_pos) const;
+    std::string get_str(const std::size_t attr_pos) const;
 
-    //std::string get_str(const std::string& attr_name) const;
+    std::string get_str(const std::string& attr_name) const;
 
-//    double get_double(const std::size_t attr_pos) const;
+    double get_double(const std::size_t attr_pos) const;
 
-//    double get_double(const std::string& attr_name) const;
+    double get_double(const std::string& attr_name) const;
 
-//    int64_t get_int64(const std::size_t attr_pos) const;
+    float get_float(const std::size_t attr_pos) const;
 
-//    int64_t get_int64(const std::string& attr_name) const;
+    float get_float(const std::string& attr_name) const;
 
-//    uint64_t get_uint64(const std::size_t attr_pos) const;
+    int64_t get_int64(const std::size_t attr_pos) const;
 
-//    uint64_t get_uint64(const std::string& attr_name) const;
+    int64_t get_int64(const std::string& attr_name) const;
 
-//    uint32_t get_uint32(const std::size_t attr_pos) const;
+    uint64_t get_uint64(const std::size_t attr_pos) const;
 
-//    uint32_t get_uint32(const std::string& attr_name) const;
+    uint64_t get_uint64(const std::string& attr_name) const;
 
-//    int16_t get_int16(const std::size_t attr_pos) const;
+    int32_t get_int32(const std::size_t attr_pos) const;
 
-//    int16_t get_int16(const std::string& attr_name) const;
+    int32_t get_int32(const std::string& attr_name) const;
 
-//    uint16_t get_uint16(const std::size_t attr_pos) const;
+    uint32_t get_uint32(const std::size_t attr_pos) const;
 
-//    uint16_t get_uint16(const std::string& attr_name) const;
+    uint32_t get_uint32(const std::string& attr_name) const;
+
+    int16_t get_int16(const std::size_t attr_pos) const;
+
+    int16_t get_int16(const std::string& attr_name) const;
+
+    uint16_t get_uint16(const std::size_t attr_pos) const;
+
+    uint16_t get_uint16(const std::string& attr_name) const;
+
+    int8_t get_int8(const std::size_t attr_pos) const;
+
+    int8_t get_int8(const std::string& attr_name) const;
 
     uint8_t get_uint8(const std::size_t attr_pos) const;
 
     uint8_t get_uint8(const std::string& attr_name) const;
 
-//    bool get_bool(const std::size_t attr_pos) const;
+    bool get_bool(const std::size_t attr_pos) const;
+
+    bool get_bool(const std::string& attr_name) const;
+
+    const ::scidb::Value& get_value(const std::size_t attr_pos) const;
 
-//    bool get_bool(const std::string& attr_name) const;
+    std::size_t num_attributes() const;
 
-//    std::size_t num_attributes() const;
+    const std::string& attribute_name(const std::size_t pos) const;
 
-//    const std::string& attribute_name(const std::size_t pos) const;
+    const ::scidb::TypeId& attribute_type(const std::size_t pos) const;
 
     std::size_t attribute_pos(const std::string& name) const;
 
     void next();
 
+  private:
+
+    template<class T> T get(const std::size_t pos) const;
+
+    void load_chunks();
+
+    void next_chunk();
+
   private:
 
     std::shared_ptr< ::scidb::Array > array_;
     std::vector< std::shared_ptr< ::scidb::ConstArrayIterator > > attribute_iterators_;
     std::vector< std::shared_ptr< ::scidb::ConstChunkIterator > > chunks_iterators_;
     std::vector<std::string> attr_names_;
+    std::vector< ::scidb::TypeId> attr_types_;
+    std::vector<std::size_t> attr_sizes_;
     std::size_t num_attributes_;
     bool& at_end_;
+
+// when the current chunks of all attributes are dense their payloads are read directly
+    bool dense_;
+    dense_chunk_layout layout_;
+    std::vector<const char*> dense_data_;
+    std::size_t cell_;
+    ::scidb::Coordinates position_;
+    mutable std::vector< ::scidb::Value> dense_values_;
 };
 
 tws::scidb::cell_iterator::cell_iterator(const std::shared_ptr< ::scidb::Array >& a)
@@ -114,89 +150,125 @@ tws::scidb::cell_iterator::get_position()
   return pimpl_->get_position();
 }
 
-//std::string
-//tws::scidb::cell_iterator::get_str(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_str(attr_pos);
-//}
-
-//std::string
-//tws::scidb::cell_iterator::get_str(const std::string& attr_name) const
-//{
-//  return pimpl_->get_str(attr_name);
-//}
-
-//double
-//tws::scidb::cell_iterator::get_double(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_double(attr_pos);
-//}
-
-//double
-//tws::scidb::cell_iterator::get_double(const std::string& attr_name) const
-//{
-//  return pimpl_->get_double(attr_name);
-//}
-
-//int64_t
-//tws::scidb::cell_iterator::get_int64(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_int64(attr_pos);
-//}
-
-//int64_t
-//tws::scidb::cell_iterator::get_int64(const std::string& attr_name) const
-//{
-//  return pimpl_->get_int64(attr_name);
-//}
-
-//uint64_t
-//tws::scidb::cell_iterator::get_uint64(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_uint64(attr_pos);
-//}
-
-//uint64_t
-//tws::scidb::cell_iterator::get_uint64(const std::string& attr_name) const
-//{
-//  return pimpl_->get_uint64(attr_name);
-//}
-
-//uint32_t
-//tws::scidb::cell_iterator::get_uint32(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_uint32(attr_pos);
-//}
-
-//uint32_t
-//tws::scidb::cell_iterator::get_uint32(const std::string& attr_name) const
-//{
-//  return pimpl_->get_uint32(attr_name);
-//}
-
-//int16_t
-//tws::scidb::cell_iterator::get_int16(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_int16(attr_pos);
-//}
-
-//int16_t
-//tws::scidb::cell_iterator::get_int16(const std::string& attr_name) const
-//{
-//  return pimpl_->get_int16(attr_name);
-//}
-
-//uint16_t
-//tws::scidb::cell_iterator::get_uint16(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_uint16(attr_pos);
-//}
-
-//uint16_t
-//tws::scidb::cell_iterator::get_uint16(const std::string& attr_name) const
-//{
-//  return pimpl_->get_uint16(attr_name);
-//}
+std::string
+tws::scidb::cell_iterator::get_str(const std::size_t attr_pos) const
+{
+  return pimpl_->get_str(attr_pos);
+}
+
+std::string
+tws::scidb::cell_iterator::get_str(const std::string& attr_name) const
+{
+  return pimpl_->get_str(attr_name);
+}
+
+double
+tws::scidb::cell_iterator::get_double(const std::size_t attr_pos) const
+{
+  return pimpl_->get_double(attr_pos);
+}
+
+double
+tws::scidb::cell_iterator::get_double(const std::string& attr_name) const
+{
+  return pimpl_->get_double(attr_name);
+}
+
+float
+tws::scidb::cell_iterator::get_float(const std::size_t attr_pos) const
+{
+  return pimpl_->get_float(attr_pos);
+}
+
+float
+tws::scidb::cell_iterator::get_float(const std::string& attr_name) const
+{
+  return pimpl_->get_float(attr_name);
+}
+
+int64_t
+tws::scidb::cell_iterator::get_int64(const std::size_t attr_pos) const
+{
+  return pimpl_->get_int64(attr_pos);
+}
+
+int64_t
+tws::scidb::cell_iterator::get_int64(const std::string& attr_name) const
+{
+  return pimpl_->get_int64(attr_name);
+}
+
+uint64_t
+tws::scidb::cell_iterator::get_uint64(const std::size_t attr_pos) const
+{
+  return pimpl_->get_uint64(attr_pos);
+}
+
+uint64_t
+tws::scidb::cell_iterator::get_uint64(const std::string& attr_name) const
+{
+  return pimpl_->get_uint64(attr_name);
+}
+
+int32_t
+tws::scidb::cell_iterator::get_int32(const std::size_t attr_pos) const
+{
+  return pimpl_->get_int32(attr_pos);
+}
+
+int32_t
+tws::scidb::cell_iterator::get_int32(const std::string& attr_name) const
+{
+  return pimpl_->get_int32(attr_name);
+}
+
+uint32_t
+tws::scidb::cell_iterator::get_uint32(const std::size_t attr_pos) const
+{
+  return pimpl_->get_uint32(attr_pos);
+}
+
+uint32_t
+tws::scidb::cell_iterator::get_uint32(const std::string& attr_name) const
+{
+  return pimpl_->get_uint32(attr_name);
+}
+
+int16_t
+tws::scidb::cell_iterator::get_int16(const std::size_t attr_pos) const
+{
+  return pimpl_->get_int16(attr_pos);
+}
+
+int16_t
+tws::scidb::cell_iterator::get_int16(const std::string& attr_name) const
+{
+  return pimpl_->get_int16(attr_name);
+}
+
+uint16_t
+tws::scidb::cell_iterator::get_uint16(const std::size_t attr_pos) const
+{
+  return pimpl_->get_uint16(attr_pos);
+}
+
+uint16_t
+tws::scidb::cell_iterator::get_uint16(const std::string& attr_name) const
+{
+  return pimpl_->get_uint16(attr_name);
+}
+
+int8_t
+tws::scidb::cell_iterator::get_int8(const std::size_t attr_pos) const
+{
+  return pimpl_->get_int8(attr_pos);
+}
+
+int8_t
+tws::scidb::cell_iterator::get_int8(const std::string& attr_name) const
+{
+  return pimpl_->get_int8(attr_name);
+}
 
 uint8_t
 tws::scidb::cell_iterator::get_uint8(const std::size_t attr_pos) const
@@ -210,29 +282,41 @@ tws::scidb::cell_iterator::get_uint8(const std::string& attr_name) const
   return pimpl_->get_uint8(attr_name);
 }
 
-//bool
-//tws::scidb::cell_iterator::get_bool(const std::size_t attr_pos) const
-//{
-//  return pimpl_->get_bool(attr_pos);
-//}
+bool
+tws::scidb::cell_iterator::get_bool(const std::size_t attr_pos) const
+{
+  return pimpl_->get_bool(attr_pos);
+}
+
+bool
+tws::scidb::cell_iterator::get_bool(const std::string& attr_name) const
+{
+  return pimpl_->get_bool(attr_name);
+}
+
+const ::scidb::Value&
+tws::scidb::cell_iterator::get_value(const std::size_t attr_pos) const
+{
+  return pimpl_->get_value(attr_pos);
+}
 
-//bool
-//tws::scidb::cell_iterator::get_bool(const std::string& attr_name) const
-//{
-//  return pimpl_->get_bool(attr_name);
-//}
+std::size_t
+tws::scidb::cell_iterator::num_attributes() const
+{
+  return pimpl_->num_attributes();
+}
 
-//std::size_t
-//tws::scidb::cell_iterator::num_attributes() const
-//{
-//  return pimpl_->num_attributes();
-//}
+const std::string&
+tws::scidb::cell_iterator::attribute_name(const std::size_t pos) const
+{
+  return pimpl_->attribute_name(pos);
+}
 
-//const std::string&
-//tws::scidb::cell_iterator::attribute_name(const std::size_t pos) const
-//{
-//  return pimpl_->attribute_name(pos);
-//}
+const ::scidb::TypeId&
+tws::scidb::cell_iterator::attribute_type(const std::size_t pos) const
+{
+  return pimpl_->attribute_type(pos);
+}
 
 std::size_t
 tws::scidb::cell_iterator::attribute_pos(const std::string& name) const
@@ -257,7 +341,9 @@ inline
 tws::scidb::cell_iterator::impl::impl(const std::shared_ptr< ::scidb::Array >& a, bool& at_end)
   : array_(a),
     num_attributes_(0),
-    at_end_(at_end)
+    at_end_(at_end),
+    dense_(false),
+    cell_(0)
 {
   const ::scidb::ArrayDesc& description = array_->getArrayDesc();
 
@@ -267,30 +353,89 @@ tws::scidb::cell_iterator::impl::impl(const std::shared_ptr< ::scidb::Array >& a
   {
     attr_names_.push_back(att_description.getName());
 
+    attr_types_.push_back(att_description.getType());
+
+// booleans (bits) and strings (variable size) can not be read from a dense payload
+    bool fixed_size = (att_description.getType() != ::scidb::TID_BOOL) && (att_description.getType() != ::scidb::TID_STRING);
+
+    attr_sizes_.push_back(fixed_size ? att_description.getSize() : 0);
+
     std::shared_ptr< ::scidb::ConstArrayIterator > it = array_->getConstIterator(att_description.getId());
 
     attribute_iterators_.push_back(it);
 
     if(it->end())
-    {
       at_end_ = true;
+  }
 
-      chunks_iterators_.push_back(std::shared_ptr< ::scidb::ConstChunkIterator >());
-    }
-    else
-    {
-      const ::scidb::ConstChunk& chunk = it->getChunk();
+  num_attributes_ = attr_names_.size();
 
-      std::shared_ptr< ::scidb::ConstChunkIterator > cit = chunk.getConstIterator();
+  chunks_iterators_.resize(num_attributes_);
 
-      if(cit->end())
-        at_end_ = true;
+  dense_data_.resize(num_attributes_, nullptr);
 
-      chunks_iterators_.push_back(cit);
+  dense_values_.resize(num_attributes_);
+
+  if(!at_end_)
+    load_chunks();
+}
+
+inline void
+tws::scidb::cell_iterator::impl::load_chunks()
+{
+// check if the chunks of all attributes are dense and share the same box
+  dense_ = true;
+
+  for(std::size_t i = 0; i != num_attributes_; ++i)
+  {
+    const ::scidb::ConstChunk& chunk = attribute_iterators_[i]->getChunk();
+
+    dense_chunk_layout layout;
+
+    if(!is_dense(chunk, attr_sizes_[i], layout) ||
+       ((i != 0) && ((layout.first != layout_.first) || (layout.last != layout_.last))))
+    {
+      dense_ = false;
+      break;
     }
+
+    if(i == 0)
+      layout_ = layout;
+
+    dense_data_[i] = static_cast<const char*>(chunk.getData());
   }
 
-  num_attributes_ = attr_names_.size();
+  if(dense_)
+  {
+    cell_ = 0;
+
+    position_ = layout_.first;
+
+    return;
+  }
+
+  for(std::size_t i = 0; i != num_attributes_; ++i)
+  {
+    chunks_iterators_[i] = attribute_iterators_[i]->getChunk().getConstIterator();
+
+    if(chunks_iterators_[i]->end())
+      at_end_ = true;
+  }
+}
+
+inline void
+tws::scidb::cell_iterator::impl::next_chunk()
+{
+  for(std::size_t i = 0; i != num_attributes_; ++i)
+  {
+    ++(*attribute_iterators_[i]);
+
+    if(attribute_iterators_[i]->end())
+      at_end_ = true;
+  }
+
+  if(!at_end_)
+    load_chunks();
 }
 
 inline
@@ -301,113 +446,149 @@ tws::scidb::cell_iterator::impl::~impl()
 inline const ::scidb::Coordinates&
 tws::scidb::cell_iterator::impl::get_position()
 {
-  return chunks_iterators_[0]->getPosition();
-}
-
-//inline std::string
-//tws::scidb::cell_iterator::impl::get_str(const std::size_t attr_pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[attr_pos]->getItem();
-
-//  return v.getString();
-//}
-
-//inline std::string
-//tws::scidb::cell_iterator::impl::get_str(const std::string& attr_name) const
-//{
-//  return get_str(attribute_pos(attr_name));
-//}
-
-//inline double
-//tws::scidb::cell_iterator::impl::get_double(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-//  return v.getDouble();
-//}
-
-//inline double
-//tws::scidb::cell_iterator::impl::get_double(const std::string& attr_name) const
-//{
-//  return get_double(attribute_pos(attr_name));
-//}
-
-//inline int64_t
-//tws::scidb::cell_iterator::impl::get_int64(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-//  return v.getInt64();
-//}
-
-//inline int64_t
-//tws::scidb::cell_iterator::impl::get_int64(const std::string& attr_name) const
-//{
-//  return get_int64(attribute_pos(attr_name));
-//}
-
-//inline uint64_t
-//tws::scidb::cell_iterator::impl::get_uint64(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-//  return v.getUint64();
-//}
-
-//inline uint64_t
-//tws::scidb::cell_iterator::impl::get_uint64(const std::string& attr_name) const
-//{
-//  return get_uint64(attribute_pos(attr_name));
-//}
-
-//inline uint32_t
-//tws::scidb::cell_iterator::impl::get_uint32(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-//  return v.getUint32();
-//}
-
-//inline uint32_t
-//tws::scidb::cell_iterator::impl::get_uint32(const std::string& attr_name) const
-//{
-//  return get_uint32(attribute_pos(attr_name));
-//}
-
-//inline int16_t
-//tws::scidb::cell_iterator::impl::get_int16(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-//  return v.getInt16();
-//}
-
-//inline int16_t
-//tws::scidb::cell_iterator::impl::get_int16(const std::string& attr_name) const
-//{
-//  return get_int16(attribute_pos(attr_name));
-//}
-
-//inline uint16_t
-//tws::scidb::cell_iterator::impl::get_uint16(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-  
-//  return v.getUint16();
-//}
+  return dense_ ? position_ : chunks_iterators_[0]->getPosition();
+}
+
+template<class T> inline T
+tws::scidb::cell_iterator::impl::get(const std::size_t pos) const
+{
+  if(dense_)
+  {
+    T v;
+
+    std::memcpy(&v, dense_data_[pos] + cell_ * attr_sizes_[pos], sizeof(T));
+
+    return v;
+  }
+
+  return value_traits<T>::get(chunks_iterators_[pos]->getItem());
+}
+
+inline std::string
+tws::scidb::cell_iterator::impl::get_str(const std::size_t pos) const
+{
+// variable size values are never read from a dense payload
+  return std::string(chunks_iterators_[pos]->getItem().getString());
+}
 
-//inline uint16_t
-//tws::scidb::cell_iterator::impl::get_uint16(const std::string& attr_name) const
-//{
-//  return get_uint16(attribute_pos(attr_name));
-//}
+inline std::string
+tws::scidb::cell_iterator::impl::get_str(const std::string& attr_name) const
+{
+  return get_str(attribute_pos(attr_name));
+}
+
+inline double
+tws::scidb::cell_iterator::impl::get_double(const std::size_t pos) const
+{
+  return get<double>(pos);
+}
+
+inline double
+tws::scidb::cell_iterator::impl::get_double(const std::string& attr_name) const
+{
+  return get_double(attribute_pos(attr_name));
+}
+
+inline float
+tws::scidb::cell_iterator::impl::get_float(const std::size_t pos) const
+{
+  return get<float>(pos);
+}
+
+inline float
+tws::scidb::cell_iterator::impl::get_float(const std::string& attr_name) const
+{
+  return get_float(attribute_pos(attr_name));
+}
+
+inline int64_t
+tws::scidb::cell_iterator::impl::get_int64(const std::size_t pos) const
+{
+  return get<int64_t>(pos);
+}
+
+inline int64_t
+tws::scidb::cell_iterator::impl::get_int64(const std::string& attr_name) const
+{
+  return get_int64(attribute_pos(attr_name));
+}
+
+inline uint64_t
+tws::scidb::cell_iterator::impl::get_uint64(const std::size_t pos) const
+{
+  return get<uint64_t>(pos);
+}
+
+inline uint64_t
+tws::scidb::cell_iterator::impl::get_uint64(const std::string& attr_name) const
+{
+  return get_uint64(attribute_pos(attr_name));
+}
+
+inline int32_t
+tws::scidb::cell_iterator::impl::get_int32(const std::size_t pos) const
+{
+  return get<int32_t>(pos);
+}
+
+inline int32_t
+tws::scidb::cell_iterator::impl::get_int32(const std::string& attr_name) const
+{
+  return get_int32(attribute_pos(attr_name));
+}
+
+inline uint32_t
+tws::scidb::cell_iterator::impl::get_uint32(const std::size_t pos) const
+{
+  return get<uint32_t>(pos);
+}
+
+inline uint32_t
+tws::scidb::cell_iterator::impl::get_uint32(const std::string& attr_name) const
+{
+  return get_uint32(attribute_pos(attr_name));
+}
+
+inline int16_t
+tws::scidb::cell_iterator::impl::get_int16(const std::size_t pos) const
+{
+  return get<int16_t>(pos);
+}
+
+inline int16_t
+tws::scidb::cell_iterator::impl::get_int16(const std::string& attr_name) const
+{
+  return get_int16(attribute_pos(attr_name));
+}
+
+inline uint16_t
+tws::scidb::cell_iterator::impl::get_uint16(const std::size_t pos) const
+{
+  return get<uint16_t>(pos);
+}
+
+inline uint16_t
+tws::scidb::cell_iterator::impl::get_uint16(const std::string& attr_name) const
+{
+  return get_uint16(attribute_pos(attr_name));
+}
+
+inline int8_t
+tws::scidb::cell_iterator::impl::get_int8(const std::size_t pos) const
+{
+  return get<int8_t>(pos);
+}
+
+inline int8_t
+tws::scidb::cell_iterator::impl::get_int8(const std::string& attr_name) const
+{
+  return get_int8(attribute_pos(attr_name));
+}
 
 inline uint8_t
 tws::scidb::cell_iterator::impl::get_uint8(const std::size_t pos) const
 {
-  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
-
-  return v.getUint8();
+  return get<uint8_t>(pos);
 }
 
 inline uint8_t
@@ -416,31 +597,49 @@ tws::scidb::cell_iterator::impl::get_uint8(const std::string& attr_name) const
   return get_uint8(attribute_pos(attr_name));
 }
 
-//inline bool
-//tws::scidb::cell_iterator::impl::get_bool(const std::size_t pos) const
-//{
-//  const ::scidb::Value& v = chunks_iterators_[pos]->getItem();
+inline bool
+tws::scidb::cell_iterator::impl::get_bool(const std::size_t pos) const
+{
+// boolean values are stored as bits: they are never read from a dense payload
+  return chunks_iterators_[pos]->getItem().getBool();
+}
+
+inline bool
+tws::scidb::cell_iterator::impl::get_bool(const std::string& attr_name) const
+{
+  return get_bool(attribute_pos(attr_name));
+}
+
+inline const ::scidb::Value&
+tws::scidb::cell_iterator::impl::get_value(const std::size_t pos) const
+{
+  if(dense_)
+  {
+    dense_values_[pos].setData(dense_data_[pos] + cell_ * attr_sizes_[pos], attr_sizes_[pos]);
 
-//  return v.getBool();
-//}
+    return dense_values_[pos];
+  }
 
-//inline bool
-//tws::scidb::cell_iterator::impl::get_bool(const std::string& attr_name) const
-//{
-//  return get_bool(attribute_pos(attr_name));
-//}
+  return chunks_iterators_[pos]->getItem();
+}
 
-//inline std::size_t
-//tws::scidb::cell_iterator::impl::num_attributes() const
-//{
-//  return attr_names_.size();
-//}
+inline std::size_t
+tws::scidb::cell_iterator::impl::num_attributes() const
+{
+  return num_attributes_;
+}
+
+inline const std::string&
+tws::scidb::cell_iterator::impl::attribute_name(const std::size_t pos) const
+{
+  return attr_names_[pos];
+}
 
-//inline const std::string&
-//tws::scidb::cell_iterator::impl::attribute_name(const std::size_t pos) const
-//{
-//  return attr_names_[pos];
-//}
+inline const ::scidb::TypeId&
+tws::scidb::cell_iterator::impl::attribute_type(const std::size_t pos) const
+{
+  return attr_types_[pos];
+}
 
 inline std::size_t
 tws::scidb::cell_iterator::impl::attribute_pos(const std::string& name) const
@@ -451,27 +650,20 @@ tws::scidb::cell_iterator::impl::attribute_pos(const std::string& name) const
 inline void
 tws::scidb::cell_iterator::impl::next()
 {
-  for(std::size_t i = 0; i != num_attributes_; ++i)
+  if(dense_)
   {
-    ++(*chunks_iterators_[i]);
+    if(++cell_ == layout_.ncells)
+      next_chunk();
+    else
+      next_position(position_, layout_);
 
-    if(chunks_iterators_[i]->end())
-    {
-// is there more chunks?
-      ++(*attribute_iterators_[i]);
-
-      if(attribute_iterators_[i]->end())
-      {
-        at_end_ = true;
-      }
-      else
-      {
-        chunks_iterators_[i] = attribute_iterators_[i]->getChunk().getConstIterator();
-
-        if(chunks_iterators_[i]->end())
-          at_end_ = true;
-      }
-    }
+    return;
   }
-}
 
+  for(std::size_t i = 0; i != num_attributes_; ++i)
+    ++(*chunks_iterators_[i]);
+
+// all attributes have the same cells: their chunks end together
+  if(chunks_iterators_[0]->end())
+    next_chunk();
+}
@@ -31,6 +31,7 @@
 #include "config.hpp"
 
 // STL
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -60,46 +61,64 @@ namespace tws
         const ::scidb::Coordinates& get_position();
 
         //! Returns a string value for the attribute indicated by a given position.
-        //std::string get_str(const std::size_t attr_pos) const;
+        std::string get_str(const std::size_t attr_pos) const;
 
         //! Returns a string value for the attribute indicated by a given name.
-        //std::string get_str(const std::string& attr_name) const;
+        std::string get_str(const std::string& attr_name) const;
 
-        //! Returns a float value for the attribute indicated by a given position.
-        //double get_double(const std::size_t attr_pos) const;
+        //! Returns a double precision float value for the attribute indicated by a given position.
+        double get_double(const std::size_t attr_pos) const;
 
-        //! Returns a float value for the attribute indicated by a given name.
-        //double get_double(const std::string& attr_name) const;
+        //! Returns a double precision float value for the attribute indicated by a given name.
+        double get_double(const std::string& attr_name) const;
+
+        //! Returns a single precision float value for the attribute indicated by a given position.
+        float get_float(const std::size_t attr_pos) const;
+
+        //! Returns a single precision float value for the attribute indicated by a given name.
+        float get_float(const std::string& attr_name) const;
 
         //! Returns a 64-bit integer for the attribute indicated by a given position.
-        //int64_t get_int64(const std::size_t attr_pos) const;
+        int64_t get_int64(const std::size_t attr_pos) const;
 
         //! Returns a 64-bit integer for the attribute indicated by a given name.
-        //int64_t get_int64(const std::string& attr_name) const;
+        int64_t get_int64(const std::string& attr_name) const;
 
         //! Returns a 64-bit unsigned integer for the attribute indicated by a given position.
-        //uint64_t get_uint64(const std::size_t attr_pos) const;
+        uint64_t get_uint64(const std::size_t attr_pos) const;
 
         //! Returns a 64-bit unsigned integer for the attribute indicated by a given name.
-        //uint64_t get_uint64(const std::string& attr_name) const;
+        uint64_t get_uint64(const std::string& attr_name) const;
+
+        //! Returns a 32-bit integer for the attribute indicated by a given position.
+        int32_t get_int32(const std::size_t attr_pos) const;
+
+        //! Returns a 32-bit integer for the attribute indicated by a given name.
+        int32_t get_int32(const std::string& attr_name) const;
 
         //! Returns a 32-bit unsigned integer for the attribute indicated by a given position.
-        //uint32_t get_uint32(const std::size_t attr_pos) const;
+        uint32_t get_uint32(const std::size_t attr_pos) const;
 
         //! Returns a 32-bit unsigned integer for the attribute indicated by a given name.
-        //uint32_t get_uint32(const std::string& attr_name) const;
+        uint32_t get_uint32(const std::string& attr_name) const;
 
         //! Returns a 16-bit signed integer for the attribute indicated by a given position.
-        //int16_t get_int16(const std::size_t attr_pos) const;
+        int16_t get_int16(const std::size_t attr_pos) const;
 
         //! Returns a 16-bit signed integer for the attribute indicated by a given name.
-        //int16_t get_int16(const std::string& attr_name) const;
+        int16_t get_int16(const std::string& attr_name) const;
 
         //! Returns a 16-bit unsigned integer for the attribute indicated by a given position.
-        //uint16_t get_uint16(const std::size_t attr_pos) const;
+        uint16_t get_uint16(const std::size_t attr_pos) const;
 
         //! Returns a 16-bit unsigned integer for the attribute indicated by a given name.
-        //uint16_t get_uint16(const std::string& attr_name) const;
+        uint16_t get_uint16(const std::string& attr_name) const;
+
+        //! Returns a 8-bit signed integer for the attribute indicated by a given position.
+        int8_t get_int8(const std::size_t attr_pos) const;
+
+        //! Returns a 8-bit signed integer for the attribute indicated by a given name.
+        int8_t get_int8(const std::string& attr_name) const;
 
         //! Returns a 8-bit unsigned integer for the attribute indicated by a given position.
         uint8_t get_uint8(const std::size_t attr_pos) const;
@@ -108,16 +127,22 @@ namespace tws
         uint8_t get_uint8(const std::string& attr_name) const;
 
         //! Returns a boolean value for the attribute indicated by a given position.
-        //bool get_bool(const std::size_t attr_pos) const;
+        bool get_bool(const std::size_t attr_pos) const;
 
         //! Returns a boolean value for the attribute indicated by a given name.
-        //bool get_bool(const std::string& attr_name) const;
+        bool get_bool(const std::string& attr_name) const;
+
+        //! Returns the raw value for the attribute indicated by a given position.
+        const ::scidb::Value& get_value(const std::size_t attr_pos) const;
 
         //! Returns the number of cell attributes.
-        //std::size_t num_attributes() const;
+        std::size_t num_attributes() const;
 
         //! Returns the attribute name at position pos.
-        //const std::string& attribute_name(const std::size_t pos) const;
+        const std::string& attribute_name(const std::size_t pos) const;
+
+        //! Returns the datatype of the attribute at position pos.
+        const ::scidb::TypeId& attribute_type(const std::size_t pos) const;
 
         //! Returns the attribute position for a named attribute.
         std::size_t attribute_pos(const std::string& name) const;
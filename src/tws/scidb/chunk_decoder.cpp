@@ -0,0 +1,59 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/scidb/chunk_decoder.cpp
+
+  \brief Typed access to the cells of SciDB chunks.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "chunk_decoder.hpp"
+
+bool
+tws::scidb::is_dense(const ::scidb::ConstChunk& chunk,
+                     std::size_t value_size,
+                     dense_chunk_layout& layout)
+{
+  if((value_size == 0) || chunk.isRLE() || chunk.isSparse() || !chunk.isCountKnown())
+    return false;
+
+  layout.first = chunk.getFirstPosition(false);
+  layout.last = chunk.getLastPosition(false);
+
+// the payload of a chunk with overlaps also stores the cells of its neighbours
+  if((layout.first != chunk.getFirstPosition(true)) || (layout.last != chunk.getLastPosition(true)))
+    return false;
+
+  layout.ncells = 1;
+
+  for(std::size_t d = 0; d != layout.first.size(); ++d)
+  {
+    if(layout.last[d] < layout.first[d])
+      return false;
+
+    layout.ncells *= static_cast<std::size_t>(layout.last[d] - layout.first[d] + 1);
+  }
+
+// empty or null cells make the payload differ from a plain array of values
+  return (chunk.getData() != nullptr) &&
+         (chunk.count() == layout.ncells) &&
+         (chunk.getSize() == layout.ncells * value_size);
+}
@@ -0,0 +1,264 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/scidb/chunk_decoder.hpp
+
+  \brief Typed access to the cells of SciDB chunks.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_SCIDB_CHUNK_DECODER_HPP__
+#define __TWS_SCIDB_CHUNK_DECODER_HPP__
+
+// TWS
+#include "config.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// SciDB
+#include <SciDBAPI.h>
+
+namespace tws
+{
+  namespace scidb
+  {
+
+    //! Maps a C++ type to the ::scidb::Value getter of the same datatype.
+    template<class T> struct value_traits;
+
+    template<> struct value_traits<int8_t>
+    {
+      static int8_t get(const ::scidb::Value& v) { return v.getInt8(); }
+    };
+
+    template<> struct value_traits<uint8_t>
+    {
+      static uint8_t get(const ::scidb::Value& v) { return v.getUint8(); }
+    };
+
+    template<> struct value_traits<int16_t>
+    {
+      static int16_t get(const ::scidb::Value& v) { return v.getInt16(); }
+    };
+
+    template<> struct value_traits<uint16_t>
+    {
+      static uint16_t get(const ::scidb::Value& v) { return v.getUint16(); }
+    };
+
+    template<> struct value_traits<int32_t>
+    {
+      static int32_t get(const ::scidb::Value& v) { return v.getInt32(); }
+    };
+
+    template<> struct value_traits<uint32_t>
+    {
+      static uint32_t get(const ::scidb::Value& v) { return v.getUint32(); }
+    };
+
+    template<> struct value_traits<int64_t>
+    {
+      static int64_t get(const ::scidb::Value& v) { return v.getInt64(); }
+    };
+
+    template<> struct value_traits<uint64_t>
+    {
+      static uint64_t get(const ::scidb::Value& v) { return v.getUint64(); }
+    };
+
+    template<> struct value_traits<float>
+    {
+      static float get(const ::scidb::Value& v) { return v.getFloat(); }
+    };
+
+    template<> struct value_traits<double>
+    {
+      static double get(const ::scidb::Value& v) { return v.getDouble(); }
+    };
+
+    //! The box of cells stored in a dense chunk.
+    struct dense_chunk_layout
+    {
+      ::scidb::Coordinates first;   //!< Position of the first cell.
+      ::scidb::Coordinates last;    //!< Position of the last cell.
+      std::size_t ncells;           //!< Number of cells in the box.
+    };
+
+    /*!
+      \brief Tells if the payload of a chunk is a contiguous row-major array of fixed size values.
+
+      Only chunks that are neither RLE nor sparse, have no overlaps
+      and have a value for each cell of their box qualify.
+
+      \param chunk      The chunk to be checked.
+      \param value_size The size in bytes of the attribute values.
+      \param layout     Filled with the box of cells if the chunk is dense.
+     */
+    bool is_dense(const ::scidb::ConstChunk& chunk,
+                  std::size_t value_size,
+                  dense_chunk_layout& layout);
+
+    //! Move a position to the next cell in a box: the last dimension varies faster.
+    inline void next_position(::scidb::Coordinates& pos,
+                              const dense_chunk_layout& layout)
+    {
+      for(std::size_t d = pos.size(); d-- != 0;)
+      {
+        if(++pos[d] <= layout.last[d])
+          return;
+
+        pos[d] = layout.first[d];
+      }
+    }
+
+    /*!
+      \brief Call f(position, value) for each cell in a chunk, in the chunk iteration order.
+
+      Dense chunks are read straight from their payload as an array of T,
+      the cell positions being computed from the chunk box. The other chunks
+      are traversed cell by cell through a chunk iterator.
+
+      \tparam T The C++ type of the chunk attribute.
+     */
+    template<class T, class F> void
+    for_each_cell(const ::scidb::ConstChunk& chunk, F& f);
+
+    //! Call f(position, value) for each cell in all the chunks of an array attribute.
+    template<class T, class F> void
+    for_each_cell(::scidb::ConstArrayIterator& it, F& f);
+
+    /*!
+      \brief Call f(position, values, n) for each run of cells along the last dimension of a chunk.
+
+      The n values are those of the cells starting at position and moving along
+      the last dimension. Dense chunks are handed over in runs as long as their
+      box along that dimension, straight from their payload; the other chunks
+      one cell at a time.
+
+      \tparam T The C++ type of the chunk attribute.
+     */
+    template<class T, class F> void
+    for_each_run(const ::scidb::ConstChunk& chunk, F& f);
+
+    //! Call f(position, values, n) for each run of cells in all the chunks of an array attribute.
+    template<class T, class F> void
+    for_each_run(::scidb::ConstArrayIterator& it, F& f);
+
+  }  // end namespace scidb
+}    // end namespace tws
+
+template<class T, class F> inline void
+tws::scidb::for_each_cell(const ::scidb::ConstChunk& chunk, F& f)
+{
+  dense_chunk_layout layout;
+
+  if(is_dense(chunk, sizeof(T), layout))
+  {
+    const T* data = static_cast<const T*>(chunk.getData());
+
+    ::scidb::Coordinates pos(layout.first);
+
+    for(std::size_t i = 0; i != layout.ncells; ++i)
+    {
+      f(pos, data[i]);
+
+      next_position(pos, layout);
+    }
+
+    return;
+  }
+
+// sparse, RLE or partially filled chunks: one cell at a time
+  std::shared_ptr< ::scidb::ConstChunkIterator > cit = chunk.getConstIterator();
+
+  while(!cit->end())
+  {
+    f(cit->getPosition(), value_traits<T>::get(cit->getItem()));
+
+    ++(*cit);
+  }
+}
+
+template<class T, class F> inline void
+tws::scidb::for_each_cell(::scidb::ConstArrayIterator& it, F& f)
+{
+  while(!it.end())
+  {
+    for_each_cell<T>(it.getChunk(), f);
+
+    ++it;
+  }
+}
+
+template<class T, class F> inline void
+tws::scidb::for_each_run(const ::scidb::ConstChunk& chunk, F& f)
+{
+  dense_chunk_layout layout;
+
+  if(is_dense(chunk, sizeof(T), layout))
+  {
+    const T* data = static_cast<const T*>(chunk.getData());
+
+    const std::size_t d = layout.first.size() - 1;
+
+    const std::size_t run_size = static_cast<std::size_t>(layout.last[d] - layout.first[d] + 1);
+
+    ::scidb::Coordinates pos(layout.first);
+
+    for(std::size_t i = 0; i < layout.ncells; i += run_size)
+    {
+      f(pos, data + i, run_size);
+
+// skip to the start of the next run
+      pos[d] = layout.last[d];
+
+      next_position(pos, layout);
+    }
+
+    return;
+  }
+
+  std::shared_ptr< ::scidb::ConstChunkIterator > cit = chunk.getConstIterator();
+
+  while(!cit->end())
+  {
+    T v = value_traits<T>::get(cit->getItem());
+
+    f(cit->getPosition(), &v, 1);
+
+    ++(*cit);
+  }
+}
+
+template<class T, class F> inline void
+tws::scidb::for_each_run(::scidb::ConstArrayIterator& it, F& f)
+{
+  while(!it.end())
+  {
+    for_each_run<T>(it.getChunk(), f);
+
+    ++it;
+  }
+}
+
+#endif  // __TWS_SCIDB_CHUNK_DECODER_HPP__
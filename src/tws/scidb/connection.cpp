@@ -34,22 +34,39 @@
 
 tws::scidb::connection::~connection()
 {
-  connection_pool::instance().release(conn_);
+  connection_pool::instance().release(conn_, failed_);
 }
 
 boost::shared_ptr<scidb::QueryResult>
 tws::scidb::connection::execute(const std::string& query_str, const bool afl)
 {
-  return conn_->execute(query_str, afl);
+  try
+  {
+    return conn_->execute(query_str, afl);
+  }
+  catch(...)
+  {
+    failed_ = true;
+    throw;
+  }
 }
 
 void
 tws::scidb::connection::completed(::scidb::QueryID id)
 {
-  conn_->completed(id);
+  try
+  {
+    conn_->completed(id);
+  }
+  catch(...)
+  {
+    failed_ = true;
+    throw;
+  }
 }
 
 tws::scidb::connection::connection(pool_connection* conn_impl)
-  : conn_(conn_impl)
+  : conn_(conn_impl),
+    failed_(false)
 {
 }
@@ -75,6 +75,7 @@ namespace tws
       private:
 
         pool_connection* conn_;
+        bool failed_;                       //!< true if a call has failed: the pool must check the connection before reusing it.
 
       friend class connection_pool;
     };
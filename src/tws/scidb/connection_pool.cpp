@@ -28,41 +28,556 @@
 
 // TWS
 #include "connection_pool.hpp"
+#include "../core/utils.hpp"
 #include "connection.hpp"
+#include "exception.hpp"
 #include "pool_connection.hpp"
 
 // STL
+#include <cassert>
+#include <cstdint>
 #include <list>
+#include <random>
+#include <string>
+#include <vector>
 
 // Boost
+#include <boost/bind.hpp>
+#include <boost/chrono.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <boost/thread/locks.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+namespace tws
+{
+  namespace scidb
+  {
+
+    //! How a coordinator is chosen among the available ones.
+    enum class balancing_policy
+    {
+      least_outstanding,
+      power_of_two_choices
+    };
+
+    struct connection_pool_config
+    {
+      std::string instance_name;
+      std::vector<std::pair<std::string, uint16_t> > coordinators;
+      balancing_policy balancing;
+      std::size_t min_size;                               //!< Per coordinator.
+      std::size_t max_size;                               //!< Per coordinator.
+      boost::chrono::milliseconds acquire_timeout;
+      boost::chrono::milliseconds idle_timeout;
+      boost::chrono::milliseconds ping_interval;
+      boost::chrono::milliseconds ejection_time;
+    };
+
+    struct idle_connection
+    {
+      pool_connection* conn;
+      boost::chrono::steady_clock::time_point last_used;
+      bool failed;
+    };
+
+    //! The connections to a single coordinator.
+    struct coordinator_pool
+    {
+      std::string address;
+      uint16_t port;
+      std::list<idle_connection> idle;                    //!< The most recently released connections come first.
+      std::size_t nconnections;                           //!< Connections idle, in use or being opened.
+      std::size_t outstanding;                            //!< Connections in use or being opened.
+      boost::chrono::steady_clock::time_point ejected_until;
+    };
+
+  }  // end namespace scidb
+}    // end namespace tws
+
+static std::size_t
+tws_scidb_read_size(const rapidjson::Value& jpool, const char* key, std::size_t default_value)
+{
+  if(!jpool.HasMember(key))
+    return default_value;
+
+  const rapidjson::Value& jvalue = jpool[key];
+
+  if(!jvalue.IsUint() || jvalue.IsNull())
+  {
+    boost::format err_msg("scidb_connection_pool entry '%1%' must be a non-negative integer.");
+
+    throw tws::parse_error() << tws::error_description((err_msg % key).str());
+  }
+
+  return jvalue.GetUint();
+}
+
+static std::string
+tws_scidb_read_string(const rapidjson::Value& jpool, const char* key, const std::string& default_value)
+{
+  if(!jpool.HasMember(key))
+    return default_value;
+
+  const rapidjson::Value& jvalue = jpool[key];
+
+  if(!jvalue.IsString() || jvalue.IsNull())
+  {
+    boost::format err_msg("scidb_connection_pool entry '%1%' must be a string.");
+
+    throw tws::parse_error() << tws::error_description((err_msg % key).str());
+  }
+
+  return jvalue.GetString();
+}
+
+static tws::scidb::connection_pool_config
+tws_scidb_read_pool_config()
+{
+  tws::scidb::connection_pool_config conf;
+
+  conf.instance_name = "local-server";
+  conf.balancing = tws::scidb::balancing_policy::power_of_two_choices;
+  conf.min_size = 1;
+  conf.max_size = 16;
+  conf.acquire_timeout = boost::chrono::milliseconds(5000);
+  conf.idle_timeout = boost::chrono::milliseconds(300000);
+  conf.ping_interval = boost::chrono::milliseconds(30000);
+  conf.ejection_time = boost::chrono::milliseconds(30000);
+
+  std::string config_file = tws::core::find_in_app_path("share/tws/config/tws_app_server.json");
+
+  std::unique_ptr<rapidjson::Document> doc;
+
+  if(!config_file.empty())
+    doc.reset(tws::core::open_json_file(config_file));
+
+  if(!doc || !doc->HasMember("scidb_connection_pool"))
+  {
+    conf.coordinators.push_back(std::make_pair(std::string("localhost"), uint16_t(1239)));
+
+    return conf;
+  }
+
+  const rapidjson::Value& jpool = (*doc)["scidb_connection_pool"];
+
+  if(!jpool.IsObject())
+    throw tws::parse_error() << tws::error_description("scidb_connection_pool entry in 'tws_app_server.json' must be an object.");
+
+  conf.instance_name = tws_scidb_read_string(jpool, "instance_name", conf.instance_name);
+
+// a list of coordinators or the address of a single one
+  if(jpool.HasMember("coordinators"))
+  {
+    const rapidjson::Value& jcoordinators = jpool["coordinators"];
+
+    if(!jcoordinators.IsArray() || jcoordinators.Empty())
+      throw tws::parse_error() << tws::error_description("scidb_connection_pool entry 'coordinators' must be a non-empty array.");
+
+    for(rapidjson::SizeType i = 0; i != jcoordinators.Size(); ++i)
+    {
+      const rapidjson::Value& jcoordinator = jcoordinators[i];
+
+      if(!jcoordinator.IsObject())
+        throw tws::parse_error() << tws::error_description("each entry in scidb_connection_pool 'coordinators' must be an object.");
+
+      std::string address = tws_scidb_read_string(jcoordinator, "address", "localhost");
+
+      uint16_t port = static_cast<uint16_t>(tws_scidb_read_size(jcoordinator, "port", 1239));
+
+      conf.coordinators.push_back(std::make_pair(address, port));
+    }
+  }
+  else
+  {
+    std::string address = tws_scidb_read_string(jpool, "coordinator_address", "localhost");
+
+    uint16_t port = static_cast<uint16_t>(tws_scidb_read_size(jpool, "coordinator_port", 1239));
+
+    conf.coordinators.push_back(std::make_pair(address, port));
+  }
+
+  std::string balancing = tws_scidb_read_string(jpool, "balancing", "power_of_two_choices");
+
+  if(balancing == "least_outstanding")
+    conf.balancing = tws::scidb::balancing_policy::least_outstanding;
+  else if(balancing == "power_of_two_choices")
+    conf.balancing = tws::scidb::balancing_policy::power_of_two_choices;
+  else
+  {
+    boost::format err_msg("unknown scidb_connection_pool balancing policy: '%1%'.");
+
+    throw tws::parse_error() << tws::error_description((err_msg % balancing).str());
+  }
+
+  conf.min_size = tws_scidb_read_size(jpool, "min_size", conf.min_size);
+  conf.max_size = tws_scidb_read_size(jpool, "max_size", conf.max_size);
+  conf.acquire_timeout = boost::chrono::milliseconds(tws_scidb_read_size(jpool, "acquire_timeout_ms", conf.acquire_timeout.count()));
+  conf.idle_timeout = boost::chrono::milliseconds(tws_scidb_read_size(jpool, "idle_timeout_ms", conf.idle_timeout.count()));
+  conf.ping_interval = boost::chrono::milliseconds(tws_scidb_read_size(jpool, "ping_interval_ms", conf.ping_interval.count()));
+  conf.ejection_time = boost::chrono::milliseconds(tws_scidb_read_size(jpool, "ejection_time_ms", conf.ejection_time.count()));
+
+  if((conf.max_size == 0) || (conf.min_size > conf.max_size))
+    throw tws::parse_error() << tws::error_description("scidb_connection_pool must have 0 < max_size and min_size <= max_size.");
+
+  if(conf.ping_interval.count() == 0)
+    throw tws::parse_error() << tws::error_description("scidb_connection_pool ping_interval_ms must be greater than zero.");
+
+  return conf;
+}
+
+// close errors are not relevant for a connection being discarded
+static void
+tws_scidb_destroy(tws::scidb::pool_connection* conn)
+{
+  try
+  {
+    conn->close();
+  }
+  catch(...)
+  {
+  }
+
+  delete conn;
+}
 
 struct tws::scidb::connection_pool::impl
 {
-  std::list<pool_connection*> connections;
+  connection_pool_config conf;
+  std::vector<coordinator_pool> coordinators;
+  bool stopped;
+  std::minstd_rand rng;
   boost::mutex mtx;
+  boost::condition_variable available;
+  boost::condition_variable stop_requested;
+  boost::thread maintenance;
+
+  impl() : stopped(false) { }
+
+  pool_connection* open_connection(const coordinator_pool& c);
+
+  coordinator_pool& owner(const pool_connection* conn);
+
+  coordinator_pool* choose(boost::chrono::steady_clock::time_point now);
+
+  void eject(coordinator_pool& c);
+
+  void maintain();
 };
 
+tws::scidb::pool_connection*
+tws::scidb::connection_pool::impl::open_connection(const coordinator_pool& c)
+{
+  std::unique_ptr<pool_connection> conn(new pool_connection("id", conf.instance_name, c.address, c.port));
+
+  conn->open();
+
+  return conn.release();
+}
+
+tws::scidb::coordinator_pool&
+tws::scidb::connection_pool::impl::owner(const pool_connection* conn)
+{
+  for(coordinator_pool& c : coordinators)
+    if((c.port == conn->coordinator_port()) && (c.address == conn->coordinator_address()))
+      return c;
+
+  assert(false);
+
+  return coordinators.front();
+}
+
+tws::scidb::coordinator_pool*
+tws::scidb::connection_pool::impl::choose(boost::chrono::steady_clock::time_point now)
+{
+// the coordinators not ejected and able to hand out a connection right now are the candidates:
+// an ejected coordinator may still hand out its idle connections, they are checked before use
+  std::vector<coordinator_pool*> candidates;
+
+  std::vector<coordinator_pool*> ejected_candidates;
+
+  coordinator_pool* first_back = nullptr;  // the ejected coordinator whose ejection ends first
+
+  bool all_ejected = true;
+
+  for(coordinator_pool& c : coordinators)
+  {
+    if(c.ejected_until <= now)
+    {
+      all_ejected = false;
+
+      if(!c.idle.empty() || (c.nconnections < conf.max_size))
+        candidates.push_back(&c);
+
+      continue;
+    }
+
+    if(!c.idle.empty())
+      ejected_candidates.push_back(&c);
+    else if((c.nconnections < conf.max_size) && ((first_back == nullptr) || (c.ejected_until < first_back->ejected_until)))
+      first_back = &c;
+  }
+
+  if(candidates.empty())
+    candidates.swap(ejected_candidates);
+
+// when all of them are ejected one is tried anyway: it may be back before its ejection time
+  if(candidates.empty())
+    return all_ejected ? first_back : nullptr;
+
+  if(candidates.size() == 1)
+    return candidates.front();
+
+  if(conf.balancing == balancing_policy::power_of_two_choices)
+  {
+    std::uniform_int_distribution<std::size_t> dist(0, candidates.size() - 1);
+
+    std::size_t i = dist(rng);
+    std::size_t j = dist(rng);
+
+    if(i == j)
+      j = (j + 1) % candidates.size();
+
+    return (candidates[j]->outstanding < candidates[i]->outstanding) ? candidates[j] : candidates[i];
+  }
+
+  coordinator_pool* least = candidates.front();
+
+  for(coordinator_pool* c : candidates)
+    if(c->outstanding < least->outstanding)
+      least = c;
+
+  return least;
+}
+
+void
+tws::scidb::connection_pool::impl::eject(coordinator_pool& c)
+{
+  c.ejected_until = boost::chrono::steady_clock::now() + conf.ejection_time;
+}
+
+void
+tws::scidb::connection_pool::impl::maintain()
+{
+  boost::unique_lock<boost::mutex> lock(mtx);
+
+  while(!stopped)
+  {
+    stop_requested.wait_for(lock, conf.ping_interval);
+
+    if(stopped)
+      return;
+
+    for(coordinator_pool& c : coordinators)
+    {
+      boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
+
+// close the connections idle for too long, starting from the oldest ones
+      std::vector<pool_connection*> evicted;
+
+      while(!c.idle.empty() && (c.nconnections > conf.min_size) && (now - c.idle.back().last_used >= conf.idle_timeout))
+      {
+        evicted.push_back(c.idle.back().conn);
+
+        c.idle.pop_back();
+
+        --c.nconnections;
+      }
+
+// the remaining idle connections are taken out of the pool while they are checked
+      std::vector<idle_connection> checking(c.idle.begin(), c.idle.end());
+
+      c.idle.clear();
+
+// an ejected coordinator is only reconnected after its ejection time
+      std::size_t nmissing = 0;
+
+      if((c.ejected_until <= now) && (c.nconnections < conf.min_size))
+        nmissing = conf.min_size - c.nconnections;
+
+      c.nconnections += nmissing;
+
+      lock.unlock();
+
+      for(pool_connection* conn : evicted)
+        tws_scidb_destroy(conn);
+
+      std::vector<idle_connection> alive;
+
+      bool unreachable = false;
+
+      for(idle_connection& ic : checking)
+      {
+        if(!ic.conn->ping())
+        {
+          try
+          {
+            ic.conn->reconnect();
+          }
+          catch(...)
+          {
+            tws_scidb_destroy(ic.conn);
+
+            unreachable = true;
+
+            continue;
+          }
+        }
+
+        ic.failed = false;
+
+        alive.push_back(ic);
+      }
+
+      for(std::size_t i = 0; (i != nmissing) && !unreachable; ++i)
+      {
+        try
+        {
+          idle_connection ic = { open_connection(c), boost::chrono::steady_clock::now(), false };
+
+          alive.push_back(ic);
+        }
+        catch(...)
+        {
+// the coordinator is probably down: try again in the next round
+          unreachable = true;
+        }
+      }
+
+      lock.lock();
+
+      c.nconnections -= (checking.size() + nmissing) - alive.size();
+
+      c.idle.insert(c.idle.end(), alive.begin(), alive.end());
+
+      if(unreachable)
+        eject(c);
+
+      if(stopped)
+        return;
+    }
+
+    available.notify_all();
+  }
+}
+
 std::unique_ptr<tws::scidb::connection>
 tws::scidb::connection_pool::get()
 {
-  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+  boost::unique_lock<boost::mutex> lock(pimpl_->mtx);
+
+  boost::chrono::steady_clock::time_point deadline = boost::chrono::steady_clock::now() + pimpl_->conf.acquire_timeout;
+
+  std::size_t nfailures = 0;
 
-  if(pimpl_->connections.empty())
+  while(true)
   {
-    std::unique_ptr<pool_connection> pconn(new pool_connection("id", "local-server", "localhost", 1239));
+    boost::chrono::steady_clock::time_point now = boost::chrono::steady_clock::now();
 
-    pconn->open();
+    coordinator_pool* c = pimpl_->choose(now);
 
-    return std::unique_ptr<tws::scidb::connection>(new connection(pconn.release()));
-  }
+    if(c == nullptr)
+    {
+      if(pimpl_->available.wait_until(lock, deadline) == boost::cv_status::timeout)
+      {
+        boost::format err_msg("timeout waiting for a connection to SciDB: all the %1% connections per coordinator are in use.");
+
+        throw connection_error() << tws::error_description((err_msg % pimpl_->conf.max_size).str());
+      }
+
+      continue;
+    }
+
+    ++(c->outstanding);
+
+    const bool ejected = (c->ejected_until > now);
+
+// there is no idle connection: open a new one without holding the pool lock
+    if(c->idle.empty())
+    {
+      ++(c->nconnections);
 
-  pool_connection* conn = pimpl_->connections.front();
+      lock.unlock();
 
-  pimpl_->connections.pop_front();
+      try
+      {
+        std::unique_ptr<tws::scidb::connection> conn(new connection(pimpl_->open_connection(*c)));
 
-  return std::unique_ptr<tws::scidb::connection>(new connection(conn));
+// the coordinator is back
+        if(ejected)
+        {
+          lock.lock();
+
+          c->ejected_until = now;
+        }
+
+        return conn;
+      }
+      catch(...)
+      {
+        lock.lock();
+
+        --(c->nconnections);
+        --(c->outstanding);
+
+        pimpl_->eject(*c);
+
+        pimpl_->available.notify_all();
+
+        if(++nfailures == pimpl_->coordinators.size())
+          throw;
+
+// try the other coordinators
+        continue;
+      }
+    }
+
+    idle_connection ic = c->idle.front();
+
+    c->idle.pop_front();
+
+    lock.unlock();
+
+// a connection whose last use has failed or whose coordinator is ejected may have been broken by a SciDB restart
+    if((ic.failed || ejected) && !ic.conn->ping())
+    {
+      try
+      {
+        ic.conn->reconnect();
+      }
+      catch(...)
+      {
+        tws_scidb_destroy(ic.conn);
+
+        lock.lock();
+
+        --(c->nconnections);
+        --(c->outstanding);
+
+        pimpl_->eject(*c);
+
+        pimpl_->available.notify_all();
+
+        if(++nfailures == pimpl_->coordinators.size())
+          throw;
+
+        continue;
+      }
+    }
+
+    if(ejected)
+    {
+      lock.lock();
+
+      c->ejected_until = now;
+    }
+
+    return std::unique_ptr<tws::scidb::connection>(new connection(ic.conn));
+  }
 }
 
 tws::scidb::connection_pool&
@@ -74,21 +589,93 @@ tws::scidb::connection_pool::instance()
 }
 
 void
-tws::scidb::connection_pool::release(pool_connection* conn)
+tws::scidb::connection_pool::release(pool_connection* conn, bool failed)
 {
-  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    coordinator_pool& c = pimpl_->owner(conn);
+
+    --c.outstanding;
+
+    if(!pimpl_->stopped)
+    {
+      idle_connection ic = { conn, boost::chrono::steady_clock::now(), failed };
+
+      c.idle.push_front(ic);
 
-  pimpl_->connections.push_back(conn);
+      pimpl_->available.notify_one();
+
+      return;
+    }
+
+    --c.nconnections;
+  }
+
+  tws_scidb_destroy(conn);
 }
 
 tws::scidb::connection_pool::connection_pool()
   : pimpl_(nullptr)
 {
   pimpl_ = new impl;
+
+  pimpl_->conf = tws_scidb_read_pool_config();
+
+  pimpl_->rng.seed(static_cast<std::minstd_rand::result_type>(boost::chrono::steady_clock::now().time_since_epoch().count()));
+
+  for(const auto& address : pimpl_->conf.coordinators)
+  {
+    coordinator_pool c;
+
+    c.address = address.first;
+    c.port = address.second;
+    c.nconnections = 0;
+    c.outstanding = 0;
+
+    pimpl_->coordinators.push_back(c);
+  }
+
+// prewarm: unreachable coordinators are ejected and the maintenance thread tries them again later
+  for(coordinator_pool& c : pimpl_->coordinators)
+  {
+    for(std::size_t i = 0; i != pimpl_->conf.min_size; ++i)
+    {
+      try
+      {
+        idle_connection ic = { pimpl_->open_connection(c), boost::chrono::steady_clock::now(), false };
+
+        c.idle.push_back(ic);
+
+        ++c.nconnections;
+      }
+      catch(...)
+      {
+        pimpl_->eject(c);
+
+        break;
+      }
+    }
+  }
+
+  pimpl_->maintenance = boost::thread(boost::bind(&impl::maintain, pimpl_));
 }
 
 tws::scidb::connection_pool::~connection_pool()
 {
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    pimpl_->stopped = true;
+  }
+
+  pimpl_->stop_requested.notify_all();
+
+  pimpl_->maintenance.join();
+
+  for(coordinator_pool& c : pimpl_->coordinators)
+    for(idle_connection& ic : c.idle)
+      tws_scidb_destroy(ic.conn);
+
   delete pimpl_;
 }
-
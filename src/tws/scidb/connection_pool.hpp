@@ -46,18 +46,46 @@ namespace tws
     class connection;
     class pool_connection;
 
-    //! A connection pool for SciDB connections.
+    /*!
+      \brief A connection pool for SciDB connections.
+
+      The pool is configured by the scidb_connection_pool entry of
+      share/tws/config/tws_app_server.json. It keeps a sub-pool for each
+      coordinator listed there: at startup each one opens min_size connections
+      and it never keeps more than max_size connections.
+
+      Each request is served by the coordinator with fewer outstanding
+      queries, either among all of them or among two picked at random
+      (power of two choices). A coordinator that can not be reached is
+      ejected for a while: only its idle connections are handed out, after
+      a ping. If all coordinators are ejected the one whose ejection ends
+      first is tried anyway, so that a SciDB restart is noticed at the
+      next request.
+
+      A background thread pings the idle connections, reconnecting the
+      broken ones, closes those idle for too long and reopens connections
+      when a sub-pool falls below its minimum size.
+     */
     class connection_pool : public boost::noncopyable
     {
       public:
 
+        //! Take a connection from the pool, opening a new one if none is idle and the pool is not full.
+        /*!
+          \exception connection_error If a connection can not be established or if none is released within the acquire timeout.
+         */
         std::unique_ptr<connection> get();
 
+        //! Access the singleton.
+        /*!
+          \exception tws::parse_error If the pool entry of the config file is invalid.
+         */
         static connection_pool& instance();
 
       private:
 
-        void release(pool_connection* conn);
+        //! Give a connection back to the pool: a failed one is checked before its next use.
+        void release(pool_connection* conn, bool failed);
 
         connection_pool();
 
@@ -35,6 +35,7 @@
 #include <SciDBAPI.h>
 
 // STL
+#include <cstdint>
 #include <vector>
 
 namespace tws
@@ -55,6 +56,15 @@ namespace tws
       }
     };
 
+    template<>
+    struct get_value_selector<int8_t>
+    {
+      static int8_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_int8(pos);
+      }
+    };
+
     template<>
     struct get_value_selector<uint8_t>
     {
@@ -64,14 +74,119 @@ namespace tws
       }
     };
 
-//    template<>
-//    struct get_value_selector<uint16_t>
-//    {
-//      static uint16_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
-//      {
-//         return cit.get_uint16(pos);
-//      }
-//    };
+    template<>
+    struct get_value_selector<int16_t>
+    {
+      static int16_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_int16(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<uint16_t>
+    {
+      static uint16_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_uint16(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<int32_t>
+    {
+      static int32_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_int32(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<uint32_t>
+    {
+      static uint32_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_uint32(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<int64_t>
+    {
+      static int64_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_int64(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<uint64_t>
+    {
+      static uint64_t get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_uint64(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<float>
+    {
+      static float get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_float(pos);
+      }
+    };
+
+    template<>
+    struct get_value_selector<double>
+    {
+      static double get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+         return cit.get_double(pos);
+      }
+    };
+
+    //! Read a value of type S and convert it to T.
+    template<class S, class T>
+    struct convert_value
+    {
+      static T get(tws::scidb::cell_iterator& cit, std::size_t pos)
+      {
+        return static_cast<T>(get_value_selector<S>::get(cit, pos));
+      }
+    };
+
+    /*!
+      \brief Returns the function that reads an attribute of a given SciDB datatype as a T value.
+
+      \exception tws::conversion_error If the datatype is not a numeric one.
+     */
+    template<class T>
+    T (*value_converter(const ::scidb::TypeId& id))(tws::scidb::cell_iterator&, std::size_t)
+    {
+      if(id == ::scidb::TID_INT8)
+        return &convert_value<int8_t, T>::get;
+      else if(id == ::scidb::TID_UINT8)
+        return &convert_value<uint8_t, T>::get;
+      else if(id == ::scidb::TID_INT16)
+        return &convert_value<int16_t, T>::get;
+      else if(id == ::scidb::TID_UINT16)
+        return &convert_value<uint16_t, T>::get;
+      else if(id == ::scidb::TID_INT32)
+        return &convert_value<int32_t, T>::get;
+      else if(id == ::scidb::TID_UINT32)
+        return &convert_value<uint32_t, T>::get;
+      else if(id == ::scidb::TID_INT64)
+        return &convert_value<int64_t, T>::get;
+      else if(id == ::scidb::TID_UINT64)
+        return &convert_value<uint64_t, T>::get;
+      else if(id == ::scidb::TID_FLOAT)
+        return &convert_value<float, T>::get;
+      else if(id == ::scidb::TID_DOUBLE)
+        return &convert_value<double, T>::get;
+
+      throw tws::conversion_error() << tws::error_description("array2d can not be filled: attribute data type not supported.");
+    }
 
     template<class T> struct array2d
     {
@@ -79,6 +194,7 @@ namespace tws
       int64_t last_col_idx;
       int64_t first_row_idx;
       int64_t last_row_idx;
+      int64_t step;
       std::size_t width;
       std::size_t height;
       std::size_t size;
@@ -87,11 +203,13 @@ namespace tws
 
       array2d(int64_t first_col, int64_t last_col,
               int64_t first_row, int64_t last_row,
-              std::size_t nattrs)
+              std::size_t nattrs,
+              int64_t sampling_step = 1)
         : first_col_idx(first_col), last_col_idx(last_col),
           first_row_idx(first_row), last_row_idx(last_row),
-          width(last_col - first_col + 1),
-          height(last_row - first_row + 1),
+          step(sampling_step),
+          width((last_col - first_col) / sampling_step + 1),
+          height((last_row - first_row) / sampling_step + 1),
           size(width * height),
           num_attributes(nattrs)
       {
@@ -105,23 +223,40 @@ namespace tws
           delete [] (attribute_data[i]);
       }
 
+      //! Fill the array with the cells of an iterator whose attributes may have any numeric datatype.
+      /*!
+        When the array samples the cells at a step greater than one, only the cells
+        lying on the sampling lattice are kept.
+
+        \exception tws::conversion_error If an attribute datatype is not a numeric one.
+       */
       void fill(tws::scidb::cell_iterator& cit)
       {
+        typedef T (*converter_t)(tws::scidb::cell_iterator&, std::size_t);
+
+// the conversion from each attribute datatype is resolved once, not for each cell
+        std::vector<converter_t> converters;
+
+        for(std::size_t i = 0; i != num_attributes; ++i)
+          converters.push_back(value_converter<T>(cit.attribute_type(i)));
+
         while(!cit.end())
         {
           const ::scidb::Coordinates& coords = cit.get_position();
 
-          int col = coords[0] - first_col_idx;
-          int row = coords[1] - first_row_idx;
+          int64_t col = coords[0] - first_col_idx;
+          int64_t row = coords[1] - first_row_idx;
 
-          for(std::size_t i = 0; i != num_attributes; ++i)
+          if((col % step != 0) || (row % step != 0))
           {
-            T v = get_value_selector<T>::get(cit, i);
+            ++cit;
+            continue;
+          }
 
-            std::size_t pos = width * row + col;
+          std::size_t pos = width * (row / step) + (col / step);
 
-            attribute_data[i][pos] = v;
-          }
+          for(std::size_t i = 0; i != num_attributes; ++i)
+            attribute_data[i][pos] = converters[i](cit, i);
 
           ++cit;
         }
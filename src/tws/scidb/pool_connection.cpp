@@ -136,6 +136,42 @@ tws::scidb::pool_connection::close()
   }
 }
 
+void
+tws::scidb::pool_connection::reconnect()
+{
+// a broken handle may fail to disconnect: it is dropped anyway
+  try
+  {
+    close();
+  }
+  catch(...)
+  {
+    handle_ = nullptr;
+  }
+
+  open();
+}
+
+bool
+tws::scidb::pool_connection::ping()
+{
+  if(handle_ == nullptr)
+    return false;
+
+  try
+  {
+    boost::shared_ptr< ::scidb::QueryResult > qresult = execute("build(<v:int8>[i=0:0,1,0], 0)", true);
+
+    completed(qresult->queryID);
+  }
+  catch(...)
+  {
+    return false;
+  }
+
+  return true;
+}
+
 bool
 tws::scidb::pool_connection::is_open() const
 {
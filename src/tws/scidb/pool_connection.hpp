@@ -92,6 +92,15 @@ namespace tws
          */
         void close();
 
+        //! Discard the current connection handle, even if it is broken, and open a new one.
+        /*!
+          \exception connection_error It throws an exception if the connection can not be established.
+         */
+        void reconnect();
+
+        //! Run a trivial query to check if the connection is still alive.
+        bool ping();
+
         //! Returns true if the connection is opened.
         bool is_open() const;
 
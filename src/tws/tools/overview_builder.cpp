@@ -0,0 +1,247 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/tools/overview_builder.cpp
+
+  \brief Materializes the missing overviews listed in share/tws/config/overviews.json.
+
+  Each overview array is created by sampling every factor-th cell of its
+  source array along the spatial dimensions, keeping the datatypes and the
+  missing values of the source attributes. Overviews already stored in the
+  database are left untouched.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "../core/utils.hpp"
+#include "../geoarray/data_types.hpp"
+#include "../geoarray/geoarray_manager.hpp"
+#include "../scidb/cell_iterator.hpp"
+#include "../scidb/connection.hpp"
+#include "../scidb/connection_pool.hpp"
+
+// STL
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/format.hpp>
+#include <boost/program_options.hpp>
+
+// SciDB
+#include <SciDBAPI.h>
+
+static std::string tws_scidb_type_name(int dt)
+{
+  switch(dt)
+  {
+    case tws::geoarray::datatype_t::int8_dt: return "int8";
+    case tws::geoarray::datatype_t::uint8_dt: return "uint8";
+    case tws::geoarray::datatype_t::int16_dt: return "int16";
+    case tws::geoarray::datatype_t::uint16_dt: return "uint16";
+    case tws::geoarray::datatype_t::int32_dt: return "int32";
+    case tws::geoarray::datatype_t::uint32_dt: return "uint32";
+    case tws::geoarray::datatype_t::int64_dt: return "int64";
+    case tws::geoarray::datatype_t::uint64_dt: return "uint64";
+    case tws::geoarray::datatype_t::float_dt: return "float";
+    case tws::geoarray::datatype_t::double_dt: return "double";
+    default:
+      throw tws::conversion_error() << tws::error_description("overview attributes must have a numeric datatype.");
+  }
+}
+
+// the schema of an overview array, with the spatial dimensions optionally renamed
+static std::string tws_overview_schema(const tws::geoarray::geoarray_t& ov,
+                                       const std::string& col_name,
+                                       const std::string& row_name,
+                                       int64_t spatial_chunk,
+                                       int64_t time_chunk)
+{
+  std::string schema = "<";
+
+  for(std::size_t i = 0; i != ov.attributes.size(); ++i)
+  {
+    if(i != 0)
+      schema += ", ";
+
+    schema += ov.attributes[i].name + ":" + tws_scidb_type_name(ov.attributes[i].datatype);
+  }
+
+  const tws::geoarray::dimension_t& col_dim = ov.dimensions[0];
+  const tws::geoarray::dimension_t& row_dim = ov.dimensions[1];
+  const tws::geoarray::dimension_t& time_dim = ov.dimensions[2];
+
+  schema += ">[" + col_name + "=" + std::to_string(col_dim.min_idx) + ":" + std::to_string(col_dim.max_idx) + "," + std::to_string(spatial_chunk) + ",0, "
+          + row_name + "=" + std::to_string(row_dim.min_idx) + ":" + std::to_string(row_dim.max_idx) + "," + std::to_string(spatial_chunk) + ",0, "
+          + time_dim.name + "=" + std::to_string(time_dim.min_idx) + ":" + std::to_string(time_dim.max_idx) + "," + std::to_string(time_chunk) + ",0]";
+
+  return schema;
+}
+
+/*
+  The overview cell (c, r, t) receives the source cell (col_min + c * factor, row_min + r * factor, t):
+  the sampled cells get their overview indices as new attributes, are redimensioned along them and
+  finally the dimensions get back the names of the source ones.
+ */
+static std::string tws_overview_query(const tws::geoarray::geoarray_t& source,
+                                      const tws::geoarray::overview_t& ov,
+                                      int64_t spatial_chunk,
+                                      int64_t time_chunk)
+{
+  const tws::geoarray::dimension_t& col_dim = source.dimensions[0];
+  const tws::geoarray::dimension_t& row_dim = source.dimensions[1];
+
+  std::string factor = std::to_string(ov.factor);
+  std::string col_offset = "(" + col_dim.name + " - " + std::to_string(col_dim.min_idx) + ")";
+  std::string row_offset = "(" + row_dim.name + " - " + std::to_string(row_dim.min_idx) + ")";
+
+  std::string sampled = "filter(" + source.name + ", "
+                      + col_offset + " % " + factor + " = 0 and " + row_offset + " % " + factor + " = 0)";
+
+  std::string indexed = "apply(" + sampled + ", ov_col, " + col_offset + " / " + factor + ", ov_row, " + row_offset + " / " + factor + ")";
+
+  std::string redimensioned = "redimension(" + indexed + ", "
+                            + tws_overview_schema(ov.array, "ov_col", "ov_row", spatial_chunk, time_chunk) + ")";
+
+  return "store(cast(" + redimensioned + ", "
+         + tws_overview_schema(ov.array, col_dim.name, row_dim.name, spatial_chunk, time_chunk) + "), "
+         + ov.array.name + ")";
+}
+
+static std::set<std::string> tws_list_arrays(tws::scidb::connection& conn)
+{
+  std::set<std::string> arrays;
+
+  boost::shared_ptr< ::scidb::QueryResult > qresult = conn.execute("project(list('arrays'), name)", true);
+
+  if((qresult == nullptr) || (qresult->array == nullptr))
+    return arrays;
+
+  tws::scidb::cell_iterator it(qresult->array);
+
+  while(!it.end())
+  {
+    arrays.insert(it.get_str(0));
+
+    ++it;
+  }
+
+  conn.completed(qresult->queryID);
+
+  return arrays;
+}
+
+int main(int argc, char* argv[])
+{
+  std::string array_name;
+  int64_t spatial_chunk = 0;
+  int64_t time_chunk = 0;
+
+  boost::program_options::options_description options("Options");
+
+  options.add_options()
+    ("help", "show this help message")
+    ("array", boost::program_options::value<std::string>(&array_name), "build only the overviews of this array")
+    ("spatial-chunk", boost::program_options::value<int64_t>(&spatial_chunk)->default_value(256), "chunk interval of the overview spatial dimensions")
+    ("time-chunk", boost::program_options::value<int64_t>(&time_chunk)->default_value(32), "chunk interval of the overview time dimension")
+    ("dry-run", "only print the queries that would be executed");
+
+  boost::program_options::variables_map vm;
+
+  try
+  {
+    boost::program_options::store(boost::program_options::parse_command_line(argc, argv, options), vm);
+
+    boost::program_options::notify(vm);
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << std::endl << options << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  if(vm.count("help"))
+  {
+    std::cout << options << std::endl;
+
+    return EXIT_SUCCESS;
+  }
+
+  bool dry_run = (vm.count("dry-run") != 0);
+
+  try
+  {
+    tws::geoarray::geoarray_manager& gmanager = tws::geoarray::geoarray_manager::instance();
+
+    std::vector<std::string> arrays = array_name.empty() ? gmanager.list_arrays() : std::vector<std::string>(1, array_name);
+
+    std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
+
+    std::set<std::string> stored_arrays = tws_list_arrays(*conn);
+
+    for(const std::string& name : arrays)
+    {
+      const tws::geoarray::geoarray_t& source = gmanager.get(name);
+
+      for(const tws::geoarray::overview_t& ov : gmanager.overviews(name))
+      {
+        if(stored_arrays.count(ov.array.name) != 0)
+        {
+          std::cout << ov.array.name << ": already stored." << std::endl;
+          continue;
+        }
+
+        std::string str_afl = tws_overview_query(source, ov, spatial_chunk, time_chunk);
+
+        std::cout << ov.array.name << ": " << str_afl << std::endl;
+
+        if(dry_run)
+          continue;
+
+        boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_afl, true);
+
+        if(qresult != nullptr)
+          conn->completed(qresult->queryID);
+      }
+    }
+  }
+  catch(const boost::exception& e)
+  {
+    if(const std::string* d = boost::get_error_info<tws::error_description>(e))
+      std::cerr << "the following error has occurred: " << *d << std::endl;
+    else
+      std::cerr << "an unknown error has occurred." << std::endl;
+
+    return EXIT_FAILURE;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << "the following error has occurred: " << e.what() << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -101,6 +101,13 @@ namespace tws
       bounded_by_t bounded_by;
     };
 
+    //! Settings of the GetCoverage operation.
+    struct get_coverage_options_t
+    {
+      uint32_t tile_size;             //!< The width and height of the GeoTIFF tiles: a multiple of 16.
+      std::size_t max_buffer_size;    //!< The maximum size in bytes of a row of tiles of all bands, the largest block kept in memory.
+    };
+
     //! Struct for handling describe coverage metadata in WCS xml response
     struct describe_coverage_t
     {
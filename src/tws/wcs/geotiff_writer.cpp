@@ -0,0 +1,385 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wcs/geotiff_writer.cpp
+
+  \brief A writer of tiled GeoTIFF files that emits the file bytes in order, as soon as each row of tiles is available.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "geotiff_writer.hpp"
+#include "../geoarray/data_types.hpp"
+#include "exception.hpp"
+
+// STL
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// Boost
+#include <boost/format.hpp>
+
+namespace tws
+{
+  namespace wcs
+  {
+    //! An entry of a TIFF image file directory, with its values already encoded.
+    struct tiff_entry
+    {
+      uint16_t tag;
+      uint16_t type;
+      uint64_t count;
+      std::string values;
+    };
+
+    //! The TIFF field types used by the writer.
+    struct tiff_type_t
+    {
+      enum
+      {
+        ascii = 2,
+        short_ = 3,
+        long_ = 4,
+        double_ = 12,
+        long8 = 16
+      };
+    };
+
+  } // end namespace wcs
+}   // end namespace tws
+
+template<class T> static void
+tws_wcs_append(std::string& buffer, T value)
+{
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<class T> static tws::wcs::tiff_entry
+tws_wcs_tiff_entry(uint16_t tag, uint16_t type, const std::vector<T>& values)
+{
+  tws::wcs::tiff_entry entry = { tag, type, values.size(), std::string() };
+
+  for(T v : values)
+    tws_wcs_append(entry.values, v);
+
+  return entry;
+}
+
+static tws::wcs::tiff_entry
+tws_wcs_tiff_entry(uint16_t tag, const std::string& text)
+{
+  tws::wcs::tiff_entry entry = { tag, tws::wcs::tiff_type_t::ascii, text.size() + 1, text };
+
+  entry.values.push_back('\0');
+
+  return entry;
+}
+
+// the offset of the first tile, past the header, the image file directory and the values that do not fit in it
+static uint64_t
+tws_wcs_tiff_data_offset(const std::vector<tws::wcs::tiff_entry>& entries, bool big_tiff)
+{
+  const std::size_t inline_size = big_tiff ? 8 : 4;
+
+  uint64_t offset = big_tiff ? (16 + 8 + entries.size() * 20 + 8) : (8 + 2 + entries.size() * 12 + 4);
+
+  for(const tws::wcs::tiff_entry& entry : entries)
+    if(entry.values.size() > inline_size)
+      offset += entry.values.size() + (entry.values.size() & 1);
+
+  return (offset + 15) & ~static_cast<uint64_t>(15);
+}
+
+// write the header, the image file directory and the values that do not fit in it
+static std::string
+tws_wcs_tiff_header(const std::vector<tws::wcs::tiff_entry>& entries, bool big_tiff)
+{
+  const uint16_t byte_order_test = 1;
+
+  const bool little_endian = *reinterpret_cast<const uint8_t*>(&byte_order_test) == 1;
+
+  const std::size_t inline_size = big_tiff ? 8 : 4;
+
+  std::string header(little_endian ? "II" : "MM");
+
+  std::string values;
+
+  uint64_t values_offset;
+
+  if(big_tiff)
+  {
+    tws_wcs_append<uint16_t>(header, 43);
+    tws_wcs_append<uint16_t>(header, 8);
+    tws_wcs_append<uint16_t>(header, 0);
+    tws_wcs_append<uint64_t>(header, 16);
+    tws_wcs_append<uint64_t>(header, entries.size());
+
+    values_offset = 16 + 8 + entries.size() * 20 + 8;
+  }
+  else
+  {
+    tws_wcs_append<uint16_t>(header, 42);
+    tws_wcs_append<uint32_t>(header, 8);
+    tws_wcs_append<uint16_t>(header, static_cast<uint16_t>(entries.size()));
+
+    values_offset = 8 + 2 + entries.size() * 12 + 4;
+  }
+
+  for(const tws::wcs::tiff_entry& entry : entries)
+  {
+    tws_wcs_append<uint16_t>(header, entry.tag);
+    tws_wcs_append<uint16_t>(header, entry.type);
+
+    if(big_tiff)
+      tws_wcs_append<uint64_t>(header, entry.count);
+    else
+      tws_wcs_append<uint32_t>(header, static_cast<uint32_t>(entry.count));
+
+// small values are stored in the entry itself, left-justified
+    if(entry.values.size() <= inline_size)
+    {
+      header.append(entry.values);
+      header.append(inline_size - entry.values.size(), '\0');
+      continue;
+    }
+
+    if(big_tiff)
+      tws_wcs_append<uint64_t>(header, values_offset + values.size());
+    else
+      tws_wcs_append<uint32_t>(header, static_cast<uint32_t>(values_offset + values.size()));
+
+    values.append(entry.values);
+
+    if(entry.values.size() & 1)
+      values.push_back('\0');
+  }
+
+// no more image file directories
+  header.append(inline_size, '\0');
+
+  header.append(values);
+
+  header.append(tws_wcs_tiff_data_offset(entries, big_tiff) - header.size(), '\0');
+
+  return header;
+}
+
+tws::wcs::geotiff_writer::geotiff_writer(uint32_t width,
+                                         uint32_t height,
+                                         uint32_t nbands,
+                                         int datatype,
+                                         uint32_t tile_size,
+                                         const geotiff_georef_t& georef,
+                                         double nodata,
+                                         const output_t& output)
+  : width_(width),
+    height_(height),
+    nbands_(nbands),
+    datatype_(datatype),
+    tile_size_(tile_size),
+    tile_cols_(0),
+    tile_rows_(0),
+    next_tile_row_(0),
+    sample_size_(0),
+    big_tiff_(false),
+    data_offset_(0),
+    output_(output)
+{
+  if((width == 0) || (height == 0) || (nbands == 0))
+    throw tws::invalid_argument_error() << tws::error_description("GeoTIFF images must have at least one row, one column and one band.");
+
+  if((tile_size == 0) || (tile_size % 16 != 0))
+    throw tws::invalid_argument_error() << tws::error_description("GeoTIFF tile sizes must be a multiple of 16.");
+
+// sample size in bits and TIFF sample format: 1 for unsigned integers, 2 for signed integers and 3 for floating point numbers
+  uint16_t bits = 0;
+  uint16_t format = 0;
+
+  switch(datatype)
+  {
+    case tws::geoarray::datatype_t::int8_dt: bits = 8; format = 2; break;
+    case tws::geoarray::datatype_t::uint8_dt: bits = 8; format = 1; break;
+    case tws::geoarray::datatype_t::int16_dt: bits = 16; format = 2; break;
+    case tws::geoarray::datatype_t::uint16_dt: bits = 16; format = 1; break;
+    case tws::geoarray::datatype_t::int32_dt: bits = 32; format = 2; break;
+    case tws::geoarray::datatype_t::uint32_dt: bits = 32; format = 1; break;
+    case tws::geoarray::datatype_t::int64_dt: bits = 64; format = 2; break;
+    case tws::geoarray::datatype_t::uint64_dt: bits = 64; format = 1; break;
+    case tws::geoarray::datatype_t::float_dt: bits = 32; format = 3; break;
+    case tws::geoarray::datatype_t::double_dt: bits = 64; format = 3; break;
+    default:
+      throw tws::invalid_argument_error() << tws::error_description("GeoTIFF images can not have samples of unknown datatype.");
+  }
+
+  sample_size_ = bits / 8;
+
+  tile_cols_ = (width + tile_size - 1) / tile_size;
+  tile_rows_ = (height + tile_size - 1) / tile_size;
+
+  tile_buffer_.resize(static_cast<std::size_t>(tile_size) * tile_size * sample_size_);
+
+  const uint64_t tiles_per_band = static_cast<uint64_t>(tile_cols_) * tile_rows_;
+  const uint64_t ntiles = tiles_per_band * nbands;
+
+// the image file directory: the entries must be sorted by tag
+  std::vector<tiff_entry> entries;
+
+  entries.push_back(tws_wcs_tiff_entry<uint32_t>(256, tiff_type_t::long_, { width }));                 // ImageWidth
+  entries.push_back(tws_wcs_tiff_entry<uint32_t>(257, tiff_type_t::long_, { height }));                // ImageLength
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(258, tiff_type_t::short_, std::vector<uint16_t>(nbands, bits)));  // BitsPerSample
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(259, tiff_type_t::short_, { 1 }));                    // Compression: none
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(262, tiff_type_t::short_, { 1 }));                    // PhotometricInterpretation: BlackIsZero
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(277, tiff_type_t::short_, { static_cast<uint16_t>(nbands) }));  // SamplesPerPixel
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(284, tiff_type_t::short_, { 2 }));                    // PlanarConfiguration: separate
+  entries.push_back(tws_wcs_tiff_entry<uint32_t>(322, tiff_type_t::long_, { tile_size }));             // TileWidth
+  entries.push_back(tws_wcs_tiff_entry<uint32_t>(323, tiff_type_t::long_, { tile_size }));             // TileLength
+
+  const std::size_t tile_offsets_entry = entries.size();
+
+  entries.push_back(tiff_entry());                                                                     // TileOffsets: filled below
+  entries.push_back(tws_wcs_tiff_entry<uint32_t>(325, tiff_type_t::long_, std::vector<uint32_t>(ntiles, static_cast<uint32_t>(tile_buffer_.size()))));  // TileByteCounts
+
+  if(nbands > 1)
+    entries.push_back(tws_wcs_tiff_entry<uint16_t>(338, tiff_type_t::short_, std::vector<uint16_t>(nbands - 1, 0)));  // ExtraSamples: unspecified
+
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(339, tiff_type_t::short_, std::vector<uint16_t>(nbands, format)));  // SampleFormat
+  entries.push_back(tws_wcs_tiff_entry<double>(33550, tiff_type_t::double_, { georef.res_x, georef.res_y, 0.0 }));  // ModelPixelScale
+  entries.push_back(tws_wcs_tiff_entry<double>(33922, tiff_type_t::double_, { 0.0, 0.0, 0.0, georef.ulx, georef.uly, 0.0 }));  // ModelTiepoint
+
+// the GeoKey directory: model type, raster type (pixel is area) and coordinate system, by its code or, if user-defined, by its WKT in the citation
+  const bool user_defined = georef.srid > 32767;
+
+  const bool has_citation = user_defined && !georef.wkt.empty();
+
+  std::vector<uint16_t> geo_keys = { 1, 1, 0, static_cast<uint16_t>(has_citation ? 4 : 3),
+                                     1024, 0, 1, static_cast<uint16_t>(georef.geographic ? 2 : 1),
+                                     1025, 0, 1, 1 };
+
+  std::string citation = "ESRI PE String = " + georef.wkt + "|";
+
+  if(has_citation)
+    geo_keys.insert(geo_keys.end(), { 1026, 34737, static_cast<uint16_t>(citation.size()), 0 });
+
+  geo_keys.insert(geo_keys.end(), { static_cast<uint16_t>(georef.geographic ? 2048 : 3072), 0, 1,
+                                    static_cast<uint16_t>(user_defined ? 32767 : georef.srid) });
+
+  entries.push_back(tws_wcs_tiff_entry<uint16_t>(34735, tiff_type_t::short_, geo_keys));              // GeoKeyDirectory
+
+  if(has_citation)
+    entries.push_back(tws_wcs_tiff_entry(34737, citation));                                            // GeoAsciiParams
+
+  entries.push_back(tws_wcs_tiff_entry(42113, (boost::format("%1%") % nodata).str()));                 // GDAL_NODATA
+
+// choose BigTIFF if the tiles end past the 32-bit offsets
+  const uint64_t data_size = ntiles * tile_buffer_.size();
+
+  entries[tile_offsets_entry] = tws_wcs_tiff_entry<uint32_t>(324, tiff_type_t::long_, std::vector<uint32_t>(ntiles, 0));
+
+  big_tiff_ = (tws_wcs_tiff_data_offset(entries, false) + data_size) > std::numeric_limits<uint32_t>::max();
+
+  if(big_tiff_)
+    entries[tile_offsets_entry] = tws_wcs_tiff_entry<uint64_t>(324, tiff_type_t::long8, std::vector<uint64_t>(ntiles, 0));
+
+  data_offset_ = tws_wcs_tiff_data_offset(entries, big_tiff_);
+
+// the tiles are listed band after band, but written a row of tiles at a time: for each band in turn, the tiles of the row
+  std::vector<uint64_t> offsets(ntiles);
+
+  for(uint64_t b = 0; b != nbands; ++b)
+    for(uint64_t r = 0; r != tile_rows_; ++r)
+      for(uint64_t c = 0; c != tile_cols_; ++c)
+        offsets[b * tiles_per_band + r * tile_cols_ + c] = data_offset_ + ((r * nbands + b) * tile_cols_ + c) * tile_buffer_.size();
+
+  if(big_tiff_)
+    entries[tile_offsets_entry] = tws_wcs_tiff_entry<uint64_t>(324, tiff_type_t::long8, offsets);
+  else
+    entries[tile_offsets_entry] = tws_wcs_tiff_entry<uint32_t>(324, tiff_type_t::long_, std::vector<uint32_t>(offsets.begin(), offsets.end()));
+
+  header_ = tws_wcs_tiff_header(entries, big_tiff_);
+}
+
+void
+tws::wcs::geotiff_writer::write_header()
+{
+  output_(header_.data(), header_.size());
+}
+
+void
+tws::wcs::geotiff_writer::write_tile_row(const void* data)
+{
+  if(next_tile_row_ == tile_rows_)
+    throw tws::outof_bounds_error() << tws::error_description("All the GeoTIFF tiles were already written.");
+
+  const char* rows = static_cast<const char*>(data);
+
+  const uint32_t nrows = rows_in_tile_row(next_tile_row_);
+
+  const std::size_t row_size = static_cast<std::size_t>(width_) * sample_size_;
+
+  const std::size_t tile_row_size = static_cast<std::size_t>(tile_size_) * sample_size_;
+
+  for(uint32_t b = 0; b != nbands_; ++b)
+  {
+    const char* band = rows + static_cast<std::size_t>(b) * nrows * row_size;
+
+    for(uint32_t c = 0; c != tile_cols_; ++c)
+    {
+// the tiles in the last row and column are padded with zeros
+      const std::size_t first_col = static_cast<std::size_t>(c) * tile_size_;
+
+      const std::size_t ncols = std::min<std::size_t>(tile_size_, width_ - first_col);
+
+      if((nrows < tile_size_) || (ncols < tile_size_))
+        std::fill(tile_buffer_.begin(), tile_buffer_.end(), 0);
+
+      for(uint32_t i = 0; i != nrows; ++i)
+        std::memcpy(&tile_buffer_[i * tile_row_size], band + i * row_size + first_col * sample_size_, ncols * sample_size_);
+
+      output_(tile_buffer_.data(), tile_buffer_.size());
+    }
+  }
+
+  ++next_tile_row_;
+}
+
+uint32_t
+tws::wcs::geotiff_writer::tile_rows() const
+{
+  return tile_rows_;
+}
+
+uint32_t
+tws::wcs::geotiff_writer::rows_in_tile_row(uint32_t tile_row) const
+{
+  return std::min(tile_size_, height_ - tile_row * tile_size_);
+}
+
+std::size_t
+tws::wcs::geotiff_writer::sample_size() const
+{
+  return sample_size_;
+}
+
+uint64_t
+tws::wcs::geotiff_writer::file_size() const
+{
+  return data_offset_ + static_cast<uint64_t>(tile_cols_) * tile_rows_ * nbands_ * tile_buffer_.size();
+}
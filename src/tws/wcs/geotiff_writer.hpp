@@ -0,0 +1,137 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wcs/geotiff_writer.hpp
+
+  \brief A writer of tiled GeoTIFF files that emits the file bytes in order, as soon as each row of tiles is available.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WCS_GEOTIFF_WRITER_HPP__
+#define __TWS_WCS_GEOTIFF_WRITER_HPP__
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wcs
+  {
+
+    //! The georeference of a grid: the upper-left corner of its first pixel, the pixel size and the coordinate reference system.
+    struct geotiff_georef_t
+    {
+      double ulx;
+      double uly;
+      double res_x;
+      double res_y;
+      uint32_t srid;     //!< An EPSG code or, for codes above 32767, a user-defined system described by wkt.
+      bool geographic;
+      std::string wkt;
+    };
+
+    /*!
+      \brief A writer of uncompressed tiled GeoTIFF files with one sample per band.
+
+      As the tiles are not compressed, all of their offsets are known in advance:
+      the header and the image file directory are written first and then, for each
+      row of tiles, the tiles of each band. So the file can be sent while it is
+      being produced and the writer keeps no more than a row of tiles in memory.
+
+      The BigTIFF format is used if the file would not fit in 4 GiB.
+     */
+    class geotiff_writer : public boost::noncopyable
+    {
+      public:
+
+        //! The function receiving the file bytes, in order.
+        typedef boost::function<void (const char* data, std::size_t size)> output_t;
+
+        /*!
+          \param datatype  The sample type: one of tws::geoarray::datatype_t.
+          \param tile_size The tile width and height: a multiple of 16.
+          \param nodata    The value written to the GDAL_NODATA tag.
+
+          \exception tws::invalid_argument_error If the image is empty, the tile size is invalid or the datatype is unknown.
+         */
+        geotiff_writer(uint32_t width,
+                       uint32_t height,
+                       uint32_t nbands,
+                       int datatype,
+                       uint32_t tile_size,
+                       const geotiff_georef_t& georef,
+                       double nodata,
+                       const output_t& output);
+
+        //! Write the file header and the image file directory.
+        void write_header();
+
+        //! Write the tiles in the next row of tiles.
+        /*!
+          \param data The rows in the row of tiles, for each band in turn: the
+                      sample at column j of row i of band b is found at position
+                      (b * nrows + i) * width + j, where nrows is given by
+                      rows_in_tile_row() and positions count samples, not bytes.
+
+          \exception tws::outof_bounds_error If all the tile rows were already written.
+         */
+        void write_tile_row(const void* data);
+
+        //! The number of rows of tiles.
+        uint32_t tile_rows() const;
+
+        //! The number of image rows in a given row of tiles: the last one may be shorter.
+        uint32_t rows_in_tile_row(uint32_t tile_row) const;
+
+        //! The size in bytes of a sample.
+        std::size_t sample_size() const;
+
+        //! The size in bytes of the whole file.
+        uint64_t file_size() const;
+
+      private:
+
+        uint32_t width_;
+        uint32_t height_;
+        uint32_t nbands_;
+        int datatype_;
+        uint32_t tile_size_;
+        uint32_t tile_cols_;
+        uint32_t tile_rows_;
+        uint32_t next_tile_row_;
+        std::size_t sample_size_;
+        bool big_tiff_;
+        uint64_t data_offset_;          //!< The offset of the first tile.
+        std::string header_;            //!< The header and the image file directory, built by the constructor.
+        std::vector<char> tile_buffer_;
+        output_t output_;
+    };
+
+  }   // end namespace wcs
+}     // end namespace tws
+
+#endif  // __TWS_WCS_GEOTIFF_WRITER_HPP__
@@ -30,6 +30,7 @@
 #include "../core/utils.hpp"
 #include "../core/http_request.hpp"
 #include "../core/http_response.hpp"
+#include "../core/query_string.hpp"
 
 
 rapidxml::xml_node<char>* tws::wcs::initialize_wcs_xml_namespaces(rapidxml::xml_document<char>& doc)
@@ -68,8 +69,8 @@ rapidxml::xml_node<char>* tws::wcs::initialize_wcs_xml_namespaces(rapidxml::xml_
 
 bool tws::wcs::validate_request_parameters(const tws::core::http_request &request, const tws::core::http_response &response, const std::string &operation)
 {
-  const char* query_string = request.query_string().c_str();
-  if (query_string == nullptr)
+  std::string query_string = request.query_string();
+  if (query_string.empty())
   {
     // TODO: wcs xml exception
     throw tws::missing_argument_error() << tws::error_description("Arguments missing. OGC services requires at least three arguments: \"service\", \"version\" e \"request\"");
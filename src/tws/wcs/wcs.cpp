@@ -29,11 +29,18 @@
 #include "wcs.hpp"
 #include "../core/http_request.hpp"
 #include "../core/http_response.hpp"
+#include "../core/query_string.hpp"
 #include "../core/service_operations_manager.hpp"
 #include "../core/utils.hpp"
 #include "../geoarray/geoarray_manager.hpp"
+#include "../geoarray/timeline.hpp"
+#include "../geoarray/timeline_manager.hpp"
+#include "../scidb/chunk_decoder.hpp"
+#include "../scidb/connection.hpp"
+#include "../scidb/connection_pool.hpp"
 #include "wcs_manager.hpp"
 #include "data_types.hpp"
+#include "geotiff_writer.hpp"
 #include "utils.hpp"
 
 // STL
@@ -44,17 +51,290 @@
 
 // Boost
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/join.hpp>
+#include <boost/algorithm/string/predicate.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 
 // SciDB
-//#include <SciDBAPI.h>
+#include <SciDBAPI.h>
 
 // RapidXml
 #include <rapidxml/rapidxml_print.hpp>
 #include <rapidxml/rapidxml.hpp>
 
+// TerraLib
+#include <terralib/srs/SpatialReferenceSystemManager.h>
+
+namespace tws
+{
+  namespace wcs
+  {
+    //! A subset of a coverage axis: a trim between two bounds, or a slice if a single bound is informed.
+    struct axis_subset_t
+    {
+      std::string axis;
+      std::string low;
+      std::string high;
+    };
+
+    struct get_coverage_request_parameters
+    {
+      std::string coverage_id;
+      std::string format;
+      std::vector<axis_subset_t> subsets;
+      std::vector<std::string> range_subset;
+    };
+
+    //! The block of array cells and the attributes returned by a GetCoverage request.
+    struct coverage_window_t
+    {
+      const tws::geoarray::geoarray_t* garray;
+      std::vector<tws::geoarray::attribute_t> attributes;
+      int64_t init_col;
+      int64_t fin_col;
+      int64_t init_row;
+      int64_t fin_row;
+      std::vector<int64_t> time_indices;  //!< The time index of each selected time point, in increasing order.
+      int datatype;                       //!< The output sample type: the datatype shared by all attributes or else 64-bit float.
+    };
+
+    //! Decode the parameters of a GetCoverage request: coverageID, subset (repeatable), rangesubset and format.
+    get_coverage_request_parameters
+    decode_get_coverage_request(const tws::core::query_string_t& qstr);
+
+    //! Find the coverage and translate the axis subsets to array indices.
+    coverage_window_t
+    compute_coverage_window(const get_coverage_request_parameters& parameters);
+
+    //! The georeference of the upper-left cell in a coverage window.
+    geotiff_georef_t
+    make_georef(const coverage_window_t& window);
+
+    /*!
+      \brief Write the coverage as a GeoTIFF with a band for each selected attribute of each selected time point.
+
+      The array is queried a row of tiles at a time and each row of tiles is
+      written as soon as its chunks are decoded, so only a row of tiles is kept
+      in memory.
+     */
+    void write_coverage(const coverage_window_t& window,
+                        geotiff_writer& writer);
+
+  } // end namespace wcs
+}   // end namespace tws
+
+//! The layout of a row of tiles being filled by the cells of a query.
+struct tws_wcs_tile_row_t
+{
+  std::size_t band_size;                    //!< The number of samples in each band of the row of tiles.
+  std::size_t nattributes;
+  const std::vector<int64_t>* time_band;    //!< For each time index from the first selected one, its position among the selected time points or -1.
+  int64_t init_col;
+  int64_t init_row;
+  int64_t first_time;
+  int64_t width;
+};
+
+template<class T, class O>
+struct tws_wcs_tile_row_filler
+{
+  O* samples;
+  const tws_wcs_tile_row_t& layout;
+  std::size_t attr;
+
+  void operator()(const ::scidb::Coordinates& pos, T v)
+  {
+    int64_t t = (*layout.time_band)[pos[2] - layout.first_time];
+
+    if(t < 0)
+      return;
+
+    std::size_t band = static_cast<std::size_t>(t) * layout.nattributes + attr;
+
+    samples[band * layout.band_size + (pos[1] - layout.init_row) * layout.width + (pos[0] - layout.init_col)] = static_cast<O>(v);
+  }
+};
+
+template<class T, class O> static void
+tws_wcs_fill_cells(O* samples, const tws_wcs_tile_row_t& layout, std::size_t attr, ::scidb::ConstArrayIterator* it)
+{
+  tws_wcs_tile_row_filler<T, O> filler = { samples, layout, attr };
+
+  tws::scidb::for_each_cell<T>(*it, filler);
+}
+
+template<class O> static void
+tws_wcs_fill_tile_row(O* samples,
+                      const tws_wcs_tile_row_t& layout,
+                      std::size_t attr,
+                      ::scidb::ConstArrayIterator* it,
+                      const ::scidb::TypeId& id)
+{
+  if(id == ::scidb::TID_INT8)
+    tws_wcs_fill_cells<int8_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_UINT8)
+    tws_wcs_fill_cells<uint8_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_INT16)
+    tws_wcs_fill_cells<int16_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_UINT16)
+    tws_wcs_fill_cells<uint16_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_INT32)
+    tws_wcs_fill_cells<int32_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_UINT32)
+    tws_wcs_fill_cells<uint32_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_INT64)
+    tws_wcs_fill_cells<int64_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_UINT64)
+    tws_wcs_fill_cells<uint64_t>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_FLOAT)
+    tws_wcs_fill_cells<float>(samples, layout, attr, it);
+  else if(id == ::scidb::TID_DOUBLE)
+    tws_wcs_fill_cells<double>(samples, layout, attr, it);
+  else
+    throw tws::conversion_error() << tws::error_description("Could not write coverage: attribute data type not supported.");
+}
+
+// query the cells of each row of tiles and hand it to the writer, band after band
+template<class O> static void
+tws_wcs_write_coverage(const tws::wcs::coverage_window_t& window,
+                       tws::wcs::geotiff_writer& writer)
+{
+  const tws::geoarray::geoarray_t& garray = *window.garray;
+
+  const std::size_t nattributes = window.attributes.size();
+
+  const std::size_t nbands = nattributes * window.time_indices.size();
+
+  const int64_t width = window.fin_col - window.init_col + 1;
+
+  const int64_t first_time = window.time_indices.front();
+
+  const int64_t last_time = window.time_indices.back();
+
+  std::vector<int64_t> time_band(last_time - first_time + 1, -1);
+
+  for(std::size_t i = 0; i != window.time_indices.size(); ++i)
+    time_band[window.time_indices[i] - first_time] = static_cast<int64_t>(i);
+
+  std::vector<std::string> attribute_names;
+
+  for(const tws::geoarray::attribute_t& attr : window.attributes)
+    attribute_names.push_back(attr.name);
+
+  const std::string projected_attributes = boost::algorithm::join(attribute_names, ", ");
+
+  std::vector<O> samples(nbands * static_cast<std::size_t>(width) * writer.rows_in_tile_row(0));
+
+  std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
+
+  for(uint32_t tr = 0; tr != writer.tile_rows(); ++tr)
+  {
+    const int64_t init_row = window.init_row + static_cast<int64_t>(tr) * writer.rows_in_tile_row(0);
+
+    const int64_t fin_row = init_row + writer.rows_in_tile_row(tr) - 1;
+
+    tws_wcs_tile_row_t layout = { static_cast<std::size_t>(width) * writer.rows_in_tile_row(tr), nattributes,
+                                  &time_band, window.init_col, init_row, first_time, width };
+
+// empty cells are taken as missing values
+    for(std::size_t b = 0; b != nbands; ++b)
+      std::fill(samples.begin() + b * layout.band_size, samples.begin() + (b + 1) * layout.band_size,
+                static_cast<O>(window.attributes[b % nattributes].missing_value));
+
+    std::string str_afl = "project(between(" + garray.name + ", "
+                        + std::to_string(window.init_col) + ", " + std::to_string(init_row) + ", " + std::to_string(first_time) + ", "
+                        + std::to_string(window.fin_col) + ", " + std::to_string(fin_row) + ", " + std::to_string(last_time)
+                        + "), " + projected_attributes + ")";
+
+    boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_afl, true);
+
+    if((qresult != nullptr) && (qresult->array != nullptr))
+    {
+      try
+      {
+        const ::scidb::Attributes& array_attributes = qresult->array->getArrayDesc().getAttributes(true);
+
+        for(std::size_t i = 0; i != nattributes; ++i)
+        {
+          std::shared_ptr< ::scidb::ConstArrayIterator > array_it = qresult->array->getConstIterator(array_attributes[i].getId());
+
+          tws_wcs_fill_tile_row(samples.data(), layout, i, array_it.get(), array_attributes[i].getType());
+        }
+      }
+      catch(...)
+      {
+        conn->completed(qresult->queryID);
+        throw;
+      }
+    }
+
+    if(qresult != nullptr)
+      conn->completed(qresult->queryID);
+
+    writer.write_tile_row(samples.data());
+  }
+}
+
+// the value of a subset bound, without the quotes around time points
+static std::string
+tws_wcs_subset_bound(std::string bound)
+{
+  boost::algorithm::trim(bound);
+
+  if((bound.size() >= 2) && (bound.front() == '"') && (bound.back() == '"'))
+    bound = bound.substr(1, bound.size() - 2);
+
+  return bound;
+}
+
+// the position of the dimension named by an axis label: either the dimension name or its name without the "_id" suffix
+static std::size_t
+tws_wcs_find_axis(const tws::geoarray::geoarray_t& garray, const std::string& axis)
+{
+  for(std::size_t d = 0; d != garray.dimensions.size(); ++d)
+  {
+    const std::string& name = garray.dimensions[d].name;
+
+    if((name == axis) || (boost::algorithm::ends_with(name, "_id") && (name.substr(0, name.size() - 3) == axis)))
+      return d;
+  }
+
+  boost::format err_msg("Error on GetCoverage operation: coverage '%1%' has no axis named '%2%'.");
+
+  throw tws::core::http_request_error() << tws::error_description((err_msg % garray.name % axis).str());
+}
+
+// intersect the array index range of a dimension with a subset
+static void
+tws_wcs_trim_dimension(const tws::geoarray::dimension_t& dim,
+                       const tws::wcs::axis_subset_t& subset,
+                       int64_t& init_idx,
+                       int64_t& fin_idx)
+{
+  try
+  {
+    init_idx = std::max(dim.min_idx, boost::lexical_cast<int64_t>(subset.low));
+    fin_idx = std::min(dim.max_idx, boost::lexical_cast<int64_t>(subset.high));
+  }
+  catch(const boost::bad_lexical_cast&)
+  {
+    boost::format err_msg("Error on GetCoverage operation: the bounds of axis '%1%' must be integer cell indices.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % subset.axis).str());
+  }
+
+  if(init_idx > fin_idx)
+  {
+    boost::format err_msg("Error on GetCoverage operation: subset of axis '%1%' is outside the coverage.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % subset.axis).str());
+  }
+}
+
 void tws::wcs::get_capabilities_functor::operator()(const tws::core::http_request& request,
                                                     tws::core::http_response& response)
 {
@@ -303,47 +583,248 @@ tws::wcs::describe_coverage_functor::operator()(const tws::core::http_request& r
 void tws::wcs::get_coverage_functor::operator()(const tws::core::http_request& request,
                                                 tws::core::http_response& response)
 {
-  const char* query_string = request.query_string().c_str();
-  // temp code
-  if (query_string == nullptr)
+  std::string query_string = request.query_string();
+
+  if (query_string.empty())
   {
     throw tws::missing_argument_error() << tws::error_description("Arguments missing. OGC services requires at least three arguments: \"service\", \"version\" e \"request\"");
   }
 
-  tws::core::query_string_t arguments = tws::core::expand(query_string);
+  tws::core::query_string_t qstr = tws::core::expand(query_string);
+
+  get_coverage_request_parameters parameters = decode_get_coverage_request(qstr);
+
+  coverage_window_t window = compute_coverage_window(parameters);
+
+  get_coverage_options_t options = wcs_manager::instance().get_coverage_options();
+
+// a row of tiles of all bands is the largest block of the coverage kept in memory
+  const std::size_t nbands = window.attributes.size() * window.time_indices.size();
+
+  const uint64_t width = window.fin_col - window.init_col + 1;
+
+  const uint64_t height = window.fin_row - window.init_row + 1;
 
-  const auto& coverage_id = arguments.find("coverageID");
-  if (coverage_id == arguments.end())
+  geotiff_writer writer(static_cast<uint32_t>(width), static_cast<uint32_t>(height), static_cast<uint32_t>(nbands),
+                        window.datatype, options.tile_size, make_georef(window),
+                        window.attributes.front().missing_value,
+                        boost::bind(&tws::core::http_response::write_chunk, &response, _1, _2));
+
+  if(static_cast<uint64_t>(options.tile_size) * width * nbands * writer.sample_size() > options.max_buffer_size)
+    throw tws::core::http_request_error() << tws::error_description("Error on GetCoverage operation: the requested coverage is too large, please, reduce its width, time interval or attribute list.");
+
+// the file is sent while it is written, a row of tiles at a time
+  response.add_header("Content-Type", "image/tiff");
+  response.add_header("Content-Disposition", ("attachment; filename=\"" + window.garray->name + ".tif\"").c_str());
+  response.add_header("Access-Control-Allow-Origin", "*");
+
+  response.begin();
+
+  writer.write_header();
+
+  write_coverage(window, writer);
+
+  response.end();
+}
+
+tws::wcs::get_coverage_request_parameters
+tws::wcs::decode_get_coverage_request(const tws::core::query_string_t& qstr)
+{
+  get_coverage_request_parameters parameters;
+
+  parameters.format = "image/tiff";
+
+  const auto& coverage_id = qstr.find("coverageID");
+  if (coverage_id == qstr.end())
     throw tws::missing_argument_error() << tws::error_description("Missing \"coverageID\" argument");
 
-  ////  std::string str_q_aql("SELECT " + attrs + " FROM " + coverage.from_clause);
-  ////
-  ////  if(!coverage.where_clause.empty())
-  ////    str_q_aql += " WHERE " + coverage.where_clause;
-  ////
-  ////  boost::format q_aql(str_q_aql);
-  ////  q_aql.bind_arg(1, pixel_col);
-  ////  q_aql.bind_arg(2, pixel_row);
-  ////  q_aql.bind_arg(3, start_time_pos);
-  ////  q_aql.bind_arg(4, pixel_col);
-  ////  q_aql.bind_arg(5, pixel_row);
-  ////  q_aql.bind_arg(6, end_time_pos);
-  //
-  //// get a connection to retrieve the time series
-  //  std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
-  //
-  ////  boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(q_aql.str(), false);
-  //
-  ////  if((qresult.get() == nullptr) || (qresult->array.get() == nullptr))
-  ////    throw tws::core::http_request_error() << tws::error_description("no query result returned after querying database.");
-  //
-  ////  const ::scidb::ArrayDesc& array_desc = qresult->array->getArrayDesc();
-  //
-  ////  const ::scidb::Attributes& array_attributes = array_desc.getAttributes(true);
-  //
-  ////  const std::size_t nattributes = array_attributes.size();
-  //  const std::size_t nattributes = queried_attributes.size();
+  parameters.coverage_id = coverage_id->second.to_string();
+
+  const auto& format = qstr.find("format");
+  if (format != qstr.end())
+    parameters.format = format->second.to_string();
+
+  if(parameters.format != "image/tiff")
+  {
+    boost::format err_msg("Error on GetCoverage operation: output format '%1%' is not supported, use \"image/tiff\".");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.format).str());
+  }
+
+  const auto& range_subset = qstr.find("rangesubset");
+  if (range_subset != qstr.end())
+    boost::split(parameters.range_subset, range_subset->second, boost::is_any_of(","));
+
+// the subset parameter may be repeated, once per axis
+  for(const tws::core::query_string_t::value_type& kv : qstr)
+  {
+    if(!boost::algorithm::iequals(kv.first, "subset"))
+      continue;
+
+    std::string subset = kv.second.to_string();
+
+    std::size_t lparen = subset.find('(');
+
+    if((lparen == std::string::npos) || (lparen == 0) || (subset.back() != ')'))
+    {
+      boost::format err_msg("Error on GetCoverage operation: invalid subset '%1%', it must be in the form: axis(low,high) or axis(value).");
+      throw tws::core::http_request_error() << tws::error_description((err_msg % subset).str());
+    }
+
+    std::string bounds = subset.substr(lparen + 1, subset.size() - lparen - 2);
+
+    std::size_t comma = bounds.find(',');
+
+    axis_subset_t axis_subset;
+
+    axis_subset.axis = subset.substr(0, lparen);
+    axis_subset.low = tws_wcs_subset_bound(bounds.substr(0, comma));
+    axis_subset.high = (comma == std::string::npos) ? axis_subset.low : tws_wcs_subset_bound(bounds.substr(comma + 1));
+
+    parameters.subsets.push_back(axis_subset);
+  }
+
+  return parameters;
+}
+
+tws::wcs::coverage_window_t
+tws::wcs::compute_coverage_window(const get_coverage_request_parameters& parameters)
+{
+  coverage_window_t window;
+
+  const tws::geoarray::geoarray_t& garray = tws::geoarray::geoarray_manager::instance().get(parameters.coverage_id);
 
+  if(garray.dimensions.size() != 3)
+  {
+    boost::format err_msg("Error on GetCoverage operation: coverage '%1%' is not a spatio-temporal array.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % garray.name).str());
+  }
+
+  window.garray = &garray;
+
+// the range subset: all attributes unless listed
+  if(parameters.range_subset.empty())
+  {
+    window.attributes = garray.attributes;
+  }
+  else
+  {
+    for(const std::string& name : parameters.range_subset)
+    {
+      const auto& it = std::find_if(garray.attributes.begin(), garray.attributes.end(),
+                                    [&name](const tws::geoarray::attribute_t& attr) { return attr.name == name; });
+
+      if(it == garray.attributes.end())
+      {
+        boost::format err_msg("Error on GetCoverage operation: coverage '%1%' has no attribute named '%2%'.");
+        throw tws::core::http_request_error() << tws::error_description((err_msg % garray.name % name).str());
+      }
+
+      window.attributes.push_back(*it);
+    }
+  }
+
+  window.datatype = window.attributes.front().datatype;
+
+  for(const tws::geoarray::attribute_t& attr : window.attributes)
+    if((attr.datatype != window.datatype) || (attr.datatype == tws::geoarray::datatype_t::unknown))
+      window.datatype = tws::geoarray::datatype_t::double_dt;
+
+// the spatial subsets, in cell indices: the whole extent unless informed
+  window.init_col = garray.dimensions[0].min_idx;
+  window.fin_col = garray.dimensions[0].max_idx;
+  window.init_row = garray.dimensions[1].min_idx;
+  window.fin_row = garray.dimensions[1].max_idx;
+
+  std::shared_ptr<const tws::geoarray::timeline> tl = tws::geoarray::timeline_manager::instance().get(garray.name);
+
+  std::string start_time_point = tl->time_points().front();
+  std::string end_time_point = tl->time_points().back();
+
+  for(const axis_subset_t& subset : parameters.subsets)
+  {
+    std::size_t d = tws_wcs_find_axis(garray, subset.axis);
+
+    if(d == 0)
+    {
+      tws_wcs_trim_dimension(garray.dimensions[0], subset, window.init_col, window.fin_col);
+    }
+    else if(d == 1)
+    {
+      tws_wcs_trim_dimension(garray.dimensions[1], subset, window.init_row, window.fin_row);
+    }
+    else
+    {
+      start_time_point = std::max(start_time_point, subset.low);
+      end_time_point = std::min(end_time_point, subset.high);
+    }
+  }
+
+// the time points within the temporal subset
+  for(const std::string& time_point : tl->time_points())
+    if((time_point >= start_time_point) && (time_point <= end_time_point))
+      window.time_indices.push_back(static_cast<int64_t>(tl->index(time_point)));
+
+  if(window.time_indices.empty())
+  {
+    boost::format err_msg("Error on GetCoverage operation: there is no time point of coverage '%1%' in the time interval ['%2%', '%3%'].");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % garray.name % start_time_point % end_time_point).str());
+  }
+
+  std::sort(window.time_indices.begin(), window.time_indices.end());
+
+  return window;
+}
+
+tws::wcs::geotiff_georef_t
+tws::wcs::make_georef(const coverage_window_t& window)
+{
+  const tws::geoarray::geoarray_t& garray = *window.garray;
+
+  const tws::geoarray::spatial_extent_t& sp_extent = garray.geo_extent.spatial;
+
+  geotiff_georef_t georef;
+
+// column indices grow from the left border of the array extent and row indices from its top border
+  georef.res_x = sp_extent.resolution.x;
+  georef.res_y = sp_extent.resolution.y;
+  georef.ulx = sp_extent.extent.xmin + (window.init_col - garray.dimensions[0].min_idx) * georef.res_x;
+  georef.uly = sp_extent.extent.ymax - (window.init_row - garray.dimensions[1].min_idx) * georef.res_y;
+  georef.srid = sp_extent.crs_code;
+
+// systems unknown to TerraLib are written as projected ones, without a description
+  try
+  {
+    const te::srs::SpatialReferenceSystemManager& srs_manager = te::srs::SpatialReferenceSystemManager::getInstance();
+
+    georef.geographic = srs_manager.isGeographic(georef.srid);
+    georef.wkt = srs_manager.getWkt(georef.srid);
+  }
+  catch(...)
+  {
+    georef.geographic = false;
+    georef.wkt.clear();
+  }
+
+  return georef;
+}
+
+void
+tws::wcs::write_coverage(const coverage_window_t& window,
+                         geotiff_writer& writer)
+{
+  switch(window.datatype)
+  {
+    case tws::geoarray::datatype_t::int8_dt: tws_wcs_write_coverage<int8_t>(window, writer); break;
+    case tws::geoarray::datatype_t::uint8_dt: tws_wcs_write_coverage<uint8_t>(window, writer); break;
+    case tws::geoarray::datatype_t::int16_dt: tws_wcs_write_coverage<int16_t>(window, writer); break;
+    case tws::geoarray::datatype_t::uint16_dt: tws_wcs_write_coverage<uint16_t>(window, writer); break;
+    case tws::geoarray::datatype_t::int32_dt: tws_wcs_write_coverage<int32_t>(window, writer); break;
+    case tws::geoarray::datatype_t::uint32_dt: tws_wcs_write_coverage<uint32_t>(window, writer); break;
+    case tws::geoarray::datatype_t::int64_dt: tws_wcs_write_coverage<int64_t>(window, writer); break;
+    case tws::geoarray::datatype_t::uint64_dt: tws_wcs_write_coverage<uint64_t>(window, writer); break;
+    case tws::geoarray::datatype_t::float_dt: tws_wcs_write_coverage<float>(window, writer); break;
+    default: tws_wcs_write_coverage<double>(window, writer);
+  }
 }
 
 void tws::wcs::register_operations()
@@ -379,7 +860,7 @@ void tws::wcs::register_operations()
     tws::core::service_operation s_op;
 
     s_op.name = "GetCoverage";
-    s_op.description = "....";
+    s_op.description = "Retrieve a subset of a coverage as a tiled GeoTIFF.";
     s_op.handler = get_coverage_functor();
 
     service.operations.push_back(s_op);
@@ -58,8 +58,8 @@ namespace tws
                       tws::core::http_response& response);
     };
 
-    //! Retrieve the time series for a given coverage.
-    /*! http://chronos.dpi.inpe.br:6543/wcs/GetCoverage?coverageID=mod09q1 */
+    //! Retrieve a subset of a coverage as a tiled GeoTIFF, with a band for each attribute of each time point.
+    /*! http://chronos.dpi.inpe.br:6543/wcs/GetCoverage?coverageID=MOD13Q1&subset=col(43200,43999)&subset=row(32000,32799)&subset=time("2000-02-18","2000-12-31")&rangesubset=ndvi,evi */
     struct get_coverage_functor
     {
       void operator()(const tws::core::http_request& request,
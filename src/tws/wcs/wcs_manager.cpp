@@ -218,3 +218,38 @@ tws::wcs::describe_coverage_t tws::wcs::wcs_manager::describe_coverage()
 
   return describe;
 }
+
+tws::wcs::get_coverage_options_t tws::wcs::wcs_manager::get_coverage_options()
+{
+  get_coverage_options_t options;
+
+  options.tile_size = 256;
+  options.max_buffer_size = 256 * 1024 * 1024;
+
+  if(!pimpl_->json_file->HasMember("get_coverage"))
+    return options;
+
+  const rapidjson::Value& get_coverage_object = (*pimpl_->json_file)["get_coverage"];
+  if (!get_coverage_object.IsObject())
+  {
+    throw tws::parse_error() << tws::error_description("get_coverage entry in wcs config file must be an object");
+  }
+
+  const rapidjson::Value& tile_size = get_coverage_object["tile_size"];
+  if (!tile_size.IsUint() || (tile_size.GetUint() == 0) || (tile_size.GetUint() % 16 != 0))
+  {
+    throw tws::parse_error() << tws::error_description("get_coverage tile_size in wcs config file must be a positive multiple of 16");
+  }
+
+  options.tile_size = tile_size.GetUint();
+
+  const rapidjson::Value& max_buffer_size = get_coverage_object["max_buffer_size"];
+  if (!max_buffer_size.IsUint64() || (max_buffer_size.GetUint64() == 0))
+  {
+    throw tws::parse_error() << tws::error_description("get_coverage max_buffer_size in wcs config file must be a positive number of bytes");
+  }
+
+  options.max_buffer_size = static_cast<std::size_t>(max_buffer_size.GetUint64());
+
+  return options;
+}
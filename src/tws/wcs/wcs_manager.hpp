@@ -11,6 +11,7 @@ namespace tws
     struct service_provider_t;
     struct service_metadata_t;
     struct describe_coverage_t;
+    struct get_coverage_options_t;
 
     class wcs_manager
     {
@@ -48,6 +49,13 @@ namespace tws
         */
         describe_coverage_t describe_coverage();
 
+        /*!
+          \brief It makes a GetCoverage settings object from the optional get_coverage entry of the wcs config file
+          \return A tws::wcs::get_coverage_options_t struct: tiles of 256 x 256 pixels and a 256 MiB buffer unless configured otherwise
+          \exception tws::parse_error If the get_coverage entry is invalid
+        */
+        get_coverage_options_t get_coverage_options();
+
       private:
         //! Constructor
         wcs_manager();
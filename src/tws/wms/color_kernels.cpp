@@ -0,0 +1,390 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/color_kernels.cpp
+
+  \brief Kernels that turn the resampled bands of a map into RGBA pixels.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "color_kernels.hpp"
+#include "../core/simd.hpp"
+#include "../exception.hpp"
+
+// STL
+#include <algorithm>
+#include <cstring>
+
+// Boost
+#include <boost/format.hpp>
+
+// the SIMD kernels are compiled with function target attributes: the module itself needs no special flags
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TWS_WMS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+static void
+tws_wms_stretch_scalar(const double* values, std::size_t n, const tws::wms::band_stretch_t& s,
+                       uint8_t* components, uint8_t* alpha)
+{
+  for(std::size_t j = 0; j < n; ++j)
+  {
+    double v = values[j];
+
+    bool valid = (v == v) && (v != s.missing_value);
+
+// std::max(0.0, NaN) is 0.0
+    double c = std::min(255.0, std::max(0.0, v * s.gain + s.offset));
+
+    components[j] = valid ? static_cast<uint8_t>(c) : 0;
+    alpha[j] &= valid ? 255 : 0;
+  }
+}
+
+static void
+tws_wms_interleave_scalar(const uint8_t* red, const uint8_t* green, const uint8_t* blue, const uint8_t* alpha,
+                          std::size_t n, uint8_t* rgba)
+{
+  for(std::size_t j = 0; j < n; ++j)
+  {
+    rgba[4 * j] = red[j];
+    rgba[4 * j + 1] = green[j];
+    rgba[4 * j + 2] = blue[j];
+    rgba[4 * j + 3] = alpha[j];
+  }
+}
+
+static void
+tws_wms_color_map_scalar(const uint8_t* components, const uint8_t* alpha, std::size_t n,
+                         const tws::wms::color_lut_t& lut, uint8_t* rgba)
+{
+  for(std::size_t j = 0; j < n; ++j)
+  {
+    uint32_t color = alpha[j] ? lut[components[j]] : 0;
+
+    std::memcpy(rgba + 4 * j, &color, 4);
+  }
+}
+
+#ifdef TWS_WMS_X86_KERNELS
+
+// 16 values at a time: each pair of doubles is converted to two 32-bit integers and then packed to bytes
+__attribute__((target("sse2")))
+static void
+tws_wms_stretch_sse2(const double* values, std::size_t n, const tws::wms::band_stretch_t& s,
+                     uint8_t* components, uint8_t* alpha)
+{
+  const __m128d gain = _mm_set1_pd(s.gain);
+  const __m128d offset = _mm_set1_pd(s.offset);
+  const __m128d missing = _mm_set1_pd(s.missing_value);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d max_component = _mm_set1_pd(255.0);
+
+  std::size_t j = 0;
+
+  for(; j + 16 <= n; j += 16)
+  {
+    __m128i c[4];
+    __m128i m[4];
+
+    for(int k = 0; k != 4; ++k)
+    {
+      __m128d v0 = _mm_loadu_pd(values + j + 4 * k);
+      __m128d v1 = _mm_loadu_pd(values + j + 4 * k + 2);
+
+// unordered comparisons: a NaN missing value never matches
+      __m128d valid0 = _mm_and_pd(_mm_cmpord_pd(v0, v0), _mm_cmpneq_pd(v0, missing));
+      __m128d valid1 = _mm_and_pd(_mm_cmpord_pd(v1, v1), _mm_cmpneq_pd(v1, missing));
+
+// maxpd returns its second operand when the first one is NaN
+      __m128d c0 = _mm_min_pd(_mm_max_pd(_mm_add_pd(_mm_mul_pd(v0, gain), offset), zero), max_component);
+      __m128d c1 = _mm_min_pd(_mm_max_pd(_mm_add_pd(_mm_mul_pd(v1, gain), offset), zero), max_component);
+
+      c[k] = _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_and_pd(c0, valid0)), _mm_cvttpd_epi32(_mm_and_pd(c1, valid1)));
+      m[k] = _mm_unpacklo_epi64(_mm_cvttpd_epi32(_mm_and_pd(max_component, valid0)), _mm_cvttpd_epi32(_mm_and_pd(max_component, valid1)));
+    }
+
+    __m128i c8 = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+    __m128i m8 = _mm_packus_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3]));
+
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + j));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(components + j), c8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(alpha + j), _mm_and_si128(a, m8));
+  }
+
+  tws_wms_stretch_scalar(values + j, n - j, s, components + j, alpha + j);
+}
+
+__attribute__((target("sse2")))
+static void
+tws_wms_interleave_sse2(const uint8_t* red, const uint8_t* green, const uint8_t* blue, const uint8_t* alpha,
+                        std::size_t n, uint8_t* rgba)
+{
+  std::size_t j = 0;
+
+  for(; j + 16 <= n; j += 16)
+  {
+    __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(red + j));
+    __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(green + j));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blue + j));
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + j));
+
+    __m128i rg_lo = _mm_unpacklo_epi8(r, g);
+    __m128i rg_hi = _mm_unpackhi_epi8(r, g);
+    __m128i ba_lo = _mm_unpacklo_epi8(b, a);
+    __m128i ba_hi = _mm_unpackhi_epi8(b, a);
+
+    __m128i* out = reinterpret_cast<__m128i*>(rgba + 4 * j);
+
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg_lo, ba_lo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rg_hi, ba_hi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rg_hi, ba_hi));
+  }
+
+  tws_wms_interleave_scalar(red + j, green + j, blue + j, alpha + j, n - j, rgba + 4 * j);
+}
+
+__attribute__((target("avx2")))
+static void
+tws_wms_stretch_avx2(const double* values, std::size_t n, const tws::wms::band_stretch_t& s,
+                     uint8_t* components, uint8_t* alpha)
+{
+  const __m256d gain = _mm256_set1_pd(s.gain);
+  const __m256d offset = _mm256_set1_pd(s.offset);
+  const __m256d missing = _mm256_set1_pd(s.missing_value);
+  const __m256d zero = _mm256_setzero_pd();
+  const __m256d max_component = _mm256_set1_pd(255.0);
+
+  std::size_t j = 0;
+
+  for(; j + 16 <= n; j += 16)
+  {
+    __m128i c[4];
+    __m128i m[4];
+
+    for(int k = 0; k != 4; ++k)
+    {
+      __m256d v = _mm256_loadu_pd(values + j + 4 * k);
+
+      __m256d valid = _mm256_and_pd(_mm256_cmp_pd(v, v, _CMP_ORD_Q), _mm256_cmp_pd(v, missing, _CMP_NEQ_UQ));
+
+      __m256d cv = _mm256_min_pd(_mm256_max_pd(_mm256_add_pd(_mm256_mul_pd(v, gain), offset), zero), max_component);
+
+      c[k] = _mm256_cvttpd_epi32(_mm256_and_pd(cv, valid));
+      m[k] = _mm256_cvttpd_epi32(_mm256_and_pd(max_component, valid));
+    }
+
+    __m128i c8 = _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3]));
+    __m128i m8 = _mm_packus_epi16(_mm_packs_epi32(m[0], m[1]), _mm_packs_epi32(m[2], m[3]));
+
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha + j));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(components + j), c8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(alpha + j), _mm_and_si128(a, m8));
+  }
+
+  tws_wms_stretch_scalar(values + j, n - j, s, components + j, alpha + j);
+}
+
+// the byte unpacks work inside each 128-bit lane: the lanes are put back in order before storing
+__attribute__((target("avx2")))
+static void
+tws_wms_interleave_avx2(const uint8_t* red, const uint8_t* green, const uint8_t* blue, const uint8_t* alpha,
+                        std::size_t n, uint8_t* rgba)
+{
+  std::size_t j = 0;
+
+  for(; j + 32 <= n; j += 32)
+  {
+    __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(red + j));
+    __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(green + j));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blue + j));
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(alpha + j));
+
+    __m256i rg_lo = _mm256_unpacklo_epi8(r, g);
+    __m256i rg_hi = _mm256_unpackhi_epi8(r, g);
+    __m256i ba_lo = _mm256_unpacklo_epi8(b, a);
+    __m256i ba_hi = _mm256_unpackhi_epi8(b, a);
+
+// pixels 0-3 and 16-19, 4-7 and 20-23, 8-11 and 24-27, 12-15 and 28-31
+    __m256i q0 = _mm256_unpacklo_epi16(rg_lo, ba_lo);
+    __m256i q1 = _mm256_unpackhi_epi16(rg_lo, ba_lo);
+    __m256i q2 = _mm256_unpacklo_epi16(rg_hi, ba_hi);
+    __m256i q3 = _mm256_unpackhi_epi16(rg_hi, ba_hi);
+
+    __m256i* out = reinterpret_cast<__m256i*>(rgba + 4 * j);
+
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(q0, q1, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+    _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+    _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+  }
+
+  tws_wms_interleave_scalar(red + j, green + j, blue + j, alpha + j, n - j, rgba + 4 * j);
+}
+
+// 8 pixels at a time: their colors are gathered from the table and masked by alpha
+__attribute__((target("avx2")))
+static void
+tws_wms_color_map_avx2(const uint8_t* components, const uint8_t* alpha, std::size_t n,
+                       const tws::wms::color_lut_t& lut, uint8_t* rgba)
+{
+  const int* table = reinterpret_cast<const int*>(lut.data());
+  const __m256i zero = _mm256_setzero_si256();
+
+  std::size_t j = 0;
+
+  for(; j + 8 <= n; j += 8)
+  {
+    __m256i idx = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(components + j)));
+    __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha + j)));
+
+    __m256i colors = _mm256_i32gather_epi32(table, idx, 4);
+
+    colors = _mm256_and_si256(colors, _mm256_cmpgt_epi32(a, zero));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + 4 * j), colors);
+  }
+
+  tws_wms_color_map_scalar(components + j, alpha + j, n - j, lut, rgba + 4 * j);
+}
+
+#endif  // TWS_WMS_X86_KERNELS
+
+const tws::wms::color_kernels&
+tws::wms::get_color_kernels(int isa)
+{
+  static const color_kernels scalar_kernels = { tws::core::simd_isa_t::scalar, "scalar",
+                                                         &tws_wms_stretch_scalar, &tws_wms_interleave_scalar, &tws_wms_color_map_scalar };
+
+#ifdef TWS_WMS_X86_KERNELS
+// there is no gather in SSE2: the color map is looked up one pixel at a time
+  static const color_kernels sse2_kernels = { tws::core::simd_isa_t::sse2, "sse2",
+                                                       &tws_wms_stretch_sse2, &tws_wms_interleave_sse2, &tws_wms_color_map_scalar };
+
+  static const color_kernels avx2_kernels = { tws::core::simd_isa_t::avx2, "avx2",
+                                                       &tws_wms_stretch_avx2, &tws_wms_interleave_avx2, &tws_wms_color_map_avx2 };
+#endif
+
+  if(!tws::core::is_supported(isa))
+  {
+    boost::format err_msg("color kernels for instruction set '%1%' are not supported in this machine.");
+
+    throw tws::invalid_argument_error() << tws::error_description((err_msg % isa).str());
+  }
+
+#ifdef TWS_WMS_X86_KERNELS
+  if(isa == tws::core::simd_isa_t::avx2)
+    return avx2_kernels;
+
+  if(isa == tws::core::simd_isa_t::sse2)
+    return sse2_kernels;
+#endif
+
+  return scalar_kernels;
+}
+
+const tws::wms::color_kernels&
+tws::wms::select_color_kernels()
+{
+  static const color_kernels& best = get_color_kernels(tws::core::select_isa());
+
+  return best;
+}
+
+tws::wms::band_stretch_t
+tws::wms::make_band_stretch(const tws::geoarray::numeric_range_t& range,
+                            double scale_factor,
+                            double missing_value)
+{
+  band_stretch_t s;
+
+  s.missing_value = missing_value;
+
+  if(range.max_val <= range.min_val)
+  {
+    s.gain = 0.0;
+    s.offset = 0.0;
+
+    return s;
+  }
+
+  double k = 255.0 / (range.max_val - range.min_val);
+
+  s.gain = scale_factor * k;
+  s.offset = -range.min_val * k;
+
+  return s;
+}
+
+tws::wms::color_lut_t
+tws::wms::make_color_lut(const std::vector<color_stop_t>& color_map,
+                         const tws::geoarray::numeric_range_t& range)
+{
+  color_lut_t lut;
+
+  lut.fill(0);
+
+  if(color_map.empty())
+    return lut;
+
+  std::size_t next = 0;
+
+  for(std::size_t i = 0; i != lut.size(); ++i)
+  {
+    double v = range.min_val + i * (range.max_val - range.min_val) / 255.0;
+
+// the first stop above v
+    while((next != color_map.size()) && (color_map[next].value <= v))
+      ++next;
+
+    uint8_t rgba[4];
+
+    if(next == 0 || next == color_map.size())
+    {
+      const color_stop_t& stop = color_map[next == 0 ? 0 : next - 1];
+
+      rgba[0] = stop.red;
+      rgba[1] = stop.green;
+      rgba[2] = stop.blue;
+      rgba[3] = stop.alpha;
+    }
+    else
+    {
+      const color_stop_t& s0 = color_map[next - 1];
+      const color_stop_t& s1 = color_map[next];
+
+      double w = (v - s0.value) / (s1.value - s0.value);
+
+      rgba[0] = static_cast<uint8_t>(s0.red + (s1.red - s0.red) * w + 0.5);
+      rgba[1] = static_cast<uint8_t>(s0.green + (s1.green - s0.green) * w + 0.5);
+      rgba[2] = static_cast<uint8_t>(s0.blue + (s1.blue - s0.blue) * w + 0.5);
+      rgba[3] = static_cast<uint8_t>(s0.alpha + (s1.alpha - s0.alpha) * w + 0.5);
+    }
+
+    std::memcpy(&lut[i], rgba, 4);
+  }
+
+  return lut;
+}
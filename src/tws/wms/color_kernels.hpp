@@ -0,0 +1,99 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/color_kernels.hpp
+
+  \brief Kernels that turn the resampled bands of a map into RGBA pixels.
+
+  Each kernel has a scalar implementation and, on x86 processors, SSE2
+  and AVX2 ones. The best implementation supported by the running CPU
+  is chosen when the kernels are first used.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WMS_COLOR_KERNELS_HPP__
+#define __TWS_WMS_COLOR_KERNELS_HPP__
+
+// TWS
+#include "../geoarray/data_types.hpp"
+#include "data_types.hpp"
+
+// STL
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tws
+{
+  namespace wms
+  {
+
+    //! The affine map from the values of a band to a color component: c = clamp(v * gain + offset, 0, 255).
+    struct band_stretch_t
+    {
+      double gain;
+      double offset;
+      double missing_value;   //!< Cells with this value, as well as NaN cells, are transparent.
+    };
+
+    //! The RGBA colors of the 256 stretched values of a band, each one packed as 4 bytes in memory order.
+    typedef std::array<uint32_t, 256> color_lut_t;
+
+    //! A set of color kernels for a given instruction set.
+    struct color_kernels
+    {
+      int isa;
+      const char* name;
+
+      //! Stretch n values to color components; alpha is cleared for the missing values and kept for the others.
+      void (*stretch)(const double* values, std::size_t n, const band_stretch_t& s, uint8_t* components, uint8_t* alpha);
+
+      //! Interleave n red, green, blue and alpha components into RGBA pixels.
+      void (*interleave)(const uint8_t* red, const uint8_t* green, const uint8_t* blue, const uint8_t* alpha,
+                         std::size_t n, uint8_t* rgba);
+
+      //! Replace n stretched values by their colors in a color map; pixels with a zero alpha are transparent.
+      void (*color_map)(const uint8_t* components, const uint8_t* alpha, std::size_t n,
+                        const color_lut_t& lut, uint8_t* rgba);
+    };
+
+    //! The kernels for a given instruction set, one of tws::core::simd_isa_t.
+    /*!
+      \exception tws::invalid_argument_error It throws an exception if the instruction set is not supported by the CPU or by the build.
+     */
+    const color_kernels& get_color_kernels(int isa);
+
+    //! The fastest kernels supported by the running CPU.
+    const color_kernels& select_color_kernels();
+
+    //! The stretch mapping a range of band values, after the scale factor is applied, to [0, 255].
+    band_stretch_t make_band_stretch(const tws::geoarray::numeric_range_t& range,
+                                     double scale_factor,
+                                     double missing_value);
+
+    //! Sample a color map at the 256 values of a range, interpolating linearly between its stops.
+    color_lut_t make_color_lut(const std::vector<color_stop_t>& color_map,
+                               const tws::geoarray::numeric_range_t& range);
+
+  }   // end namespace wms
+}     // end namespace tws
+
+#endif  // __TWS_WMS_COLOR_KERNELS_HPP__
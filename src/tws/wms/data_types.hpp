@@ -181,6 +181,16 @@ namespace tws
       online_resource_t online_resource;
     };
     
+    //! A color map entry: the color of a band value, given in the band units after its scale factor is applied.
+    struct color_stop_t
+    {
+      double value;
+      uint8_t red;
+      uint8_t green;
+      uint8_t blue;
+      uint8_t alpha;
+    };
+
     //! Lists the name by which a style is requested and a human-readable title for pick lists.
     /*!
      Optionally provides a human-readable description, and optionally gives a style URL.
@@ -195,6 +205,8 @@ namespace tws
       style_url_t style_url;
       std::string style_type;
       std::vector<std::string> colors;
+      std::vector<tws::geoarray::numeric_range_t> stretch;  //!< The range stretched to [0, 255] for each band; if empty, the band valid range.
+      std::vector<color_stop_t> color_map;                  //!< The color map of a "color map" style, sorted by value.
     };
    
     //! Nested list of zero or more map Layers offered by this server.
@@ -292,6 +304,22 @@ namespace tws
       uint32_t max_height;
     };
     
+    /*!
+      \brief The fixed tile matrix set of the WMTS and XYZ tile operations.
+
+      The tile matrix of a layer is defined over its array grid: zoom level 0
+      is the coarsest one and in the finest level, max_zoom, a tile pixel is
+      an array cell. The tiles of level z start at the array origin (the
+      min_idx of the spatial dimensions) and span tile_size * 2^(max_zoom - z)
+      cells. The chunk intervals of the arrays are not known here, so the
+      tile borders are not checked against the chunk borders.
+     */
+    struct tile_matrix_set_t
+    {
+      uint32_t tile_size;      //!< The width and height of a tile, in pixels.
+      uint32_t metatile_size;  //!< The number of tiles along each axis rendered by a single query.
+    };
+
     //! Base datatype for WMS_Capabilities document.
     struct capabilities_t
     {
@@ -0,0 +1,213 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/encoder_manager.cpp
+
+  \brief The image encoders of WMS, indexed by output format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "encoder_manager.hpp"
+#include "../core/thread_pool.hpp"
+#include "../core/utils.hpp"
+#include "exception.hpp"
+
+// STL
+#include <algorithm>
+#include <map>
+#include <memory>
+
+// Boost
+#include <boost/bind.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/thread.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+struct tws::wms::encoder_manager::impl
+{
+  std::map<std::string, image_encoder_t> encoders;
+  std::unique_ptr<tws::core::thread_pool> pool;   //!< The threads shared by all images being encoded.
+};
+
+// read an optional integer setting of an encoder
+static int
+tws_wms_read_int(const rapidjson::Value& jencoder, const char* name, int min_val, int max_val, int default_val)
+{
+  if(!jencoder.HasMember(name))
+    return default_val;
+
+  const rapidjson::Value& jval = jencoder[name];
+
+  if(!jval.IsInt() || (jval.GetInt() < min_val) || (jval.GetInt() > max_val))
+  {
+    boost::format err_msg("encoder entry '%1%' in file 'share/tws/config/wms.json' must be an integer in the range [%2%, %3%].");
+
+    throw tws::parse_error() << tws::error_description((err_msg % name % min_val % max_val).str());
+  }
+
+  return jval.GetInt();
+}
+
+static int
+tws_wms_read_png_filter(const rapidjson::Value& jpng)
+{
+  if(!jpng.HasMember("filter"))
+    return tws::wms::png_filter_t::sub;
+
+  const rapidjson::Value& jfilter = jpng["filter"];
+
+  std::string filter = jfilter.IsString() ? jfilter.GetString() : "";
+
+  if(filter == "none")
+    return tws::wms::png_filter_t::none;
+  else if(filter == "sub")
+    return tws::wms::png_filter_t::sub;
+  else if(filter == "up")
+    return tws::wms::png_filter_t::up;
+  else if(filter == "average")
+    return tws::wms::png_filter_t::average;
+  else if(filter == "paeth")
+    return tws::wms::png_filter_t::paeth;
+
+  throw tws::parse_error() << tws::error_description("PNG encoder filter in file 'share/tws/config/wms.json' must be one of: none, sub, up, average or paeth.");
+}
+
+void
+tws::wms::encoder_manager::insert(const std::string& format, const image_encoder_t& encoder)
+{
+  pimpl_->encoders[format] = encoder;
+}
+
+bool
+tws::wms::encoder_manager::exists(const std::string& format) const
+{
+  return pimpl_->encoders.find(format) != pimpl_->encoders.end();
+}
+
+std::vector<std::string>
+tws::wms::encoder_manager::formats() const
+{
+  std::vector<std::string> result;
+
+  for(const auto& e : pimpl_->encoders)
+    result.push_back(e.first);
+
+  return result;
+}
+
+std::string
+tws::wms::encoder_manager::encode(const rgba_image& img, const std::string& format) const
+{
+  std::map<std::string, image_encoder_t>::const_iterator it = pimpl_->encoders.find(format);
+
+  if(it == pimpl_->encoders.end())
+  {
+    boost::format err_msg("there is no encoder for image format: '%1%'.");
+
+    throw tws::item_not_found_error() << tws::error_description((err_msg % format).str());
+  }
+
+  return it->second(img);
+}
+
+tws::wms::encoder_manager&
+tws::wms::encoder_manager::instance()
+{
+  static encoder_manager instance;
+
+  return instance;
+}
+
+tws::wms::encoder_manager::encoder_manager()
+  : pimpl_(nullptr)
+{
+  pimpl_ = new impl;
+
+  std::string wms_file = tws::core::find_in_app_path("share/tws/config/wms.json");
+
+  if(wms_file.empty())
+    throw tws::file_exists_error() << tws::error_description("Could not locate file 'share/tws/config/wms.json'.");
+
+  std::unique_ptr<rapidjson::Document> jdocument(tws::core::open_json_file(wms_file));
+
+  rapidjson::Value jempty(rapidjson::kObjectType);
+
+  const rapidjson::Value& jencoders = jdocument->HasMember("encoders") ? (*jdocument)["encoders"] : jempty;
+
+  if(!jencoders.IsObject())
+    throw tws::parse_error() << tws::error_description("encoders entry in file 'share/tws/config/wms.json' must be an object.");
+
+// by default, a single image may use all processors: the threads helping the calling one are shared by all images
+  std::size_t threads = static_cast<std::size_t>(tws_wms_read_int(jencoders, "threads", 0, 1024, 0));
+
+  if(threads == 0)
+    threads = std::max(1u, boost::thread::hardware_concurrency());
+
+  if(threads > 1)
+    pimpl_->pool.reset(new tws::core::thread_pool(threads - 1, 4 * threads));
+
+// PNG
+  {
+    const rapidjson::Value& jpng = jencoders.HasMember("image/png") ? jencoders["image/png"] : jempty;
+
+    png_options_t options;
+
+    options.compression_level = tws_wms_read_int(jpng, "compression_level", -1, 9, 6);
+    options.filter = tws_wms_read_png_filter(jpng);
+    options.band_rows = static_cast<uint32_t>(tws_wms_read_int(jpng, "band_rows", 0, 1 << 20, 128));
+    options.threads = threads;
+    options.pool = pimpl_->pool.get();
+
+    insert("image/png", boost::bind(&tws::wms::encode_png, _1, options));
+  }
+
+#ifdef TWS_WMS_JPEG_ENABLED
+  {
+    const rapidjson::Value& jjpeg = jencoders.HasMember("image/jpeg") ? jencoders["image/jpeg"] : jempty;
+
+    jpeg_options_t options;
+
+    options.quality = tws_wms_read_int(jjpeg, "quality", 0, 100, 85);
+
+    insert("image/jpeg", boost::bind(&tws::wms::encode_jpeg, _1, options));
+  }
+#endif
+
+#ifdef TWS_WMS_WEBP_ENABLED
+  {
+    const rapidjson::Value& jwebp = jencoders.HasMember("image/webp") ? jencoders["image/webp"] : jempty;
+
+    webp_options_t options;
+
+    options.quality = static_cast<float>(tws_wms_read_int(jwebp, "quality", 0, 100, 80));
+    options.lossless = jwebp.HasMember("lossless") && jwebp["lossless"].IsBool() && jwebp["lossless"].GetBool();
+
+    insert("image/webp", boost::bind(&tws::wms::encode_webp, _1, options));
+  }
+#endif
+}
+
+tws::wms::encoder_manager::~encoder_manager()
+{
+  delete pimpl_;
+}
@@ -0,0 +1,102 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/encoder_manager.hpp
+
+  \brief The image encoders of WMS, indexed by output format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WMS_ENCODER_MANAGER_HPP__
+#define __TWS_WMS_ENCODER_MANAGER_HPP__
+
+// TWS
+#include "image.hpp"
+
+// STL
+#include <string>
+#include <vector>
+
+// Boost
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wms
+  {
+
+    //! A function encoding an image in a given format.
+    typedef boost::function<std::string (const rgba_image& img)> image_encoder_t;
+
+    /*!
+      \brief The image encoders of WMS, indexed by output format (MIME type).
+
+      The built-in encoders are registered when the manager is created, with
+      the settings of the encoders entry of share/tws/config/wms.json: PNG is
+      always available, while JPEG and WebP depend on the build options.
+
+      Encoders must only be added during the initialization of the service:
+      the manager is not protected against concurrent changes.
+     */
+    class encoder_manager : public boost::noncopyable
+    {
+      public:
+
+        //! Add or replace the encoder of a format.
+        void insert(const std::string& format, const image_encoder_t& encoder);
+
+        //! Tells if there is an encoder for a given format.
+        bool exists(const std::string& format) const;
+
+        //! The list of formats with an encoder.
+        std::vector<std::string> formats() const;
+
+        //! Encode an image in a given format.
+        /*!
+          \exception tws::item_not_found_error It throws an exception if there is no encoder for the format.
+          \exception tws::wms::encode_error    It throws an exception if the encoder fails.
+         */
+        std::string encode(const rgba_image& img, const std::string& format) const;
+
+        //! Access the singleton.
+        /*!
+          \exception tws::file_exists_error If the file 'share/tws/config/wms.json' is not found.
+          \exception tws::parse_error       If the encoders section of the config file is invalid.
+         */
+        static encoder_manager& instance();
+
+      private:
+
+        encoder_manager();
+
+        ~encoder_manager();
+
+      private:
+
+        struct impl;
+
+        impl* pimpl_;
+    };
+
+  }   // end namespace wms
+}     // end namespace tws
+
+#endif  // __TWS_WMS_ENCODER_MANAGER_HPP__
@@ -39,6 +39,9 @@ namespace tws
     //! The base type for the WMS module exceptions.
     struct exception: virtual tws::exception { };
 
+    //! An error while encoding an output image.
+    struct encode_error: virtual exception { };
+
 
   }  // end namespace wms
 }    // end namespace tws
@@ -0,0 +1,497 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/image.cpp
+
+  \brief An in-memory RGBA image and its encoders.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "image.hpp"
+#include "../core/thread_pool.hpp"
+#include "exception.hpp"
+
+// STL
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+// zlib
+#include <zlib.h>
+
+#ifdef TWS_WMS_JPEG_ENABLED
+// libjpeg
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+#endif
+
+#ifdef TWS_WMS_WEBP_ENABLED
+// libwebp
+#include <webp/encode.h>
+#endif
+
+namespace tws
+{
+  namespace wms
+  {
+    //! A band of image rows compressed as raw deflate blocks.
+    struct png_band
+    {
+      uint32_t first_row;
+      uint32_t last_row;
+      std::string data;
+      uLong adler;
+      std::size_t length;   //!< The size of the filtered rows, before compression.
+    };
+
+  } // end namespace wms
+}   // end namespace tws
+
+// append a 32-bit integer in network byte order
+static void
+tws_wms_png_put_uint32(std::string& out, uint32_t v)
+{
+  char b[4] = { static_cast<char>(v >> 24), static_cast<char>(v >> 16), static_cast<char>(v >> 8), static_cast<char>(v) };
+
+  out.append(b, 4);
+}
+
+// close a chunk started at offset start: write its data length and append the CRC of its type and data
+static void
+tws_wms_png_end_chunk(std::string& out, std::size_t start)
+{
+  uint32_t length = static_cast<uint32_t>(out.size() - start - 8);
+
+  for(int i = 0; i != 4; ++i)
+    out[start + i] = static_cast<char>(length >> (24 - 8 * i));
+
+  uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(out.data() + start + 4), length + 4);
+
+  tws_wms_png_put_uint32(out, static_cast<uint32_t>(crc));
+}
+
+// start a chunk whose length will be known only at its end
+static std::size_t
+tws_wms_png_begin_chunk(std::string& out, const char* type)
+{
+  std::size_t start = out.size();
+
+  out.append(4, '\0');
+  out.append(type, 4);
+
+  return start;
+}
+
+// deflate the available input and append the compressed bytes to the output
+static int
+tws_wms_png_deflate(z_stream& zs, int flush, std::string& out)
+{
+  char buffer[65536];
+
+  int ret = Z_OK;
+
+  do
+  {
+    zs.next_out = reinterpret_cast<Bytef*>(buffer);
+    zs.avail_out = sizeof(buffer);
+
+    ret = deflate(&zs, flush);
+
+    if(ret == Z_STREAM_ERROR)
+      throw tws::wms::encode_error() << tws::error_description("could not compress the PNG image data.");
+
+    out.append(buffer, sizeof(buffer) - zs.avail_out);
+
+  } while(zs.avail_out == 0);
+
+  return ret;
+}
+
+static uint8_t
+tws_wms_png_paeth(int a, int b, int c)
+{
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+
+  if((pa <= pb) && (pa <= pc))
+    return static_cast<uint8_t>(a);
+
+  return static_cast<uint8_t>((pb <= pc) ? b : c);
+}
+
+// filter a row into dst, which starts with the filter type; the row above the first one is taken as zeros
+static void
+tws_wms_png_filter_row(const uint8_t* src, const uint8_t* prev, std::size_t row_size, int filter, uint8_t* dst)
+{
+  *dst++ = static_cast<uint8_t>(filter);
+
+  std::size_t first = std::min<std::size_t>(4, row_size);
+
+  switch(filter)
+  {
+    case tws::wms::png_filter_t::sub:
+      std::memcpy(dst, src, first);
+
+      for(std::size_t k = first; k < row_size; ++k)
+        dst[k] = static_cast<uint8_t>(src[k] - src[k - 4]);
+      break;
+
+    case tws::wms::png_filter_t::up:
+      if(prev == nullptr)
+      {
+        std::memcpy(dst, src, row_size);
+        break;
+      }
+
+      for(std::size_t k = 0; k < row_size; ++k)
+        dst[k] = static_cast<uint8_t>(src[k] - prev[k]);
+      break;
+
+    case tws::wms::png_filter_t::average:
+      for(std::size_t k = 0; k < row_size; ++k)
+      {
+        int left = (k >= 4) ? src[k - 4] : 0;
+        int up = prev ? prev[k] : 0;
+
+        dst[k] = static_cast<uint8_t>(src[k] - ((left + up) >> 1));
+      }
+      break;
+
+    case tws::wms::png_filter_t::paeth:
+      for(std::size_t k = 0; k < row_size; ++k)
+      {
+        int left = (k >= 4) ? src[k - 4] : 0;
+        int up = prev ? prev[k] : 0;
+        int up_left = (prev && (k >= 4)) ? prev[k - 4] : 0;
+
+        dst[k] = static_cast<uint8_t>(src[k] - tws_wms_png_paeth(left, up, up_left));
+      }
+      break;
+
+    default:
+      std::memcpy(dst, src, row_size);
+  }
+}
+
+// filter and compress a band: all bands but the last end on a byte boundary with a sync flush
+static void
+tws_wms_png_compress_band(const tws::wms::rgba_image& img,
+                          const tws::wms::png_options_t& options,
+                          bool last_band,
+                          tws::wms::png_band& band)
+{
+  std::size_t row_size = static_cast<std::size_t>(img.width) * 4;
+
+  std::vector<uint8_t> filtered((row_size + 1) * (band.last_row - band.first_row));
+
+  for(uint32_t i = band.first_row; i != band.last_row; ++i)
+    tws_wms_png_filter_row(img.row(i), (i == 0) ? nullptr : img.row(i - 1), row_size, options.filter,
+                           &filtered[(row_size + 1) * (i - band.first_row)]);
+
+  band.length = filtered.size();
+  band.adler = adler32(adler32(0L, Z_NULL, 0), filtered.empty() ? Z_NULL : &filtered[0], static_cast<uInt>(filtered.size()));
+
+  z_stream zs;
+
+  std::memset(&zs, 0, sizeof(zs));
+
+  int strategy = (options.filter == tws::wms::png_filter_t::none) ? Z_DEFAULT_STRATEGY : Z_FILTERED;
+
+// raw deflate: the zlib header and trailer are written once for the whole image
+  if(deflateInit2(&zs, options.compression_level, Z_DEFLATED, -15, 8, strategy) != Z_OK)
+    throw tws::wms::encode_error() << tws::error_description("could not initialize the PNG compressor.");
+
+  band.data.reserve(filtered.size() / 4 + 64);
+
+  try
+  {
+    zs.next_in = filtered.empty() ? Z_NULL : &filtered[0];
+    zs.avail_in = static_cast<uInt>(filtered.size());
+
+    if(last_band)
+    {
+      while(tws_wms_png_deflate(zs, Z_FINISH, band.data) != Z_STREAM_END)
+        ;
+    }
+    else
+    {
+      tws_wms_png_deflate(zs, Z_SYNC_FLUSH, band.data);
+    }
+  }
+  catch(...)
+  {
+    deflateEnd(&zs);
+    throw;
+  }
+
+  deflateEnd(&zs);
+}
+
+void
+tws::wms::composite(rgba_image& dst, const rgba_image& src)
+{
+  if((dst.width != src.width) || (dst.height != src.height))
+    throw tws::invalid_argument_error() << tws::error_description("Can not composite images of different sizes.");
+
+  uint8_t* d = dst.pixels.data();
+  const uint8_t* s = src.pixels.data();
+  const uint8_t* s_end = s + src.pixels.size();
+
+  for(; s != s_end; s += 4, d += 4)
+  {
+    uint32_t sa = s[3];
+
+    if(sa == 0)
+      continue;
+
+    if(sa == 255 || d[3] == 0)
+    {
+      std::memcpy(d, s, 4);
+      continue;
+    }
+
+// the weights of source and destination colors, scaled by 255 * 255
+    uint32_t ws = sa * 255;
+    uint32_t wd = d[3] * (255 - sa);
+    uint32_t wa = ws + wd;
+
+    for(int c = 0; c != 3; ++c)
+      d[c] = static_cast<uint8_t>((s[c] * ws + d[c] * wd + wa / 2) / wa);
+
+    d[3] = static_cast<uint8_t>((wa + 127) / 255);
+  }
+}
+
+std::string
+tws::wms::encode_png(const rgba_image& img, const png_options_t& options)
+{
+// split the rows in bands
+  uint32_t band_rows = (options.band_rows == 0) ? std::max<uint32_t>(img.height, 1) : options.band_rows;
+
+  std::size_t nbands = std::max<std::size_t>(1, (img.height + band_rows - 1) / band_rows);
+
+  std::vector<png_band> bands(nbands);
+
+  for(std::size_t b = 0; b != nbands; ++b)
+  {
+    bands[b].first_row = static_cast<uint32_t>(b * band_rows);
+    bands[b].last_row = static_cast<uint32_t>(std::min<std::size_t>(img.height, (b + 1) * band_rows));
+  }
+
+// compress the bands: small images are not worth handing over to other threads
+  auto compress_band = [&](std::size_t b) { tws_wms_png_compress_band(img, options, b + 1 == nbands, bands[b]); };
+
+  std::size_t nhelpers = std::max<std::size_t>(1, options.threads) - 1;
+
+  if((options.pool == nullptr) || (nhelpers == 0) || (nbands < png_min_parallel_bands))
+  {
+    for(std::size_t b = 0; b != nbands; ++b)
+      compress_band(b);
+  }
+  else
+  {
+    tws::core::parallel_for(*options.pool, nbands, nhelpers, compress_band);
+  }
+
+  std::size_t compressed_size = 0;
+
+  for(const png_band& band : bands)
+    compressed_size += band.data.size();
+
+  std::string out;
+
+  out.reserve(compressed_size + 64);
+
+  out.append("\x89PNG\r\n\x1a\n", 8);
+
+// header: 8-bit RGBA, no interlace
+  std::size_t start = tws_wms_png_begin_chunk(out, "IHDR");
+
+  tws_wms_png_put_uint32(out, img.width);
+  tws_wms_png_put_uint32(out, img.height);
+
+  const char ihdr[] = { 8, 6, 0, 0, 0 };
+
+  out.append(ihdr, sizeof(ihdr));
+
+  tws_wms_png_end_chunk(out, start);
+
+// image data: a zlib stream made of the deflate blocks of all bands and the checksum of the whole filtered data
+  start = tws_wms_png_begin_chunk(out, "IDAT");
+
+  const int level = options.compression_level;
+
+  const char zlib_header[] = { 0x78, static_cast<char>((level == 0 || level == 1) ? 0x01 : (level >= 2 && level <= 5) ? 0x5e : (level >= 7) ? 0xda : 0x9c) };
+
+  out.append(zlib_header, 2);
+
+  uLong adler = adler32(0L, Z_NULL, 0);
+
+  for(const png_band& band : bands)
+  {
+    out.append(band.data);
+
+    adler = adler32_combine(adler, band.adler, static_cast<z_off_t>(band.length));
+  }
+
+  tws_wms_png_put_uint32(out, static_cast<uint32_t>(adler));
+
+  tws_wms_png_end_chunk(out, start);
+
+// trailer
+  start = tws_wms_png_begin_chunk(out, "IEND");
+
+  tws_wms_png_end_chunk(out, start);
+
+  return out;
+}
+
+#ifdef TWS_WMS_JPEG_ENABLED
+
+// libjpeg reports errors through a callback that must not return
+struct tws_wms_jpeg_error_mgr
+{
+  jpeg_error_mgr pub;
+  std::jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+};
+
+static void
+tws_wms_jpeg_error_exit(j_common_ptr cinfo)
+{
+  tws_wms_jpeg_error_mgr* err = reinterpret_cast<tws_wms_jpeg_error_mgr*>(cinfo->err);
+
+  (*cinfo->err->format_message)(cinfo, err->message);
+
+  std::longjmp(err->jump, 1);
+}
+
+std::string
+tws::wms::encode_jpeg(const rgba_image& img, const jpeg_options_t& options)
+{
+  jpeg_compress_struct cinfo;
+  tws_wms_jpeg_error_mgr jerr;
+
+  unsigned char* buffer = nullptr;
+  unsigned long size = 0;
+
+  std::vector<uint8_t> line(static_cast<std::size_t>(img.width) * 3);
+
+  cinfo.err = jpeg_std_error(&jerr.pub);
+  jerr.pub.error_exit = tws_wms_jpeg_error_exit;
+
+  if(setjmp(jerr.jump))
+  {
+    jpeg_destroy_compress(&cinfo);
+
+    std::free(buffer);
+
+    throw tws::wms::encode_error() << tws::error_description(std::string("could not encode JPEG image: ") + jerr.message);
+  }
+
+  jpeg_create_compress(&cinfo);
+
+  jpeg_mem_dest(&cinfo, &buffer, &size);
+
+  cinfo.image_width = img.width;
+  cinfo.image_height = img.height;
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_RGB;
+
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, options.quality, TRUE);
+  jpeg_start_compress(&cinfo, TRUE);
+
+// JPEG has no alpha channel: the pixels are blended over white
+  while(cinfo.next_scanline < cinfo.image_height)
+  {
+    const uint8_t* src = img.row(cinfo.next_scanline);
+
+    for(std::size_t j = 0; j != img.width; ++j)
+    {
+      unsigned a = src[4 * j + 3];
+
+      line[3 * j] = static_cast<uint8_t>((src[4 * j] * a + 255 * (255 - a)) / 255);
+      line[3 * j + 1] = static_cast<uint8_t>((src[4 * j + 1] * a + 255 * (255 - a)) / 255);
+      line[3 * j + 2] = static_cast<uint8_t>((src[4 * j + 2] * a + 255 * (255 - a)) / 255);
+    }
+
+    JSAMPROW row = &line[0];
+
+    jpeg_write_scanlines(&cinfo, &row, 1);
+  }
+
+  jpeg_finish_compress(&cinfo);
+
+  jpeg_destroy_compress(&cinfo);
+
+  std::string out(reinterpret_cast<const char*>(buffer), size);
+
+  std::free(buffer);
+
+  return out;
+}
+
+#else
+
+std::string
+tws::wms::encode_jpeg(const rgba_image& /*img*/, const jpeg_options_t& /*options*/)
+{
+  throw tws::wms::encode_error() << tws::error_description("TWS was built without JPEG support.");
+}
+
+#endif  // TWS_WMS_JPEG_ENABLED
+
+#ifdef TWS_WMS_WEBP_ENABLED
+
+std::string
+tws::wms::encode_webp(const rgba_image& img, const webp_options_t& options)
+{
+  uint8_t* output = nullptr;
+
+  int stride = static_cast<int>(img.width) * 4;
+
+  std::size_t size = options.lossless ? WebPEncodeLosslessRGBA(&img.pixels[0], img.width, img.height, stride, &output)
+                                      : WebPEncodeRGBA(&img.pixels[0], img.width, img.height, stride, options.quality, &output);
+
+  if(size == 0)
+    throw tws::wms::encode_error() << tws::error_description("could not encode WebP image.");
+
+  std::string out(reinterpret_cast<const char*>(output), size);
+
+  WebPFree(output);
+
+  return out;
+}
+
+#else
+
+std::string
+tws::wms::encode_webp(const rgba_image& /*img*/, const webp_options_t& /*options*/)
+{
+  throw tws::wms::encode_error() << tws::error_description("TWS was built without WebP support.");
+}
+
+#endif  // TWS_WMS_WEBP_ENABLED
@@ -0,0 +1,141 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/image.hpp
+
+  \brief An in-memory RGBA image and its encoders.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WMS_IMAGE_HPP__
+#define __TWS_WMS_IMAGE_HPP__
+
+// TWS
+#include "config.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tws
+{
+  namespace core
+  {
+    class thread_pool;
+  }
+
+  namespace wms
+  {
+
+    /*!
+      \brief An image with 8-bit RGBA pixels stored row by row in a single buffer.
+
+      A new image has all of its pixels transparent.
+     */
+    struct rgba_image
+    {
+      rgba_image(uint32_t w, uint32_t h)
+        : width(w), height(h), pixels(static_cast<std::size_t>(w) * h * 4, 0)
+      {
+      }
+
+      uint8_t* row(uint32_t i) { return &pixels[static_cast<std::size_t>(i) * width * 4]; }
+
+      const uint8_t* row(uint32_t i) const { return &pixels[static_cast<std::size_t>(i) * width * 4]; }
+
+      uint32_t width;
+      uint32_t height;
+      std::vector<uint8_t> pixels;
+    };
+
+    //! Draw an image over another of the same size with the source-over operator of non-premultiplied alpha.
+    /*!
+      \exception tws::invalid_argument_error It throws an exception if the images differ in size.
+     */
+    void composite(rgba_image& dst, const rgba_image& src);
+
+    //! The PNG row filters.
+    struct png_filter_t
+    {
+      enum
+      {
+        none,
+        sub,
+        up,
+        average,
+        paeth
+      };
+    };
+
+    //! The settings of the PNG encoder.
+    struct png_options_t
+    {
+      int compression_level;   //!< A zlib level, from 0 (none) to 9 (best), or -1 for the zlib default.
+      int filter;              //!< The filter applied to every row: one of png_filter_t.
+      uint32_t band_rows;      //!< The number of rows compressed as an independent deflate block.
+      std::size_t threads;     //!< The maximum number of threads compressing the bands of a single image, the calling one included.
+      tws::core::thread_pool* pool;  //!< The threads shared by all images to help the calling one, or null.
+    };
+
+    //! The settings of the JPEG encoder.
+    struct jpeg_options_t
+    {
+      int quality;             //!< From 0 (worst) to 100 (best).
+    };
+
+    //! The settings of the WebP encoder.
+    struct webp_options_t
+    {
+      float quality;           //!< From 0 (smallest) to 100 (best); for lossless images, the compression effort.
+      bool lossless;
+    };
+
+    //! The number of bands from which compressing them in parallel pays off the handing over to other threads.
+    const std::size_t png_min_parallel_bands = 4;
+
+    //! Encode an image in the PNG format.
+    /*!
+      The image rows are split in bands compressed as independent deflate
+      blocks, which are then concatenated in a single zlib stream, as pigz does.
+      Images with at least png_min_parallel_bands bands are compressed by the
+      calling thread helped by the shared pool, the others by the calling thread alone.
+
+      \exception tws::wms::encode_error It throws an exception if zlib fails to compress the image data.
+     */
+    std::string encode_png(const rgba_image& img, const png_options_t& options);
+
+    //! Encode an image in the JPEG format, over a white background.
+    /*!
+      \exception tws::wms::encode_error It throws an exception if libjpeg fails or if TWS was built without JPEG support.
+     */
+    std::string encode_jpeg(const rgba_image& img, const jpeg_options_t& options);
+
+    //! Encode an image in the WebP format.
+    /*!
+      \exception tws::wms::encode_error It throws an exception if libwebp fails or if TWS was built without WebP support.
+     */
+    std::string encode_webp(const rgba_image& img, const webp_options_t& options);
+
+  }   // end namespace wms
+}     // end namespace tws
+
+#endif  // __TWS_WMS_IMAGE_HPP__
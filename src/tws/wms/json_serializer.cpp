@@ -529,5 +529,90 @@ tws::wms::read_style(const rapidjson::Value& jstyle)
   for(unsigned int i = 0; i < jcolors.Size(); ++i)
     result.colors.push_back(jcolors[i].GetString());
 
+  if(jstyle.HasMember("stretch"))
+  {
+    result.stretch = read_stretch(jstyle["stretch"]);
+
+    if(result.stretch.size() != result.colors.size())
+      throw tws::parse_error() << tws::error_description("error parsing style metadata: the stretch list must have one range per band.");
+  }
+
+  if(jstyle.HasMember("color_map"))
+    result.color_map = read_color_map(jstyle["color_map"]);
+
   return result;
 }
+
+std::vector<tws::geoarray::numeric_range_t>
+tws::wms::read_stretch(const rapidjson::Value& jstretch)
+{
+  if(!jstretch.IsArray())
+    throw tws::parse_error() << tws::error_description("error parsing style stretch metadata.");
+
+  std::vector<tws::geoarray::numeric_range_t> stretch;
+
+  for(unsigned int i = 0; i < jstretch.Size(); ++i)
+  {
+    const rapidjson::Value& jmin = jstretch[i]["min"];
+    const rapidjson::Value& jmax = jstretch[i]["max"];
+
+    if(!jmin.IsNumber() || jmin.IsNull() || !jmax.IsNumber() || jmax.IsNull())
+      throw tws::parse_error() << tws::error_description("error parsing style stretch metadata: each range must have a min and a max value.");
+
+    tws::geoarray::numeric_range_t range;
+
+    range.min_val = jmin.GetDouble();
+    range.max_val = jmax.GetDouble();
+
+    if(range.max_val <= range.min_val)
+      throw tws::parse_error() << tws::error_description("error parsing style stretch metadata: max value must be greater than min value.");
+
+    stretch.push_back(range);
+  }
+
+  return stretch;
+}
+
+std::vector<tws::wms::color_stop_t>
+tws::wms::read_color_map(const rapidjson::Value& jcolor_map)
+{
+  if(!jcolor_map.IsArray() || jcolor_map.Empty())
+    throw tws::parse_error() << tws::error_description("error parsing style color map metadata.");
+
+  std::vector<color_stop_t> color_map;
+
+  for(unsigned int i = 0; i < jcolor_map.Size(); ++i)
+  {
+    const rapidjson::Value& jvalue = jcolor_map[i]["value"];
+
+    if(!jvalue.IsNumber() || jvalue.IsNull())
+      throw tws::parse_error() << tws::error_description("error parsing style color map metadata: each entry must have a value.");
+
+    const rapidjson::Value& jcolor = jcolor_map[i]["color"];
+
+    if(!jcolor.IsString())
+      throw tws::parse_error() << tws::error_description("error parsing style color map metadata: each entry must have a color.");
+
+// colors are written as #rrggbb or #rrggbbaa
+    std::string color = jcolor.GetString();
+
+    if((color.size() != 7 && color.size() != 9) || (color[0] != '#') ||
+       (color.find_first_not_of("0123456789abcdefABCDEF", 1) != std::string::npos))
+      throw tws::parse_error() << tws::error_description("error parsing style color map metadata: colors must be written as #rrggbb or #rrggbbaa.");
+
+    color_stop_t stop;
+
+    stop.value = jvalue.GetDouble();
+    stop.red = static_cast<uint8_t>(std::stoul(color.substr(1, 2), nullptr, 16));
+    stop.green = static_cast<uint8_t>(std::stoul(color.substr(3, 2), nullptr, 16));
+    stop.blue = static_cast<uint8_t>(std::stoul(color.substr(5, 2), nullptr, 16));
+    stop.alpha = (color.size() == 9) ? static_cast<uint8_t>(std::stoul(color.substr(7, 2), nullptr, 16)) : 255;
+
+    if(!color_map.empty() && (stop.value <= color_map.back().value))
+      throw tws::parse_error() << tws::error_description("error parsing style color map metadata: entries must be sorted by increasing value.");
+
+    color_map.push_back(stop);
+  }
+
+  return color_map;
+}
@@ -75,6 +75,10 @@ namespace tws
 
     style_t read_style(const rapidjson::Value& jstyle);
 
+    std::vector<tws::geoarray::numeric_range_t> read_stretch(const rapidjson::Value& jstretch);
+
+    std::vector<color_stop_t> read_color_map(const rapidjson::Value& jcolor_map);
+
   }  // end namespace wms
 }    // end namespace tws
 
@@ -0,0 +1,702 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/tile_cache.cpp
+
+  \brief A cache for the maps rendered by WMS.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "tile_cache.hpp"
+#include "../core/utils.hpp"
+#include "../geoarray/timeline_manager.hpp"
+#include "exception.hpp"
+
+// STL
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Boost
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/format.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+namespace tws
+{
+  namespace wms
+  {
+
+    struct memory_tile
+    {
+      std::string key;
+      tws::core::cached_response value;
+      std::size_t nbytes;
+    };
+
+    struct disk_tile
+    {
+      std::string key;
+      std::string hash;
+      std::size_t nbytes;
+    };
+
+    typedef std::list<memory_tile> memory_lru_t;
+    typedef std::list<disk_tile> disk_lru_t;
+
+  }  // end namespace wms
+}    // end namespace tws
+
+// the 64-bit FNV-1a hash of a key, in hexadecimal: the name of its file in the disk tier
+static std::string
+tws_wms_key_hash(const std::string& key)
+{
+  return (boost::format("%016x") % tws::core::fnv1a_hash(key)).str();
+}
+
+// tells if the layer list at the beginning of a key contains a given layer
+static bool
+tws_wms_key_has_layer(const std::string& key, const std::string& layer)
+{
+  std::string layers = key.substr(0, key.find('|'));
+
+  std::vector<std::string> names;
+
+  boost::split(names, layers, boost::is_any_of(","));
+
+  return std::find(names.begin(), names.end(), layer) != names.end();
+}
+
+static void
+tws_wms_remove_files(const std::vector<boost::filesystem::path>& files)
+{
+  for(const boost::filesystem::path& f : files)
+  {
+    boost::system::error_code ec;
+
+    boost::filesystem::remove(f, ec);
+  }
+}
+
+struct tws::wms::tile_cache::impl
+{
+  mutable boost::mutex mtx;
+
+// memory tier
+  memory_lru_t memory_lru;
+  std::unordered_map<std::string, memory_lru_t::iterator> memory_entries;
+  std::size_t memory_bytes;
+  std::size_t memory_max_bytes;
+
+// disk tier: an index of the files in the cache directory
+  boost::filesystem::path disk_path;
+  disk_lru_t disk_lru;
+  std::unordered_map<std::string, disk_lru_t::iterator> disk_entries;
+  std::size_t disk_bytes;
+  std::size_t disk_max_bytes;
+
+// the renders in progress
+  std::map<std::string, std::shared_future<tws::core::cached_response> > pending;
+
+  double bbox_quantum;
+
+  tile_cache_stats counters;
+
+  impl()
+    : memory_bytes(0), memory_max_bytes(0),
+      disk_bytes(0), disk_max_bytes(0),
+      bbox_quantum(0.0)
+  {
+    counters = tile_cache_stats();
+  }
+
+  boost::filesystem::path file_path(const std::string& hash) const
+  {
+    return disk_path / hash.substr(0, 2) / (hash + ".tile");
+  }
+
+// the functions below must be called with the mutex held
+
+  void memory_insert(const std::string& key, const tws::core::cached_response& value);
+
+  void memory_erase(memory_lru_t::iterator it);
+
+  void disk_insert(const disk_tile& tile, std::vector<boost::filesystem::path>& evicted);
+
+  void disk_erase(disk_lru_t::iterator it);
+
+// the functions below do their I/O without holding the mutex
+
+  bool disk_read(const std::string& key, tws::core::cached_response& value);
+
+  void disk_write(const std::string& key, const tws::core::cached_response& value);
+
+  void disk_scan();
+};
+
+void
+tws::wms::tile_cache::impl::memory_insert(const std::string& key,
+                                          const tws::core::cached_response& value)
+{
+  std::size_t nbytes = value.content->size() + 2 * key.size() + value.etag.size() + sizeof(memory_tile) + 64;
+
+  if(nbytes > memory_max_bytes)
+    return;
+
+  std::unordered_map<std::string, memory_lru_t::iterator>::iterator it = memory_entries.find(key);
+
+  if(it != memory_entries.end())
+    memory_erase(it->second);
+
+  while(!memory_lru.empty() && (memory_bytes + nbytes > memory_max_bytes))
+  {
+    memory_erase(--memory_lru.end());
+
+    ++counters.memory_evictions;
+  }
+
+  memory_tile tile = { key, value, nbytes };
+
+  memory_lru.push_front(tile);
+
+  memory_entries[key] = memory_lru.begin();
+
+  memory_bytes += nbytes;
+}
+
+void
+tws::wms::tile_cache::impl::memory_erase(memory_lru_t::iterator it)
+{
+  memory_bytes -= it->nbytes;
+
+  memory_entries.erase(it->key);
+
+  memory_lru.erase(it);
+}
+
+void
+tws::wms::tile_cache::impl::disk_insert(const disk_tile& tile,
+                                        std::vector<boost::filesystem::path>& evicted)
+{
+  std::unordered_map<std::string, disk_lru_t::iterator>::iterator it = disk_entries.find(tile.hash);
+
+  if(it != disk_entries.end())
+    disk_erase(it->second);
+
+  disk_lru.push_front(tile);
+
+  disk_entries[tile.hash] = disk_lru.begin();
+
+  disk_bytes += tile.nbytes;
+
+  while((disk_bytes > disk_max_bytes) && (disk_lru.size() > 1))
+  {
+    disk_lru_t::iterator last = --disk_lru.end();
+
+    evicted.push_back(file_path(last->hash));
+
+    disk_erase(last);
+
+    ++counters.disk_evictions;
+  }
+}
+
+void
+tws::wms::tile_cache::impl::disk_erase(disk_lru_t::iterator it)
+{
+  disk_bytes -= it->nbytes;
+
+  disk_entries.erase(it->hash);
+
+  disk_lru.erase(it);
+}
+
+bool
+tws::wms::tile_cache::impl::disk_read(const std::string& key,
+                                      tws::core::cached_response& value)
+{
+  if(disk_max_bytes == 0)
+    return false;
+
+  std::string hash = tws_wms_key_hash(key);
+
+  {
+    boost::lock_guard<boost::mutex> lock(mtx);
+
+    std::unordered_map<std::string, disk_lru_t::iterator>::iterator it = disk_entries.find(hash);
+
+    if(it == disk_entries.end())
+      return false;
+
+    disk_lru.splice(disk_lru.begin(), disk_lru, it->second);
+  }
+
+// a file evicted meanwhile or written for another key with the same hash is just a miss
+  std::ifstream istr(file_path(hash).string().c_str(), std::ios::in | std::ios::binary);
+
+  std::string file_key;
+
+  if(!std::getline(istr, file_key) || (file_key != key))
+    return false;
+
+  if(!std::getline(istr, value.content_type) || !std::getline(istr, value.etag))
+    return false;
+
+  value.content = std::make_shared<const std::string>(std::istreambuf_iterator<char>(istr), std::istreambuf_iterator<char>());
+
+  return true;
+}
+
+void
+tws::wms::tile_cache::impl::disk_write(const std::string& key,
+                                       const tws::core::cached_response& value)
+{
+  if(disk_max_bytes == 0)
+    return;
+
+  std::string hash = tws_wms_key_hash(key);
+
+  boost::filesystem::path fpath = file_path(hash);
+
+  boost::system::error_code ec;
+
+  boost::filesystem::create_directories(fpath.parent_path(), ec);
+
+// the file is written aside and then renamed so that readers never see a partial tile
+  boost::filesystem::path tmp_path = fpath.parent_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.tmp");
+
+  {
+    std::ofstream ostr(tmp_path.string().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+    ostr << key << '\n' << value.content_type << '\n' << value.etag << '\n';
+
+    ostr.write(value.content->data(), value.content->size());
+
+    if(!ostr)
+    {
+      ostr.close();
+      boost::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+
+  boost::filesystem::rename(tmp_path, fpath, ec);
+
+  if(ec)
+  {
+    boost::filesystem::remove(tmp_path, ec);
+    return;
+  }
+
+  disk_tile tile = { key, hash, key.size() + value.content_type.size() + value.etag.size() + 3 + value.content->size() };
+
+  std::vector<boost::filesystem::path> evicted;
+
+  {
+    boost::lock_guard<boost::mutex> lock(mtx);
+
+    disk_insert(tile, evicted);
+  }
+
+  tws_wms_remove_files(evicted);
+}
+
+void
+tws::wms::tile_cache::impl::disk_scan()
+{
+  boost::system::error_code ec;
+
+  boost::filesystem::create_directories(disk_path, ec);
+
+  if(!boost::filesystem::is_directory(disk_path))
+  {
+    boost::format err_msg("could not create the tile cache directory '%1%'.");
+
+    throw tws::file_open_error() << tws::error_description((err_msg % disk_path.string()).str());
+  }
+
+// index the tiles left by previous runs, the most recently written ones at the front of the LRU list
+  std::vector<std::pair<std::time_t, disk_tile> > tiles;
+
+  for(boost::filesystem::recursive_directory_iterator it(disk_path), it_end; it != it_end; ++it)
+  {
+    const boost::filesystem::path& p = it->path();
+
+    if(!boost::filesystem::is_regular_file(p))
+      continue;
+
+    if(p.extension() != ".tile")
+    {
+// remove the temporary files of interrupted writes
+      if(p.extension() == ".tmp")
+        boost::filesystem::remove(p, ec);
+
+      continue;
+    }
+
+    std::ifstream istr(p.string().c_str(), std::ios::in | std::ios::binary);
+
+    disk_tile tile;
+
+    if(!std::getline(istr, tile.key))
+      continue;
+
+    tile.hash = p.stem().string();
+    tile.nbytes = static_cast<std::size_t>(boost::filesystem::file_size(p));
+
+    tiles.push_back(std::make_pair(boost::filesystem::last_write_time(p), tile));
+  }
+
+  std::sort(tiles.begin(), tiles.end(),
+            [](const std::pair<std::time_t, disk_tile>& lhs, const std::pair<std::time_t, disk_tile>& rhs)
+            { return lhs.first < rhs.first; });
+
+  std::vector<boost::filesystem::path> evicted;
+
+  for(const std::pair<std::time_t, disk_tile>& t : tiles)
+    disk_insert(t.second, evicted);
+
+  tws_wms_remove_files(evicted);
+}
+
+tws::core::cached_response
+tws::wms::tile_cache::get(const std::string& key,
+                          const render_function_t& render)
+{
+  if(!enabled())
+    return render();
+
+  std::promise<tws::core::cached_response> promise;
+
+  std::shared_future<tws::core::cached_response> result;
+
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    std::unordered_map<std::string, memory_lru_t::iterator>::iterator it = pimpl_->memory_entries.find(key);
+
+    if(it != pimpl_->memory_entries.end())
+    {
+      pimpl_->memory_lru.splice(pimpl_->memory_lru.begin(), pimpl_->memory_lru, it->second);
+
+      ++pimpl_->counters.memory_hits;
+
+      return it->second->value;
+    }
+
+    std::map<std::string, std::shared_future<tws::core::cached_response> >::iterator it_pending = pimpl_->pending.find(key);
+
+    if(it_pending != pimpl_->pending.end())
+    {
+      result = it_pending->second;
+
+      ++pimpl_->counters.coalesced;
+    }
+    else
+    {
+      pimpl_->pending[key] = promise.get_future().share();
+    }
+  }
+
+// another request is producing the map: wait for it
+  if(result.valid())
+    return result.get();
+
+  try
+  {
+    tws::core::cached_response value;
+
+    bool from_disk = pimpl_->disk_read(key, value);
+
+    if(!from_disk)
+    {
+      value = render();
+
+      pimpl_->disk_write(key, value);
+    }
+
+    {
+      boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+      if(from_disk)
+        ++pimpl_->counters.disk_hits;
+      else
+        ++pimpl_->counters.misses;
+
+      if(pimpl_->memory_max_bytes != 0)
+        pimpl_->memory_insert(key, value);
+
+      pimpl_->pending.erase(key);
+    }
+
+    promise.set_value(value);
+
+    return value;
+  }
+  catch(...)
+  {
+    {
+      boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+      pimpl_->pending.erase(key);
+    }
+
+    promise.set_exception(std::current_exception());
+
+    throw;
+  }
+}
+
+bool
+tws::wms::tile_cache::find(const std::string& key,
+                           tws::core::cached_response& value)
+{
+  if(!enabled())
+    return false;
+
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    std::unordered_map<std::string, memory_lru_t::iterator>::iterator it = pimpl_->memory_entries.find(key);
+
+    if(it != pimpl_->memory_entries.end())
+    {
+      pimpl_->memory_lru.splice(pimpl_->memory_lru.begin(), pimpl_->memory_lru, it->second);
+
+      ++pimpl_->counters.memory_hits;
+
+      value = it->second->value;
+
+      return true;
+    }
+  }
+
+  if(!pimpl_->disk_read(key, value))
+    return false;
+
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  ++pimpl_->counters.disk_hits;
+
+  if(pimpl_->memory_max_bytes != 0)
+    pimpl_->memory_insert(key, value);
+
+  return true;
+}
+
+void
+tws::wms::tile_cache::insert(const std::string& key,
+                             const tws::core::cached_response& value)
+{
+  if(!enabled())
+    return;
+
+  pimpl_->disk_write(key, value);
+
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  if(pimpl_->memory_max_bytes != 0)
+    pimpl_->memory_insert(key, value);
+}
+
+void
+tws::wms::tile_cache::invalidate(const std::string& layer)
+{
+  std::vector<boost::filesystem::path> removed;
+
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    memory_lru_t::iterator it = pimpl_->memory_lru.begin();
+
+    while(it != pimpl_->memory_lru.end())
+    {
+      memory_lru_t::iterator next = it;
+
+      ++next;
+
+      if(tws_wms_key_has_layer(it->key, layer))
+        pimpl_->memory_erase(it);
+
+      it = next;
+    }
+
+    disk_lru_t::iterator dit = pimpl_->disk_lru.begin();
+
+    while(dit != pimpl_->disk_lru.end())
+    {
+      disk_lru_t::iterator next = dit;
+
+      ++next;
+
+      if(tws_wms_key_has_layer(dit->key, layer))
+      {
+        removed.push_back(pimpl_->file_path(dit->hash));
+
+        pimpl_->disk_erase(dit);
+      }
+
+      dit = next;
+    }
+  }
+
+  tws_wms_remove_files(removed);
+}
+
+void
+tws::wms::tile_cache::clear()
+{
+  std::vector<boost::filesystem::path> removed;
+
+  {
+    boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+    for(const disk_tile& tile : pimpl_->disk_lru)
+      removed.push_back(pimpl_->file_path(tile.hash));
+
+    pimpl_->memory_lru.clear();
+    pimpl_->memory_entries.clear();
+    pimpl_->memory_bytes = 0;
+
+    pimpl_->disk_lru.clear();
+    pimpl_->disk_entries.clear();
+    pimpl_->disk_bytes = 0;
+  }
+
+  tws_wms_remove_files(removed);
+}
+
+bool
+tws::wms::tile_cache::enabled() const
+{
+  return (pimpl_->memory_max_bytes != 0) || (pimpl_->disk_max_bytes != 0);
+}
+
+double
+tws::wms::tile_cache::bbox_quantum() const
+{
+  return pimpl_->bbox_quantum;
+}
+
+tws::wms::tile_cache_stats
+tws::wms::tile_cache::stats() const
+{
+  boost::lock_guard<boost::mutex> lock(pimpl_->mtx);
+
+  tile_cache_stats st = pimpl_->counters;
+
+  st.memory_entries = pimpl_->memory_entries.size();
+  st.memory_bytes = pimpl_->memory_bytes;
+  st.disk_entries = pimpl_->disk_entries.size();
+  st.disk_bytes = pimpl_->disk_bytes;
+
+  return st;
+}
+
+tws::wms::tile_cache&
+tws::wms::tile_cache::instance()
+{
+  static tile_cache inst;
+
+  return inst;
+}
+
+tws::wms::tile_cache::tile_cache()
+  : pimpl_(nullptr)
+{
+// the impl is owned here until the configuration is read: a bad entry or a failing disk scan must not leak it
+  std::unique_ptr<impl> pimpl(new impl);
+
+  std::string wms_file = tws::core::find_in_app_path("share/tws/config/wms.json");
+
+  if(wms_file.empty())
+    throw tws::file_exists_error() << tws::error_description("Could not locate file 'share/tws/config/wms.json'.");
+
+  std::unique_ptr<rapidjson::Document> jdocument(tws::core::open_json_file(wms_file));
+
+  if(!jdocument->HasMember("tile_cache"))
+  {
+    pimpl_ = pimpl.release();
+
+    return;
+  }
+
+  const rapidjson::Value& jcache = (*jdocument)["tile_cache"];
+
+  if(!jcache.IsObject())
+    throw tws::parse_error() << tws::error_description("tile_cache entry in file 'share/tws/config/wms.json' must be an object.");
+
+  const rapidjson::Value& jmemory_max_bytes = jcache["memory_max_bytes"];
+
+  if(!jmemory_max_bytes.IsNumber() || jmemory_max_bytes.IsNull())
+    throw tws::parse_error() << tws::error_description("tile_cache must have a numeric memory_max_bytes entry.");
+
+  const rapidjson::Value& jdisk_max_bytes = jcache["disk_max_bytes"];
+
+  if(!jdisk_max_bytes.IsNumber() || jdisk_max_bytes.IsNull())
+    throw tws::parse_error() << tws::error_description("tile_cache must have a numeric disk_max_bytes entry.");
+
+  const rapidjson::Value& jbbox_quantum = jcache["bbox_quantum"];
+
+  if(!jbbox_quantum.IsNumber() || jbbox_quantum.IsNull() || (jbbox_quantum.GetDouble() < 0.0))
+    throw tws::parse_error() << tws::error_description("tile_cache must have a non-negative bbox_quantum entry.");
+
+  pimpl->memory_max_bytes = static_cast<std::size_t>(jmemory_max_bytes.GetUint64());
+  pimpl->disk_max_bytes = static_cast<std::size_t>(jdisk_max_bytes.GetUint64());
+  pimpl->bbox_quantum = jbbox_quantum.GetDouble();
+
+// a zero budget disables the disk tier
+  if(pimpl->disk_max_bytes != 0)
+  {
+    const rapidjson::Value& jdisk_path = jcache["disk_path"];
+
+    if(!jdisk_path.IsString() || jdisk_path.IsNull())
+      throw tws::parse_error() << tws::error_description("tile_cache must have a disk_path entry when disk_max_bytes is not zero.");
+
+    pimpl->disk_path = jdisk_path.GetString();
+
+    pimpl->disk_scan();
+  }
+
+  pimpl_ = pimpl.release();
+
+  if(enabled())
+    tws::geoarray::timeline_manager::instance().add_change_handler(boost::bind(&tile_cache::invalidate, this, _1));
+}
+
+tws::wms::tile_cache::~tile_cache()
+{
+  delete pimpl_;
+}
@@ -0,0 +1,134 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wms/tile_cache.hpp
+
+  \brief A cache for the maps rendered by WMS.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WMS_TILE_CACHE_HPP__
+#define __TWS_WMS_TILE_CACHE_HPP__
+
+// TWS
+#include "../core/cached_response.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Boost
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wms
+  {
+
+    //! The counters of the tile cache.
+    struct tile_cache_stats
+    {
+      uint64_t memory_hits;
+      uint64_t disk_hits;
+      uint64_t misses;
+      uint64_t coalesced;         //!< Requests that waited for a render already in progress.
+      uint64_t memory_evictions;
+      uint64_t disk_evictions;
+      std::size_t memory_entries;
+      std::size_t memory_bytes;
+      std::size_t disk_entries;
+      std::size_t disk_bytes;
+    };
+
+    /*!
+      \brief A two-tier cache of encoded map images.
+
+      The most recently used images are kept in memory and all of them are also
+      written to a directory, in a file named after the hash of the request key.
+      Both tiers are bounded by the byte budgets informed in the tile_cache entry
+      of share/tws/config/wms.json.
+
+      A map is rendered only once even if many requests for it arrive at the same
+      time: the later requests wait for the result of the first one.
+
+      Keys start with the comma separated list of layers, followed by a '|'. The
+      maps of a layer are discarded whenever its timeline is updated in the
+      timeline manager.
+     */
+    class tile_cache : public boost::noncopyable
+    {
+      public:
+
+        typedef boost::function<tws::core::cached_response ()> render_function_t;
+
+        //! Returns the map identified by a key, rendering it if it is not found in any tier.
+        /*!
+          \exception Any exception thrown by render, which is also rethrown to the waiting requests.
+         */
+        tws::core::cached_response get(const std::string& key,
+                                       const render_function_t& render);
+
+        //! Look up a map in both tiers without rendering it.
+        bool find(const std::string& key, tws::core::cached_response& value);
+
+        //! Add or replace a map in both tiers.
+        void insert(const std::string& key, const tws::core::cached_response& value);
+
+        //! Discard all maps containing a given layer.
+        void invalidate(const std::string& layer);
+
+        //! Discard all maps from both tiers.
+        void clear();
+
+        //! Tells if any of the tiers has a non-zero byte budget.
+        bool enabled() const;
+
+        //! The fraction of an output pixel the bounding boxes are rounded to in the keys.
+        double bbox_quantum() const;
+
+        //! Returns a snapshot of the cache counters.
+        tile_cache_stats stats() const;
+
+        //! Access the singleton.
+        /*!
+          \exception tws::file_exists_error If the file 'share/tws/config/wms.json' is not found.
+          \exception tws::parse_error       If the tile_cache section of the config file is invalid.
+         */
+        static tile_cache& instance();
+
+      private:
+
+        tile_cache();
+
+        ~tile_cache();
+
+      private:
+
+        struct impl;
+
+        impl* pimpl_;
+    };
+
+  }   // end namespace wms
+}     // end namespace tws
+
+#endif  // __TWS_WMS_TILE_CACHE_HPP__
@@ -27,9 +27,12 @@
 
 // TWS
 #include "wms.hpp"
+#include "../core/cached_response.hpp"
 #include "../core/http_request.hpp"
 #include "../core/http_response.hpp"
+#include "../core/query_string.hpp"
 #include "../core/service_operations_manager.hpp"
+#include "../core/thread_pool.hpp"
 #include "../core/utils.hpp"
 #include "../geoarray/geoarray_manager.hpp"
 #include "../geoarray/timeline.hpp"
@@ -39,20 +42,35 @@
 #include "../scidb/connection_pool.hpp"
 #include "../scidb/mem_array.hpp"
 #include "../scidb/utils.hpp"
+#include "color_kernels.hpp"
 #include "data_types.hpp"
+#include "encoder_manager.hpp"
+#include "image.hpp"
+#include "tile_cache.hpp"
 #include "wms_manager.hpp"
 #include "xml_serializer.hpp"
 
 // STL
 #include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
 #include <memory>
 #include <tuple>
 
 // Boost
 #include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/join.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
 #include <boost/format.hpp>
+#include <boost/functional/hash.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 // SciDB
 #include <SciDBAPI.h>
@@ -61,9 +79,6 @@
 #include <rapidxml/rapidxml.hpp>
 #include <rapidxml/rapidxml_print.hpp>
 
-// GD
-#include <gd.h>
-
 // TerraLib
 #include <terralib/geometry/Envelope.h>
 #include <terralib/raster/Grid.h>
@@ -73,6 +88,13 @@ namespace tws
 {
   namespace wms
   {
+    //! The kernel used to resample the array cells to the pixels of the output image.
+    enum resampling_kernel
+    {
+      nearest_resampling,
+      bilinear_resampling
+    };
+
     struct get_map_request_parameters
     {
       std::string version;
@@ -84,9 +106,59 @@ namespace tws
       uint32_t height;
       std::string format;
       std::string time_point;
+      resampling_kernel resampling;
+    };
+
+    /*!
+      \brief The window of array cells covered by a GetMap request.
+
+      The output image pixels are spread evenly over the requested bounding box:
+      the center of pixel (j, i) lies at array column col0 + (j + 0.5) * col_scale
+      and array row row0 + (i + 0.5) * row_scale. Only the cells multiple of
+      step, counting from the window origin, are retrieved from the array.
+     */
+    struct render_window
+    {
+      bool empty;
+      int64_t init_col;
+      int64_t fin_col;
+      int64_t init_row;
+      int64_t fin_row;
+      int64_t step;
+      double col0;
+      double col_scale;
+      double row0;
+      double row_scale;
+    };
+
+    //! A tile request, through either the WMTS KVP encoding or a XYZ path.
+    struct tile_request_parameters
+    {
+      std::string layer;
+      std::string style;
+      uint32_t zoom;
+      uint32_t row;
+      uint32_t col;
+      std::string format;
+      std::string time_point;
     };
 
-    typedef std::tuple<const layer_t*, const style_t*, const tws::geoarray::geoarray_t*, const tws::geoarray::timeline*> layer_tuple_t;
+    /*!
+      \brief A zoom level in the tile matrix of a layer.
+
+      The finest level, max_zoom, has one array cell per tile pixel and each
+      coarser level doubles the cells per pixel along both axes.
+     */
+    struct tile_matrix_t
+    {
+      uint32_t max_zoom;
+      int64_t cells_per_pixel;
+      int64_t tile_cells;       //!< The number of cells covered by a tile along each axis.
+      int64_t matrix_width;     //!< The number of tile columns.
+      int64_t matrix_height;    //!< The number of tile rows.
+    };
+
+    typedef std::tuple<const layer_t*, const style_t*, const tws::geoarray::geoarray_t*, std::shared_ptr<const tws::geoarray::timeline> > layer_tuple_t;
 
     get_map_request_parameters
     decode_get_map_request(const tws::core::query_string_t& qstr);
@@ -94,21 +166,119 @@ namespace tws
     std::vector<layer_tuple_t>
     valid(const get_map_request_parameters& parameters);
 
-    gdImagePtr render(const layer_tuple_t& ltuple,
+    //! Find a layer and one of its styles; the layer's first style is taken when no style name is informed.
+    layer_tuple_t find_layer(const std::string& layer_name,
+                             const std::string& style_name);
+
+    tile_request_parameters
+    decode_get_tile_request(const tws::core::query_string_t& qstr);
+
+    //! Decode a path in the form: /wmts/tile/{layer}/{time}/{z}/{x}/{y}.{png|jpg|webp}
+    tile_request_parameters
+    decode_xyz_tile_request(const std::string& path,
+                            const tws::core::query_string_t& qstr);
+
+    tile_matrix_t
+    compute_tile_matrix(const tws::geoarray::geoarray_t& garray,
+                        const tile_matrix_set_t& tms,
+                        uint32_t zoom);
+
+    /*!
+      \brief Render the metatile around a tile, cache all of its tiles and return the requested one.
+
+      Concurrent requests for tiles in the same metatile wait for a single rendering.
+     */
+    tws::core::cached_response
+    render_tile(const layer_tuple_t& ltuple,
+                const tile_request_parameters& parameters);
+
+    rgba_image render(const layer_tuple_t& ltuple,
+                      const get_map_request_parameters& parameters);
+
+    /*!
+      \brief Render a list of layers and composite them in order, the first one at the bottom.
+
+      The calling thread renders the layers together with up to layer_render_threads
+      helpers of a pool shared by all requests, each one with its own connection
+      taken from the pool. A helper busy with other maps is not waited for: the
+      calling thread renders the remaining layers itself. With layer_render_threads
+      set to 0 the layers are rendered one after the other.
+     */
+    rgba_image render(const std::vector<layer_tuple_t>& layers,
                       const get_map_request_parameters& parameters);
 
-    gdImagePtr
+    //! Encode a rendered image as a response in one of the formats with an encoder.
+    tws::core::cached_response encode_map(const rgba_image& img,
+                                          const std::string& format);
+
+    //! Render the layers of a map and encode it in the requested format.
+    tws::core::cached_response
+    render_map(const std::vector<layer_tuple_t>& layers,
+               const get_map_request_parameters& parameters);
+
+    //! The tile cache key of a GetMap request, with the bounding box rounded to a fraction of the output pixel size.
+    std::string make_tile_key(const get_map_request_parameters& parameters,
+                              double bbox_quantum);
+
+    rgba_image
     render_single_band_gray(tws::scidb::connection* conn,
                             std::size_t time_idx,
                             const layer_tuple_t& ltuple,
                             const get_map_request_parameters& parameters);
 
-    gdImagePtr
+    rgba_image
     render_rgb(tws::scidb::connection* conn,
                std::size_t time_idx,
                const layer_tuple_t& ltuple,
                const get_map_request_parameters& parameters);
 
+    //! Render a band through the color map of the style.
+    rgba_image
+    render_color_map(tws::scidb::connection* conn,
+                     std::size_t time_idx,
+                     const layer_tuple_t& ltuple,
+                     const get_map_request_parameters& parameters);
+
+    //! The range of a style band, in the band units after its scale factor is applied: the style stretch, if any, or the attribute valid range.
+    tws::geoarray::numeric_range_t
+    style_band_range(const style_t& style,
+                     std::size_t band,
+                     const tws::geoarray::attribute_t& attr);
+
+    //! Compute the array window and the sampling step needed to render an image of the requested size.
+    render_window
+    compute_render_window(const tws::geoarray::geoarray_t& garray,
+                          const get_map_request_parameters& parameters);
+
+    //! Retrieve the listed attributes of the cells in the sampling lattice of a render window.
+    std::unique_ptr<tws::scidb::array2d<double> >
+    fetch_window(tws::scidb::connection* conn,
+                 std::size_t time_idx,
+                 const layer_t& layer,
+                 const tws::geoarray::geoarray_t& garray,
+                 const std::vector<std::string>& attributes,
+                 const render_window& window);
+
+    //! Resample a band of the fetched cells to the output image grid; pixels outside the array are set to NaN.
+    void resample(const tws::scidb::array2d<double>& data,
+                  std::size_t band,
+                  double missing_value,
+                  const render_window& window,
+                  const get_map_request_parameters& parameters,
+                  std::vector<double>& result);
+
+    /*!
+      \brief Returns the attribute of an array used as a style band.
+
+      A band that is not a plain name is taken as a SciDB expression yielding a color
+      component: it is then described as an attribute in the range [0, 255] with NaN as missing value.
+
+      \exception tws::core::http_request_error If the band is a name but the array has no such attribute.
+     */
+    tws::geoarray::attribute_t
+    band_attribute(const tws::geoarray::geoarray_t& garray,
+                   const std::string& band);
+
     te::gm::Envelope
     compute_intersection(te::gm::Envelope query_rectangle,
                          int query_srid,
@@ -119,35 +289,93 @@ namespace tws
   } // end namespace wms
 }   // end namespace tws
 
-void
-tws::wms::get_capabilities_functor::operator()(const tws::core::http_request& request,
-                                               tws::core::http_response& response)
+/*
+  For each of the npixels output pixels along an axis, compute the positions in the sampling
+  lattice of the two cells around the pixel center and the interpolation weight of the second one.
+  For the nearest kernel, the weight tells which of the two cells is the closest one.
+  Pixels whose center falls outside the window get a negative position.
+ */
+static void
+tws_wms_sampling_positions(double origin, double scale,
+                           int64_t first, int64_t last, int64_t step,
+                           std::size_t npixels,
+                           std::vector<int64_t>& p0,
+                           std::vector<int64_t>& p1,
+                           std::vector<double>& weight)
 {
-  const rapidxml::xml_document<>& xml_capabilities = tws::wms::wms_manager::instance().xml_capabilities();
+  p0.assign(npixels, -1);
+  p1.assign(npixels, -1);
+  weight.assign(npixels, 0.0);
+
+  int64_t last_sample = (last - first) / step;
+
+  for(std::size_t k = 0; k != npixels; ++k)
+  {
+    double pos = origin + (k + 0.5) * scale;
 
-// output result
-  std::string str_buff;
+// cell centers are at integer positions
+    if((pos < first - 0.5) || (pos >= last + 0.5))
+      continue;
+
+    double s = (pos - first) / step;
+
+    if(s <= 0.0)
+    {
+      p0[k] = p1[k] = 0;
+      continue;
+    }
+
+    int64_t s0 = static_cast<int64_t>(std::floor(s));
+
+    if(s0 >= last_sample)
+    {
+      p0[k] = p1[k] = last_sample;
+      continue;
+    }
+
+    p0[k] = s0;
+    p1[k] = s0 + 1;
+    weight[k] = s - s0;
+  }
+}
+
+// the metatiles are rendered under a lock taken from a fixed set, chosen by the metatile key
+static boost::mutex&
+tws_wms_metatile_mutex(const std::string& metatile_key)
+{
+  static boost::mutex stripes[64];
 
-  rapidxml::print(std::back_inserter(str_buff), xml_capabilities, 0);
+  return stripes[boost::hash<std::string>()(metatile_key) % 64];
+}
 
-  const char* p_str_buff = str_buff.c_str();
+// the cache key of a tile: it starts with the layer name, as the keys of GetMap requests
+static std::string
+tws_wms_tile_key(const tws::wms::tile_request_parameters& parameters,
+                 uint32_t row, uint32_t col)
+{
+  return parameters.layer + "|" + parameters.style + "|wmts:"
+       + std::to_string(parameters.zoom) + "/" + std::to_string(col) + "/" + std::to_string(row) + "|"
+       + parameters.time_point + "|" + parameters.format;
+}
 
-  response.add_header("Content-Type", "application/xml");
-  response.add_header("Access-Control-Allow-Origin", "*");
-  response.set_content(p_str_buff, str_buff.size());
+void
+tws::wms::get_capabilities_functor::operator()(const tws::core::http_request& request,
+                                               tws::core::http_response& response)
+{
+  tws::core::send_cached_response(tws::wms::wms_manager::instance().cached_capabilities(), request, response);
 }
 
 void
 tws::wms::get_map_functor::operator()(const tws::core::http_request& request,
                                       tws::core::http_response& response)
 {
-// get client query string
-  const char* qstring = request.query_string().c_str();
+// get client query string: it is decoded in place
+  std::string qstring = request.query_string();
 
-  if(qstring == nullptr)
+  if(qstring.empty())
     throw tws::core::http_request_error() << tws::error_description("GetMap operation requires the following parameters: \"VERSION\", \"LAYERS\", \"CRS\", \"BBOX\", \"WIDTH\", \"HEIGHT\", \"FORMAT\", \"TIME\".");
 
-// parse plain text query string to a std::map
+// split the query string into its key-value pairs
   tws::core::query_string_t qstr = tws::core::expand(qstring);
 
 // parse parameters to a struct
@@ -156,16 +384,13 @@ tws::wms::get_map_functor::operator()(const tws::core::http_request& request,
 // valid parameters
   std::vector<tws::wms::layer_tuple_t> layers_to_render = valid(parameters);
 
-// now... let's render the selected layers!
-  std::unique_ptr<gdImage, decltype(&gdImageDestroy)> img(render(layers_to_render[0], parameters), gdImageDestroy);
+// now... let's render the selected layers, unless the map is already in the cache!
+  tile_cache& cache = tile_cache::instance();
 
-  int png_size = 0;
+  tws::core::cached_response map = cache.get(make_tile_key(parameters, cache.bbox_quantum()),
+                                             boost::bind(&tws::wms::render_map, boost::cref(layers_to_render), boost::cref(parameters)));
 
-  std::unique_ptr<void, decltype(&gdFree)> png_img(gdImagePngPtr(img.get(), &png_size), gdFree);
-
-  response.add_header("Content-Type", "image/png");
-  response.add_header("Access-Control-Allow-Origin", "*");
-  response.set_content((char*)(png_img.get()), png_size);
+  tws::core::send_cached_response(map, request, response);
 }
 
 void
@@ -175,6 +400,39 @@ tws::wms::get_feature_info_functor::operator()(const tws::core::http_request& re
 
 }
 
+void
+tws::wms::get_tile_functor::operator()(const tws::core::http_request& request,
+                                       tws::core::http_response& response)
+{
+  std::string qstring = request.query_string();
+
+  if(qstring.empty())
+    throw tws::core::http_request_error() << tws::error_description("GetTile operation requires the following parameters: \"LAYER\", \"TILEMATRIX\", \"TILEROW\", \"TILECOL\".");
+
+  tws::core::query_string_t qstr = tws::core::expand(qstring);
+
+  tile_request_parameters parameters = decode_get_tile_request(qstr);
+
+  layer_tuple_t ltuple = find_layer(parameters.layer, parameters.style);
+
+  tws::core::send_cached_response(render_tile(ltuple, parameters), request, response);
+}
+
+void
+tws::wms::xyz_tile_functor::operator()(const tws::core::http_request& request,
+                                       tws::core::http_response& response)
+{
+  std::string qstring = request.query_string();
+
+  tws::core::query_string_t qstr = tws::core::expand(qstring);
+
+  tile_request_parameters parameters = decode_xyz_tile_request(request.base_uri(), qstr);
+
+  layer_tuple_t ltuple = find_layer(parameters.layer, parameters.style);
+
+  tws::core::send_cached_response(render_tile(ltuple, parameters), request, response);
+}
+
 void
 tws::wms::register_operations()
 {
@@ -216,6 +474,35 @@ tws::wms::register_operations()
   }
 
   tws::core::service_operations_manager::instance().insert(service);
+
+// the tile service shares the layers, styles and cache of WMS
+  tws::core::service_metadata tile_service;
+
+  tile_service.name = "wmts";
+
+// 1st WMTS operation: GetTile
+  {
+    tws::core::service_operation s_op;
+
+    s_op.name = "GetTile";
+    s_op.description = "Request a tile of a layer in the server tile matrix set.";
+    s_op.handler = get_tile_functor();
+
+    tile_service.operations.push_back(s_op);
+  }
+
+// 2nd WMTS operation: XYZ tiles addressed by path
+  {
+    tws::core::service_operation s_op;
+
+    s_op.name = "tile";
+    s_op.description = "Request a tile of a layer through a path: /wmts/tile/{layer}/{time}/{z}/{x}/{y}.{png|jpg|webp}.";
+    s_op.handler = xyz_tile_functor();
+
+    tile_service.operations.push_back(s_op);
+  }
+
+  tws::core::service_operations_manager::instance().insert(tile_service);
 }
 
 void
@@ -223,7 +510,10 @@ tws::wms::initialize_operations()
 {
   tws::geoarray::geoarray_manager::instance();
   tws::geoarray::timeline_manager::instance();
+  encoder_manager::instance();
   wms_manager::instance();
+  tile_cache::instance();
+  tws::scidb::connection_pool::instance();
 }
 
 tws::wms::get_map_request_parameters
@@ -237,7 +527,7 @@ tws::wms::decode_get_map_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"VERSION\" parameter is missing.");
 
-  parameters.version = it->second;
+  parameters.version = it->second.to_string();
 
 // get layers
   it = qstr.find("LAYERS");
@@ -247,13 +537,13 @@ tws::wms::decode_get_map_request(const tws::core::query_string_t& qstr)
 
   boost::split(parameters.layers, it->second, boost::is_any_of(","));
 
-// get layers
-    it = qstr.find("STYLES");
+// get styles
+  it = qstr.find("STYLES");
 
-    if(it == it_end)
-      throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"STYLES\" parameter is missing.");
+  if(it == it_end)
+    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"STYLES\" parameter is missing.");
 
-    boost::split(parameters.styles, it->second, boost::is_any_of(","));
+  boost::split(parameters.styles, it->second, boost::is_any_of(","));
 
 // retrieve crs
   it = qstr.find("CRS");
@@ -261,7 +551,7 @@ tws::wms::decode_get_map_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"CRS\" parameter is missing.");
 
-  parameters.crs = it->second;
+  parameters.crs = it->second.to_string();
 
 // retrieve bounding box
   it = qstr.find("BBOX");
@@ -290,14 +580,14 @@ tws::wms::decode_get_map_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"WIDTH\" parameter is missing.");
 
-  parameters.width = std::stoul(it->second);
+  parameters.width = std::stoul(it->second.to_string());
 
   it = qstr.find("HEIGHT");
 
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"HEIGHT\" parameter is missing.");
 
-  parameters.height = std::stoul(it->second);
+  parameters.height = std::stoul(it->second.to_string());
 
 // output image format
   it = qstr.find("FORMAT");
@@ -305,12 +595,29 @@ tws::wms::decode_get_map_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"FORMAT\" parameter is missing.");
 
-  parameters.format = it->second;
+  parameters.format = it->second.to_string();
 
 // retrieve time instant
   it = qstr.find("TIME");
 
-  parameters.time_point = (it != it_end) ? it->second : std::string("");
+  parameters.time_point = (it != it_end) ? it->second.to_string() : std::string();
+
+// retrieve the resampling kernel: a vendor-specific parameter
+  it = qstr.find("RESAMPLING");
+
+  if((it == it_end) || it->second.empty() || (it->second == "nearest"))
+  {
+    parameters.resampling = nearest_resampling;
+  }
+  else if(it->second == "bilinear")
+  {
+    parameters.resampling = bilinear_resampling;
+  }
+  else
+  {
+    boost::format err_msg("Error on GetMap operation: invalid resampling kernel '%1%'.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % it->second).str());
+  }
 
   return parameters;
 }
@@ -329,97 +636,378 @@ tws::wms::valid(const get_map_request_parameters& parameters)
   if(parameters.layers.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: empty layer list.");
 
-// artificial check: currently, we are accepting just one layer per request
-  if(parameters.layers.size() > 1) // TODO: remove this restriction in near future!
-    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: this WMS implementation can only render one array per time.");
-
 // check if style-list size is the same as layer-list size
   if(parameters.layers.size() != parameters.styles.size())
     throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: the requested layer list must have the same size as style list.");
 
+  const capabilities_t& wms_capabilities = tws::wms::wms_manager::instance().capabilities();
+
+// check the number of layers against the service limit
+  if(parameters.layers.size() > wms_capabilities.service.layer_limit)
+  {
+    boost::format err_msg("Error on GetMap operation: this WMS implementation can render at most %1% layers per request.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % wms_capabilities.service.layer_limit).str());
+  }
+
 // valid layer list and styles and prepare rendering data
   std::vector<tws::wms::layer_tuple_t> result;
 
-  const capabilities_t& wms_capabilities = tws::wms::wms_manager::instance().capabilities();
+  for(std::size_t i = 0; i < parameters.layers.size(); ++i)
+  {
+// a style must be informed for each layer in a GetMap request
+    if(parameters.styles[i].empty())
+    {
+      boost::format err_msg("Error on GetMap operation: no style informed for layer '%1%'.");
+      throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.layers[i]).str());
+    }
 
-  const layer_t& root_layer = wms_capabilities.capability.layer;
+    result.push_back(find_layer(parameters.layers[i], parameters.styles[i]));
+  }
 
-  for(std::size_t i = 0; i < parameters.layers.size(); ++i)
+// check output image size
+  if((parameters.width == 0) || (parameters.height == 0))
+    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"WIDTH\" and \"HEIGHT\" must be greater than zero.");
+
+  if(parameters.width > wms_capabilities.service.max_width)
+    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"WIDTH\" parameter is out-of bounds.");
+
+  if(parameters.height > wms_capabilities.service.max_height)
+    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"HEIGHT\" parameter is out-of bounds.");
+
+// check requested output format
+  if(std::find_if(wms_capabilities.capability.request.get_map.format.begin(),
+                  wms_capabilities.capability.request.get_map.format.end(),
+                  [&parameters](const std::string& f){ return (f == parameters.format); }) == wms_capabilities.capability.request.get_map.format.end())
   {
-// find requested layer in the server layer list
-    const std::string& layer_name = parameters.layers[i];
+    boost::format err_msg("Error on GetMap operation: image output format '%1%' is not valid.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.format).str());
+  }
 
-    const auto& it_layer = std::find_if(root_layer.layers.begin(), root_layer.layers.end(), [&layer_name]
-                                                                                            (const layer_t& l)
-                                                                                            { return l.name == layer_name; });
+// ok: return rendering info computed during validation
+  return result;
+}
 
-    if(it_layer == root_layer.layers.end())
-    {
-      boost::format err_msg("Error on GetMap operation: could not find layer '%1%'.");
-      throw tws::core::http_request_error() << tws::error_description((err_msg % layer_name).str());
-    }
+tws::wms::layer_tuple_t
+tws::wms::find_layer(const std::string& layer_name,
+                     const std::string& style_name)
+{
+  const layer_t& root_layer = tws::wms::wms_manager::instance().capabilities().capability.layer;
 
-    const layer_t& current_layer = *it_layer;
+// find requested layer in the server layer list
+  const auto& it_layer = std::find_if(root_layer.layers.begin(), root_layer.layers.end(), [&layer_name]
+                                                                                          (const layer_t& l)
+                                                                                          { return l.name == layer_name; });
 
-// find the requested layer style
-    const std::string& style_name = parameters.styles[i];
+  if(it_layer == root_layer.layers.end())
+  {
+    boost::format err_msg("Error on map request: could not find layer '%1%'.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % layer_name).str());
+  }
 
-    const auto& it_style = std::find_if(current_layer.styles.begin(), current_layer.styles.end(), [&style_name]
-                                                                                                  (const style_t& s)
-                                                                                                  { return s.name == style_name; });
+  const layer_t& current_layer = *it_layer;
 
-    if(it_style == current_layer.styles.end())
-    {
-      boost::format err_msg("Error on GetMap operation: could not find layer style named '%1%'.");
-      throw tws::core::http_request_error() << tws::error_description((err_msg % style_name).str());
-    }
+// find the requested layer style
+  const auto& it_style = style_name.empty() ? current_layer.styles.begin()
+                                            : std::find_if(current_layer.styles.begin(), current_layer.styles.end(), [&style_name]
+                                                                                                                     (const style_t& s)
+                                                                                                                     { return s.name == style_name; });
+
+  if(it_style == current_layer.styles.end())
+  {
+    boost::format err_msg("Error on map request: could not find layer style named '%1%'.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % style_name).str());
+  }
 
-    const auto& current_layer_style = *it_style;
+  const auto& current_layer_style = *it_style;
 
 // find layer's original geoarray and time-line info
-    const tws::geoarray::timeline& tl = tws::geoarray::timeline_manager::instance().get(layer_name);
+  std::shared_ptr<const tws::geoarray::timeline> tl = tws::geoarray::timeline_manager::instance().get(layer_name);
 
-    const tws::geoarray::geoarray_t& geo_array = tws::geoarray::geoarray_manager::instance().get(layer_name);
+  const tws::geoarray::geoarray_t& geo_array = tws::geoarray::geoarray_manager::instance().get(layer_name);
 
 // check if it is a 3D array
-    if(geo_array.dimensions.size() != 3)
+  if(geo_array.dimensions.size() != 3)
+  {
+    boost::format err_msg("Error on map request: layer '%1%' is not a spatio-temporal array.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % layer_name).str());
+  }
+
+// create tuple info
+  return std::make_tuple(&current_layer, &current_layer_style , &geo_array, tl);
+}
+
+tws::wms::tile_request_parameters
+tws::wms::decode_get_tile_request(const tws::core::query_string_t& qstr)
+{
+  tile_request_parameters parameters;
+
+  tws::core::query_string_t::const_iterator it_end = qstr.end();
+
+// get layer and its optional style
+  tws::core::query_string_t::const_iterator it = qstr.find("LAYER");
+
+  if(it == it_end || it->second.empty())
+    throw tws::core::http_request_error() << tws::error_description("Error on GetTile operation: \"LAYER\" parameter is missing.");
+
+  parameters.layer = it->second.to_string();
+
+  it = qstr.find("STYLE");
+
+  parameters.style = (it != it_end) ? it->second.to_string() : std::string();
+
+// get tile address
+  const char* tile_address[] = { "TILEMATRIX", "TILEROW", "TILECOL" };
+
+  uint32_t* tile_address_values[] = { &parameters.zoom, &parameters.row, &parameters.col };
+
+  for(std::size_t i = 0; i != 3; ++i)
+  {
+    it = qstr.find(tile_address[i]);
+
+    if(it == it_end || it->second.empty())
     {
-      boost::format err_msg("Error on GetMap operation: layer '%1%' is not a spatio-temporal array.");
-      throw tws::core::http_request_error() << tws::error_description((err_msg % layer_name).str());
+      boost::format err_msg("Error on GetTile operation: \"%1%\" parameter is missing.");
+      throw tws::core::http_request_error() << tws::error_description((err_msg % tile_address[i]).str());
     }
 
-// create tuple info
-    layer_tuple_t ltuple = std::make_tuple(&current_layer, &current_layer_style , &geo_array, &tl);
+    try
+    {
+      *(tile_address_values[i]) = boost::lexical_cast<uint32_t>(it->second.to_string());
+    }
+    catch(const boost::bad_lexical_cast&)
+    {
+      boost::format err_msg("Error on GetTile operation: invalid value '%1%' for parameter \"%2%\".");
+      throw tws::core::http_request_error() << tws::error_description((err_msg % it->second % tile_address[i]).str());
+    }
+  }
+
+// output image format
+  it = qstr.find("FORMAT");
+
+  parameters.format = ((it != it_end) && !it->second.empty()) ? it->second.to_string() : std::string("image/png");
+
+// retrieve time instant
+  it = qstr.find("TIME");
+
+  parameters.time_point = (it != it_end) ? it->second.to_string() : std::string();
+
+  return parameters;
+}
+
+tws::wms::tile_request_parameters
+tws::wms::decode_xyz_tile_request(const std::string& path,
+                                  const tws::core::query_string_t& qstr)
+{
+  std::vector<std::string> segments;
+
+  boost::split(segments, path, boost::is_any_of("/"));
 
-    result.push_back(ltuple);
+// "", "wmts", "tile", layer, time, z, x, y.ext
+  if(segments.size() != 8)
+  {
+    boost::format err_msg("Error on tile operation: invalid tile path '%1%', expected /wmts/tile/{layer}/{time}/{z}/{x}/{y}.{png|jpg|webp}.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % path).str());
   }
 
-// check output image size
-  if(parameters.width > wms_capabilities.service.max_width)
-    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"WIDTH\" parameter is out-of bounds.");
+  tile_request_parameters parameters;
 
-  if(parameters.height > wms_capabilities.service.max_height)
-    throw tws::core::http_request_error() << tws::error_description("Error on GetMap operation: \"HEIGHT\" parameter is out-of bounds.");
+  parameters.layer = segments[3];
 
-// check requested output format
-  if(std::find_if(wms_capabilities.capability.request.get_map.format.begin(),
-                  wms_capabilities.capability.request.get_map.format.end(),
-                  [&parameters](const std::string& f){ return (f == parameters.format); }) == wms_capabilities.capability.request.get_map.format.end())
+  tws::core::query_string_t::const_iterator it = qstr.find("STYLE");
+
+  parameters.style = (it != qstr.end()) ? it->second.to_string() : std::string();
+
+  parameters.time_point = (segments[4] == "default") ? std::string("") : segments[4];
+
+// the file extension tells the output format
+  std::string::size_type ext_pos = segments[7].rfind('.');
+
+  std::string ext = (ext_pos == std::string::npos) ? std::string("") : segments[7].substr(ext_pos + 1);
+
+  if(ext == "png")
+    parameters.format = "image/png";
+  else if((ext == "jpg") || (ext == "jpeg"))
+    parameters.format = "image/jpeg";
+  else if(ext == "webp")
+    parameters.format = "image/webp";
+  else
   {
-    boost::format err_msg("Error on GetMap operation: image output format '%1%' is not valid.");
+    boost::format err_msg("Error on tile operation: invalid tile path '%1%', the tile extension must be png, jpg or webp.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % path).str());
+  }
+
+  try
+  {
+    parameters.zoom = boost::lexical_cast<uint32_t>(segments[5]);
+    parameters.col = boost::lexical_cast<uint32_t>(segments[6]);
+    parameters.row = boost::lexical_cast<uint32_t>(segments[7].substr(0, ext_pos));
+  }
+  catch(const boost::bad_lexical_cast&)
+  {
+    boost::format err_msg("Error on tile operation: invalid tile address in path '%1%'.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % path).str());
+  }
+
+  return parameters;
+}
+
+tws::wms::tile_matrix_t
+tws::wms::compute_tile_matrix(const tws::geoarray::geoarray_t& garray,
+                              const tile_matrix_set_t& tms,
+                              uint32_t zoom)
+{
+  int64_t ncols = garray.dimensions[0].max_idx - garray.dimensions[0].min_idx + 1;
+  int64_t nrows = garray.dimensions[1].max_idx - garray.dimensions[1].min_idx + 1;
+
+  tile_matrix_t tm;
+
+// the finest level is the first one whose tiles may cover the whole array with a single tile per cell
+  tm.max_zoom = 0;
+
+  while((static_cast<int64_t>(tms.tile_size) << tm.max_zoom) < std::max(ncols, nrows))
+    ++tm.max_zoom;
+
+  if(zoom > tm.max_zoom)
+  {
+    boost::format err_msg("Error on tile request: zoom level %1% is out of the tile matrix set, the finest level is %2%.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % zoom % tm.max_zoom).str());
+  }
+
+  tm.cells_per_pixel = static_cast<int64_t>(1) << (tm.max_zoom - zoom);
+  tm.tile_cells = tms.tile_size * tm.cells_per_pixel;
+  tm.matrix_width = (ncols + tm.tile_cells - 1) / tm.tile_cells;
+  tm.matrix_height = (nrows + tm.tile_cells - 1) / tm.tile_cells;
+
+  return tm;
+}
+
+tws::core::cached_response
+tws::wms::render_tile(const layer_tuple_t& ltuple,
+                      const tile_request_parameters& parameters)
+{
+  const layer_t* layer = std::get<0>(ltuple);
+  const style_t* style = std::get<1>(ltuple);
+  const tws::geoarray::geoarray_t* garray = std::get<2>(ltuple);
+  const tws::geoarray::timeline* tline = std::get<3>(ltuple).get();
+
+  const capabilities_t& wms_capabilities = tws::wms::wms_manager::instance().capabilities();
+
+  if(std::find(wms_capabilities.capability.request.get_map.format.begin(),
+               wms_capabilities.capability.request.get_map.format.end(),
+               parameters.format) == wms_capabilities.capability.request.get_map.format.end())
+  {
+    boost::format err_msg("Error on tile request: image output format '%1%' is not valid.");
     throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.format).str());
   }
 
-// ok: return rendering info computed during validation
+  const tile_matrix_set_t& tms = tws::wms::wms_manager::instance().tile_matrix_set();
+
+  tile_matrix_t tm = compute_tile_matrix(*garray, tms, parameters.zoom);
+
+  if((parameters.col >= tm.matrix_width) || (parameters.row >= tm.matrix_height))
+  {
+    boost::format err_msg("Error on tile request: tile %1%/%2%/%3% is out of the tile matrix.");
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.zoom % parameters.col % parameters.row).str());
+  }
+
+// the cache keys name the actual time point, so the default one does not get a key of its own
+  tile_request_parameters tile = parameters;
+
+  tile.style = style->name;
+
+  if(tile.time_point.empty())
+    tile.time_point = tline->time_points().front();
+
+  std::string key = tws_wms_tile_key(tile, tile.row, tile.col);
+
+  tile_cache& cache = tile_cache::instance();
+
+  tws::core::cached_response result;
+
+  if(cache.find(key, result))
+    return result;
+
+// the metatile holding the requested tile: without a cache, the neighbour tiles would be thrown away
+  int64_t msize = cache.enabled() ? tms.metatile_size : 1;
+
+  int64_t mcol = (tile.col / msize) * msize;
+  int64_t mrow = (tile.row / msize) * msize;
+
+  int64_t ncols = std::min(msize, tm.matrix_width - mcol);
+  int64_t nrows = std::min(msize, tm.matrix_height - mrow);
+
+  boost::lock_guard<boost::mutex> lock(tws_wms_metatile_mutex(tws_wms_tile_key(tile, mrow, mcol)));
+
+// another request may have rendered the metatile while we were waiting
+  if(cache.find(key, result))
+    return result;
+
+  const tws::geoarray::spatial_extent_t& sp_extent = garray->geo_extent.spatial;
+
+  double tile_width = tm.tile_cells * sp_extent.resolution.x;
+  double tile_height = tm.tile_cells * sp_extent.resolution.y;
+
+  get_map_request_parameters map_parameters;
+
+  map_parameters.version = "1.3.0";
+  map_parameters.layers.push_back(layer->name);
+  map_parameters.styles.push_back(style->name);
+  map_parameters.crs = std::to_string(sp_extent.crs_code);
+  map_parameters.bbox = te::gm::Envelope(sp_extent.extent.xmin + mcol * tile_width,
+                                         sp_extent.extent.ymax - (mrow + nrows) * tile_height,
+                                         sp_extent.extent.xmin + (mcol + ncols) * tile_width,
+                                         sp_extent.extent.ymax - mrow * tile_height);
+  map_parameters.width = static_cast<uint32_t>(ncols * tms.tile_size);
+  map_parameters.height = static_cast<uint32_t>(nrows * tms.tile_size);
+  map_parameters.format = tile.format;
+  map_parameters.time_point = tile.time_point;
+  map_parameters.resampling = nearest_resampling;
+
+  rgba_image metatile = render(ltuple, map_parameters);
+
+// slice the metatile and keep all of its tiles
+  std::size_t tile_row_size = static_cast<std::size_t>(tms.tile_size) * 4;
+
+  for(int64_t i = 0; i != nrows; ++i)
+  {
+    for(int64_t j = 0; j != ncols; ++j)
+    {
+      rgba_image img(tms.tile_size, tms.tile_size);
+
+      for(uint32_t k = 0; k != tms.tile_size; ++k)
+        std::memcpy(img.row(k), metatile.row(i * tms.tile_size + k) + j * tile_row_size, tile_row_size);
+
+      tws::core::cached_response tile_img = encode_map(img, tile.format);
+
+      if(((mrow + i) == tile.row) && ((mcol + j) == tile.col))
+        result = tile_img;
+
+      cache.insert(tws_wms_tile_key(tile, mrow + i, mcol + j), tile_img);
+    }
+  }
+
   return result;
 }
 
-gdImagePtr
+tws::wms::rgba_image
 tws::wms::render(const layer_tuple_t& ltuple,
                  const get_map_request_parameters& parameters)
 {
   const style_t* style = std::get<1>(ltuple);
-  const tws::geoarray::timeline* tline = std::get<3>(ltuple);
+  const tws::geoarray::geoarray_t* garray = std::get<2>(ltuple);
+  const tws::geoarray::timeline* tline = std::get<3>(ltuple).get();
+
+// choose the coarsest overview of the layer array whose cells are not larger than the output pixels
+  te::gm::Envelope query_rectangle(parameters.bbox);
+
+  query_rectangle.transform(std::stoi(parameters.crs), garray->geo_extent.spatial.crs_code);
+
+  double pixel_size = std::min(query_rectangle.getWidth() / parameters.width,
+                               query_rectangle.getHeight() / parameters.height);
+
+  const tws::geoarray::geoarray_t& render_array = tws::geoarray::geoarray_manager::instance().select(garray->name, pixel_size);
+
+  layer_tuple_t render_tuple = std::make_tuple(std::get<0>(ltuple), style, &render_array, std::get<3>(ltuple));
 
 // compute time-index
   std::size_t time_idx = parameters.time_point.empty() ? tline->index(tline->time_points().front()) : tline->index(parameters.time_point);
@@ -430,11 +1018,15 @@ tws::wms::render(const layer_tuple_t& ltuple,
 // choose renderization mode
   if(style->style_type == "single band gray")
   {
-    return render_single_band_gray(conn.get(), time_idx, ltuple, parameters);
+    return render_single_band_gray(conn.get(), time_idx, render_tuple, parameters);
   }
   else if(style->style_type == "rgb")
   {
-    return render_rgb(conn.get(), time_idx, ltuple, parameters);
+    return render_rgb(conn.get(), time_idx, render_tuple, parameters);
+  }
+  else if(style->style_type == "color map")
+  {
+    return render_color_map(conn.get(), time_idx, render_tuple, parameters);
   }
   else
   {
@@ -443,7 +1035,88 @@ tws::wms::render(const layer_tuple_t& ltuple,
 
 }
 
-gdImagePtr
+tws::wms::rgba_image
+tws::wms::render(const std::vector<layer_tuple_t>& layers,
+                 const get_map_request_parameters& parameters)
+{
+  if(layers.size() == 1)
+    return render(layers.front(), parameters);
+
+// the layers are rendered by the calling thread helped by the threads shared by all requests
+  std::vector<rgba_image> images(layers.size(), rgba_image(0, 0));
+
+  std::size_t nhelpers = wms_manager::instance().layer_render_threads();
+
+  if(nhelpers == 0)
+  {
+    for(std::size_t i = 0; i != layers.size(); ++i)
+      images[i] = render(layers[i], parameters);
+  }
+  else
+  {
+    static tws::core::thread_pool layer_pool(nhelpers, 4 * nhelpers);
+
+    tws::core::parallel_for(layer_pool, layers.size(), nhelpers,
+                            [&](std::size_t i) { images[i] = render(layers[i], parameters); });
+  }
+
+// draw the layers over the bottom one, in the requested order
+  rgba_image& img = images.front();
+
+  for(std::size_t i = 1; i < images.size(); ++i)
+    composite(img, images[i]);
+
+  return std::move(img);
+}
+
+tws::core::cached_response
+tws::wms::encode_map(const rgba_image& img,
+                     const std::string& format)
+{
+  return tws::core::make_cached_response(encoder_manager::instance().encode(img, format), format);
+}
+
+tws::core::cached_response
+tws::wms::render_map(const std::vector<layer_tuple_t>& layers,
+                     const get_map_request_parameters& parameters)
+{
+  return encode_map(render(layers, parameters), parameters.format);
+}
+
+std::string
+tws::wms::make_tile_key(const get_map_request_parameters& parameters,
+                        double bbox_quantum)
+{
+  std::string key = boost::algorithm::join(parameters.layers, ",") + "|"
+                  + boost::algorithm::join(parameters.styles, ",") + "|"
+                  + parameters.crs + "|";
+
+// requests whose bounding boxes differ by less than the quantum share the same map
+  double step = bbox_quantum * std::min(parameters.bbox.getWidth() / parameters.width,
+                                        parameters.bbox.getHeight() / parameters.height);
+
+  if(step > 0.0)
+  {
+    key += (boost::format("%1%,%2%,%3%,%4%")
+            % std::llround(parameters.bbox.m_llx / step) % std::llround(parameters.bbox.m_lly / step)
+            % std::llround(parameters.bbox.m_urx / step) % std::llround(parameters.bbox.m_ury / step)).str();
+  }
+  else
+  {
+    key += (boost::format("%1$.17g,%2$.17g,%3$.17g,%4$.17g")
+            % parameters.bbox.m_llx % parameters.bbox.m_lly
+            % parameters.bbox.m_urx % parameters.bbox.m_ury).str();
+  }
+
+  key += "|" + std::to_string(parameters.width) + "x" + std::to_string(parameters.height)
+       + "|" + parameters.format
+       + "|" + parameters.time_point
+       + "|" + (parameters.resampling == bilinear_resampling ? "bilinear" : "nearest");
+
+  return key;
+}
+
+tws::wms::rgba_image
 tws::wms::render_single_band_gray(tws::scidb::connection* conn,
                                   std::size_t time_idx,
                                   const layer_tuple_t& ltuple,
@@ -460,177 +1133,422 @@ tws::wms::render_single_band_gray(tws::scidb::connection* conn,
     throw tws::core::http_request_error() << tws::error_description((err_msg % layer->name).str());
   }
 
-// get rendering extent
-  te::gm::Envelope data_extent = tws::wms::compute_intersection(parameters.bbox, std::stoi(parameters.crs),
-                                                                garray->geo_extent.spatial.extent, garray->geo_extent.spatial.crs_code);
-// get array coordinates to render
-  te::rst::Grid array_grid(garray->dimensions[0].max_idx - garray->dimensions[0].min_idx + 1,
-                           garray->dimensions[1].max_idx - garray->dimensions[1].min_idx + 1,
-                           garray->geo_extent.spatial.resolution.x,
-                           garray->geo_extent.spatial.resolution.y,
-                           new te::gm::Envelope(garray->geo_extent.spatial.extent.xmin,
-                                                garray->geo_extent.spatial.extent.ymin,
-                                                garray->geo_extent.spatial.extent.xmax,
-                                                garray->geo_extent.spatial.extent.ymax),
-                           garray->geo_extent.spatial.crs_code);
+  tws::geoarray::attribute_t attr = band_attribute(*garray, style->colors[0]);
 
-  double dpixel_col = 0.0;
-  double dpixel_row = 0.0;
+// get the array window and the sampling step that fit the output image size
+  render_window window = compute_render_window(*garray, parameters);
 
-  array_grid.geoToGrid(data_extent.m_llx, data_extent.m_lly, dpixel_col, dpixel_row);
+  rgba_image img(parameters.width, parameters.height);
 
-  int64_t init_pixel_col = static_cast<int64_t>(dpixel_col);
-  int64_t fin_pixel_row = static_cast<int64_t>(dpixel_row);
+  if(window.empty)
+    return img;
 
-  array_grid.geoToGrid(data_extent.m_urx, data_extent.m_ury, dpixel_col, dpixel_row);
+  std::unique_ptr<tws::scidb::array2d<double> > data(fetch_window(conn, time_idx, *layer, *garray, style->colors, window));
 
-  int64_t fin_pixel_col = static_cast<int64_t>(dpixel_col);
-  int64_t init_pixel_row = static_cast<int64_t>(dpixel_row);
+  std::vector<double> gray;
 
-// prepare the query string
-  std::string str_aql = "SELECT " + style->colors[0] + " "
-                      + "FROM between(" + layer->name + ", "
-                                        + std::to_string(init_pixel_col) + ","
-                                        + std::to_string(init_pixel_row) + ","
-                                        + std::to_string(time_idx) + ","
-                                        + std::to_string(fin_pixel_col) + ","
-                                        + std::to_string(fin_pixel_row) + ","
-                                        + std::to_string(time_idx)
-                                        + ")";
+  resample(*data, 0, attr.missing_value, window, parameters, gray);
 
-  boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_aql, false);
+  const color_kernels& kernels = select_color_kernels();
 
-  if((qresult.get() == nullptr) || (qresult->array.get() == nullptr))
+  band_stretch_t s = make_band_stretch(style_band_range(*style, 0, attr), attr.scale_factor, attr.missing_value);
+
+  std::vector<uint8_t> components(parameters.width);
+  std::vector<uint8_t> alpha(parameters.width);
+
+  for(uint32_t i = 0; i != parameters.height; ++i)
   {
-    boost::format err_msg("Error querying layer: '%1%'!");
+    std::fill(alpha.begin(), alpha.end(), 255);
+
+    kernels.stretch(&gray[static_cast<std::size_t>(i) * parameters.width], parameters.width, s, &components[0], &alpha[0]);
+
+    kernels.interleave(&components[0], &components[0], &components[0], &alpha[0], parameters.width, img.row(i));
+  }
+
+  return img;
+}
+
+tws::wms::rgba_image
+tws::wms::render_rgb(tws::scidb::connection* conn,
+                     std::size_t time_idx,
+                     const layer_tuple_t& ltuple,
+                     const get_map_request_parameters& parameters)
+{
+  const layer_t* layer = std::get<0>(ltuple);
+  const style_t* style = std::get<1>(ltuple);
+  const tws::geoarray::geoarray_t* garray = std::get<2>(ltuple);
+
+  if(style->colors.size() != 3)
+  {
+    boost::format err_msg("Error on GetMap operation: style is not correctly defined for layer %1%.");
 
     throw tws::core::http_request_error() << tws::error_description((err_msg % layer->name).str());
   }
 
-  tws::scidb::cell_iterator cit(qresult->array);
+  tws::geoarray::attribute_t rattr = band_attribute(*garray, style->colors[0]);
+  tws::geoarray::attribute_t gattr = band_attribute(*garray, style->colors[1]);
+  tws::geoarray::attribute_t battr = band_attribute(*garray, style->colors[2]);
+
+// get the array window and the sampling step that fit the output image size
+  render_window window = compute_render_window(*garray, parameters);
+
+  rgba_image img(parameters.width, parameters.height);
 
-  tws::scidb::array2d<uint8_t> tmp_array(init_pixel_col, fin_pixel_col, init_pixel_row, fin_pixel_row, 1);
+  if(window.empty)
+    return img;
 
-  tmp_array.fill(cit);
+  std::unique_ptr<tws::scidb::array2d<double> > data(fetch_window(conn, time_idx, *layer, *garray, style->colors, window));
 
-  std::unique_ptr<gdImage, decltype(&gdImageDestroy)> img(gdImageCreateTrueColor(tmp_array.width, tmp_array.height), gdImageDestroy);
+  std::vector<double> red;
+  std::vector<double> green;
+  std::vector<double> blue;
 
-  for(std::size_t i = 0; i != tmp_array.height; ++i)
+  resample(*data, 0, rattr.missing_value, window, parameters, red);
+  resample(*data, 1, gattr.missing_value, window, parameters, green);
+  resample(*data, 2, battr.missing_value, window, parameters, blue);
+
+  const color_kernels& kernels = select_color_kernels();
+
+  band_stretch_t rs = make_band_stretch(style_band_range(*style, 0, rattr), rattr.scale_factor, rattr.missing_value);
+  band_stretch_t gs = make_band_stretch(style_band_range(*style, 1, gattr), gattr.scale_factor, gattr.missing_value);
+  band_stretch_t bs = make_band_stretch(style_band_range(*style, 2, battr), battr.scale_factor, battr.missing_value);
+
+  std::vector<uint8_t> r(parameters.width);
+  std::vector<uint8_t> g(parameters.width);
+  std::vector<uint8_t> b(parameters.width);
+  std::vector<uint8_t> alpha(parameters.width);
+
+// a pixel missing in any band is transparent
+  for(uint32_t i = 0; i != parameters.height; ++i)
   {
-    std::size_t offset = i *  tmp_array.width;
+    std::size_t offset = static_cast<std::size_t>(i) * parameters.width;
 
-    for(std::size_t j = 0; j != tmp_array.width; ++j)
-    {
-      int v = tmp_array.attribute_data[0][offset + j];
-      int color = gdTrueColorAlpha(v, v, v, 0);
-      gdImageSetPixel(img.get(), j, i, color);
-    }
+    std::fill(alpha.begin(), alpha.end(), 255);
+
+    kernels.stretch(&red[offset], parameters.width, rs, &r[0], &alpha[0]);
+    kernels.stretch(&green[offset], parameters.width, gs, &g[0], &alpha[0]);
+    kernels.stretch(&blue[offset], parameters.width, bs, &b[0], &alpha[0]);
+
+    kernels.interleave(&r[0], &g[0], &b[0], &alpha[0], parameters.width, img.row(i));
   }
 
-  return img.release();
+  return img;
 }
 
-gdImagePtr
-tws::wms::render_rgb(tws::scidb::connection* conn,
-                     std::size_t time_idx,
-                     const layer_tuple_t& ltuple,
-                     const get_map_request_parameters& parameters)
+tws::wms::rgba_image
+tws::wms::render_color_map(tws::scidb::connection* conn,
+                           std::size_t time_idx,
+                           const layer_tuple_t& ltuple,
+                           const get_map_request_parameters& parameters)
 {
   const layer_t* layer = std::get<0>(ltuple);
   const style_t* style = std::get<1>(ltuple);
   const tws::geoarray::geoarray_t* garray = std::get<2>(ltuple);
 
-  if(style->colors.size() != 3)
+  if((style->colors.size() != 1) || style->color_map.empty())
   {
     boost::format err_msg("Error on GetMap operation: style is not correctly defined for layer %1%.");
 
     throw tws::core::http_request_error() << tws::error_description((err_msg % layer->name).str());
   }
 
+  tws::geoarray::attribute_t attr = band_attribute(*garray, style->colors[0]);
+
+// get the array window and the sampling step that fit the output image size
+  render_window window = compute_render_window(*garray, parameters);
+
+  rgba_image img(parameters.width, parameters.height);
+
+  if(window.empty)
+    return img;
+
+  std::unique_ptr<tws::scidb::array2d<double> > data(fetch_window(conn, time_idx, *layer, *garray, style->colors, window));
+
+  std::vector<double> values;
+
+  resample(*data, 0, attr.missing_value, window, parameters, values);
+
+// without a stretch, the color map spans the range between its first and last stops
+  tws::geoarray::numeric_range_t range = { style->color_map.front().value, style->color_map.back().value };
+
+  if(!style->stretch.empty())
+    range = style->stretch[0];
+
+  const color_kernels& kernels = select_color_kernels();
+
+  band_stretch_t s = make_band_stretch(range, attr.scale_factor, attr.missing_value);
+
+  color_lut_t lut = make_color_lut(style->color_map, range);
+
+  std::vector<uint8_t> components(parameters.width);
+  std::vector<uint8_t> alpha(parameters.width);
+
+  for(uint32_t i = 0; i != parameters.height; ++i)
+  {
+    std::fill(alpha.begin(), alpha.end(), 255);
+
+    kernels.stretch(&values[static_cast<std::size_t>(i) * parameters.width], parameters.width, s, &components[0], &alpha[0]);
+
+    kernels.color_map(&components[0], &alpha[0], parameters.width, lut, img.row(i));
+  }
+
+  return img;
+}
+
+tws::wms::render_window
+tws::wms::compute_render_window(const tws::geoarray::geoarray_t& garray,
+                                const get_map_request_parameters& parameters)
+{
+  render_window window = { true, 0, 0, 0, 0, 1, 0.0, 0.0, 0.0, 0.0 };
+
+  int query_srid = std::stoi(parameters.crs);
+  int layer_srid = garray.geo_extent.spatial.crs_code;
+
 // get rendering extent
-  te::gm::Envelope data_extent = tws::wms::compute_intersection(parameters.bbox, std::stoi(parameters.crs),
-                                                                garray->geo_extent.spatial.extent, garray->geo_extent.spatial.crs_code);
+  te::gm::Envelope data_extent = compute_intersection(parameters.bbox, query_srid,
+                                                      garray.geo_extent.spatial.extent, layer_srid);
+
+  if(!data_extent.isValid())
+    return window;
+
+  const tws::geoarray::dimension_t& col_dim = garray.dimensions[0];
+  const tws::geoarray::dimension_t& row_dim = garray.dimensions[1];
+
+  int64_t ncols = col_dim.max_idx - col_dim.min_idx + 1;
+  int64_t nrows = row_dim.max_idx - row_dim.min_idx + 1;
+
+  te::rst::Grid array_grid(ncols, nrows,
+                           garray.geo_extent.spatial.resolution.x,
+                           garray.geo_extent.spatial.resolution.y,
+                           new te::gm::Envelope(garray.geo_extent.spatial.extent.xmin,
+                                                garray.geo_extent.spatial.extent.ymin,
+                                                garray.geo_extent.spatial.extent.xmax,
+                                                garray.geo_extent.spatial.extent.ymax),
+                           layer_srid);
 
-// get array coordinates to render
-  te::rst::Grid array_grid(garray->dimensions[0].max_idx - garray->dimensions[0].min_idx + 1,
-                           garray->dimensions[1].max_idx - garray->dimensions[1].min_idx + 1,
-                           garray->geo_extent.spatial.resolution.x,
-                           garray->geo_extent.spatial.resolution.y,
-                           new te::gm::Envelope(garray->geo_extent.spatial.extent.xmin,
-                                                garray->geo_extent.spatial.extent.ymin,
-                                                garray->geo_extent.spatial.extent.xmax,
-                                                garray->geo_extent.spatial.extent.ymax),
-                           garray->geo_extent.spatial.crs_code);
+// the output pixels are spread over the whole requested box, even over the parts outside the array
+  te::gm::Envelope query_rectangle(parameters.bbox);
 
-  double dpixel_col = 0.0;
-  double dpixel_row = 0.0;
+  query_rectangle.transform(query_srid, layer_srid);
+
+  double ul_col = 0.0;
+  double ul_row = 0.0;
+  double lr_col = 0.0;
+  double lr_row = 0.0;
+
+  array_grid.geoToGrid(query_rectangle.m_llx, query_rectangle.m_ury, ul_col, ul_row);
+  array_grid.geoToGrid(query_rectangle.m_urx, query_rectangle.m_lly, lr_col, lr_row);
+
+  window.col_scale = (lr_col - ul_col) / parameters.width;
+  window.row_scale = (lr_row - ul_row) / parameters.height;
+  window.col0 = ul_col + col_dim.min_idx;
+  window.row0 = ul_row + row_dim.min_idx;
 
-  array_grid.geoToGrid(data_extent.m_llx, data_extent.m_lly, dpixel_col, dpixel_row);
+// the cells touched by the data extent, with one extra cell at each side for the bilinear kernel
+  array_grid.geoToGrid(data_extent.m_llx, data_extent.m_ury, ul_col, ul_row);
+  array_grid.geoToGrid(data_extent.m_urx, data_extent.m_lly, lr_col, lr_row);
 
-  int64_t init_pixel_col = static_cast<int64_t>(dpixel_col);
-  int64_t fin_pixel_row = static_cast<int64_t>(dpixel_row);
+  window.init_col = std::max<int64_t>(0, static_cast<int64_t>(std::floor(ul_col))) + col_dim.min_idx;
+  window.fin_col = std::min<int64_t>(ncols - 1, static_cast<int64_t>(std::ceil(lr_col))) + col_dim.min_idx;
+  window.init_row = std::max<int64_t>(0, static_cast<int64_t>(std::floor(ul_row))) + row_dim.min_idx;
+  window.fin_row = std::min<int64_t>(nrows - 1, static_cast<int64_t>(std::ceil(lr_row))) + row_dim.min_idx;
 
-  array_grid.geoToGrid(data_extent.m_urx, data_extent.m_ury, dpixel_col, dpixel_row);
+  if((window.init_col > window.fin_col) || (window.init_row > window.fin_row))
+    return window;
 
-  int64_t fin_pixel_col = static_cast<int64_t>(dpixel_col);
-  int64_t init_pixel_row = static_cast<int64_t>(dpixel_row);
+// when an output pixel covers several cells, only one cell in each step x step block is needed
+  double cells_per_pixel = std::min(std::fabs(window.col_scale), std::fabs(window.row_scale));
 
+  window.step = std::max<int64_t>(1, static_cast<int64_t>(std::floor(cells_per_pixel)));
+
+  window.empty = false;
+
+  return window;
+}
 
+std::unique_ptr<tws::scidb::array2d<double> >
+tws::wms::fetch_window(tws::scidb::connection* conn,
+                       std::size_t time_idx,
+                       const layer_t& layer,
+                       const tws::geoarray::geoarray_t& garray,
+                       const std::vector<std::string>& attributes,
+                       const render_window& window)
+{
 // prepare the query string
-  std::string str_aql = "SELECT " + style->colors[0] + ", " + style->colors[1] + ", " + style->colors[2] + " "
-                      + "FROM between(" + layer->name + ", "
-                                        + std::to_string(init_pixel_col) + ","
-                                        + std::to_string(init_pixel_row) + ","
+  std::string str_aql = "SELECT " + boost::algorithm::join(attributes, ", ") + " "
+                      + "FROM between(" + garray.name + ", "
+                                        + std::to_string(window.init_col) + ","
+                                        + std::to_string(window.init_row) + ","
                                         + std::to_string(time_idx) + ","
-                                        + std::to_string(fin_pixel_col) + ","
-                                        + std::to_string(fin_pixel_row) + ","
+                                        + std::to_string(window.fin_col) + ","
+                                        + std::to_string(window.fin_row) + ","
                                         + std::to_string(time_idx)
                                         + ")";
 
-  //std::cout << str_aql << std::endl;
+// a strided lattice keeps the number of cells transferred proportional to the output image size
+  if(window.step > 1)
+  {
+    const std::string& col_name = garray.dimensions[0].name;
+    const std::string& row_name = garray.dimensions[1].name;
+
+    str_aql += " WHERE (" + col_name + " - " + std::to_string(window.init_col) + ") % " + std::to_string(window.step) + " = 0"
+               " AND (" + row_name + " - " + std::to_string(window.init_row) + ") % " + std::to_string(window.step) + " = 0";
+  }
 
   boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_aql, false);
 
   if((qresult.get() == nullptr) || (qresult->array.get() == nullptr))
   {
+    if(qresult.get() != nullptr)
+      conn->completed(qresult->queryID);
+
     boost::format err_msg("Error querying layer: '%1%'!");
 
-    throw tws::core::http_request_error() << tws::error_description((err_msg % layer->name).str());
+    throw tws::core::http_request_error() << tws::error_description((err_msg % layer.name).str());
   }
 
-  int width = fin_pixel_col - init_pixel_col + 1;
-  int height = fin_pixel_row - init_pixel_row + 1;
+  std::unique_ptr<tws::scidb::array2d<double> > data;
 
-  std::unique_ptr<gdImage, decltype(&gdImageDestroy)> img(gdImageCreateTrueColor(width, height), gdImageDestroy);
+  try
+  {
+    data.reset(new tws::scidb::array2d<double>(window.init_col, window.fin_col,
+                                               window.init_row, window.fin_row,
+                                               attributes.size(), window.step));
 
-  tws::scidb::cell_iterator cit(qresult->array);
+// empty cells are taken as missing values
+    for(std::size_t b = 0; b != attributes.size(); ++b)
+    {
+      tws::geoarray::attribute_t attr = band_attribute(garray, attributes[b]);
+
+      std::fill(data->attribute_data[b], data->attribute_data[b] + data->size, attr.missing_value);
+    }
 
-  //int64_t first_col = garray->dimensions[0].min_idx;
-  //int64_t first_row = garray->dimensions[1].min_idx;
+    tws::scidb::cell_iterator cit(qresult->array);
 
-  while(!cit.end())
+    data->fill(cit);
+  }
+  catch(...)
   {
-    int r = cit.get_uint8(0);
-    int g = cit.get_uint8(1);
-    int b = cit.get_uint8(2);
+    conn->completed(qresult->queryID);
+    throw;
+  }
 
-    int color = gdTrueColorAlpha(r, g, b, 0);
+  conn->completed(qresult->queryID);
 
-    const ::scidb::Coordinates& coords = cit.get_position();
+  return data;
+}
 
-    int col = coords[0] - init_pixel_col;
-    int row = coords[1] - init_pixel_row;
+void
+tws::wms::resample(const tws::scidb::array2d<double>& data,
+                   std::size_t band,
+                   double missing_value,
+                   const render_window& window,
+                   const get_map_request_parameters& parameters,
+                   std::vector<double>& result)
+{
+  result.assign(parameters.width * parameters.height, std::numeric_limits<double>::quiet_NaN());
+
+// the lattice positions of each output column and row are computed once
+  std::vector<int64_t> col0, col1, row0, row1;
+  std::vector<double> fcol, frow;
+
+  tws_wms_sampling_positions(window.col0, window.col_scale, window.init_col, window.fin_col, window.step, parameters.width, col0, col1, fcol);
+  tws_wms_sampling_positions(window.row0, window.row_scale, window.init_row, window.fin_row, window.step, parameters.height, row0, row1, frow);
+
+  const double* values = data.attribute_data[band];
+
+  for(std::size_t i = 0; i != parameters.height; ++i)
+  {
+    if(row0[i] < 0)
+      continue;
+
+    const double* line0 = values + row0[i] * data.width;
+    const double* line1 = values + row1[i] * data.width;
+
+    double* out = &result[i * parameters.width];
+
+    for(std::size_t j = 0; j != parameters.width; ++j)
+    {
+      if(col0[j] < 0)
+        continue;
+
+      const double* nearest_line = (frow[i] < 0.5) ? line0 : line1;
+      int64_t nearest_col = (fcol[j] < 0.5) ? col0[j] : col1[j];
+
+      if(parameters.resampling == nearest_resampling)
+      {
+        out[j] = nearest_line[nearest_col];
+        continue;
+      }
+
+      double v00 = line0[col0[j]];
+      double v01 = line0[col1[j]];
+      double v10 = line1[col0[j]];
+      double v11 = line1[col1[j]];
+
+// missing values are not interpolated: fall back to the nearest cell
+      if((v00 == missing_value) || (v01 == missing_value) || (v10 == missing_value) || (v11 == missing_value))
+      {
+        out[j] = nearest_line[nearest_col];
+        continue;
+      }
+
+      double top = v00 + (v01 - v00) * fcol[j];
+      double bottom = v10 + (v11 - v10) * fcol[j];
+
+      out[j] = top + (bottom - top) * frow[i];
+    }
+  }
+}
+
+tws::geoarray::attribute_t
+tws::wms::band_attribute(const tws::geoarray::geoarray_t& garray,
+                         const std::string& band)
+{
+  for(const tws::geoarray::attribute_t& attr : garray.attributes)
+    if(attr.name == band)
+      return attr;
 
-    assert(col < width);
-    assert(row < height);
-    assert(static_cast<uint64_t>(coords[2]) == time_idx);
+// a plain name must be one of the array attributes: report a typo instead of letting SciDB reject the query
+  bool is_name = !band.empty() && (std::isalpha(static_cast<unsigned char>(band[0])) || (band[0] == '_'));
 
-    gdImageSetPixel(img.get(), col, row, color);
+  for(std::size_t i = 1; is_name && (i != band.size()); ++i)
+    is_name = std::isalnum(static_cast<unsigned char>(band[i])) || (band[i] == '_');
 
-    ++cit;
+  if(is_name)
+  {
+    boost::format err_msg("Error on GetMap operation: style refers to an unknown attribute '%1%' of layer '%2%'.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % band % garray.name).str());
   }
 
-  return img.release();
+// an expression: its values are already color components
+  tws::geoarray::attribute_t attr;
+
+  attr.name = band;
+  attr.valid_range.min_val = 0.0;
+  attr.valid_range.max_val = 255.0;
+  attr.scale_factor = 1.0;
+  attr.missing_value = std::numeric_limits<double>::quiet_NaN();
+  attr.datatype = tws::geoarray::datatype_t::unknown;
+
+  return attr;
+}
+
+tws::geoarray::numeric_range_t
+tws::wms::style_band_range(const style_t& style,
+                           std::size_t band,
+                           const tws::geoarray::attribute_t& attr)
+{
+  if(band < style.stretch.size())
+    return style.stretch[band];
+
+  double v0 = attr.valid_range.min_val * attr.scale_factor;
+  double v1 = attr.valid_range.max_val * attr.scale_factor;
+
+  tws::geoarray::numeric_range_t range = { std::min(v0, v1), std::max(v0, v1) };
+
+  return range;
 }
 
 te::gm::Envelope
@@ -65,6 +65,22 @@ namespace tws
                       tws::core::http_response& response);
     };
 
+    //! Request a tile of a layer through the WMTS KVP encoding.
+    /*! http://chronos.dpi.inpe.br:6543/wmts/GetTile?LAYER=mod13q1&TILEMATRIX=5&TILEROW=10&TILECOL=12 */
+    struct get_tile_functor
+    {
+      void operator()(const tws::core::http_request& request,
+                      tws::core::http_response& response);
+    };
+
+    //! Request a tile of a layer through a XYZ path: /wmts/tile/{layer}/{time}/{z}/{x}/{y}.{png|jpg|webp}
+    /*! http://chronos.dpi.inpe.br:6543/wmts/tile/mod13q1/2000-02-18/5/12/10.png */
+    struct xyz_tile_functor
+    {
+      void operator()(const tws::core::http_request& request,
+                      tws::core::http_response& response);
+    };
+
     //! Register all service operations.
     void register_operations();
 
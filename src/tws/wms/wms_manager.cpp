@@ -28,21 +28,34 @@
 #include "wms_manager.hpp"
 #include "../core/utils.hpp"
 #include "data_types.hpp"
+#include "encoder_manager.hpp"
 #include "json_serializer.hpp"
 #include "xml_serializer.hpp"
 
 // Rapidjson
 #include <rapidjson/document.h>
 
+// RapidXml
+#include <rapidxml/rapidxml_print.hpp>
+
 // STL
+#include <algorithm>
+#include <iterator>
 #include <memory>
+#include <utility>
 
 struct tws::wms::wms_manager::impl
 {
   tws::wms::capabilities_t capabilities;
   rapidxml::xml_document<> xml_doc;
+  tws::core::cached_response cached_capabilities;
+  tws::wms::tile_matrix_set_t tile_matrix_set;
+  std::size_t layer_render_threads;
 };
 
+//! The layer limit advertised when wms.json asks for no limit.
+static const uint32_t tws_wms_max_layer_limit = 16;
+
 tws::wms::wms_manager&
 tws::wms::wms_manager::instance()
 {
@@ -63,6 +76,24 @@ tws::wms::wms_manager::xml_capabilities() const
   return pimpl_->xml_doc;
 }
 
+const tws::core::cached_response&
+tws::wms::wms_manager::cached_capabilities() const
+{
+  return pimpl_->cached_capabilities;
+}
+
+const tws::wms::tile_matrix_set_t&
+tws::wms::wms_manager::tile_matrix_set() const
+{
+  return pimpl_->tile_matrix_set;
+}
+
+std::size_t
+tws::wms::wms_manager::layer_render_threads() const
+{
+  return pimpl_->layer_render_threads;
+}
+
 tws::wms::wms_manager::wms_manager()
   : pimpl_(nullptr)
 {
@@ -82,7 +113,62 @@ tws::wms::wms_manager::wms_manager()
 
   pimpl_->capabilities = read_capabilities(jcapabilities);
 
+// each layer of a map is rendered by its own query: the number of layers per request is always bounded
+  if(pimpl_->capabilities.service.layer_limit == 0)
+    pimpl_->capabilities.service.layer_limit = tws_wms_max_layer_limit;
+
+// only the GetMap formats with an encoder in this build are advertised
+  std::vector<std::string>& formats = pimpl_->capabilities.capability.request.get_map.format;
+
+  formats.erase(std::remove_if(formats.begin(), formats.end(),
+                               [](const std::string& f) { return !encoder_manager::instance().exists(f); }),
+                formats.end());
+
   write(pimpl_->capabilities, pimpl_->xml_doc);
+
+  std::string str_buff;
+
+  rapidxml::print(std::back_inserter(str_buff), pimpl_->xml_doc, 0);
+
+  pimpl_->cached_capabilities = tws::core::make_cached_response(std::move(str_buff), "application/xml");
+
+// the tile matrix set: 256 x 256 tiles rendered in groups of 4 x 4 unless informed otherwise
+  pimpl_->tile_matrix_set.tile_size = 256;
+  pimpl_->tile_matrix_set.metatile_size = 4;
+
+  if(jdocument->HasMember("tile_matrix_set"))
+  {
+    const rapidjson::Value& jtms = (*jdocument)["tile_matrix_set"];
+
+    if(!jtms.IsObject())
+      throw tws::parse_error() << tws::error_description("tile_matrix_set entry in file 'share/tws/config/wms.json' must be an object.");
+
+    const rapidjson::Value& jtile_size = jtms["tile_size"];
+
+    if(!jtile_size.IsNumber() || jtile_size.IsNull() || (jtile_size.GetUint() == 0))
+      throw tws::parse_error() << tws::error_description("tile_matrix_set must have a positive tile_size entry.");
+
+    const rapidjson::Value& jmetatile_size = jtms["metatile_size"];
+
+    if(!jmetatile_size.IsNumber() || jmetatile_size.IsNull() || (jmetatile_size.GetUint() == 0))
+      throw tws::parse_error() << tws::error_description("tile_matrix_set must have a positive metatile_size entry.");
+
+    pimpl_->tile_matrix_set.tile_size = jtile_size.GetUint();
+    pimpl_->tile_matrix_set.metatile_size = jmetatile_size.GetUint();
+  }
+
+// the threads rendering the extra layers of multi-layer maps: 2 unless informed otherwise
+  pimpl_->layer_render_threads = 2;
+
+  if(jdocument->HasMember("layer_render_threads"))
+  {
+    const rapidjson::Value& jthreads = (*jdocument)["layer_render_threads"];
+
+    if(!jthreads.IsUint() || jthreads.IsNull())
+      throw tws::parse_error() << tws::error_description("layer_render_threads entry in file 'share/tws/config/wms.json' must be a non-negative integer.");
+
+    pimpl_->layer_render_threads = jthreads.GetUint();
+  }
 }
 
 tws::wms::wms_manager::~wms_manager()
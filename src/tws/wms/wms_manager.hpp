@@ -28,6 +28,7 @@
 #define __TWS_WMS_WMS_MANAGER_HPP__
 
 // TWS
+#include "../core/cached_response.hpp"
 #include "config.hpp"
 #include "data_types.hpp"
 
@@ -62,6 +63,19 @@ namespace tws
 
         const rapidxml::xml_document<>& xml_capabilities() const;
 
+        //! The capabilities document already serialized to XML.
+        const tws::core::cached_response& cached_capabilities() const;
+
+        //! The tile matrix set of the tile operations.
+        const tile_matrix_set_t& tile_matrix_set() const;
+
+        //! The number of threads shared by all requests to render the layers of multi-layer maps.
+        /*!
+          Each of them may hold a SciDB connection besides the ones of the server
+          workers: the connection pool max_size should account for both.
+         */
+        std::size_t layer_render_threads() const;
+
       private:
 
 // singleton is accesible through class member function: instance()
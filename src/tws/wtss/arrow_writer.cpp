@@ -0,0 +1,499 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/arrow_writer.cpp
+
+  \brief A writer for the Apache Arrow IPC streaming format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "arrow_writer.hpp"
+#include "../geoarray/data_types.hpp"
+
+// STL
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+//! Append a value in little-endian byte order.
+template<class T> inline void
+tws_wtss_put_le(std::string& buf, T value)
+{
+  for(std::size_t i = 0; i != sizeof(T); ++i)
+    buf.push_back(static_cast<char>((static_cast<uint64_t>(value) >> (8 * i)) & 0xFF));
+}
+
+namespace tws
+{
+  namespace wtss
+  {
+    //! A field of a flatbuffers table: a little-endian scalar or, if size is zero, an offset to another object.
+    struct fb_field
+    {
+      uint16_t id;
+      uint8_t size;
+      uint64_t value;
+    };
+
+    /*!
+      \brief A minimal flatbuffers builder for the Arrow messages.
+
+      Flatbuffers offsets must point forward, so a table is written before the
+      objects it refers to: its offset fields are left as slots that are linked
+      to the objects when they are written.
+     */
+    class flatbuffer_builder
+    {
+      public:
+
+        static const std::size_t no_slot = static_cast<std::size_t>(-1);
+
+        //! The buffer starts with the slot of the root table offset.
+        flatbuffer_builder() { put<uint32_t>(0); }
+
+        std::size_t root() const { return 0; }
+
+        //! Write a table linked to slot and return the slots of its offset fields, in the order informed.
+        std::vector<std::size_t> table(std::size_t slot, const std::vector<fb_field>& fields);
+
+        //! Write a vector of n offsets linked to slot and return the slot of its first element.
+        std::size_t offsets(std::size_t slot, std::size_t n);
+
+        //! Write a vector of n structs with 8-byte alignment, linked to slot.
+        void structs(std::size_t slot, const std::string& data, std::size_t n);
+
+        void string(std::size_t slot, const std::string& value);
+
+        const std::string& str() const { return buf_; }
+
+      private:
+
+        template<class T> void put(T value) { tws_wtss_put_le(buf_, value); }
+
+        //! Pad with zeros until (size + extra) is a multiple of alignment.
+        void pad(std::size_t alignment, std::size_t extra = 0)
+        {
+          while((buf_.size() + extra) % alignment != 0)
+            buf_.push_back('\0');
+        }
+
+        //! Make the offset in slot point to the end of the buffer.
+        void link(std::size_t slot)
+        {
+          uint32_t offset = static_cast<uint32_t>(buf_.size() - slot);
+
+          for(std::size_t i = 0; i != 4; ++i)
+            buf_[slot + i] = static_cast<char>((offset >> (8 * i)) & 0xFF);
+        }
+
+      private:
+
+        std::string buf_;
+    };
+
+  }  // end namespace wtss
+}    // end namespace tws
+
+// the Arrow format constants, from its Schema.fbs and Message.fbs files
+static const uint16_t tws_wtss_arrow_metadata_v5 = 4;
+static const uint8_t tws_wtss_arrow_header_schema = 1;
+static const uint8_t tws_wtss_arrow_header_record_batch = 3;
+static const uint8_t tws_wtss_arrow_type_int = 2;
+static const uint8_t tws_wtss_arrow_type_floating_point = 3;
+static const uint8_t tws_wtss_arrow_type_utf8 = 5;
+static const uint8_t tws_wtss_arrow_type_fixed_size_list = 16;
+static const uint16_t tws_wtss_arrow_precision_single = 1;
+static const uint16_t tws_wtss_arrow_precision_double = 2;
+
+static void
+tws_wtss_arrow_write_metadata(tws::wtss::flatbuffer_builder& fb,
+                              std::size_t slot,
+                              const tws::wtss::arrow_metadata_t& metadata)
+{
+  std::size_t first = fb.offsets(slot, metadata.size());
+
+  for(std::size_t i = 0; i != metadata.size(); ++i)
+  {
+    std::vector<std::size_t> kv = fb.table(first + 4 * i, { {0, 0, 0}, {1, 0, 0} });
+
+    fb.string(kv[0], metadata[i].first);
+    fb.string(kv[1], metadata[i].second);
+  }
+}
+
+// the type of a field, as in the Type union
+static uint8_t
+tws_wtss_arrow_type_id(bool is_string, int datatype)
+{
+  if(is_string)
+    return tws_wtss_arrow_type_utf8;
+
+  if((datatype == tws::geoarray::datatype_t::float_dt) ||
+     (datatype == tws::geoarray::datatype_t::double_dt) ||
+     (datatype == tws::geoarray::datatype_t::unknown))
+    return tws_wtss_arrow_type_floating_point;
+
+  return tws_wtss_arrow_type_int;
+}
+
+// the Int or FloatingPoint type table of a numeric field
+static void
+tws_wtss_arrow_write_type(tws::wtss::flatbuffer_builder& fb, std::size_t slot, int datatype)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(datatype)
+  {
+    case dt::int8_dt: fb.table(slot, { {0, 4, 8}, {1, 1, 1} }); break;
+    case dt::uint8_dt: fb.table(slot, { {0, 4, 8}, {1, 1, 0} }); break;
+    case dt::int16_dt: fb.table(slot, { {0, 4, 16}, {1, 1, 1} }); break;
+    case dt::uint16_dt: fb.table(slot, { {0, 4, 16}, {1, 1, 0} }); break;
+    case dt::int32_dt: fb.table(slot, { {0, 4, 32}, {1, 1, 1} }); break;
+    case dt::uint32_dt: fb.table(slot, { {0, 4, 32}, {1, 1, 0} }); break;
+    case dt::int64_dt: fb.table(slot, { {0, 4, 64}, {1, 1, 1} }); break;
+    case dt::uint64_dt: fb.table(slot, { {0, 4, 64}, {1, 1, 0} }); break;
+    case dt::float_dt: fb.table(slot, { {0, 2, tws_wtss_arrow_precision_single} }); break;
+    default: fb.table(slot, { {0, 2, tws_wtss_arrow_precision_double} });
+  }
+}
+
+// a field without children: a string or numeric column or the item of a list
+static void
+tws_wtss_arrow_write_field(tws::wtss::flatbuffer_builder& fb,
+                           std::size_t slot,
+                           const std::string& name,
+                           bool is_string,
+                           int datatype,
+                           const tws::wtss::arrow_metadata_t& metadata)
+{
+// name, nullable, type and children: an empty list, as the readers expect one
+  std::vector<tws::wtss::fb_field> field_fields = { {0, 0, 0}, {1, 1, 0}, {2, 1, tws_wtss_arrow_type_id(is_string, datatype)}, {3, 0, 0}, {5, 0, 0} };
+
+  if(!metadata.empty())
+    field_fields.push_back({6, 0, 0});
+
+  std::vector<std::size_t> f = fb.table(slot, field_fields);
+
+  fb.string(f[0], name);
+
+  if(is_string)
+    fb.table(f[1], std::vector<tws::wtss::fb_field>());
+  else
+    tws_wtss_arrow_write_type(fb, f[1], datatype);
+
+  fb.offsets(f[2], 0);
+
+  if(!metadata.empty())
+    tws_wtss_arrow_write_metadata(fb, f[3], metadata);
+}
+
+std::vector<std::size_t>
+tws::wtss::flatbuffer_builder::table(std::size_t slot, const std::vector<fb_field>& fields)
+{
+// the fields are laid out by decreasing size: all of them are aligned if the table is 8-byte aligned
+  std::vector<std::size_t> order(fields.size());
+
+  std::iota(order.begin(), order.end(), 0);
+
+  std::stable_sort(order.begin(), order.end(),
+                   [&fields](std::size_t a, std::size_t b) { return std::max<int>(fields[a].size, 4 * (fields[a].size == 0)) >
+                                                                    std::max<int>(fields[b].size, 4 * (fields[b].size == 0)); });
+
+  std::vector<uint16_t> field_pos(fields.size());
+
+  std::size_t table_size = 4;  // the vtable offset
+
+  std::size_t nids = 0;
+
+  for(std::size_t i : order)
+  {
+    std::size_t size = (fields[i].size == 0) ? 4 : fields[i].size;
+
+    table_size = (table_size + size - 1) / size * size;
+
+    field_pos[i] = static_cast<uint16_t>(table_size);
+
+    table_size += size;
+
+    nids = std::max<std::size_t>(nids, fields[i].id + 1);
+  }
+
+// the vtable: its size, the table size and the position of each field in the table, zero if absent
+  pad(2);
+
+  std::size_t vtable = buf_.size();
+
+  put<uint16_t>(static_cast<uint16_t>(4 + 2 * nids));
+  put<uint16_t>(static_cast<uint16_t>(table_size));
+
+  std::vector<uint16_t> vtable_entries(nids, 0);
+
+  for(std::size_t i = 0; i != fields.size(); ++i)
+    vtable_entries[fields[i].id] = field_pos[i];
+
+  for(uint16_t entry : vtable_entries)
+    put<uint16_t>(entry);
+
+// the table, starting with the signed distance back to its vtable
+  pad(8);
+
+  std::size_t table = buf_.size();
+
+  if(slot != no_slot)
+    link(slot);
+
+  put<int32_t>(static_cast<int32_t>(table - vtable));
+
+  buf_.resize(table + table_size, '\0');
+
+  std::vector<std::size_t> slots;
+
+  for(std::size_t i = 0; i != fields.size(); ++i)
+  {
+    std::size_t pos = table + field_pos[i];
+
+    if(fields[i].size == 0)
+    {
+      slots.push_back(pos);
+      continue;
+    }
+
+    for(std::size_t b = 0; b != fields[i].size; ++b)
+      buf_[pos + b] = static_cast<char>((fields[i].value >> (8 * b)) & 0xFF);
+  }
+
+  return slots;
+}
+
+std::size_t
+tws::wtss::flatbuffer_builder::offsets(std::size_t slot, std::size_t n)
+{
+  pad(4);
+
+  link(slot);
+
+  put<uint32_t>(static_cast<uint32_t>(n));
+
+  std::size_t first = buf_.size();
+
+  buf_.append(4 * n, '\0');
+
+  return first;
+}
+
+void
+tws::wtss::flatbuffer_builder::structs(std::size_t slot, const std::string& data, std::size_t n)
+{
+  pad(8, 4);
+
+  link(slot);
+
+  put<uint32_t>(static_cast<uint32_t>(n));
+
+  buf_.append(data);
+}
+
+void
+tws::wtss::flatbuffer_builder::string(std::size_t slot, const std::string& value)
+{
+  pad(4);
+
+  link(slot);
+
+  put<uint32_t>(static_cast<uint32_t>(value.size()));
+
+  buf_.append(value);
+
+  buf_.push_back('\0');
+}
+
+tws::wtss::arrow_stream_writer::arrow_stream_writer(output_buffer& out)
+  : out_(out)
+{
+}
+
+void
+tws::wtss::arrow_stream_writer::schema(const std::vector<arrow_field_t>& fields,
+                                       const arrow_metadata_t& metadata)
+{
+  fields_ = fields;
+
+  flatbuffer_builder fb;
+
+  std::vector<std::size_t> msg = fb.table(fb.root(), { {0, 2, tws_wtss_arrow_metadata_v5},
+                                                       {1, 1, tws_wtss_arrow_header_schema},
+                                                       {2, 0, 0},
+                                                       {3, 8, 0} });
+
+// endianness (little), fields and custom metadata
+  std::vector<fb_field> schema_fields = { {0, 2, 0}, {1, 0, 0} };
+
+  if(!metadata.empty())
+    schema_fields.push_back({2, 0, 0});
+
+  std::vector<std::size_t> schema = fb.table(msg[0], schema_fields);
+
+  std::size_t first = fb.offsets(schema[0], fields.size());
+
+  for(std::size_t i = 0; i != fields.size(); ++i)
+  {
+    const arrow_field_t& field = fields[i];
+
+    if(field.list_size == 0)
+    {
+      tws_wtss_arrow_write_field(fb, first + 4 * i, field.name, field.is_string, field.datatype, field.metadata);
+      continue;
+    }
+
+// a FixedSizeList field: its numbers are the values of a single child field
+    std::vector<fb_field> field_fields = { {0, 0, 0}, {1, 1, 0}, {2, 1, tws_wtss_arrow_type_fixed_size_list}, {3, 0, 0}, {5, 0, 0} };
+
+    if(!field.metadata.empty())
+      field_fields.push_back({6, 0, 0});
+
+    std::vector<std::size_t> f = fb.table(first + 4 * i, field_fields);
+
+    fb.string(f[0], field.name);
+
+    fb.table(f[1], { {0, 4, field.list_size} });
+
+    std::size_t child = fb.offsets(f[2], 1);
+
+    tws_wtss_arrow_write_field(fb, child, "item", false, field.datatype, arrow_metadata_t());
+
+    if(!field.metadata.empty())
+      tws_wtss_arrow_write_metadata(fb, f[3], field.metadata);
+  }
+
+  if(!metadata.empty())
+    tws_wtss_arrow_write_metadata(fb, schema[1], metadata);
+
+  message(fb.str());
+
+  out_.check();
+}
+
+void
+tws::wtss::arrow_stream_writer::record_batch(int64_t nrows, const std::vector<arrow_column_t>& columns)
+{
+  assert(columns.size() == fields_.size());
+
+// the body buffers: an empty validity bitmap, the offsets of string columns and the values, each one 8-byte aligned
+  std::vector<std::pair<const void*, std::size_t> > body;
+
+// the FieldNode structs, in depth-first order: length and null count of each column and list child
+  std::string nodes_data;
+
+  std::size_t nnodes = 0;
+
+  for(std::size_t i = 0; i != columns.size(); ++i)
+  {
+    body.push_back(std::make_pair(static_cast<const void*>(nullptr), 0));
+
+    tws_wtss_put_le<int64_t>(nodes_data, nrows);
+    tws_wtss_put_le<int64_t>(nodes_data, 0);
+
+    ++nnodes;
+
+    if(fields_[i].list_size != 0)
+    {
+      body.push_back(std::make_pair(static_cast<const void*>(nullptr), 0));
+
+      tws_wtss_put_le<int64_t>(nodes_data, nrows * static_cast<int64_t>(fields_[i].list_size));
+      tws_wtss_put_le<int64_t>(nodes_data, 0);
+
+      ++nnodes;
+    }
+
+    if(fields_[i].is_string)
+      body.push_back(std::make_pair(static_cast<const void*>(columns[i].offsets), static_cast<std::size_t>(nrows + 1) * sizeof(int32_t)));
+
+    body.push_back(std::make_pair(columns[i].values, columns[i].values_size));
+  }
+
+// the Buffer structs: offset and length of each buffer in the body
+  std::string buffers_data;
+
+  uint64_t body_length = 0;
+
+  for(const auto& buffer : body)
+  {
+    tws_wtss_put_le<int64_t>(buffers_data, static_cast<int64_t>(body_length));
+    tws_wtss_put_le<int64_t>(buffers_data, static_cast<int64_t>(buffer.second));
+
+    body_length += (buffer.second + 7) / 8 * 8;
+  }
+
+  flatbuffer_builder fb;
+
+  std::vector<std::size_t> msg = fb.table(fb.root(), { {0, 2, tws_wtss_arrow_metadata_v5},
+                                                       {1, 1, tws_wtss_arrow_header_record_batch},
+                                                       {2, 0, 0},
+                                                       {3, 8, body_length} });
+
+  std::vector<std::size_t> batch = fb.table(msg[0], { {0, 8, static_cast<uint64_t>(nrows)}, {1, 0, 0}, {2, 0, 0} });
+
+  fb.structs(batch[0], nodes_data, nnodes);
+  fb.structs(batch[1], buffers_data, body.size());
+
+  message(fb.str());
+
+  static const char zeros[8] = { 0 };
+
+  for(const auto& buffer : body)
+  {
+    if(buffer.second == 0)
+      continue;
+
+    out_.append(static_cast<const char*>(buffer.first), buffer.second);
+    out_.append(zeros, (8 - buffer.second % 8) % 8);
+  }
+
+  out_.check();
+}
+
+void
+tws::wtss::arrow_stream_writer::end()
+{
+  static const char eos[8] = { '\xFF', '\xFF', '\xFF', '\xFF', 0, 0, 0, 0 };
+
+  out_.append(eos, sizeof(eos));
+
+  out_.check();
+}
+
+// an encapsulated message: continuation marker, metadata size, metadata padded to 8 bytes
+void
+tws::wtss::arrow_stream_writer::message(const std::string& metadata)
+{
+  static const char zeros[8] = { 0 };
+
+  std::size_t padded_size = (metadata.size() + 7) / 8 * 8;
+
+  std::string prefix;
+
+  tws_wtss_put_le<uint32_t>(prefix, 0xFFFFFFFF);
+  tws_wtss_put_le<int32_t>(prefix, static_cast<int32_t>(padded_size));
+
+  out_.append(prefix.data(), prefix.size());
+  out_.append(metadata.data(), metadata.size());
+  out_.append(zeros, padded_size - metadata.size());
+}
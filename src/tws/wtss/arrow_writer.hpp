@@ -0,0 +1,107 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/arrow_writer.hpp
+
+  \brief A writer for the Apache Arrow IPC streaming format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_ARROW_WRITER_HPP__
+#define __TWS_WTSS_ARROW_WRITER_HPP__
+
+// TWS
+#include "output_buffer.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Boost
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    //! A list of key-value pairs attached to a schema or to a field.
+    typedef std::vector<std::pair<std::string, std::string> > arrow_metadata_t;
+
+    //! A column of the record batches of a stream.
+    struct arrow_field_t
+    {
+      std::string name;
+      int datatype;                //!< A tws::geoarray::datatype_t code; ignored for string columns.
+      bool is_string;              //!< A column of UTF-8 strings.
+      std::size_t list_size;       //!< If not zero, each value is a list of list_size numbers of the datatype.
+      arrow_metadata_t metadata;
+    };
+
+    //! The buffers of a column in a record batch.
+    struct arrow_column_t
+    {
+      const void* values;          //!< The values or, for a string column, their characters; the lists are laid out one after the other.
+      std::size_t values_size;     //!< The size of the values buffer, in bytes.
+      const int32_t* offsets;      //!< For a string column, the nrows + 1 offsets of the strings in the characters buffer.
+    };
+
+    /*!
+      \brief Writes an Arrow IPC stream: a schema followed by record batches.
+
+      The columns have no null values: missing values keep their coverage
+      representation, which the field metadata tells. A column may also hold
+      lists of a fixed number of values, such as a time series per row.
+      Values are written in little-endian byte order, the order of the
+      platforms TWS runs on.
+     */
+    class arrow_stream_writer : public boost::noncopyable
+    {
+      public:
+
+        explicit arrow_stream_writer(output_buffer& out);
+
+        //! Write the schema message: it must be the first one.
+        void schema(const std::vector<arrow_field_t>& fields,
+                    const arrow_metadata_t& metadata);
+
+        //! Write a record batch with a column for each field of the schema.
+        void record_batch(int64_t nrows, const std::vector<arrow_column_t>& columns);
+
+        //! Write the end-of-stream marker.
+        void end();
+
+      private:
+
+        void message(const std::string& metadata);
+
+      private:
+
+        output_buffer& out_;
+        std::vector<arrow_field_t> fields_;
+    };
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_ARROW_WRITER_HPP__
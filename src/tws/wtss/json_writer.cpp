@@ -0,0 +1,331 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/json_writer.cpp
+
+  \brief A streaming JSON writer for the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "json_writer.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const double tws_wtss_pow10[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+  1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20
+};
+
+static const uint64_t tws_wtss_upow10[] =
+{
+  1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+  100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+  10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL
+};
+
+static char*
+tws_wtss_write_uint(uint64_t value, char* out)
+{
+  char digits[20];
+
+  int n = 0;
+
+  do
+  {
+    digits[n++] = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  }
+  while(value != 0);
+
+  while(n != 0)
+    *out++ = digits[--n];
+
+  return out;
+}
+
+char*
+tws::wtss::format_double(double value, int precision, char* out)
+{
+  precision = std::max(1, std::min(precision, 17));
+
+  if(value == 0.0)
+  {
+    *out++ = '0';
+    return out;
+  }
+
+  if(value < 0.0)
+  {
+    *out++ = '-';
+    value = -value;
+  }
+
+// integral values are written exactly while they fit the double mantissa: the array attributes are mostly integers
+  if((value < 9007199254740992.0) && (value == std::floor(value)))
+    return tws_wtss_write_uint(static_cast<uint64_t>(value), out);
+
+// the usual magnitudes are rounded to an integer with precision digits and written in fixed notation:
+// the last digit may differ from the one printf would choose when the value is very close to a tie
+  if((precision <= 12) && (value >= 1e-5) && (value < 1e15))
+  {
+    int e = static_cast<int>(std::floor(std::log10(value)));
+
+    int k = 0;
+
+    uint64_t r = 0;
+
+// log10 may be off by one near the powers of ten and rounding may carry to one more digit
+    for(int attempt = 0; attempt != 3; ++attempt)
+    {
+      k = precision - 1 - e;
+
+      double scaled = (k >= 0) ? value * tws_wtss_pow10[k] : value / tws_wtss_pow10[-k];
+
+      r = static_cast<uint64_t>(scaled + 0.5);
+
+      if(r >= tws_wtss_upow10[precision])
+        ++e;
+      else if(r < tws_wtss_upow10[precision - 1])
+        --e;
+      else
+        break;
+    }
+
+    int ndigits = precision;
+
+// remove the trailing zeros of the fractional part
+    while((k > 0) && (r % 10 == 0))
+    {
+      r /= 10;
+      --k;
+      --ndigits;
+    }
+
+    char digits[20];
+
+    tws_wtss_write_uint(r, digits);
+
+    if(k <= 0)
+    {
+      out = std::copy(digits, digits + ndigits, out);
+      out = std::fill_n(out, -k, '0');
+    }
+    else if(ndigits > k)
+    {
+      out = std::copy(digits, digits + (ndigits - k), out);
+      *out++ = '.';
+      out = std::copy(digits + (ndigits - k), digits + ndigits, out);
+    }
+    else
+    {
+      *out++ = '0';
+      *out++ = '.';
+      out = std::fill_n(out, k - ndigits, '0');
+      out = std::copy(digits, digits + ndigits, out);
+    }
+
+    return out;
+  }
+
+// very small or large magnitudes and the full precision ones go the slow way
+  int n = std::snprintf(out, 31, "%.*g", precision, value);
+
+  return out + n;
+}
+
+tws::wtss::json_writer::json_writer(output_buffer& out, int precision)
+  : out_(out),
+    precision_(precision),
+    need_comma_(false)
+{
+}
+
+void
+tws::wtss::json_writer::start_object()
+{
+  separate();
+
+  out_.push_back('{');
+
+  need_comma_ = false;
+}
+
+void
+tws::wtss::json_writer::end_object()
+{
+  out_.push_back('}');
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::start_array()
+{
+  separate();
+
+  out_.push_back('[');
+
+  need_comma_ = false;
+}
+
+void
+tws::wtss::json_writer::end_array()
+{
+  out_.push_back(']');
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::key(const char* name, std::size_t len)
+{
+  string(name, len);
+
+  out_.push_back(':');
+
+  need_comma_ = false;
+}
+
+void
+tws::wtss::json_writer::string(const char* value, std::size_t len)
+{
+  static const char hex[] = "0123456789abcdef";
+
+  separate();
+
+  out_.push_back('"');
+
+// copy the runs of characters that need no escaping at once
+  const char* first = value;
+  const char* last = value + len;
+
+  for(const char* c = value; c != last; ++c)
+  {
+    unsigned char uc = static_cast<unsigned char>(*c);
+
+    if((uc >= 0x20) && (uc != '"') && (uc != '\\'))
+      continue;
+
+    out_.append(first, c);
+
+    out_.push_back('\\');
+
+    switch(uc)
+    {
+      case '"': out_.push_back('"'); break;
+      case '\\': out_.push_back('\\'); break;
+      case '\n': out_.push_back('n'); break;
+      case '\r': out_.push_back('r'); break;
+      case '\t': out_.push_back('t'); break;
+      case '\b': out_.push_back('b'); break;
+      case '\f': out_.push_back('f'); break;
+      default:
+        out_.append("u00", 3);
+        out_.push_back(hex[uc >> 4]);
+        out_.push_back(hex[uc & 0xF]);
+    }
+
+    first = c + 1;
+  }
+
+  out_.append(first, last);
+
+  out_.push_back('"');
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::number(double value)
+{
+  separate();
+
+  if(std::isfinite(value))
+  {
+    char text[32];
+
+    out_.append(text, format_double(value, precision_, text));
+  }
+  else
+  {
+    out_.append("null", 4);
+  }
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::number(int64_t value)
+{
+  separate();
+
+  char text[24];
+
+  char* last = text;
+
+  if(value < 0)
+    *last++ = '-';
+
+  last = tws_wtss_write_uint(value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value), last);
+
+  out_.append(text, last);
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::null()
+{
+  separate();
+
+  out_.append("null", 4);
+
+  value_written();
+}
+
+void
+tws::wtss::json_writer::numbers(const double* first, const double* last)
+{
+  start_array();
+
+  char text[33];
+
+  for(const double* v = first; v != last; ++v)
+  {
+    char* text_first = text + 1;
+    char* text_last = std::isfinite(*v) ? format_double(*v, precision_, text_first)
+                                        : std::copy_n("null", 4, text_first);
+
+// the comma is written together with the number
+    if(v != first)
+      *--text_first = ',';
+
+    out_.append(text_first, text_last);
+
+    out_.check();
+  }
+
+  end_array();
+}
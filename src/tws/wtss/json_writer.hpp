@@ -0,0 +1,119 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/json_writer.hpp
+
+  \brief A streaming JSON writer for the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_JSON_WRITER_HPP__
+#define __TWS_WTSS_JSON_WRITER_HPP__
+
+// TWS
+#include "output_buffer.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Boost
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    /*!
+      \brief Writes a JSON document as its values are informed, without building a DOM.
+
+      Numbers are written with at most precision significant digits, except for
+      integral values, which are written exactly. NaN and infinite values are
+      written as null.
+     */
+    class json_writer : public boost::noncopyable
+    {
+      public:
+
+        json_writer(output_buffer& out, int precision);
+
+        void start_object();
+
+        void end_object();
+
+        void start_array();
+
+        void end_array();
+
+        //! Write a member name: the next value belongs to it.
+        void key(const char* name, std::size_t len);
+
+        void key(const std::string& name) { key(name.c_str(), name.size()); }
+
+        void string(const char* value, std::size_t len);
+
+        void string(const std::string& value) { string(value.c_str(), value.size()); }
+
+        void number(double value);
+
+        void number(int64_t value);
+
+        void null();
+
+        //! Write an array with the numbers in the range [first, last).
+        void numbers(const double* first, const double* last);
+
+      private:
+
+        void separate()
+        {
+          if(need_comma_)
+            out_.push_back(',');
+        }
+
+        void value_written()
+        {
+          need_comma_ = true;
+
+          out_.check();
+        }
+
+      private:
+
+        output_buffer& out_;
+        int precision_;
+        bool need_comma_;
+    };
+
+    /*!
+      \brief Write a double with at most precision significant digits (between 1 and 17).
+
+      The text is a valid JSON number and is not null terminated.
+
+      \return A pointer past the last character written: at most 32 bytes of out are used.
+     */
+    char* format_double(double value, int precision, char* out);
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_JSON_WRITER_HPP__
@@ -0,0 +1,135 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/msgpack_writer.cpp
+
+  \brief A streaming MessagePack writer for the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "msgpack_writer.hpp"
+
+// STL
+#include <cstring>
+
+tws::wtss::msgpack_writer::msgpack_writer(output_buffer& out)
+  : out_(out)
+{
+}
+
+// MessagePack numbers and lengths are written in big-endian byte order
+template<class T> inline void
+tws::wtss::msgpack_writer::put(uint8_t marker, T value)
+{
+  char bytes[1 + sizeof(T)];
+
+  bytes[0] = static_cast<char>(marker);
+
+  for(std::size_t i = 0; i != sizeof(T); ++i)
+    bytes[sizeof(T) - i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+
+  out_.append(bytes, sizeof(bytes));
+}
+
+void
+tws::wtss::msgpack_writer::map(uint32_t nelements)
+{
+  if(nelements < 16)
+    out_.push_back(static_cast<char>(0x80 | nelements));
+  else if(nelements <= 0xFFFF)
+    put<uint16_t>(0xde, static_cast<uint16_t>(nelements));
+  else
+    put<uint32_t>(0xdf, nelements);
+}
+
+void
+tws::wtss::msgpack_writer::array(uint32_t nelements)
+{
+  if(nelements < 16)
+    out_.push_back(static_cast<char>(0x90 | nelements));
+  else if(nelements <= 0xFFFF)
+    put<uint16_t>(0xdc, static_cast<uint16_t>(nelements));
+  else
+    put<uint32_t>(0xdd, nelements);
+}
+
+void
+tws::wtss::msgpack_writer::string(const char* value, std::size_t len)
+{
+  if(len < 32)
+    out_.push_back(static_cast<char>(0xa0 | len));
+  else if(len <= 0xFF)
+    put<uint8_t>(0xd9, static_cast<uint8_t>(len));
+  else if(len <= 0xFFFF)
+    put<uint16_t>(0xda, static_cast<uint16_t>(len));
+  else
+    put<uint32_t>(0xdb, static_cast<uint32_t>(len));
+
+  out_.append(value, len);
+
+  out_.check();
+}
+
+void
+tws::wtss::msgpack_writer::number(double value)
+{
+  uint64_t bits = 0;
+
+  std::memcpy(&bits, &value, sizeof(bits));
+
+  put<uint64_t>(0xcb, bits);
+
+  out_.check();
+}
+
+void
+tws::wtss::msgpack_writer::integer(int64_t value)
+{
+  if((value >= -32) && (value <= 127))
+    out_.push_back(static_cast<char>(value));
+  else if((value >= INT16_MIN) && (value <= INT16_MAX))
+    put<uint16_t>(0xd1, static_cast<uint16_t>(value));
+  else if((value >= INT32_MIN) && (value <= INT32_MAX))
+    put<uint32_t>(0xd2, static_cast<uint32_t>(value));
+  else
+    put<uint64_t>(0xd3, static_cast<uint64_t>(value));
+
+  out_.check();
+}
+
+void
+tws::wtss::msgpack_writer::nil()
+{
+  out_.push_back(static_cast<char>(0xc0));
+
+  out_.check();
+}
+
+void
+tws::wtss::msgpack_writer::bin(std::size_t size)
+{
+  if(size <= 0xFF)
+    put<uint8_t>(0xc4, static_cast<uint8_t>(size));
+  else if(size <= 0xFFFF)
+    put<uint16_t>(0xc5, static_cast<uint16_t>(size));
+  else
+    put<uint32_t>(0xc6, static_cast<uint32_t>(size));
+}
@@ -0,0 +1,91 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/msgpack_writer.hpp
+
+  \brief A streaming MessagePack writer for the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_MSGPACK_WRITER_HPP__
+#define __TWS_WTSS_MSGPACK_WRITER_HPP__
+
+// TWS
+#include "output_buffer.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Boost
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    /*!
+      \brief Writes a MessagePack document as its values are informed.
+
+      Maps and arrays are started with their number of elements, which must be
+      written next: for maps, a key followed by its value.
+     */
+    class msgpack_writer : public boost::noncopyable
+    {
+      public:
+
+        explicit msgpack_writer(output_buffer& out);
+
+        void map(uint32_t nelements);
+
+        void array(uint32_t nelements);
+
+        void string(const char* value, std::size_t len);
+
+        void string(const std::string& value) { string(value.c_str(), value.size()); }
+
+        //! Write a 64-bit float.
+        void number(double value);
+
+        //! Write an integer in its shortest encoding.
+        void integer(int64_t value);
+
+        void nil();
+
+        //! Write the header of a byte array whose size bytes must be appended next to the output buffer.
+        void bin(std::size_t size);
+
+        output_buffer& out() { return out_; }
+
+      private:
+
+        template<class T> void put(uint8_t marker, T value);
+
+      private:
+
+        output_buffer& out_;
+    };
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_MSGPACK_WRITER_HPP__
@@ -0,0 +1,84 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/output_buffer.cpp
+
+  \brief The buffer shared by the writers of the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "output_buffer.hpp"
+
+// STL
+#include <algorithm>
+
+// Boost
+#include <boost/thread/tss.hpp>
+
+//! A thread buffer larger than this is released when it is no longer used.
+static const std::size_t tws_wtss_max_retained_buffer = 16 * 1024 * 1024;
+
+static std::string&
+tws_wtss_thread_buffer()
+{
+  static boost::thread_specific_ptr<std::string> buffer;
+
+  if(buffer.get() == nullptr)
+    buffer.reset(new std::string);
+
+  return *buffer;
+}
+
+tws::wtss::output_buffer::output_buffer()
+  : buffer_(tws_wtss_thread_buffer()),
+    flush_size_(0)
+{
+  buffer_.clear();
+}
+
+tws::wtss::output_buffer::output_buffer(const output_t& output, std::size_t flush_size)
+  : buffer_(tws_wtss_thread_buffer()),
+    output_(output),
+    flush_size_(std::max<std::size_t>(flush_size, 1))
+{
+  buffer_.clear();
+
+  buffer_.reserve(flush_size_ + 64);
+}
+
+tws::wtss::output_buffer::~output_buffer()
+{
+  if(buffer_.capacity() > tws_wtss_max_retained_buffer)
+    std::string().swap(buffer_);
+  else
+    buffer_.clear();
+}
+
+void
+tws::wtss::output_buffer::flush()
+{
+  if(output_.empty() || buffer_.empty())
+    return;
+
+  output_(buffer_.data(), buffer_.size());
+
+  buffer_.clear();
+}
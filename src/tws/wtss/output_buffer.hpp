@@ -0,0 +1,98 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/output_buffer.hpp
+
+  \brief The buffer shared by the writers of the WTSS responses.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_OUTPUT_BUFFER_HPP__
+#define __TWS_WTSS_OUTPUT_BUFFER_HPP__
+
+// STL
+#include <cstddef>
+#include <string>
+
+// Boost
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    /*!
+      \brief A buffer owned by the calling thread where a response is written.
+
+      The memory is reused by all buffers created in a thread, so that writing a
+      response seldom allocates memory. Only one buffer may be alive in a thread
+      at a time.
+
+      If an output function is informed, the text is handed over to it each
+      time at least flush_size bytes are buffered and when flush is called;
+      otherwise the whole response is kept until the buffer is destroyed.
+     */
+    class output_buffer : public boost::noncopyable
+    {
+      public:
+
+        typedef boost::function<void (const char*, std::size_t)> output_t;
+
+        //! A buffer that keeps the whole response.
+        output_buffer();
+
+        //! A buffer that sends the response to output in pieces of about flush_size bytes.
+        output_buffer(const output_t& output, std::size_t flush_size);
+
+        ~output_buffer();
+
+        void append(const char* first, const char* last) { buffer_.append(first, last); }
+
+        void append(const char* value, std::size_t size) { buffer_.append(value, size); }
+
+        void push_back(char c) { buffer_.push_back(c); }
+
+        //! Flush the buffer if it reached the flush size.
+        void check()
+        {
+          if((flush_size_ != 0) && (buffer_.size() >= flush_size_))
+            flush();
+        }
+
+        //! Hand the buffered bytes over to the output function, if there is one.
+        void flush();
+
+        const char* data() const { return buffer_.data(); }
+
+        std::size_t size() const { return buffer_.size(); }
+
+      private:
+
+        std::string& buffer_;
+        output_t output_;
+        std::size_t flush_size_;
+    };
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_OUTPUT_BUFFER_HPP__
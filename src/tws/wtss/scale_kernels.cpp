@@ -0,0 +1,422 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/scale_kernels.cpp
+
+  \brief Kernels that turn the stored values of an attribute into analysis-ready values.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "scale_kernels.hpp"
+#include "../core/simd.hpp"
+#include "../exception.hpp"
+#include "time_series.hpp"
+
+// STL
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Boost
+#include <boost/format.hpp>
+
+// the SIMD kernels are compiled with function target attributes: the module itself needs no special flags
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TWS_WTSS_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+template<class T> static void
+tws_wtss_scale_scalar(const T* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+
+  for(std::size_t j = 0; j < n; ++j)
+  {
+    double v = static_cast<double>(values[j]);
+
+    bool valid = (v == v) && (v != s.missing_value);
+
+    out[j] = valid ? std::min(s.max_val, std::max(s.min_val, v)) * s.scale_factor : nan;
+  }
+}
+
+#ifdef TWS_WTSS_X86_KERNELS
+
+// clamp and scale two doubles, replacing the invalid ones by NaN
+__attribute__((target("sse2")))
+static inline __m128d
+tws_wtss_scale_pd(__m128d v, __m128d valid, __m128d min_val, __m128d max_val, __m128d scale, __m128d nan)
+{
+  __m128d scaled = _mm_mul_pd(_mm_min_pd(_mm_max_pd(v, min_val), max_val), scale);
+
+  return _mm_or_pd(_mm_and_pd(valid, scaled), _mm_andnot_pd(valid, nan));
+}
+
+// 8 integers at a time: they are widened to 32 bits and then converted two by two to double
+template<bool is_signed>
+__attribute__((target("sse2")))
+static void
+tws_wtss_scale_16_sse2(const void* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m128d scale = _mm_set1_pd(s.scale_factor);
+  const __m128d min_val = _mm_set1_pd(s.min_val);
+  const __m128d max_val = _mm_set1_pd(s.max_val);
+  const __m128d missing = _mm_set1_pd(s.missing_value);
+  const __m128d nan = _mm_set1_pd(std::numeric_limits<double>::quiet_NaN());
+  const __m128i zero = _mm_setzero_si128();
+
+  const char* first = static_cast<const char*>(values);
+
+  std::size_t j = 0;
+
+  for(; j + 8 <= n; j += 8)
+  {
+    __m128i v16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 2 * j));
+
+    __m128i v32[2];
+
+    if(is_signed)
+    {
+      v32[0] = _mm_srai_epi32(_mm_unpacklo_epi16(v16, v16), 16);
+      v32[1] = _mm_srai_epi32(_mm_unpackhi_epi16(v16, v16), 16);
+    }
+    else
+    {
+      v32[0] = _mm_unpacklo_epi16(v16, zero);
+      v32[1] = _mm_unpackhi_epi16(v16, zero);
+    }
+
+    for(int k = 0; k != 2; ++k)
+    {
+      __m128d v0 = _mm_cvtepi32_pd(v32[k]);
+      __m128d v1 = _mm_cvtepi32_pd(_mm_shuffle_epi32(v32[k], 0x0E));
+
+      _mm_storeu_pd(out + j + 4 * k, tws_wtss_scale_pd(v0, _mm_cmpneq_pd(v0, missing), min_val, max_val, scale, nan));
+      _mm_storeu_pd(out + j + 4 * k + 2, tws_wtss_scale_pd(v1, _mm_cmpneq_pd(v1, missing), min_val, max_val, scale, nan));
+    }
+  }
+
+  if(is_signed)
+    tws_wtss_scale_scalar(reinterpret_cast<const int16_t*>(first) + j, n - j, s, out + j);
+  else
+    tws_wtss_scale_scalar(reinterpret_cast<const uint16_t*>(first) + j, n - j, s, out + j);
+}
+
+__attribute__((target("sse2")))
+static void
+tws_wtss_scale_int16_sse2(const int16_t* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  tws_wtss_scale_16_sse2<true>(values, n, s, out);
+}
+
+__attribute__((target("sse2")))
+static void
+tws_wtss_scale_uint16_sse2(const uint16_t* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  tws_wtss_scale_16_sse2<false>(values, n, s, out);
+}
+
+__attribute__((target("sse2")))
+static void
+tws_wtss_scale_float_sse2(const float* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m128d scale = _mm_set1_pd(s.scale_factor);
+  const __m128d min_val = _mm_set1_pd(s.min_val);
+  const __m128d max_val = _mm_set1_pd(s.max_val);
+  const __m128d missing = _mm_set1_pd(s.missing_value);
+  const __m128d nan = _mm_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  std::size_t j = 0;
+
+  for(; j + 4 <= n; j += 4)
+  {
+    __m128 v = _mm_loadu_ps(values + j);
+
+    __m128d v0 = _mm_cvtps_pd(v);
+    __m128d v1 = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+
+// unordered comparisons: a NaN value or missing value never matches
+    __m128d valid0 = _mm_and_pd(_mm_cmpord_pd(v0, v0), _mm_cmpneq_pd(v0, missing));
+    __m128d valid1 = _mm_and_pd(_mm_cmpord_pd(v1, v1), _mm_cmpneq_pd(v1, missing));
+
+    _mm_storeu_pd(out + j, tws_wtss_scale_pd(v0, valid0, min_val, max_val, scale, nan));
+    _mm_storeu_pd(out + j + 2, tws_wtss_scale_pd(v1, valid1, min_val, max_val, scale, nan));
+  }
+
+  tws_wtss_scale_scalar(values + j, n - j, s, out + j);
+}
+
+__attribute__((target("sse2")))
+static void
+tws_wtss_scale_double_sse2(const double* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m128d scale = _mm_set1_pd(s.scale_factor);
+  const __m128d min_val = _mm_set1_pd(s.min_val);
+  const __m128d max_val = _mm_set1_pd(s.max_val);
+  const __m128d missing = _mm_set1_pd(s.missing_value);
+  const __m128d nan = _mm_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  std::size_t j = 0;
+
+  for(; j + 2 <= n; j += 2)
+  {
+    __m128d v = _mm_loadu_pd(values + j);
+
+    __m128d valid = _mm_and_pd(_mm_cmpord_pd(v, v), _mm_cmpneq_pd(v, missing));
+
+    _mm_storeu_pd(out + j, tws_wtss_scale_pd(v, valid, min_val, max_val, scale, nan));
+  }
+
+  tws_wtss_scale_scalar(values + j, n - j, s, out + j);
+}
+
+// clamp and scale four doubles, replacing the invalid ones by NaN
+__attribute__((target("avx2")))
+static inline __m256d
+tws_wtss_scale_pd_avx2(__m256d v, __m256d valid, __m256d min_val, __m256d max_val, __m256d scale, __m256d nan)
+{
+  __m256d scaled = _mm256_mul_pd(_mm256_min_pd(_mm256_max_pd(v, min_val), max_val), scale);
+
+  return _mm256_blendv_pd(nan, scaled, valid);
+}
+
+// 8 integers at a time: they are widened to 32 bits and then converted four by four to double
+template<bool is_signed>
+__attribute__((target("avx2")))
+static void
+tws_wtss_scale_16_avx2(const void* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m256d scale = _mm256_set1_pd(s.scale_factor);
+  const __m256d min_val = _mm256_set1_pd(s.min_val);
+  const __m256d max_val = _mm256_set1_pd(s.max_val);
+  const __m256d missing = _mm256_set1_pd(s.missing_value);
+  const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  const char* first = static_cast<const char*>(values);
+
+  std::size_t j = 0;
+
+  for(; j + 8 <= n; j += 8)
+  {
+    __m128i v16 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 2 * j));
+
+    __m256i v32 = is_signed ? _mm256_cvtepi16_epi32(v16) : _mm256_cvtepu16_epi32(v16);
+
+    __m256d v0 = _mm256_cvtepi32_pd(_mm256_castsi256_si128(v32));
+    __m256d v1 = _mm256_cvtepi32_pd(_mm256_extracti128_si256(v32, 1));
+
+    _mm256_storeu_pd(out + j, tws_wtss_scale_pd_avx2(v0, _mm256_cmp_pd(v0, missing, _CMP_NEQ_UQ), min_val, max_val, scale, nan));
+    _mm256_storeu_pd(out + j + 4, tws_wtss_scale_pd_avx2(v1, _mm256_cmp_pd(v1, missing, _CMP_NEQ_UQ), min_val, max_val, scale, nan));
+  }
+
+  if(is_signed)
+    tws_wtss_scale_scalar(reinterpret_cast<const int16_t*>(first) + j, n - j, s, out + j);
+  else
+    tws_wtss_scale_scalar(reinterpret_cast<const uint16_t*>(first) + j, n - j, s, out + j);
+}
+
+__attribute__((target("avx2")))
+static void
+tws_wtss_scale_int16_avx2(const int16_t* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  tws_wtss_scale_16_avx2<true>(values, n, s, out);
+}
+
+__attribute__((target("avx2")))
+static void
+tws_wtss_scale_uint16_avx2(const uint16_t* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  tws_wtss_scale_16_avx2<false>(values, n, s, out);
+}
+
+__attribute__((target("avx2")))
+static void
+tws_wtss_scale_float_avx2(const float* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m256d scale = _mm256_set1_pd(s.scale_factor);
+  const __m256d min_val = _mm256_set1_pd(s.min_val);
+  const __m256d max_val = _mm256_set1_pd(s.max_val);
+  const __m256d missing = _mm256_set1_pd(s.missing_value);
+  const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  std::size_t j = 0;
+
+  for(; j + 4 <= n; j += 4)
+  {
+    __m256d v = _mm256_cvtps_pd(_mm_loadu_ps(values + j));
+
+    __m256d valid = _mm256_and_pd(_mm256_cmp_pd(v, v, _CMP_ORD_Q), _mm256_cmp_pd(v, missing, _CMP_NEQ_UQ));
+
+    _mm256_storeu_pd(out + j, tws_wtss_scale_pd_avx2(v, valid, min_val, max_val, scale, nan));
+  }
+
+  tws_wtss_scale_scalar(values + j, n - j, s, out + j);
+}
+
+__attribute__((target("avx2")))
+static void
+tws_wtss_scale_double_avx2(const double* values, std::size_t n, const tws::wtss::value_scale_t& s, double* out)
+{
+  const __m256d scale = _mm256_set1_pd(s.scale_factor);
+  const __m256d min_val = _mm256_set1_pd(s.min_val);
+  const __m256d max_val = _mm256_set1_pd(s.max_val);
+  const __m256d missing = _mm256_set1_pd(s.missing_value);
+  const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+
+  std::size_t j = 0;
+
+  for(; j + 4 <= n; j += 4)
+  {
+    __m256d v = _mm256_loadu_pd(values + j);
+
+    __m256d valid = _mm256_and_pd(_mm256_cmp_pd(v, v, _CMP_ORD_Q), _mm256_cmp_pd(v, missing, _CMP_NEQ_UQ));
+
+    _mm256_storeu_pd(out + j, tws_wtss_scale_pd_avx2(v, valid, min_val, max_val, scale, nan));
+  }
+
+  tws_wtss_scale_scalar(values + j, n - j, s, out + j);
+}
+
+#endif  // TWS_WTSS_X86_KERNELS
+
+const tws::wtss::scale_kernels&
+tws::wtss::get_scale_kernels(int isa)
+{
+  static const scale_kernels scalar_kernels = { tws::core::simd_isa_t::scalar, "scalar",
+                                                         &tws_wtss_scale_scalar<int16_t>, &tws_wtss_scale_scalar<uint16_t>,
+                                                         &tws_wtss_scale_scalar<float>, &tws_wtss_scale_scalar<double> };
+
+#ifdef TWS_WTSS_X86_KERNELS
+  static const scale_kernels sse2_kernels = { tws::core::simd_isa_t::sse2, "sse2",
+                                                       &tws_wtss_scale_int16_sse2, &tws_wtss_scale_uint16_sse2,
+                                                       &tws_wtss_scale_float_sse2, &tws_wtss_scale_double_sse2 };
+
+  static const scale_kernels avx2_kernels = { tws::core::simd_isa_t::avx2, "avx2",
+                                                       &tws_wtss_scale_int16_avx2, &tws_wtss_scale_uint16_avx2,
+                                                       &tws_wtss_scale_float_avx2, &tws_wtss_scale_double_avx2 };
+#endif
+
+  if(!tws::core::is_supported(isa))
+  {
+    boost::format err_msg("scale kernels for instruction set '%1%' are not supported in this machine.");
+
+    throw tws::invalid_argument_error() << tws::error_description((err_msg % isa).str());
+  }
+
+#ifdef TWS_WTSS_X86_KERNELS
+  if(isa == tws::core::simd_isa_t::avx2)
+    return avx2_kernels;
+
+  if(isa == tws::core::simd_isa_t::sse2)
+    return sse2_kernels;
+#endif
+
+  return scalar_kernels;
+}
+
+const tws::wtss::scale_kernels&
+tws::wtss::select_scale_kernels()
+{
+  static const scale_kernels& best = get_scale_kernels(tws::core::select_isa());
+
+  return best;
+}
+
+tws::wtss::value_scale_t
+tws::wtss::make_value_scale(const tws::geoarray::attribute_t& attr)
+{
+  value_scale_t s = { attr.scale_factor, attr.valid_range.min_val, attr.valid_range.max_val, attr.missing_value };
+
+  return s;
+}
+
+template<class T> void
+tws::wtss::scale_values(const T* values, std::size_t n, const value_scale_t& s, double* out)
+{
+  tws_wtss_scale_scalar(values, n, s, out);
+}
+
+namespace tws
+{
+  namespace wtss
+  {
+    template<> void
+    scale_values<int16_t>(const int16_t* values, std::size_t n, const value_scale_t& s, double* out)
+    {
+      select_scale_kernels().scale_int16(values, n, s, out);
+    }
+
+    template<> void
+    scale_values<uint16_t>(const uint16_t* values, std::size_t n, const value_scale_t& s, double* out)
+    {
+      select_scale_kernels().scale_uint16(values, n, s, out);
+    }
+
+    template<> void
+    scale_values<float>(const float* values, std::size_t n, const value_scale_t& s, double* out)
+    {
+      select_scale_kernels().scale_float(values, n, s, out);
+    }
+
+    template<> void
+    scale_values<double>(const double* values, std::size_t n, const value_scale_t& s, double* out)
+    {
+      select_scale_kernels().scale_double(values, n, s, out);
+    }
+
+    template void scale_values<int8_t>(const int8_t*, std::size_t, const value_scale_t&, double*);
+    template void scale_values<uint8_t>(const uint8_t*, std::size_t, const value_scale_t&, double*);
+    template void scale_values<int32_t>(const int32_t*, std::size_t, const value_scale_t&, double*);
+    template void scale_values<uint32_t>(const uint32_t*, std::size_t, const value_scale_t&, double*);
+    template void scale_values<int64_t>(const int64_t*, std::size_t, const value_scale_t&, double*);
+    template void scale_values<uint64_t>(const uint64_t*, std::size_t, const value_scale_t&, double*);
+
+  }  // end namespace wtss
+}    // end namespace tws
+
+template<class T> static void
+tws_wtss_scale_typed(const tws::wtss::time_series_values& values, std::size_t pos, std::size_t n,
+                     const tws::wtss::value_scale_t& s, double* out)
+{
+  tws::wtss::scale_values(static_cast<const T*>(values.data()) + pos, n, s, out);
+}
+
+void
+tws::wtss::scale_values(const time_series_values& values, std::size_t pos, std::size_t n,
+                        const value_scale_t& s, double* out)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(values.datatype())
+  {
+    case dt::int8_dt: tws_wtss_scale_typed<int8_t>(values, pos, n, s, out); break;
+    case dt::uint8_dt: tws_wtss_scale_typed<uint8_t>(values, pos, n, s, out); break;
+    case dt::int16_dt: tws_wtss_scale_typed<int16_t>(values, pos, n, s, out); break;
+    case dt::uint16_dt: tws_wtss_scale_typed<uint16_t>(values, pos, n, s, out); break;
+    case dt::int32_dt: tws_wtss_scale_typed<int32_t>(values, pos, n, s, out); break;
+    case dt::uint32_dt: tws_wtss_scale_typed<uint32_t>(values, pos, n, s, out); break;
+    case dt::int64_dt: tws_wtss_scale_typed<int64_t>(values, pos, n, s, out); break;
+    case dt::uint64_dt: tws_wtss_scale_typed<uint64_t>(values, pos, n, s, out); break;
+    case dt::float_dt: tws_wtss_scale_typed<float>(values, pos, n, s, out); break;
+    default: tws_wtss_scale_typed<double>(values, pos, n, s, out);
+  }
+}
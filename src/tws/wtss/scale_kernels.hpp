@@ -0,0 +1,98 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/scale_kernels.hpp
+
+  \brief Kernels that turn the stored values of an attribute into analysis-ready values.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_SCALE_KERNELS_HPP__
+#define __TWS_WTSS_SCALE_KERNELS_HPP__
+
+// TWS
+#include "../geoarray/data_types.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+
+namespace tws
+{
+  namespace wtss
+  {
+    class time_series_values;
+
+    //! How the stored values of an attribute are scaled: out = clamp(v, min_val, max_val) * scale_factor.
+    struct value_scale_t
+    {
+      double scale_factor;
+      double min_val;         //!< The valid range, in the stored values units.
+      double max_val;
+      double missing_value;   //!< Values equal to it, as well as NaN values, are written as NaN.
+    };
+
+    //! A set of scale kernels for a given instruction set.
+    struct scale_kernels
+    {
+      int isa;
+      const char* name;
+
+      void (*scale_int16)(const int16_t* values, std::size_t n, const value_scale_t& s, double* out);
+
+      void (*scale_uint16)(const uint16_t* values, std::size_t n, const value_scale_t& s, double* out);
+
+      void (*scale_float)(const float* values, std::size_t n, const value_scale_t& s, double* out);
+
+      void (*scale_double)(const double* values, std::size_t n, const value_scale_t& s, double* out);
+    };
+
+    //! The kernels for a given instruction set, one of tws::core::simd_isa_t.
+    /*!
+      \exception tws::invalid_argument_error It throws an exception if the instruction set is not supported by the CPU or by the build.
+     */
+    const scale_kernels& get_scale_kernels(int isa);
+
+    //! The fastest kernels supported by the running CPU.
+    const scale_kernels& select_scale_kernels();
+
+    //! The scale of an attribute from its metadata.
+    value_scale_t make_value_scale(const tws::geoarray::attribute_t& attr);
+
+    //! Scale n values with the fastest kernels of the CPU: only 16-bit integers and floating point values have SIMD kernels.
+    template<class T> void
+    scale_values(const T* values, std::size_t n, const value_scale_t& s, double* out);
+
+    template<> void scale_values<int16_t>(const int16_t* values, std::size_t n, const value_scale_t& s, double* out);
+
+    template<> void scale_values<uint16_t>(const uint16_t* values, std::size_t n, const value_scale_t& s, double* out);
+
+    template<> void scale_values<float>(const float* values, std::size_t n, const value_scale_t& s, double* out);
+
+    template<> void scale_values<double>(const double* values, std::size_t n, const value_scale_t& s, double* out);
+
+    //! Scale the n values of a time series container starting at pos.
+    void scale_values(const time_series_values& values, std::size_t pos, std::size_t n,
+                      const value_scale_t& s, double* out);
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_SCALE_KERNELS_HPP__
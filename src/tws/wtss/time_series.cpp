@@ -0,0 +1,54 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series.cpp
+
+  \brief Containers for time series values kept in the datatype of their attribute.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "time_series.hpp"
+
+template<class T> static std::unique_ptr<tws::wtss::time_series_values>
+tws_wtss_make_values(std::size_t size, double fill_value)
+{
+  return std::unique_ptr<tws::wtss::time_series_values>(new tws::wtss::typed_time_series_values<T>(size, static_cast<T>(fill_value)));
+}
+
+std::unique_ptr<tws::wtss::time_series_values>
+tws::wtss::make_time_series_values(int datatype, std::size_t size, double fill_value)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(datatype)
+  {
+    case dt::int8_dt: return tws_wtss_make_values<int8_t>(size, fill_value);
+    case dt::uint8_dt: return tws_wtss_make_values<uint8_t>(size, fill_value);
+    case dt::int16_dt: return tws_wtss_make_values<int16_t>(size, fill_value);
+    case dt::uint16_dt: return tws_wtss_make_values<uint16_t>(size, fill_value);
+    case dt::int32_dt: return tws_wtss_make_values<int32_t>(size, fill_value);
+    case dt::uint32_dt: return tws_wtss_make_values<uint32_t>(size, fill_value);
+    case dt::int64_dt: return tws_wtss_make_values<int64_t>(size, fill_value);
+    case dt::uint64_dt: return tws_wtss_make_values<uint64_t>(size, fill_value);
+    case dt::float_dt: return tws_wtss_make_values<float>(size, fill_value);
+    default: return tws_wtss_make_values<double>(size, fill_value);
+  }
+}
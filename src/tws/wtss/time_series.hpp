@@ -0,0 +1,168 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series.hpp
+
+  \brief Containers for time series values kept in the datatype of their attribute.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_TIME_SERIES_HPP__
+#define __TWS_WTSS_TIME_SERIES_HPP__
+
+// TWS
+#include "../geoarray/data_types.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Boost
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    //! The datatype_t code of a C++ type.
+    template<class T> struct datatype_traits;
+
+    template<> struct datatype_traits<int8_t> { enum { value = tws::geoarray::datatype_t::int8_dt }; };
+    template<> struct datatype_traits<uint8_t> { enum { value = tws::geoarray::datatype_t::uint8_dt }; };
+    template<> struct datatype_traits<int16_t> { enum { value = tws::geoarray::datatype_t::int16_dt }; };
+    template<> struct datatype_traits<uint16_t> { enum { value = tws::geoarray::datatype_t::uint16_dt }; };
+    template<> struct datatype_traits<int32_t> { enum { value = tws::geoarray::datatype_t::int32_dt }; };
+    template<> struct datatype_traits<uint32_t> { enum { value = tws::geoarray::datatype_t::uint32_dt }; };
+    template<> struct datatype_traits<int64_t> { enum { value = tws::geoarray::datatype_t::int64_dt }; };
+    template<> struct datatype_traits<uint64_t> { enum { value = tws::geoarray::datatype_t::uint64_dt }; };
+    template<> struct datatype_traits<float> { enum { value = tws::geoarray::datatype_t::float_dt }; };
+    template<> struct datatype_traits<double> { enum { value = tws::geoarray::datatype_t::double_dt }; };
+
+    /*!
+      \brief The values of one or more time series of an attribute.
+
+      The values are kept in the attribute datatype: this is the type-erased
+      view that the decoders and the response writers work with. The raw
+      buffer can be copied as is to the binary outputs; the values are only
+      widened to double when they are asked for as double.
+     */
+    class time_series_values : public boost::noncopyable
+    {
+      public:
+
+        virtual ~time_series_values() { }
+
+        //! The datatype_t code of the values: never unknown.
+        int datatype() const { return datatype_; }
+
+        //! The number of values.
+        std::size_t size() const { return size_; }
+
+        //! The size of a value, in bytes.
+        std::size_t sample_size() const { return sample_size_; }
+
+        //! The values, in the byte order of the host.
+        const void* data() const { return data_; }
+
+        //! The value at pos, widened to double.
+        virtual double get(std::size_t pos) const = 0;
+
+        //! Widen the n values starting at pos to double.
+        virtual void copy(std::size_t pos, std::size_t n, double* out) const = 0;
+
+        //! Set the value at pos, converting it to the datatype of the values.
+        virtual void set(std::size_t pos, double value) = 0;
+
+        //! Set the value at pos: it is stored as is if T is the datatype of the values.
+        template<class T> void store(std::size_t pos, T value)
+        {
+          if(datatype_ == datatype_traits<T>::value)
+            static_cast<T*>(data_)[pos] = value;
+          else
+            set(pos, static_cast<double>(value));
+        }
+
+      protected:
+
+        time_series_values(int datatype, std::size_t size, std::size_t sample_size)
+          : datatype_(datatype), data_(nullptr), size_(size), sample_size_(sample_size)
+        {
+        }
+
+        //! The derived classes tell where their values are once they are allocated.
+        void set_data(void* data) { data_ = data; }
+
+      private:
+
+        int datatype_;
+        void* data_;
+        std::size_t size_;
+        std::size_t sample_size_;
+    };
+
+    //! Time series values of type T.
+    template<class T>
+    class typed_time_series_values : public time_series_values
+    {
+      public:
+
+        typed_time_series_values(std::size_t size, T fill_value)
+          : time_series_values(datatype_traits<T>::value, size, sizeof(T)),
+            values_(size, fill_value)
+        {
+          set_data(values_.data());
+        }
+
+        const std::vector<T>& values() const { return values_; }
+
+        std::vector<T>& values() { return values_; }
+
+        double get(std::size_t pos) const { return static_cast<double>(values_[pos]); }
+
+        void copy(std::size_t pos, std::size_t n, double* out) const
+        {
+          const T* first = values_.data() + pos;
+
+          for(std::size_t i = 0; i != n; ++i)
+            out[i] = static_cast<double>(first[i]);
+        }
+
+        void set(std::size_t pos, double value) { values_[pos] = static_cast<T>(value); }
+
+      private:
+
+        std::vector<T> values_;
+    };
+
+    /*!
+      \brief Create a container with size values of the given datatype, all of them set to fill_value.
+
+      An unknown datatype is kept as double.
+     */
+    std::unique_ptr<time_series_values>
+    make_time_series_values(int datatype, std::size_t size, double fill_value);
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_TIME_SERIES_HPP__
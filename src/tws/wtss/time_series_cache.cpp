@@ -0,0 +1,345 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series_cache.cpp
+
+  \brief A cache for the time series retrieved by WTSS.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "time_series_cache.hpp"
+#include "../core/utils.hpp"
+#include "../geoarray/data_types.hpp"
+#include "../geoarray/geoarray_manager.hpp"
+#include "../geoarray/timeline_manager.hpp"
+#include "exception.hpp"
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <utility>
+
+// Boost
+#include <boost/bind.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+// RapidJSON
+#include <rapidjson/document.h>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    struct time_series_key_hash
+    {
+      std::size_t operator()(const time_series_key& k) const
+      {
+        std::size_t seed = 0;
+
+        boost::hash_combine(seed, k.coverage);
+        boost::hash_combine(seed, k.attribute);
+        boost::hash_combine(seed, k.pixel_col);
+        boost::hash_combine(seed, k.pixel_row);
+        boost::hash_combine(seed, k.start_time_idx);
+        boost::hash_combine(seed, k.end_time_idx);
+
+        return seed;
+      }
+    };
+
+    struct time_series_key_equal
+    {
+      bool operator()(const time_series_key& lhs, const time_series_key& rhs) const
+      {
+        return (lhs.pixel_col == rhs.pixel_col) &&
+               (lhs.pixel_row == rhs.pixel_row) &&
+               (lhs.start_time_idx == rhs.start_time_idx) &&
+               (lhs.end_time_idx == rhs.end_time_idx) &&
+               (lhs.attribute == rhs.attribute) &&
+               (lhs.coverage == rhs.coverage);
+      }
+    };
+
+    struct time_series_cache_entry
+    {
+      time_series_key key;
+      time_series_cache::value_type values;
+      std::size_t nbytes;
+    };
+
+    typedef std::list<time_series_cache_entry> lru_list_t;
+
+    struct time_series_cache_shard
+    {
+      boost::mutex mtx;
+      lru_list_t lru;
+      std::unordered_map<time_series_key, lru_list_t::iterator,
+                         time_series_key_hash, time_series_key_equal> entries;
+      std::size_t nbytes;
+      std::size_t max_bytes;
+
+      time_series_cache_shard() : nbytes(0), max_bytes(0) { }
+
+      void erase(lru_list_t::iterator it);
+    };
+
+  }  // end namespace wtss
+}    // end namespace tws
+
+// an approximation of the memory held by an entry: its values, the key strings and the bookkeeping nodes
+static std::size_t
+tws_wtss_entry_size(const tws::wtss::time_series_key& key,
+                    const tws::wtss::time_series_values& values)
+{
+  return values.size() * values.sample_size() +
+         key.coverage.size() + key.attribute.size() +
+         2 * sizeof(tws::wtss::time_series_cache_entry) + 64;
+}
+
+void
+tws::wtss::time_series_cache_shard::erase(lru_list_t::iterator it)
+{
+  nbytes -= it->nbytes;
+
+  entries.erase(it->key);
+
+  lru.erase(it);
+}
+
+struct tws::wtss::time_series_cache::impl
+{
+  std::vector<std::unique_ptr<time_series_cache_shard> > shards;
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+
+  impl() : hits(0), misses(0) { }
+
+  time_series_cache_shard& shard(const time_series_key& key)
+  {
+    return *shards[time_series_key_hash()(key) % shards.size()];
+  }
+};
+
+tws::wtss::time_series_cache::value_type
+tws::wtss::time_series_cache::get(const time_series_key& key)
+{
+  if(!enabled())
+    return value_type();
+
+  time_series_cache_shard& s = pimpl_->shard(key);
+
+  {
+    boost::lock_guard<boost::mutex> lock(s.mtx);
+
+    auto it = s.entries.find(key);
+
+    if(it != s.entries.end())
+    {
+// move the entry to the front of the LRU list
+      s.lru.splice(s.lru.begin(), s.lru, it->second);
+
+      ++(pimpl_->hits);
+
+      return it->second->values;
+    }
+  }
+
+  ++(pimpl_->misses);
+
+  return value_type();
+}
+
+void
+tws::wtss::time_series_cache::insert(const time_series_key& key,
+                                     const value_type& values,
+                                     uint64_t generation)
+{
+  if(!enabled() || (values.get() == nullptr))
+    return;
+
+  time_series_cache_shard& s = pimpl_->shard(key);
+
+  std::size_t nbytes = tws_wtss_entry_size(key, *values);
+
+// a series that does not fit in a shard is never cached
+  if(nbytes > s.max_bytes)
+    return;
+
+  boost::lock_guard<boost::mutex> lock(s.mtx);
+
+// checked under the shard lock: an update after the check invalidates the shard only once the entry is in
+  if(generation != tws::geoarray::timeline_manager::instance().generation())
+    return;
+
+  auto it = s.entries.find(key);
+
+  if(it != s.entries.end())
+    s.erase(it->second);
+
+  while(!s.lru.empty() && (s.nbytes + nbytes > s.max_bytes))
+    s.erase(--s.lru.end());
+
+  time_series_cache_entry entry = { key, values, nbytes };
+
+  s.lru.push_front(entry);
+
+  s.entries[key] = s.lru.begin();
+
+  s.nbytes += nbytes;
+}
+
+void
+tws::wtss::time_series_cache::invalidate(const std::string& coverage)
+{
+// the series read from the coverage overviews are also discarded
+  std::set<std::string> arrays;
+
+  arrays.insert(coverage);
+
+  for(const tws::geoarray::overview_t& ov : tws::geoarray::geoarray_manager::instance().overviews(coverage))
+    arrays.insert(ov.array.name);
+
+  for(std::unique_ptr<time_series_cache_shard>& s : pimpl_->shards)
+  {
+    boost::lock_guard<boost::mutex> lock(s->mtx);
+
+    lru_list_t::iterator it = s->lru.begin();
+
+    while(it != s->lru.end())
+    {
+      lru_list_t::iterator next = it;
+
+      ++next;
+
+      if(arrays.count(it->key.coverage) != 0)
+        s->erase(it);
+
+      it = next;
+    }
+  }
+}
+
+void
+tws::wtss::time_series_cache::clear()
+{
+  for(std::unique_ptr<time_series_cache_shard>& s : pimpl_->shards)
+  {
+    boost::lock_guard<boost::mutex> lock(s->mtx);
+
+    s->entries.clear();
+    s->lru.clear();
+    s->nbytes = 0;
+  }
+}
+
+bool
+tws::wtss::time_series_cache::enabled() const
+{
+  return !pimpl_->shards.empty();
+}
+
+tws::wtss::time_series_cache_stats
+tws::wtss::time_series_cache::stats() const
+{
+  time_series_cache_stats st;
+
+  st.hits = pimpl_->hits;
+  st.misses = pimpl_->misses;
+  st.nentries = 0;
+  st.nbytes = 0;
+
+  for(const std::unique_ptr<time_series_cache_shard>& s : pimpl_->shards)
+  {
+    boost::lock_guard<boost::mutex> lock(s->mtx);
+
+    st.nentries += s->entries.size();
+    st.nbytes += s->nbytes;
+  }
+
+  return st;
+}
+
+tws::wtss::time_series_cache&
+tws::wtss::time_series_cache::instance()
+{
+  static time_series_cache inst;
+
+  return inst;
+}
+
+tws::wtss::time_series_cache::time_series_cache()
+  : pimpl_(nullptr)
+{
+  pimpl_ = new impl;
+
+  std::string wtss_file = tws::core::find_in_app_path("share/tws/config/wtss.json");
+
+  if(wtss_file.empty())
+    throw tws::file_exists_error() << tws::error_description("Could not locate file 'share/tws/config/wtss.json'.");
+
+  std::unique_ptr<rapidjson::Document> jdocument(tws::core::open_json_file(wtss_file));
+
+  if(!jdocument->HasMember("time_series_cache"))
+    return;
+
+  const rapidjson::Value& jcache = (*jdocument)["time_series_cache"];
+
+  if(!jcache.IsObject())
+    throw tws::parse_error() << tws::error_description("time_series_cache entry in file 'share/tws/config/wtss.json' must be an object.");
+
+  const rapidjson::Value& jmax_bytes = jcache["max_bytes"];
+
+  if(!jmax_bytes.IsNumber() || jmax_bytes.IsNull())
+    throw tws::parse_error() << tws::error_description("time_series_cache must have a numeric max_bytes entry.");
+
+  const rapidjson::Value& jshards = jcache["shards"];
+
+  if(!jshards.IsNumber() || jshards.IsNull())
+    throw tws::parse_error() << tws::error_description("time_series_cache must have a numeric shards entry.");
+
+  std::size_t max_bytes = static_cast<std::size_t>(jmax_bytes.GetUint64());
+
+  std::size_t nshards = std::max<std::size_t>(jshards.GetUint(), 1);
+
+// a zero budget disables the cache
+  if(max_bytes == 0)
+    return;
+
+  for(std::size_t i = 0; i != nshards; ++i)
+  {
+    pimpl_->shards.emplace_back(new time_series_cache_shard);
+
+    pimpl_->shards.back()->max_bytes = max_bytes / nshards;
+  }
+
+  tws::geoarray::timeline_manager::instance().add_change_handler(boost::bind(&time_series_cache::invalidate, this, _1));
+}
+
+tws::wtss::time_series_cache::~time_series_cache()
+{
+  delete pimpl_;
+}
@@ -0,0 +1,128 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+
+  This file is part of the TerraLib GeoWeb Services.
+
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series_cache.hpp
+
+  \brief A cache for the time series retrieved by WTSS.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_TIME_SERIES_CACHE_HPP__
+#define __TWS_WTSS_TIME_SERIES_CACHE_HPP__
+
+// TWS
+#include "time_series.hpp"
+
+// STL
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Boost
+#include <boost/noncopyable.hpp>
+
+namespace tws
+{
+  namespace wtss
+  {
+
+    //! Identifies the time series of an attribute at a given pixel.
+    struct time_series_key
+    {
+      std::string coverage;
+      std::string attribute;
+      int64_t pixel_col;
+      int64_t pixel_row;
+      std::size_t start_time_idx;
+      std::size_t end_time_idx;
+    };
+
+    //! The counters of a time series cache.
+    struct time_series_cache_stats
+    {
+      uint64_t hits;
+      uint64_t misses;
+      std::size_t nentries;
+      std::size_t nbytes;
+    };
+
+    /*!
+      \brief A sharded LRU cache for decoded time series, kept in the datatype of their attribute.
+
+      The entries are spread over a number of shards, each one with its own lock
+      and LRU list, so that concurrent worker threads seldom contend. Each shard
+      keeps its share of the byte budget informed in share/tws/config/wtss.json.
+
+      The entries of a coverage are discarded whenever its timeline is updated
+      in the timeline manager.
+     */
+    class time_series_cache : public boost::noncopyable
+    {
+      public:
+
+        typedef std::shared_ptr<const time_series_values> value_type;
+
+        //! Returns the cached time series or a null pointer if it is not in the cache.
+        value_type get(const time_series_key& key);
+
+        //! Add or replace a time series in the cache, evicting the least recently used ones if needed.
+        /*!
+          \param generation The timeline manager generation read before the series was fetched:
+                            a series fetched before a timeline update is not cached.
+         */
+        void insert(const time_series_key& key, const value_type& values, uint64_t generation);
+
+        //! Discard all time series of a given coverage and of its overviews.
+        void invalidate(const std::string& coverage);
+
+        //! Discard all time series.
+        void clear();
+
+        //! Tells if the cache has a non-zero byte budget.
+        bool enabled() const;
+
+        //! Returns a snapshot of the cache counters.
+        time_series_cache_stats stats() const;
+
+        //! Access the singleton.
+        /*!
+          \exception tws::file_exists_error If the file 'share/tws/config/wtss.json' is not found.
+          \exception tws::parse_error       If the cache section of the config file is invalid.
+         */
+        static time_series_cache& instance();
+
+      private:
+
+        time_series_cache();
+
+        ~time_series_cache();
+
+      private:
+
+        struct impl;
+
+        impl* pimpl_;
+    };
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_TIME_SERIES_CACHE_HPP__
@@ -0,0 +1,813 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series_writers.cpp
+
+  \brief Write the result of the time series operations in each output format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+// TWS
+#include "time_series_writers.hpp"
+#include "arrow_writer.hpp"
+#include "json_writer.hpp"
+#include "msgpack_writer.hpp"
+#include "time_series.hpp"
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+//! The number of time series values above which the Arrow output of a batch starts a new record batch.
+static const std::size_t tws_wtss_arrow_batch_rows = 65536;
+
+// the datatype of an attribute in the binary outputs: 64-bit float if it is unknown
+static int
+tws_wtss_sample_type(int datatype)
+{
+  return ((datatype >= tws::geoarray::datatype_t::int8_dt) && (datatype < tws::geoarray::datatype_t::unknown))
+         ? datatype : static_cast<int>(tws::geoarray::datatype_t::double_dt);
+}
+
+static std::size_t
+tws_wtss_sample_size(int datatype)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(datatype)
+  {
+    case dt::int8_dt:
+    case dt::uint8_dt:
+      return 1;
+    case dt::int16_dt:
+    case dt::uint16_dt:
+      return 2;
+    case dt::int32_dt:
+    case dt::uint32_dt:
+    case dt::float_dt:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+// the datatype names in the MessagePack output, as known by most array libraries
+static const char*
+tws_wtss_datatype_name(int datatype)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(datatype)
+  {
+    case dt::int8_dt: return "int8";
+    case dt::uint8_dt: return "uint8";
+    case dt::int16_dt: return "int16";
+    case dt::uint16_dt: return "uint16";
+    case dt::int32_dt: return "int32";
+    case dt::uint32_dt: return "uint32";
+    case dt::int64_dt: return "int64";
+    case dt::uint64_dt: return "uint64";
+    case dt::float_dt: return "float32";
+    default: return "float64";
+  }
+}
+
+template<class T> static void
+tws_wtss_convert(const double* src, std::size_t n, char* dst)
+{
+  for(std::size_t i = 0; i != n; ++i)
+  {
+    T value = static_cast<T>(src[i]);
+
+    std::memcpy(dst + i * sizeof(T), &value, sizeof(T));
+  }
+}
+
+// write n values in the given datatype to dst, in the byte order of the host
+static void
+tws_wtss_convert_samples(const double* src, std::size_t n, int datatype, char* dst)
+{
+  typedef tws::geoarray::datatype_t dt;
+
+  switch(datatype)
+  {
+    case dt::int8_dt: tws_wtss_convert<int8_t>(src, n, dst); break;
+    case dt::uint8_dt: tws_wtss_convert<uint8_t>(src, n, dst); break;
+    case dt::int16_dt: tws_wtss_convert<int16_t>(src, n, dst); break;
+    case dt::uint16_dt: tws_wtss_convert<uint16_t>(src, n, dst); break;
+    case dt::int32_dt: tws_wtss_convert<int32_t>(src, n, dst); break;
+    case dt::uint32_dt: tws_wtss_convert<uint32_t>(src, n, dst); break;
+    case dt::int64_dt: tws_wtss_convert<int64_t>(src, n, dst); break;
+    case dt::uint64_dt: tws_wtss_convert<uint64_t>(src, n, dst); break;
+    case dt::float_dt: tws_wtss_convert<float>(src, n, dst); break;
+    default: std::memcpy(dst, src, n * sizeof(double));
+  }
+}
+
+// the n values of a series starting at pos, in the given datatype: they are only converted if it is not theirs
+static const char*
+tws_wtss_samples(const tws::wtss::time_series_values& values, std::size_t pos, std::size_t n,
+                 int datatype, std::vector<char>& buffer)
+{
+  if(values.datatype() == datatype)
+    return static_cast<const char*>(values.data()) + pos * values.sample_size();
+
+  std::vector<double> widened(n);
+
+  values.copy(pos, n, widened.data());
+
+  buffer.resize(n * tws_wtss_sample_size(datatype));
+
+  tws_wtss_convert_samples(widened.data(), n, datatype, buffer.data());
+
+  return buffer.data();
+}
+
+// append the values of a time series to the output
+static void
+tws_wtss_append_samples(const tws::wtss::time_series_values& values, std::size_t pos, std::size_t n,
+                        int datatype, tws::wtss::output_buffer& out)
+{
+  std::vector<char> buffer;
+
+  out.append(tws_wtss_samples(values, pos, n, datatype, buffer), n * tws_wtss_sample_size(datatype));
+
+  out.check();
+}
+
+// the n values of a series starting at pos, as double: only the JSON output needs them widened
+static const double*
+tws_wtss_widen(const tws::wtss::time_series_values& values, std::size_t pos, std::size_t n,
+               std::vector<double>& buffer)
+{
+  if(values.datatype() == tws::geoarray::datatype_t::double_dt)
+    return static_cast<const double*>(values.data()) + pos;
+
+  buffer.resize(n);
+
+  values.copy(pos, n, buffer.data());
+
+  return buffer.data();
+}
+
+// the shortest of 15 or 17 significant digits that reads back as the same value
+static std::string
+tws_wtss_to_string(double value)
+{
+  if(std::isnan(value))
+    return "NaN";
+
+  char text[33];
+
+  char* last = tws::wtss::format_double(value, 15, text);
+
+  *last = '\0';
+
+  if(std::strtod(text, nullptr) != value)
+    last = tws::wtss::format_double(value, 17, text);
+
+  return std::string(text, last);
+}
+
+// the scale factor and missing value of an attribute in the Arrow field metadata
+static tws::wtss::arrow_field_t
+tws_wtss_arrow_attribute_field(const tws::geoarray::attribute_t& attr)
+{
+  tws::wtss::arrow_field_t field;
+
+  field.name = attr.name;
+  field.datatype = tws_wtss_sample_type(attr.datatype);
+  field.is_string = false;
+  field.list_size = 0;
+  field.metadata.push_back(std::make_pair("scale_factor", tws_wtss_to_string(attr.scale_factor)));
+  field.metadata.push_back(std::make_pair("missing_value", tws_wtss_to_string(attr.missing_value)));
+
+  return field;
+}
+
+static void
+tws_wtss_msgpack_attribute_metadata(const tws::geoarray::attribute_t& attr, tws::wtss::msgpack_writer& writer)
+{
+  writer.string("attribute", 9);
+  writer.string(attr.name);
+
+  const char* datatype = tws_wtss_datatype_name(tws_wtss_sample_type(attr.datatype));
+
+  writer.string("datatype", 8);
+  writer.string(datatype, std::strlen(datatype));
+
+  writer.string("scale_factor", 12);
+  writer.number(attr.scale_factor);
+
+  writer.string("missing_value", 13);
+  writer.number(attr.missing_value);
+}
+
+void
+tws::wtss::write_time_series(const time_series_result_t& result, json_writer& writer)
+{
+  const time_series_point_t& point = result.points.front();
+
+  const std::size_t ntime_pts = result.timeline.size();
+
+// the series are widened to double a point at a time
+  std::vector<double> widened;
+
+  writer.start_object();
+
+// prepare result part in response
+  writer.key("result", 6);
+
+  writer.start_object();
+
+  writer.key("attributes", 10);
+
+  writer.start_array();
+
+  for(std::size_t i = 0; i != result.attributes.size(); ++i)
+  {
+    writer.start_object();
+
+    writer.key("attribute", 9);
+    writer.string(result.attributes[i].name);
+
+    writer.key("values", 6);
+
+    if(result.values[i] != nullptr)
+    {
+      const double* first = tws_wtss_widen(*result.values[i], point.pixel_pos * ntime_pts, ntime_pts, widened);
+
+      writer.numbers(first, first + ntime_pts);
+    }
+    else
+    {
+      writer.numbers(nullptr, nullptr);
+    }
+
+    writer.end_object();
+  }
+
+  writer.end_array();
+
+// add timeline in the response
+  writer.key("timeline", 8);
+
+  writer.start_array();
+
+  for(const std::string& time_point : result.timeline)
+    writer.string(time_point);
+
+  writer.end_array();
+
+// add the pixel center location in response
+  writer.key("center_coordinates", 18);
+
+  writer.start_object();
+  writer.key("latitude", 8);
+  writer.number(point.center_latitude);
+  writer.key("longitude", 9);
+  writer.number(point.center_longitude);
+  writer.end_object();
+
+  writer.end_object();
+
+// prepare the query part in response
+  writer.key("query", 5);
+
+  writer.start_object();
+
+  writer.key("coverage", 8);
+  writer.string(result.coverage);
+
+  writer.key("attributes", 10);
+
+  writer.start_array();
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+    writer.string(attr.name);
+
+  writer.end_array();
+
+  writer.key("latitude", 8);
+  writer.number(point.latitude);
+
+  writer.key("longitude", 9);
+  writer.number(point.longitude);
+
+  writer.end_object();
+
+  writer.end_object();
+}
+
+void
+tws::wtss::write_time_series(const time_series_result_t& result, msgpack_writer& writer)
+{
+  const time_series_point_t& point = result.points.front();
+
+  const std::size_t ntime_pts = result.timeline.size();
+
+  const std::size_t nattributes = result.attributes.size();
+
+  writer.map(2);
+
+  writer.string("result", 6);
+
+  writer.map(3);
+
+  writer.string("attributes", 10);
+
+  writer.array(static_cast<uint32_t>(nattributes));
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+  {
+    const tws::geoarray::attribute_t& attr = result.attributes[i];
+
+    writer.map(5);
+
+    tws_wtss_msgpack_attribute_metadata(attr, writer);
+
+    writer.string("values", 6);
+
+    if(result.values[i] == nullptr)
+    {
+      writer.bin(0);
+      continue;
+    }
+
+    int datatype = tws_wtss_sample_type(attr.datatype);
+
+    writer.bin(ntime_pts * tws_wtss_sample_size(datatype));
+
+    tws_wtss_append_samples(*result.values[i], point.pixel_pos * ntime_pts, ntime_pts, datatype, writer.out());
+  }
+
+  writer.string("timeline", 8);
+
+  writer.array(static_cast<uint32_t>(ntime_pts));
+
+  for(const std::string& time_point : result.timeline)
+    writer.string(time_point);
+
+  writer.string("center_coordinates", 18);
+
+  writer.map(2);
+  writer.string("latitude", 8);
+  writer.number(point.center_latitude);
+  writer.string("longitude", 9);
+  writer.number(point.center_longitude);
+
+  writer.string("query", 5);
+
+  writer.map(4);
+
+  writer.string("coverage", 8);
+  writer.string(result.coverage);
+
+  writer.string("attributes", 10);
+
+  writer.array(static_cast<uint32_t>(nattributes));
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+    writer.string(attr.name);
+
+  writer.string("latitude", 8);
+  writer.number(point.latitude);
+
+  writer.string("longitude", 9);
+  writer.number(point.longitude);
+}
+
+void
+tws::wtss::write_time_series(const time_series_result_t& result, arrow_stream_writer& writer)
+{
+  const time_series_point_t& point = result.points.front();
+
+  const std::size_t ntime_pts = result.timeline.size();
+
+  const std::size_t nattributes = result.attributes.size();
+
+// the schema: the timeline and the attributes, with the query and pixel location as metadata
+  std::vector<arrow_field_t> fields;
+
+  fields.push_back({"timeline", tws::geoarray::datatype_t::unknown, true, 0, arrow_metadata_t()});
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+    fields.push_back(tws_wtss_arrow_attribute_field(attr));
+
+  arrow_metadata_t metadata;
+
+  metadata.push_back(std::make_pair("coverage", result.coverage));
+  metadata.push_back(std::make_pair("longitude", tws_wtss_to_string(point.longitude)));
+  metadata.push_back(std::make_pair("latitude", tws_wtss_to_string(point.latitude)));
+  metadata.push_back(std::make_pair("center_longitude", tws_wtss_to_string(point.center_longitude)));
+  metadata.push_back(std::make_pair("center_latitude", tws_wtss_to_string(point.center_latitude)));
+
+  writer.schema(fields, metadata);
+
+// a single record batch
+  std::vector<arrow_column_t> columns;
+
+  std::string timeline_chars;
+
+  std::vector<int32_t> timeline_offsets(1, 0);
+
+  for(const std::string& time_point : result.timeline)
+  {
+    timeline_chars += time_point;
+    timeline_offsets.push_back(static_cast<int32_t>(timeline_chars.size()));
+  }
+
+  columns.push_back({timeline_chars.data(), timeline_chars.size(), timeline_offsets.data()});
+
+  std::vector<std::vector<char> > attribute_values(nattributes);
+
+  std::vector<std::unique_ptr<time_series_values> > missing;
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+  {
+    const tws::geoarray::attribute_t& attr = result.attributes[i];
+
+    int datatype = tws_wtss_sample_type(attr.datatype);
+
+// the columns must have a value per row: without data the series is missing
+    const time_series_values* values = result.values[i];
+
+    std::size_t pos = point.pixel_pos * ntime_pts;
+
+    if(values == nullptr)
+    {
+      missing.push_back(make_time_series_values(datatype, ntime_pts, attr.missing_value));
+
+      values = missing.back().get();
+      pos = 0;
+    }
+
+    const char* samples = tws_wtss_samples(*values, pos, ntime_pts, datatype, attribute_values[i]);
+
+    columns.push_back({samples, ntime_pts * tws_wtss_sample_size(datatype), nullptr});
+  }
+
+  writer.record_batch(static_cast<int64_t>(ntime_pts), columns);
+
+  writer.end();
+}
+
+void
+tws::wtss::write_time_series_batch(const time_series_result_t& result, json_writer& writer)
+{
+  const std::size_t ntime_pts = result.timeline.size();
+
+// the series are widened to double a point at a time
+  std::vector<double> widened;
+
+  const std::size_t nattributes = result.attributes.size();
+
+  writer.start_object();
+
+// prepare result part in response
+  writer.key("result", 6);
+
+  writer.start_object();
+
+// add timeline in the response
+  writer.key("timeline", 8);
+
+  writer.start_array();
+
+  for(const std::string& time_point : result.timeline)
+    writer.string(time_point);
+
+  writer.end_array();
+
+// add the time series of each point, in the same order of the query
+  writer.key("points", 6);
+
+  writer.start_array();
+
+  for(const time_series_point_t& point : result.points)
+  {
+    writer.start_object();
+
+    writer.key("longitude", 9);
+    writer.number(point.longitude);
+
+    writer.key("latitude", 8);
+    writer.number(point.latitude);
+
+    if(!point.valid)
+    {
+      writer.key("error", 5);
+      writer.string("location is out of coverage extent", 34);
+
+      writer.end_object();
+
+      continue;
+    }
+
+    writer.key("center_coordinates", 18);
+
+    writer.start_object();
+    writer.key("latitude", 8);
+    writer.number(point.center_latitude);
+    writer.key("longitude", 9);
+    writer.number(point.center_longitude);
+    writer.end_object();
+
+    writer.key("attributes", 10);
+
+    writer.start_array();
+
+    for(std::size_t j = 0; j != nattributes; ++j)
+    {
+      writer.start_object();
+
+      writer.key("attribute", 9);
+      writer.string(result.attributes[j].name);
+
+      writer.key("values", 6);
+
+      const double* first = tws_wtss_widen(*result.values[j], point.pixel_pos * ntime_pts, ntime_pts, widened);
+
+      writer.numbers(first, first + ntime_pts);
+
+      writer.end_object();
+    }
+
+    writer.end_array();
+
+    writer.end_object();
+  }
+
+  writer.end_array();
+
+  writer.end_object();
+
+// prepare the query part in response
+  writer.key("query", 5);
+
+  writer.start_object();
+
+  writer.key("coverage", 8);
+  writer.string(result.coverage);
+
+  writer.key("attributes", 10);
+
+  writer.start_array();
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+    writer.string(attr.name);
+
+  writer.end_array();
+
+  writer.key("start", 5);
+  writer.string(result.timeline.front());
+
+  writer.key("end", 3);
+  writer.string(result.timeline.back());
+
+  writer.end_object();
+
+  writer.end_object();
+}
+
+void
+tws::wtss::write_time_series_batch(const time_series_result_t& result, msgpack_writer& writer)
+{
+  const std::size_t ntime_pts = result.timeline.size();
+
+  const std::size_t nattributes = result.attributes.size();
+
+  writer.map(2);
+
+  writer.string("result", 6);
+
+  writer.map(3);
+
+  writer.string("timeline", 8);
+
+  writer.array(static_cast<uint32_t>(ntime_pts));
+
+  for(const std::string& time_point : result.timeline)
+    writer.string(time_point);
+
+// the attribute metadata is written once for all points
+  writer.string("attributes", 10);
+
+  writer.array(static_cast<uint32_t>(nattributes));
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+  {
+    writer.map(4);
+
+    tws_wtss_msgpack_attribute_metadata(attr, writer);
+  }
+
+  writer.string("points", 6);
+
+  writer.array(static_cast<uint32_t>(result.points.size()));
+
+  for(const time_series_point_t& point : result.points)
+  {
+    writer.map(point.valid ? 4 : 3);
+
+    writer.string("longitude", 9);
+    writer.number(point.longitude);
+
+    writer.string("latitude", 8);
+    writer.number(point.latitude);
+
+    if(!point.valid)
+    {
+      writer.string("error", 5);
+      writer.string("location is out of coverage extent", 34);
+
+      continue;
+    }
+
+    writer.string("center_coordinates", 18);
+
+    writer.map(2);
+    writer.string("latitude", 8);
+    writer.number(point.center_latitude);
+    writer.string("longitude", 9);
+    writer.number(point.center_longitude);
+
+// the time series of each attribute, in the order of the attributes list
+    writer.string("values", 6);
+
+    writer.array(static_cast<uint32_t>(nattributes));
+
+    for(std::size_t j = 0; j != nattributes; ++j)
+    {
+      int datatype = tws_wtss_sample_type(result.attributes[j].datatype);
+
+      writer.bin(ntime_pts * tws_wtss_sample_size(datatype));
+
+      tws_wtss_append_samples(*result.values[j], point.pixel_pos * ntime_pts, ntime_pts, datatype, writer.out());
+    }
+  }
+
+  writer.string("query", 5);
+
+  writer.map(4);
+
+  writer.string("coverage", 8);
+  writer.string(result.coverage);
+
+  writer.string("attributes", 10);
+
+  writer.array(static_cast<uint32_t>(nattributes));
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+    writer.string(attr.name);
+
+  writer.string("start", 5);
+  writer.string(result.timeline.front());
+
+  writer.string("end", 3);
+  writer.string(result.timeline.back());
+}
+
+void
+tws::wtss::write_time_series_batch(const time_series_result_t& result, arrow_stream_writer& writer)
+{
+  const std::size_t ntime_pts = result.timeline.size();
+
+  const std::size_t nattributes = result.attributes.size();
+
+// a row for each point in the coverage extent: the time series are lists as long as the timeline
+  std::vector<arrow_field_t> fields;
+
+  fields.push_back({"point", tws::geoarray::datatype_t::int32_dt, false, 0, arrow_metadata_t()});
+  fields.push_back({"longitude", tws::geoarray::datatype_t::double_dt, false, 0, arrow_metadata_t()});
+  fields.push_back({"latitude", tws::geoarray::datatype_t::double_dt, false, 0, arrow_metadata_t()});
+  fields.push_back({"center_longitude", tws::geoarray::datatype_t::double_dt, false, 0, arrow_metadata_t()});
+  fields.push_back({"center_latitude", tws::geoarray::datatype_t::double_dt, false, 0, arrow_metadata_t()});
+
+  std::vector<int> datatypes;
+
+  for(const tws::geoarray::attribute_t& attr : result.attributes)
+  {
+    fields.push_back(tws_wtss_arrow_attribute_field(attr));
+
+    fields.back().list_size = ntime_pts;
+
+    datatypes.push_back(fields.back().datatype);
+  }
+
+// the timeline is shared by all rows: its time points are separated by commas
+  std::string timeline;
+
+  for(const std::string& time_point : result.timeline)
+  {
+    if(!timeline.empty())
+      timeline.push_back(',');
+
+    timeline += time_point;
+  }
+
+  arrow_metadata_t metadata;
+
+  metadata.push_back(std::make_pair("coverage", result.coverage));
+  metadata.push_back(std::make_pair("start", result.timeline.front()));
+  metadata.push_back(std::make_pair("end", result.timeline.back()));
+  metadata.push_back(std::make_pair("timeline", timeline));
+
+  writer.schema(fields, metadata);
+
+// the buffers of a record batch, reused by all of them
+  const std::size_t batch_points = std::max<std::size_t>(1, tws_wtss_arrow_batch_rows / ntime_pts);
+
+  std::vector<int32_t> point_column;
+  std::vector<double> coordinate_columns[4];
+  std::vector<std::vector<char> > attribute_columns(nattributes);
+
+  std::vector<char> converted;
+
+  std::vector<arrow_column_t> columns;
+
+  std::size_t ipoint = 0;
+
+  const std::size_t npoints = result.points.size();
+
+  while(ipoint != npoints)
+  {
+    point_column.clear();
+
+    for(std::vector<double>& column : coordinate_columns)
+      column.clear();
+
+    for(std::vector<char>& column : attribute_columns)
+      column.clear();
+
+// fill the batch with the points in the coverage extent
+    for(; (ipoint != npoints) && (point_column.size() != batch_points); ++ipoint)
+    {
+      const time_series_point_t& point = result.points[ipoint];
+
+      if(!point.valid)
+        continue;
+
+      point_column.push_back(static_cast<int32_t>(ipoint));
+      coordinate_columns[0].push_back(point.longitude);
+      coordinate_columns[1].push_back(point.latitude);
+      coordinate_columns[2].push_back(point.center_longitude);
+      coordinate_columns[3].push_back(point.center_latitude);
+
+      for(std::size_t j = 0; j != nattributes; ++j)
+      {
+        const char* samples = tws_wtss_samples(*result.values[j], point.pixel_pos * ntime_pts, ntime_pts, datatypes[j], converted);
+
+        attribute_columns[j].insert(attribute_columns[j].end(), samples, samples + ntime_pts * tws_wtss_sample_size(datatypes[j]));
+      }
+    }
+
+    if(point_column.empty())
+      break;
+
+    columns.clear();
+
+    columns.push_back({point_column.data(), point_column.size() * sizeof(int32_t), nullptr});
+
+    for(const std::vector<double>& column : coordinate_columns)
+      columns.push_back({column.data(), column.size() * sizeof(double), nullptr});
+
+    for(const std::vector<char>& column : attribute_columns)
+      columns.push_back({column.data(), column.size(), nullptr});
+
+    writer.record_batch(static_cast<int64_t>(point_column.size()), columns);
+  }
+
+  writer.end();
+}
+
+const std::vector<std::string>&
+tws::wtss::output_media_types()
+{
+  static const std::vector<std::string> media_types = { "application/json",
+                                                        "application/x-msgpack",
+                                                        "application/vnd.apache.arrow.stream" };
+
+  return media_types;
+}
@@ -0,0 +1,120 @@
+/*
+  Copyright (C) 2014 National Institute For Space Research (INPE) - Brazil.
+ 
+  This file is part of the TerraLib GeoWeb Services.
+ 
+  TerraLib GeoWeb Services is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License version 3 as
+  published by the Free Software Foundation.
+ 
+  TerraLib GeoWeb Services is distributed  "AS-IS" in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY OF ANY KIND; without even the implied warranty
+  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+  GNU Lesser General Public License for more details.
+ 
+  You should have received a copy of the GNU Lesser General Public License along
+  with TerraLib Web Services. See COPYING. If not, see <http://www.gnu.org/licenses/lgpl-3.0.html>.
+ */
+
+/*!
+  \file tws/wtss/time_series_writers.hpp
+
+  \brief Write the result of the time series operations in each output format.
+
+  \author Gilberto Ribeiro de Queiroz
+ */
+
+#ifndef __TWS_WTSS_TIME_SERIES_WRITERS_HPP__
+#define __TWS_WTSS_TIME_SERIES_WRITERS_HPP__
+
+// TWS
+#include "../geoarray/data_types.hpp"
+
+// STL
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tws
+{
+  namespace wtss
+  {
+    class arrow_stream_writer;
+    class json_writer;
+    class msgpack_writer;
+    class time_series_values;
+
+    //! The output formats of the time series operations, chosen by content negotiation.
+    struct output_format_t
+    {
+      enum
+      {
+        json,     //!< application/json
+        msgpack,  //!< application/x-msgpack
+        arrow     //!< application/vnd.apache.arrow.stream
+      };
+    };
+
+    //! The media types of the output formats, in the order of output_format_t.
+    const std::vector<std::string>& output_media_types();
+
+    //! A location in a time series result.
+    struct time_series_point_t
+    {
+      double longitude;         //!< The queried longitude.
+      double latitude;          //!< The queried latitude.
+      bool valid;               //!< False if the location is outside the coverage.
+      double center_longitude;  //!< The longitude of the center of the pixel.
+      double center_latitude;   //!< The latitude of the center of the pixel.
+      std::size_t pixel_pos;    //!< The position of the pixel time series in the values.
+    };
+
+    //! The time series of a set of locations, as written in the responses.
+    struct time_series_result_t
+    {
+      std::string coverage;
+      std::vector<tws::geoarray::attribute_t> attributes;  //!< The queried attributes, in the query order.
+      std::vector<std::string> timeline;
+      std::vector<time_series_point_t> points;
+      std::vector<const time_series_values*> values;       //!< The time series of the attributes: for the pixel at position p they start at p times the timeline size. NULL if there is no data.
+    };
+
+    /*!
+      \brief Write the time series of a single location.
+
+      The JSON output has the time series widened to double. The binary
+      outputs have them in the attribute datatype, copied as they were
+      decoded, together with its scale factor and missing value:
+
+      - MessagePack: the JSON document layout, with the values of each attribute in a little-endian byte array;
+      - Arrow: a record batch with a timeline column and a column per attribute,
+        the query and pixel location in the schema metadata.
+     */
+    void write_time_series(const time_series_result_t& result, json_writer& writer);
+
+    void write_time_series(const time_series_result_t& result, msgpack_writer& writer);
+
+    void write_time_series(const time_series_result_t& result, arrow_stream_writer& writer);
+
+    /*!
+      \brief Write the time series of a list of locations.
+
+      - MessagePack: the JSON document layout, except that the attribute
+        metadata is written once and each point has the list of byte arrays
+        of its time series;
+      - Arrow: a row per location with the columns point (its position in the
+        query), longitude, latitude, center_longitude, center_latitude and a
+        fixed size list column per attribute. Locations outside the coverage
+        have no rows, the timeline is in the schema metadata, separated by
+        commas, and the record batches hold about 64K values per attribute.
+     */
+    void write_time_series_batch(const time_series_result_t& result, json_writer& writer);
+
+    void write_time_series_batch(const time_series_result_t& result, msgpack_writer& writer);
+
+    void write_time_series_batch(const time_series_result_t& result, arrow_stream_writer& writer);
+
+  }   // end namespace wtss
+}     // end namespace tws
+
+#endif  // __TWS_WTSS_TIME_SERIES_WRITERS_HPP__
@@ -26,6 +26,7 @@
 
 // TWS
 #include "utils.hpp"
+#include "../scidb/chunk_decoder.hpp"
 #include "exception.hpp"
 
 
@@ -379,130 +380,303 @@ tws::wtss::write(const tws::geoarray::dimension_t& dim,
   //jdim.AddMember("pos", dim.pos, allocator);
 }
 
-#define TWS_FILL_VECTOR(values, nvalues, array_it, time_idx, offset, get_name) \
-  std::size_t npts = 0; \
-  \
-  while(!array_it->end()) \
-  { \
-  \
-    const ::scidb::ConstChunk& chunk = array_it->getChunk(); \
-  \
-    std::shared_ptr< ::scidb::ConstChunkIterator > chunk_it = chunk.getConstIterator(); \
-  \
-    while(!chunk_it->end()) \
-    { \
-      ++npts; \
-  \
-      if(npts > nvalues) \
-        throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found too many values."); \
-  \
-      const ::scidb::Value& v = chunk_it->getItem(); \
-  \
-      const ::scidb::Coordinates& coords = chunk_it->getPosition(); \
-  \
-      ::scidb::Coordinate cell_idx = coords[time_idx] + offset; \
-  \
-      values[cell_idx] = v.get_name(); \
-  \
-      ++(*chunk_it); \
-    } \
-  \
-    ++(*array_it); \
- \
-  } \
-  if(npts != nvalues) \
-      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: missing some values.");
-
-inline void
-tws_scidb_fill_int8(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
+template<class T>
+struct tws_scidb_time_series_filler
 {
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getInt8)
-}
+  tws::wtss::time_series_values& values;
+  std::size_t nvalues;
+  ::scidb::Coordinate time_idx;
+  int64_t offset;
+  std::size_t npts;
 
-inline void
-tws_scidb_fill_uint8(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
-{
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getUint8)
-}
+  void operator()(const ::scidb::Coordinates& coords, T v)
+  {
+    ++npts;
 
-inline void
-tws_scidb_fill_int16(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
-{
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getInt16)
-}
+    if(npts > nvalues)
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found too many values.");
 
-inline void
-tws_scidb_fill_uint16(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
-{
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getUint16)
-}
+    ::scidb::Coordinate cell_idx = coords[time_idx] + offset;
 
-inline void
-tws_scidb_fill_int32(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
-{
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getInt32)
-}
+    if((cell_idx < 0) || (static_cast<std::size_t>(cell_idx) >= nvalues))
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found a value out of the time interval.");
 
-inline void
-tws_scidb_fill_uint32(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
-{
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getUint32)
-}
+    values.store(cell_idx, v);
+  }
+};
 
-inline void
-tws_scidb_fill_int64(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
+template<class T> void
+tws_scidb_fill_values(tws::wtss::time_series_values& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
 {
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getInt64)
+  tws_scidb_time_series_filler<T> filler = { values, nvalues, time_idx, offset, 0 };
+
+  tws::scidb::for_each_cell<T>(*it, filler);
+
+  if(filler.npts != nvalues)
+    throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: missing some values.");
 }
 
-inline void
-tws_scidb_fill_uint64(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
+void
+tws::wtss::fill_time_series(time_series_values& values,
+                            std::size_t nvalues,
+                            ::scidb::ConstArrayIterator* it,
+                            const ::scidb::TypeId& id,
+                            ::scidb::Coordinate time_idx,
+                            int64_t offset)
 {
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getUint64)
+  assert(values.size() == nvalues);
+
+  if(id == ::scidb::TID_INT8)
+    tws_scidb_fill_values<int8_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT8)
+    tws_scidb_fill_values<uint8_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT16)
+    tws_scidb_fill_values<int16_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT16)
+    tws_scidb_fill_values<uint16_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT32)
+    tws_scidb_fill_values<int32_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT32)
+    tws_scidb_fill_values<uint32_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT64)
+      tws_scidb_fill_values<int64_t>(values, nvalues, it, time_idx, offset);
+    else if(id == ::scidb::TID_UINT64)
+      tws_scidb_fill_values<uint64_t>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_FLOAT)
+    tws_scidb_fill_values<float>(values, nvalues, it, time_idx, offset);
+  else if(id == ::scidb::TID_DOUBLE)
+    tws_scidb_fill_values<double>(values, nvalues, it, time_idx, offset);
+  else
+    throw tws::conversion_error() << tws::error_description("Could not fill values vector with iterator items: data type not supported.");
 }
 
-inline void
-tws_scidb_fill_float(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
+template<class T>
+struct tws_scidb_pixels_filler
 {
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getFloat)
-}
+  tws::wtss::time_series_values& values;
+  std::size_t nvalues;
+  const tws::wtss::pixel_index_t& pixels;
+  ::scidb::Coordinate time_idx;
+  int64_t offset;
 
-inline void
-tws_scidb_fill_double(std::vector<double>& values, std::size_t nvalues, ::scidb::ConstArrayIterator* it, ::scidb::Coordinate time_idx, int64_t offset)
+  void operator()(const ::scidb::Coordinates& coords, T v)
+  {
+    tws::wtss::pixel_index_t::const_iterator ipixel = pixels.find(tws::wtss::pixel_key(coords[0], coords[1]));
+
+    if(ipixel == pixels.end())
+      return;
+
+    ::scidb::Coordinate cell_idx = coords[time_idx] + offset;
+
+    if((cell_idx < 0) || (static_cast<std::size_t>(cell_idx) >= nvalues))
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found a value out of the time interval.");
+
+    values.store(ipixel->second * nvalues + cell_idx, v);
+  }
+};
+
+template<class T> void
+tws_scidb_fill_pixels(tws::wtss::time_series_values& values,
+                      std::size_t nvalues,
+                      const tws::wtss::pixel_index_t& pixels,
+                      ::scidb::ConstArrayIterator* array_it,
+                      ::scidb::Coordinate time_idx,
+                      int64_t offset)
 {
-  TWS_FILL_VECTOR(values, nvalues, it, time_idx, offset, getDouble)
+  tws_scidb_pixels_filler<T> filler = { values, nvalues, pixels, time_idx, offset };
+
+  tws::scidb::for_each_cell<T>(*array_it, filler);
 }
 
 void
-tws::wtss::fill_time_series(std::vector<double>& values,
+tws::wtss::fill_time_series(time_series_values& values,
                             std::size_t nvalues,
+                            const pixel_index_t& pixels,
                             ::scidb::ConstArrayIterator* it,
                             const ::scidb::TypeId& id,
                             ::scidb::Coordinate time_idx,
                             int64_t offset)
 {
-  assert(values.size() == nvalues);
+  if(id == ::scidb::TID_INT8)
+    tws_scidb_fill_pixels<int8_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT8)
+    tws_scidb_fill_pixels<uint8_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT16)
+    tws_scidb_fill_pixels<int16_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT16)
+    tws_scidb_fill_pixels<uint16_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT32)
+    tws_scidb_fill_pixels<int32_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT32)
+    tws_scidb_fill_pixels<uint32_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_INT64)
+    tws_scidb_fill_pixels<int64_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_UINT64)
+    tws_scidb_fill_pixels<uint64_t>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_FLOAT)
+    tws_scidb_fill_pixels<float>(values, nvalues, pixels, it, time_idx, offset);
+  else if(id == ::scidb::TID_DOUBLE)
+    tws_scidb_fill_pixels<double>(values, nvalues, pixels, it, time_idx, offset);
+  else
+    throw tws::conversion_error() << tws::error_description("Could not fill values vector with iterator items: data type not supported.");
+}
+
+template<class T>
+struct tws_scidb_scaled_pixels_filler
+{
+  double* values;
+  std::size_t nvalues;
+  const tws::wtss::pixel_index_t& pixels;
+  ::scidb::Coordinate time_idx;
+  int64_t offset;
+  const tws::wtss::value_scale_t& scale;
+
+  void operator()(const ::scidb::Coordinates& coords, const T* run, std::size_t n)
+  {
+    assert(static_cast<std::size_t>(time_idx) + 1 == coords.size());
+
+    tws::wtss::pixel_index_t::const_iterator ipixel = pixels.find(tws::wtss::pixel_key(coords[0], coords[1]));
+
+    if(ipixel == pixels.end())
+      return;
+
+    ::scidb::Coordinate cell_idx = coords[time_idx] + offset;
+
+    if((cell_idx < 0) || (static_cast<std::size_t>(cell_idx) + n > nvalues))
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found a value out of the time interval.");
+
+    tws::wtss::scale_values(run, n, scale, values + ipixel->second * nvalues + cell_idx);
+  }
+};
+
+template<class T> void
+tws_scidb_fill_scaled_pixels(std::vector<double>& values,
+                             std::size_t nvalues,
+                             const tws::wtss::pixel_index_t& pixels,
+                             ::scidb::ConstArrayIterator* array_it,
+                             ::scidb::Coordinate time_idx,
+                             int64_t offset,
+                             const tws::wtss::value_scale_t& scale)
+{
+  tws_scidb_scaled_pixels_filler<T> filler = { values.data(), nvalues, pixels, time_idx, offset, scale };
+
+  tws::scidb::for_each_run<T>(*array_it, filler);
+}
+
+void
+tws::wtss::fill_scaled_time_series(typed_time_series_values<double>& values,
+                                   std::size_t nvalues,
+                                   const pixel_index_t& pixels,
+                                   ::scidb::ConstArrayIterator* it,
+                                   const ::scidb::TypeId& id,
+                                   ::scidb::Coordinate time_idx,
+                                   int64_t offset,
+                                   const value_scale_t& scale)
+{
+  std::vector<double>& buffer = values.values();
 
   if(id == ::scidb::TID_INT8)
-    tws_scidb_fill_int8(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<int8_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_UINT8)
-    tws_scidb_fill_uint8(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<uint8_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_INT16)
-    tws_scidb_fill_int16(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<int16_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_UINT16)
-    tws_scidb_fill_uint16(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<uint16_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_INT32)
-    tws_scidb_fill_int32(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<int32_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_UINT32)
-    tws_scidb_fill_uint32(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<uint32_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_INT64)
-      tws_scidb_fill_int64(values, nvalues, it, time_idx, offset);
-    else if(id == ::scidb::TID_UINT64)
-      tws_scidb_fill_uint64(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<int64_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
+  else if(id == ::scidb::TID_UINT64)
+    tws_scidb_fill_scaled_pixels<uint64_t>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_FLOAT)
-    tws_scidb_fill_float(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<float>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else if(id == ::scidb::TID_DOUBLE)
-    tws_scidb_fill_double(values, nvalues, it, time_idx, offset);
+    tws_scidb_fill_scaled_pixels<double>(buffer, nvalues, pixels, it, time_idx, offset, scale);
   else
     throw tws::conversion_error() << tws::error_description("Could not fill values vector with iterator items: data type not supported.");
 }
+
+template<class T, T (::scidb::Value::*get_value)() const> void
+tws_scidb_store_value(const ::scidb::Value& v, tws::wtss::time_series_values& values, std::size_t pos)
+{
+  values.store(pos, (v.*get_value)());
+}
+
+typedef void (*tws_scidb_value_setter_t)(const ::scidb::Value&, tws::wtss::time_series_values&, std::size_t);
+
+static tws_scidb_value_setter_t
+tws_scidb_value_setter(const ::scidb::TypeId& id)
+{
+  if(id == ::scidb::TID_INT8)
+    return &tws_scidb_store_value<int8_t, &::scidb::Value::getInt8>;
+  else if(id == ::scidb::TID_UINT8)
+    return &tws_scidb_store_value<uint8_t, &::scidb::Value::getUint8>;
+  else if(id == ::scidb::TID_INT16)
+    return &tws_scidb_store_value<int16_t, &::scidb::Value::getInt16>;
+  else if(id == ::scidb::TID_UINT16)
+    return &tws_scidb_store_value<uint16_t, &::scidb::Value::getUint16>;
+  else if(id == ::scidb::TID_INT32)
+    return &tws_scidb_store_value<int32_t, &::scidb::Value::getInt32>;
+  else if(id == ::scidb::TID_UINT32)
+    return &tws_scidb_store_value<uint32_t, &::scidb::Value::getUint32>;
+  else if(id == ::scidb::TID_INT64)
+    return &tws_scidb_store_value<int64_t, &::scidb::Value::getInt64>;
+  else if(id == ::scidb::TID_UINT64)
+    return &tws_scidb_store_value<uint64_t, &::scidb::Value::getUint64>;
+  else if(id == ::scidb::TID_FLOAT)
+    return &tws_scidb_store_value<float, &::scidb::Value::getFloat>;
+  else if(id == ::scidb::TID_DOUBLE)
+    return &tws_scidb_store_value<double, &::scidb::Value::getDouble>;
+
+  throw tws::conversion_error() << tws::error_description("Could not fill values vector with iterator items: data type not supported.");
+}
+
+void
+tws::wtss::fill_time_series(std::vector<std::unique_ptr<time_series_values> >& values,
+                            std::size_t nvalues,
+                            tws::scidb::cell_iterator& it,
+                            ::scidb::Coordinate time_idx,
+                            int64_t offset)
+{
+  const std::size_t nattributes = it.num_attributes();
+
+  assert(values.size() == nattributes);
+
+// resolve the datatype of each attribute once, not for each cell
+  std::vector<tws_scidb_value_setter_t> setters;
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+  {
+    assert(values[i]->size() == nvalues);
+
+    setters.push_back(tws_scidb_value_setter(it.attribute_type(i)));
+  }
+
+  std::size_t npts = 0;
+
+  while(!it.end())
+  {
+    ++npts;
+
+    if(npts > nvalues)
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found too many values.");
+
+    const ::scidb::Coordinates& coords = it.get_position();
+
+    ::scidb::Coordinate cell_idx = coords[time_idx] + offset;
+
+    if((cell_idx < 0) || (static_cast<std::size_t>(cell_idx) >= nvalues))
+      throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: found a value out of the time interval.");
+
+    for(std::size_t i = 0; i != nattributes; ++i)
+      setters[i](it.get_value(i), *values[i], cell_idx);
+
+    ++it;
+  }
+
+  if(npts != nvalues)
+    throw tws::outof_bounds_error() << tws::error_description("Invalid timeseries range: missing some values.");
+}
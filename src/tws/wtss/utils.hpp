@@ -30,6 +30,15 @@
 // TWS
 //#include "config.hpp"
 #include "../geoarray/data_types.hpp"
+#include "../scidb/cell_iterator.hpp"
+#include "scale_kernels.hpp"
+#include "time_series.hpp"
+
+// STL
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 // RapidJSON
 #include <rapidjson/document.h>
@@ -82,7 +91,7 @@ namespace tws
     /*!
        \brief Fill the timeseries with cell values.
 
-       \param values   A pre-allocated vector with at least nvalues.
+       \param values   A pre-allocated container with nvalues: cells are converted to its datatype only if it is not the cell datatype.
        \param nvalues  Number of expected values in the timeseries.
        \param it       An array iterator.
        \param id       The datatype of the cell.
@@ -91,13 +100,92 @@ namespace tws
 
        \exception tws::outof_bounds_error If the number of values found is less than or greater than the number o expected time-series values.
      */
-    void fill_time_series(std::vector<double>& values,
+    void fill_time_series(time_series_values& values,
+                          std::size_t nvalues,
+                          ::scidb::ConstArrayIterator* it,
+                          const ::scidb::TypeId& id,
+                          ::scidb::Coordinate time_idx,
+                          int64_t offset);
+
+    /*!
+       \brief Fill the timeseries of all attributes traversed by a cell iterator in a single pass.
+
+       \param values   One pre-allocated container with nvalues for each attribute in the iterator.
+       \param nvalues  Number of expected values in each timeseries.
+       \param it       A cell iterator over all queried attributes.
+       \param time_idx The time coordinate index. It will be used to map cell-values to the time-series vector.
+       \param offset   An offset considered in the time_idx mapping.
+
+       \exception tws::outof_bounds_error If the number of values found is less than or greater than the number o expected time-series values.
+       \exception tws::conversion_error   If the datatype of an attribute is not supported.
+     */
+    void fill_time_series(std::vector<std::unique_ptr<time_series_values> >& values,
+                          std::size_t nvalues,
+                          tws::scidb::cell_iterator& it,
+                          ::scidb::Coordinate time_idx,
+                          int64_t offset);
+
+    //! Maps the location of a pixel, as computed by pixel_key, to the position of its time series in a buffer.
+    typedef std::unordered_map<uint64_t, std::size_t> pixel_index_t;
+
+    //! Combine the column and row of a pixel in a single key.
+    inline uint64_t pixel_key(int64_t col, int64_t row)
+    {
+      return (static_cast<uint64_t>(col) << 32) | (static_cast<uint64_t>(row) & 0xFFFFFFFF);
+    }
+
+    /*!
+       \brief Fill the timeseries of a set of pixels with cell values.
+
+       Cells whose location is not in the pixels index are skipped. Time series
+       values not found in the iterator are left untouched.
+
+       \param values   A pre-allocated buffer: the time series of the pixel at position p starts at p * nvalues.
+       \param nvalues  Number of expected values in each timeseries.
+       \param pixels   The pixels of interest and the position of their time series in the buffer.
+       \param it       An array iterator.
+       \param id       The datatype of the cell.
+       \param time_idx The time coordinate index. It will be used to map cell-values to the time-series vector.
+       \param offset   An offset considered in the time_idx mapping.
+
+       \exception tws::outof_bounds_error If a cell is out of the expected time range.
+     */
+    void fill_time_series(time_series_values& values,
                           std::size_t nvalues,
+                          const pixel_index_t& pixels,
                           ::scidb::ConstArrayIterator* it,
                           const ::scidb::TypeId& id,
                           ::scidb::Coordinate time_idx,
                           int64_t offset);
 
+    /*!
+       \brief Fill the scaled timeseries of a set of pixels with cell values.
+
+       The values are scaled as they are decoded, a run of cells along the time
+       dimension at a time. Cells whose location is not in the pixels index are
+       skipped. Time series values not found in the iterator are left untouched.
+
+       \param values   A pre-allocated buffer: the time series of the pixel at position p starts at p * nvalues.
+       \param nvalues  Number of expected values in each timeseries.
+       \param pixels   The pixels of interest and the position of their time series in the buffer.
+       \param it       An array iterator.
+       \param id       The datatype of the cell.
+       \param time_idx The time coordinate index: it must be the last dimension of the array.
+       \param offset   An offset considered in the time_idx mapping.
+       \param scale    How the cell values are scaled.
+
+       \exception tws::outof_bounds_error If a cell is out of the expected time range.
+       \exception tws::conversion_error   If the datatype of the cells is not supported.
+     */
+    void fill_scaled_time_series(typed_time_series_values<double>& values,
+                                 std::size_t nvalues,
+                                 const pixel_index_t& pixels,
+                                 ::scidb::ConstArrayIterator* it,
+                                 const ::scidb::TypeId& id,
+                                 ::scidb::Coordinate time_idx,
+                                 int64_t offset,
+                                 const value_scale_t& scale);
+
   } // end namespace wtss
 }   // end namespace tws
 
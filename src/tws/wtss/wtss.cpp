@@ -26,8 +26,10 @@
 
 // TWS
 #include "wtss.hpp"
+#include "../core/cached_response.hpp"
 #include "../core/http_request.hpp"
 #include "../core/http_response.hpp"
+#include "../core/query_string.hpp"
 #include "../core/service_operations_manager.hpp"
 #include "../core/utils.hpp"
 #include "../geoarray/geoarray_manager.hpp"
@@ -35,8 +37,17 @@
 #include "../geoarray/timeline_manager.hpp"
 #include "../geoarray/utils.hpp"
 #include "../scidb/connection.hpp"
+#include "../scidb/cell_iterator.hpp"
 #include "../scidb/connection_pool.hpp"
 #include "../scidb/utils.hpp"
+#include "arrow_writer.hpp"
+#include "json_writer.hpp"
+#include "msgpack_writer.hpp"
+#include "output_buffer.hpp"
+#include "scale_kernels.hpp"
+#include "time_series.hpp"
+#include "time_series_cache.hpp"
+#include "time_series_writers.hpp"
 #include "utils.hpp"
 
 // STL
@@ -44,16 +55,21 @@
 //#include <chrono>
 //#include <iostream>
 #include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 // Boost
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/bind.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
-
+#include <boost/noncopyable.hpp>
 
 // SciDB
 #include <SciDBAPI.h>
@@ -72,6 +88,32 @@ namespace tws
 {
   namespace wtss
   {
+    //! Maximum number of points accepted in a single time_series_batch request.
+    const std::size_t max_batch_points = 10000;
+
+    //! Side, in pixels, of the tiles used to group the points of a batch in a single query.
+    const int64_t batch_tile_size = 128;
+
+    //! A tile whose bounding box has more cells than this factor times its number of pixels is filtered in the server.
+    const int64_t batch_sparse_factor = 4;
+
+    //! The maximum number of pixels tested by the filter of a tile: SciDB evaluates every term on every cell of the bounding box.
+    const std::size_t batch_max_filter_terms = 32;
+
+    //! How the time series responses are written: the precision only applies to JSON.
+    struct json_output_options
+    {
+      int precision;           //!< The maximum number of significant digits of the non-integral values.
+      std::size_t flush_size;  //!< The number of bytes buffered before a chunk of a streamed response is sent.
+    };
+
+    //! The pre-serialized answers of the operations that only read the immutable coverage metadata.
+    struct metadata_responses
+    {
+      tws::core::cached_response list_coverages;
+      std::map<std::string, tws::core::cached_response> coverages;
+    };
+
     struct timeseries_request_parameters
     {
       std::string cv_name;
@@ -80,13 +122,16 @@ namespace tws
       double latitude;
       std::string start_time_point;
       std::string end_time_point;
+      double resolution;  //!< The coarsest cell size acceptable, in the coverage SRS units, or zero for the native resolution.
+      bool scaled;        //!< Apply the valid range, missing value and scale factor of the attributes to the values.
     };
 
     struct timeseries_validated_parameters
     {
       std::vector<std::size_t> attribute_positions;
       const tws::geoarray::geoarray_t* geo_array;
-      const tws::geoarray::timeline* timeline;
+      std::shared_ptr<const tws::geoarray::timeline> timeline;
+      uint64_t timeline_generation;   //!< The timeline manager generation read before the timeline.
       std::size_t start_time_idx;
       std::size_t end_time_idx;
       int64_t pixel_col;
@@ -95,24 +140,127 @@ namespace tws
       double pixel_center_latitude;
     };
 
+    struct timeseries_batch_request_parameters
+    {
+      std::string cv_name;
+      std::vector<std::string> queried_attributes;
+      std::vector<std::pair<double, double> > points;  //!< List of (longitude, latitude).
+      std::string start_time_point;
+      std::string end_time_point;
+      double resolution;  //!< The coarsest cell size acceptable, in the coverage SRS units, or zero for the native resolution.
+      bool scaled;        //!< Apply the valid range, missing value and scale factor of the attributes to the values.
+    };
+
+    //! The location of a batch point in the array grid.
+    struct batch_point_location
+    {
+      bool valid;
+      int64_t pixel_col;
+      int64_t pixel_row;
+      double pixel_center_longitude;
+      double pixel_center_latitude;
+      std::size_t pixel_pos;  //!< Position of the pixel time series in the batch buffers.
+    };
+
+    //! Maps WGS84 locations to the pixels of a geo-array.
+    class pixel_locator : public boost::noncopyable
+    {
+      public:
+
+        explicit pixel_locator(const tws::geoarray::geoarray_t& geo_array);
+
+        //! Returns false if the location is outside the geo-array.
+        bool locate(double longitude, double latitude,
+                    int64_t& pixel_col, int64_t& pixel_row,
+                    double& pixel_center_longitude, double& pixel_center_latitude);
+
+      private:
+
+        const tws::geoarray::geoarray_t& geo_array_;
+        te::srs::Converter srs_conv_;
+        std::unique_ptr<te::rst::Grid> grid_;
+    };
+
+    metadata_responses make_metadata_responses();
+
+    //! Read the optional json_output entry of share/tws/config/wtss.json.
+    json_output_options read_json_output_options();
+
+    const json_output_options& json_output();
+
+    const metadata_responses& cached_metadata();
+
     timeseries_request_parameters
     decode_timeseries_request(const tws::core::query_string_t& qstr);
 
+    timeseries_batch_request_parameters
+    decode_timeseries_batch_request(const tws::core::query_string_t& qstr);
+
+    timeseries_batch_request_parameters
+    decode_timeseries_batch_request(const rapidjson::Value& jrequest);
+
     timeseries_validated_parameters
     valid(const timeseries_request_parameters& parameters);
 
+    void
+    valid_query(const std::string& cv_name,
+                const std::vector<std::string>& queried_attributes,
+                const std::string& start_time_point,
+                const std::string& end_time_point,
+                double resolution,
+                timeseries_validated_parameters& vparameters);
+
+    //! Read the optional resolution parameter of a query to the named operation.
+    double decode_resolution(const tws::core::query_string_t& qstr,
+                             const char* operation);
+
+    //! Read the optional scaled parameter of a query to the named operation: "true" or "false".
+    bool decode_scaled(const tws::core::query_string_t& qstr,
+                       const char* operation);
+
+    //! Retrieve the time series of each queried attribute: a null pointer if the query returned no data.
     void
     compute_time_series(const timeseries_request_parameters& parameters,
                         const timeseries_validated_parameters& vparameters,
-                        rapidjson::Document::AllocatorType& allocator,
-                        rapidjson::Value& jattributes);
+                        std::vector<time_series_cache::value_type>& values);
 
     void
-    prepare_timeseries_response(const timeseries_request_parameters& parameters,
-                                const timeseries_validated_parameters& vparameters,
-                                rapidjson::Document& doc,
-                                rapidjson::Value& jattributes,
-                                rapidjson::Document::AllocatorType& allocator);
+    compute_time_series_batch(const timeseries_batch_request_parameters& parameters,
+                              const timeseries_validated_parameters& vparameters,
+                              const std::vector<batch_point_location>& locations,
+                              std::size_t npixels,
+                              std::vector<time_series_cache::value_type>& values);
+
+    //! Query the time series of the pixels of a batch for the distinct attributes, tile by tile.
+    void
+    fetch_time_series_batch(const timeseries_validated_parameters& vparameters,
+                            const std::vector<batch_point_location>& locations,
+                            std::size_t npixels,
+                            bool scaled,
+                            const std::vector<std::string>& attributes,
+                            const std::vector<value_scale_t>& scales,
+                            std::vector<std::unique_ptr<time_series_values> >& values);
+
+    //! Copy the queried attributes and the timeline of the queried interval to a result.
+    /*!
+      If the values are scaled the attributes are reported as double values,
+      with a unit scale factor, NaN as missing value and a scaled valid range.
+     */
+    void
+    prepare_time_series_result(const std::string& cv_name,
+                               const timeseries_validated_parameters& vparameters,
+                               bool scaled,
+                               time_series_result_t& result);
+
+    //! Choose the output format from the Accept header of a request and add the matching Content-Type to the response.
+    int negotiate_output_format(const tws::core::http_request& request,
+                                tws::core::http_response& response);
+
+    //! Write the result of a time series operation in one of the output formats.
+    void
+    write_time_series_response(const time_series_result_t& result,
+                               int format, bool batch,
+                               output_buffer& out);
 
   }  // end namespace wtss
 }    // end namespace tws
@@ -121,42 +269,16 @@ void
 tws::wtss::list_coverages_functor::operator()(const tws::core::http_request& request,
                                               tws::core::http_response& response)
 {
-// retrieve the list of registered geo-arrays
-  std::vector<std::string> arrays = tws::geoarray::geoarray_manager::instance().list_arrays();
-
-// output result
-  rapidjson::Document::AllocatorType allocator;
-
-  rapidjson::Document doc;
-
-  doc.SetObject();
-
-  rapidjson::Value jarrays(rapidjson::kArrayType);
-
-  tws::core::copy_string_array(arrays.begin(), arrays.end(), jarrays, allocator);
-
-  doc.AddMember("coverages", jarrays, allocator);
-
-  rapidjson::StringBuffer str_buff;
-
-  rapidjson::Writer<rapidjson::StringBuffer> writer(str_buff);
-
-  doc.Accept(writer);
-
-  const char* p_str_buff = str_buff.GetString();
-
-  response.add_header("Content-Type", "application/json");
-  response.add_header("Access-Control-Allow-Origin", "*");
-  response.set_content(p_str_buff, str_buff.Size());
+  tws::core::send_cached_response(cached_metadata().list_coverages, request, response);
 }
 
 void
 tws::wtss::describe_coverage_functor::operator()(const tws::core::http_request& request,
                                                  tws::core::http_response& response)
 {
-  const char* qstring = request.query_string().c_str();
+  std::string qstring = request.query_string();
 
-  if(qstring == nullptr)
+  if(qstring.empty())
     throw tws::core::http_request_error() << tws::error_description("describe_coverage operation requires the parameter: \"name\".");
 
   tws::core::query_string_t qstr = tws::core::expand(qstring);
@@ -168,42 +290,32 @@ tws::wtss::describe_coverage_functor::operator()(const tws::core::http_request&
   if(it == it_end)
     throw tws::core::http_request_error() << tws::error_description("check describe_coverage operation: \"name\" parameter is missing!");
 
-// retrieve the coverage
-  const tws::geoarray::geoarray_t& cv = tws::geoarray::geoarray_manager::instance().get(it->second);
-
-// output result: JSON document
-  rapidjson::Document::AllocatorType allocator;
+// retrieve the coverage description
+  const metadata_responses& metadata = cached_metadata();
 
-  rapidjson::Document doc;
+  std::map<std::string, tws::core::cached_response>::const_iterator icv = metadata.coverages.find(it->second.to_string());
 
-  doc.SetObject();
-
-  write(cv, doc, allocator);
-
-  rapidjson::StringBuffer str_buff;
-
-  rapidjson::Writer<rapidjson::StringBuffer> writer(str_buff);
-
-  doc.Accept(writer);
+  if(icv == metadata.coverages.end())
+  {
+    boost::format err_msg("could not find array: '%1%'.");
 
-  const char* p_str_buff = str_buff.GetString();
+    throw tws::item_not_found_error() << tws::error_description((err_msg % it->second).str());
+  }
 
-  response.add_header("Content-Type", "application/json");
-  response.add_header("Access-Control-Allow-Origin", "*");
-  response.set_content(p_str_buff, str_buff.Size());
+  tws::core::send_cached_response(icv->second, request, response);
 }
 
 void
 tws::wtss::time_series_functor::operator()(const tws::core::http_request& request,
                                            tws::core::http_response& response)
 {
-// get client query string
-  const char* qstring = request.query_string().c_str();
+// get client query string: it is decoded in place
+  std::string qstring = request.query_string();
 
-  if(qstring == nullptr)
+  if(qstring.empty())
     throw tws::core::http_request_error() << tws::error_description("time_series operation requires the following parameters: \"coverage\", \"attributes\", \"latitude\", \"longitude\", \"start\", \"end\".");
 
-// parse plain text query string to a std::map
+// split the query string into its key-value pairs
   tws::core::query_string_t qstr = tws::core::expand(qstring);
 
 // parse parameters to a struct
@@ -212,34 +324,170 @@ tws::wtss::time_series_functor::operator()(const tws::core::http_request& reques
 // valid parameters
   timeseries_validated_parameters vparameters = valid(parameters);
 
-// prepare the JSON root document
-  rapidjson::Document::AllocatorType allocator;
+// compute timeseries for queried coverage attributes
+  std::vector<time_series_cache::value_type> values;
 
-  rapidjson::Value jattributes(rapidjson::kArrayType);
+  compute_time_series(parameters, vparameters, values);
 
-// compute timeseries for queried coverage attributes
-  compute_time_series(parameters, vparameters, allocator, jattributes);
+// the time series of the single queried pixel
+  time_series_result_t result;
+
+  prepare_time_series_result(parameters.cv_name, vparameters, parameters.scaled, result);
+
+  time_series_point_t point = { parameters.longitude, parameters.latitude, true,
+                                vparameters.pixel_center_longitude, vparameters.pixel_center_latitude, 0 };
+
+  result.points.push_back(point);
+
+// the cache keeps the series as stored in the array: they are scaled on their way out
+  std::vector<std::unique_ptr<time_series_values> > scaled_values;
+
+  for(std::size_t i = 0; i != values.size(); ++i)
+  {
+    if(!parameters.scaled || (values[i] == nullptr))
+    {
+      result.values.push_back(values[i].get());
+
+      continue;
+    }
+
+    const tws::geoarray::attribute_t& attr = vparameters.geo_array->attributes[vparameters.attribute_positions[i]];
+
+    std::unique_ptr<typed_time_series_values<double> > scaled(new typed_time_series_values<double>(values[i]->size(), 0.0));
+
+    scale_values(*values[i], 0, values[i]->size(), make_value_scale(attr), scaled->values().data());
+
+    result.values.push_back(scaled.get());
+
+    scaled_values.push_back(std::move(scaled));
+  }
+
+// write the response straight from the time series: the document is small enough to be sent at once
+  int format = negotiate_output_format(request, response);
+
+  response.add_header("Access-Control-Allow-Origin", "*");
+
+  output_buffer out;
+
+  write_time_series_response(result, format, false, out);
+
+  response.set_content(out.data(), out.size());
+}
+
+void
+tws::wtss::time_series_batch_functor::operator()(const tws::core::http_request& request,
+                                                 tws::core::http_response& response)
+{
+// the query may be a JSON document in the request body or be informed in the query string
+  timeseries_batch_request_parameters parameters;
+
+  if(request.content_length() != 0)
+  {
+    std::string body(request.content(), request.content_length());
+
+    rapidjson::Document jrequest;
+
+    jrequest.Parse<0>(body.c_str());
+
+    if(jrequest.HasParseError() || !jrequest.IsObject())
+      throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: request body must be a JSON object.");
+
+    parameters = decode_timeseries_batch_request(jrequest);
+  }
+  else
+  {
+    std::string qstring = request.query_string();
+
+    if(qstring.empty())
+      throw tws::core::http_request_error() << tws::error_description("time_series_batch operation requires the following parameters: \"coverage\", \"attributes\", \"points\", \"start\", \"end\".");
+
+    tws::core::query_string_t qstr = tws::core::expand(qstring);
+
+    parameters = decode_timeseries_batch_request(qstr);
+  }
+
+  if(parameters.points.empty())
+    throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: please, inform at least one point.");
+
+  if(parameters.points.size() > max_batch_points)
+  {
+    boost::format err_msg("Error on time_series_batch operation: too many points (%1%), the limit is %2%.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.points.size() % max_batch_points).str());
+  }
+
+// valid coverage, attributes and time interval
+  timeseries_validated_parameters vparameters;
+
+  valid_query(parameters.cv_name, parameters.queried_attributes,
+              parameters.start_time_point, parameters.end_time_point,
+              parameters.resolution, vparameters);
+
+// locate the points in the array grid: points falling in the same pixel share the time series
+  std::vector<batch_point_location> locations(parameters.points.size());
+
+  std::map<std::pair<int64_t, int64_t>, std::size_t> pixels;
+
+  pixel_locator locator(*vparameters.geo_array);
+
+  for(std::size_t i = 0; i != parameters.points.size(); ++i)
+  {
+    batch_point_location& loc = locations[i];
+
+    loc.valid = locator.locate(parameters.points[i].first, parameters.points[i].second,
+                               loc.pixel_col, loc.pixel_row,
+                               loc.pixel_center_longitude, loc.pixel_center_latitude);
+
+    if(!loc.valid)
+      continue;
+
+    std::pair<int64_t, int64_t> pixel(loc.pixel_col, loc.pixel_row);
 
-// prepare the return document
-  rapidjson::Document doc;
+    loc.pixel_pos = pixels.insert(std::make_pair(pixel, pixels.size())).first->second;
+  }
+
+// retrieve the time series of all pixels
+  std::vector<time_series_cache::value_type> values;
 
-  doc.SetObject();
+  compute_time_series_batch(parameters, vparameters, locations, pixels.size(), values);
 
-  prepare_timeseries_response(parameters, vparameters, doc, jattributes, allocator);
+// the time series of all points: points sharing a pixel point to the same series
+  time_series_result_t result;
 
-// send response
-  rapidjson::StringBuffer str_buff;
+  prepare_time_series_result(parameters.cv_name, vparameters, parameters.scaled, result);
 
-  rapidjson::Writer<rapidjson::StringBuffer> writer(str_buff);
+  result.points.resize(locations.size());
 
-  doc.Accept(writer);
+  for(std::size_t i = 0; i != locations.size(); ++i)
+  {
+    const batch_point_location& loc = locations[i];
 
-  const char* p_str_buff = str_buff.GetString();
+    time_series_point_t point = { parameters.points[i].first, parameters.points[i].second, loc.valid,
+                                  loc.pixel_center_longitude, loc.pixel_center_latitude, loc.pixel_pos };
+
+    result.points[i] = point;
+  }
+
+  for(const time_series_cache::value_type& v : values)
+    result.values.push_back(v.get());
+
+// write the response point by point, sending it while it is written
+  int format = negotiate_output_format(request, response);
 
-  //response.add_header("Content-Length", boost::lexical_cast<std::string>(content.size()).c_str());
-  response.add_header("Content-Type", "application/json");
   response.add_header("Access-Control-Allow-Origin", "*");
-  response.set_content(p_str_buff, str_buff.Size());
+
+  response.begin();
+
+  {
+    output_buffer out(boost::bind(&tws::core::http_response::write_chunk, &response, _1, _2),
+                      json_output().flush_size);
+
+    write_time_series_response(result, format, true, out);
+
+    out.flush();
+  }
+
+  response.end();
 }
 
 void
@@ -282,6 +530,17 @@ tws::wtss::register_operations()
     service.operations.push_back(s_op);
   }
 
+// 4th WTSS operation: time series retrieval for a list of locations
+  {
+    tws::core::service_operation s_op;
+
+    s_op.name = "time_series_batch";
+    s_op.description = "Retrieve the time series for a list of locations in a particular coverage";
+    s_op.handler = time_series_batch_functor();
+
+    service.operations.push_back(s_op);
+  }
+
   tws::core::service_operations_manager::instance().insert(service);
 }
 
@@ -290,6 +549,119 @@ tws::wtss::initialize_operations()
 {
   tws::geoarray::geoarray_manager::instance();
   tws::geoarray::timeline_manager::instance();
+  tws::wtss::time_series_cache::instance();
+  tws::scidb::connection_pool::instance();
+  tws::wtss::cached_metadata();
+  tws::wtss::json_output();
+}
+
+const tws::wtss::metadata_responses&
+tws::wtss::cached_metadata()
+{
+// the coverage metadata does not change after startup: serialize it only once
+  static const metadata_responses metadata = make_metadata_responses();
+
+  return metadata;
+}
+
+const tws::wtss::json_output_options&
+tws::wtss::json_output()
+{
+  static const json_output_options options = read_json_output_options();
+
+  return options;
+}
+
+tws::wtss::json_output_options
+tws::wtss::read_json_output_options()
+{
+  json_output_options options;
+
+  options.precision = 9;
+  options.flush_size = 65536;
+
+  std::string wtss_file = tws::core::find_in_app_path("share/tws/config/wtss.json");
+
+  if(wtss_file.empty())
+    throw tws::file_exists_error() << tws::error_description("Could not locate file 'share/tws/config/wtss.json'.");
+
+  std::unique_ptr<rapidjson::Document> jdocument(tws::core::open_json_file(wtss_file));
+
+  if(!jdocument->HasMember("json_output"))
+    return options;
+
+  const rapidjson::Value& joutput = (*jdocument)["json_output"];
+
+  if(!joutput.IsObject())
+    throw tws::parse_error() << tws::error_description("json_output entry in file 'share/tws/config/wtss.json' must be an object.");
+
+  const rapidjson::Value& jprecision = joutput["precision"];
+
+  if(!jprecision.IsNumber() || jprecision.IsNull() || (jprecision.GetInt() < 1) || (jprecision.GetInt() > 17))
+    throw tws::parse_error() << tws::error_description("json_output must have a precision entry between 1 and 17.");
+
+  const rapidjson::Value& jflush_size = joutput["flush_size"];
+
+  if(!jflush_size.IsNumber() || jflush_size.IsNull() || (jflush_size.GetUint() == 0))
+    throw tws::parse_error() << tws::error_description("json_output must have a positive flush_size entry.");
+
+  options.precision = jprecision.GetInt();
+  options.flush_size = jflush_size.GetUint();
+
+  return options;
+}
+
+tws::wtss::metadata_responses
+tws::wtss::make_metadata_responses()
+{
+  metadata_responses m;
+
+  const tws::geoarray::geoarray_manager& gmanager = tws::geoarray::geoarray_manager::instance();
+
+  std::vector<std::string> arrays = gmanager.list_arrays();
+
+  {
+    rapidjson::Document::AllocatorType allocator;
+
+    rapidjson::Document doc;
+
+    doc.SetObject();
+
+    rapidjson::Value jarrays(rapidjson::kArrayType);
+
+    tws::core::copy_string_array(arrays.begin(), arrays.end(), jarrays, allocator);
+
+    doc.AddMember("coverages", jarrays, allocator);
+
+    rapidjson::StringBuffer str_buff;
+
+    rapidjson::Writer<rapidjson::StringBuffer> writer(str_buff);
+
+    doc.Accept(writer);
+
+    m.list_coverages = tws::core::make_cached_response(std::string(str_buff.GetString(), str_buff.Size()), "application/json");
+  }
+
+  for(const std::string& array_name : arrays)
+  {
+    rapidjson::Document::AllocatorType allocator;
+
+    rapidjson::Document doc;
+
+    doc.SetObject();
+
+    write(gmanager.get(array_name), doc, allocator);
+
+    rapidjson::StringBuffer str_buff;
+
+    rapidjson::Writer<rapidjson::StringBuffer> writer(str_buff);
+
+    doc.Accept(writer);
+
+    m.coverages[array_name] = tws::core::make_cached_response(std::string(str_buff.GetString(), str_buff.Size()), "application/json");
+  }
+
+  return m;
 }
 
 tws::wtss::timeseries_request_parameters
@@ -304,7 +676,7 @@ tws::wtss::decode_timeseries_request(const tws::core::query_string_t& qstr)
   if(it == it_end)
     throw tws::core::http_request_error() << tws::error_description("Error on time_series operation: \"coverage\" parameter is missing.");
 
-  parameters.cv_name = it->second;
+  parameters.cv_name = it->second.to_string();
 
 // get queried attributes
   it = qstr.find("attributes");
@@ -324,7 +696,7 @@ tws::wtss::decode_timeseries_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("Error on time_series operation: \"longitude\" parameter is missing.");
 
-  parameters.longitude = boost::lexical_cast<double>(it->second);
+  parameters.longitude = boost::lexical_cast<double>(it->second.to_string());
 
 // extract latitude
   it = qstr.find("latitude");
@@ -332,38 +704,266 @@ tws::wtss::decode_timeseries_request(const tws::core::query_string_t& qstr)
   if(it == it_end || it->second.empty())
     throw tws::core::http_request_error() << tws::error_description("check time_series operation: \"latitude\" parameter is missing.");
 
-  parameters.latitude = boost::lexical_cast<double>(it->second);
+  parameters.latitude = boost::lexical_cast<double>(it->second.to_string());
 
 // extract start and end times if any
   it = qstr.find("start");
 
-  parameters.start_time_point = (it != it_end) ? it->second : std::string("");
+  parameters.start_time_point = (it != it_end) ? it->second.to_string() : std::string();
 
   it = qstr.find("end");
 
-  parameters.end_time_point = (it != it_end) ? it->second : std::string("");
+  parameters.end_time_point = (it != it_end) ? it->second.to_string() : std::string();
+
+  parameters.resolution = decode_resolution(qstr, "time_series");
+
+  parameters.scaled = decode_scaled(qstr, "time_series");
 
 // ok: finished extracting parameters
   return parameters;
 }
 
+tws::wtss::timeseries_batch_request_parameters
+tws::wtss::decode_timeseries_batch_request(const tws::core::query_string_t& qstr)
+{
+  timeseries_batch_request_parameters parameters;
+
+// get coverage name
+  tws::core::query_string_t::const_iterator it = qstr.find("coverage");
+  tws::core::query_string_t::const_iterator it_end = qstr.end();
+
+  if(it == it_end)
+    throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"coverage\" parameter is missing.");
+
+  parameters.cv_name = it->second.to_string();
+
+// get queried attributes
+  it = qstr.find("attributes");
+
+  if(it == it_end)
+  {
+    boost::format err_msg("Error on time_series_batch operation: \"attributes\" parameter is missing for coverage '%1%'.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.cv_name).str());
+  }
+
+  boost::split(parameters.queried_attributes, it->second, boost::is_any_of(","));
+
+// extract the list of points: lon,lat;lon,lat;...
+  it = qstr.find("points");
+
+  if(it == it_end || it->second.empty())
+    throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"points\" parameter is missing.");
+
+  std::vector<std::string> points;
+
+  boost::split(points, it->second, boost::is_any_of(";"));
+
+  for(const std::string& point : points)
+  {
+    std::vector<std::string> coords;
+
+    boost::split(coords, point, boost::is_any_of(","));
+
+    if(coords.size() != 2)
+    {
+      boost::format err_msg("Error on time_series_batch operation: invalid point '%1%', expecting \"longitude,latitude\".");
+
+      throw tws::core::http_request_error() << tws::error_description((err_msg % point).str());
+    }
+
+    parameters.points.push_back(std::make_pair(boost::lexical_cast<double>(coords[0]),
+                                               boost::lexical_cast<double>(coords[1])));
+  }
+
+// extract start and end times if any
+  it = qstr.find("start");
+
+  parameters.start_time_point = (it != it_end) ? it->second.to_string() : std::string();
+
+  it = qstr.find("end");
+
+  parameters.end_time_point = (it != it_end) ? it->second.to_string() : std::string();
+
+  parameters.resolution = decode_resolution(qstr, "time_series_batch");
+
+  parameters.scaled = decode_scaled(qstr, "time_series_batch");
+
+  return parameters;
+}
+
+tws::wtss::timeseries_batch_request_parameters
+tws::wtss::decode_timeseries_batch_request(const rapidjson::Value& jrequest)
+{
+  timeseries_batch_request_parameters parameters;
+
+// get coverage name
+  const rapidjson::Value& jcoverage = jrequest["coverage"];
+
+  if(!jcoverage.IsString() || jcoverage.IsNull())
+    throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"coverage\" parameter is missing.");
+
+  parameters.cv_name = jcoverage.GetString();
+
+// get queried attributes
+  const rapidjson::Value& jattributes = jrequest["attributes"];
+
+  if(!jattributes.IsArray() || jattributes.IsNull())
+  {
+    boost::format err_msg("Error on time_series_batch operation: \"attributes\" parameter is missing for coverage '%1%'.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.cv_name).str());
+  }
+
+  tws::core::copy_string_array(jattributes, std::back_inserter(parameters.queried_attributes));
+
+// extract the list of points: [[lon, lat], [lon, lat], ...]
+  const rapidjson::Value& jpoints = jrequest["points"];
+
+  if(!jpoints.IsArray() || jpoints.IsNull())
+    throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"points\" parameter is missing.");
+
+  const rapidjson::SizeType npoints = jpoints.Size();
+
+  parameters.points.reserve(npoints);
+
+  for(rapidjson::SizeType i = 0; i != npoints; ++i)
+  {
+    const rapidjson::Value& jpoint = jpoints[i];
+
+    if(!jpoint.IsArray() || (jpoint.Size() != 2) || !jpoint[0u].IsNumber() || !jpoint[1u].IsNumber())
+    {
+      boost::format err_msg("Error on time_series_batch operation: invalid point at position %1%, expecting [longitude, latitude].");
+
+      throw tws::core::http_request_error() << tws::error_description((err_msg % i).str());
+    }
+
+    parameters.points.push_back(std::make_pair(jpoint[0u].GetDouble(), jpoint[1u].GetDouble()));
+  }
+
+// extract start and end times if any
+  if(jrequest.HasMember("start") && jrequest["start"].IsString())
+    parameters.start_time_point = jrequest["start"].GetString();
+
+  if(jrequest.HasMember("end") && jrequest["end"].IsString())
+    parameters.end_time_point = jrequest["end"].GetString();
+
+// the coarsest cell size acceptable, if any
+  parameters.resolution = 0.0;
+
+  if(jrequest.HasMember("resolution"))
+  {
+    const rapidjson::Value& jresolution = jrequest["resolution"];
+
+    if(!jresolution.IsNumber() || (jresolution.GetDouble() < 0.0))
+      throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"resolution\" must be a non-negative number.");
+
+    parameters.resolution = jresolution.GetDouble();
+  }
+
+// should the values be scaled?
+  parameters.scaled = false;
+
+  if(jrequest.HasMember("scaled"))
+  {
+    const rapidjson::Value& jscaled = jrequest["scaled"];
+
+    if(!jscaled.IsBool())
+      throw tws::core::http_request_error() << tws::error_description("Error on time_series_batch operation: \"scaled\" must be true or false.");
+
+    parameters.scaled = jscaled.GetBool();
+  }
+
+  return parameters;
+}
+
+double
+tws::wtss::decode_resolution(const tws::core::query_string_t& qstr,
+                             const char* operation)
+{
+  tws::core::query_string_t::const_iterator it = qstr.find("resolution");
+
+  if((it == qstr.end()) || it->second.empty())
+    return 0.0;
+
+  double resolution = boost::lexical_cast<double>(it->second.to_string());
+
+  if(resolution < 0.0)
+  {
+    boost::format err_msg("Error on %1% operation: invalid resolution '%2%'.");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % operation % it->second).str());
+  }
+
+  return resolution;
+}
+
+bool
+tws::wtss::decode_scaled(const tws::core::query_string_t& qstr,
+                         const char* operation)
+{
+  tws::core::query_string_t::const_iterator it = qstr.find("scaled");
+
+  if((it == qstr.end()) || it->second.empty() || (it->second == "false"))
+    return false;
+
+  if(it->second == "true")
+    return true;
+
+  boost::format err_msg("Error on %1% operation: invalid scaled value '%2%', expecting true or false.");
+
+  throw tws::core::http_request_error() << tws::error_description((err_msg % operation % it->second).str());
+}
+
 tws::wtss::timeseries_validated_parameters
 tws::wtss::valid(const timeseries_request_parameters& parameters)
 {
   timeseries_validated_parameters vparameters;
 
-// retrieve the underlying geoarray
-  vparameters.geo_array = & (tws::geoarray::geoarray_manager::instance().get(parameters.cv_name));
+  valid_query(parameters.cv_name, parameters.queried_attributes,
+              parameters.start_time_point, parameters.end_time_point,
+              parameters.resolution, vparameters);
+
+// compute pixel location from input Lat/Long WGS84 coordinate
+  pixel_locator locator(*vparameters.geo_array);
+
+  if(!locator.locate(parameters.longitude, parameters.latitude,
+                     vparameters.pixel_col, vparameters.pixel_row,
+                     vparameters.pixel_center_longitude, vparameters.pixel_center_latitude))
+  {
+    boost::format err_msg("Error on time_series operation: queried longitude '%1%' or latitude '%2%' is outof coverage '%3%' extent (%4%, %5%, %6%, %7%).");
+
+    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.longitude % parameters.latitude % parameters.cv_name
+                                                                     % vparameters.geo_array->geo_extent.spatial.extent.xmin
+                                                                     % vparameters.geo_array->geo_extent.spatial.extent.xmax
+                                                                     % vparameters.geo_array->geo_extent.spatial.extent.ymin
+                                                                     % vparameters.geo_array->geo_extent.spatial.extent.ymax).str());
+  }
+
+  return vparameters;
+}
+
+void
+tws::wtss::valid_query(const std::string& cv_name,
+                       const std::vector<std::string>& queried_attributes,
+                       const std::string& start_time_point,
+                       const std::string& end_time_point,
+                       double resolution,
+                       timeseries_validated_parameters& vparameters)
+{
+// retrieve the underlying geoarray: coarse queries are answered by the coarsest overview allowed
+  vparameters.geo_array = (resolution > 0.0) ? & (tws::geoarray::geoarray_manager::instance().select(cv_name, resolution))
+                                             : & (tws::geoarray::geoarray_manager::instance().get(cv_name));
 
 // valid queried attributes
-  if(parameters.queried_attributes.empty())
+  if(queried_attributes.empty())
   {
     boost::format err_msg("Error on time_series operation: please, inform at least one attribute coverage '%1%'.");
 
-    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.cv_name).str());
+    throw tws::core::http_request_error() << tws::error_description((err_msg % cv_name).str());
   }
 
-  for(const std::string& attr_name : parameters.queried_attributes)
+  for(const std::string& attr_name : queried_attributes)
   {
     const std::vector<tws::geoarray::attribute_t>::const_iterator it = std::find_if(vparameters.geo_array->attributes.begin(),
                                                                        vparameters.geo_array->attributes.end(),
@@ -374,163 +974,381 @@ tws::wtss::valid(const timeseries_request_parameters& parameters)
     if(it == it_end)
     {
       boost::format err_msg("Error on time_series operation: attribute '%1%' doesn't belong to coverage '%2%'.");
-      throw tws::core::http_request_error() << tws::error_description((err_msg % attr_name % parameters.cv_name).str());
+      throw tws::core::http_request_error() << tws::error_description((err_msg % attr_name % cv_name).str());
     }
 
-    std::size_t pos = std::distance(it, it_end);
+    std::size_t pos = std::distance(vparameters.geo_array->attributes.begin(), it);
 
     vparameters.attribute_positions.push_back(pos);
   }
 
-// valid queried time-interval
-  vparameters.timeline = & (tws::geoarray::timeline_manager::instance().get(parameters.cv_name));
+// valid queried time-interval: the series fetched for a timeline replaced meanwhile are not cached
+  vparameters.timeline_generation = tws::geoarray::timeline_manager::instance().generation();
+
+  vparameters.timeline = tws::geoarray::timeline_manager::instance().get(cv_name);
 
-  vparameters.start_time_idx = parameters.start_time_point.empty() ? vparameters.timeline->index(vparameters.timeline->time_points().front()) : vparameters.timeline->index(parameters.start_time_point);
+  vparameters.start_time_idx = start_time_point.empty() ? vparameters.timeline->index(vparameters.timeline->time_points().front()) : vparameters.timeline->index(start_time_point);
 
-  vparameters.end_time_idx = parameters.end_time_point.empty() ? vparameters.timeline->index(vparameters.timeline->time_points().back()) : vparameters.timeline->index(parameters.end_time_point);
+  vparameters.end_time_idx = end_time_point.empty() ? vparameters.timeline->index(vparameters.timeline->time_points().back()) : vparameters.timeline->index(end_time_point);
 
   if(vparameters.end_time_idx < vparameters.start_time_idx)
   {
     boost::format err_msg("Error on time_series operation: invalid time range [%1%, %2%].");
 
-    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.start_time_point % parameters.end_time_point).str());
+    throw tws::core::http_request_error() << tws::error_description((err_msg % start_time_point % end_time_point).str());
   }
 
   // find start_time_idx on xxx_timeline.json
   // start_time_idx is not on xxx_timeline.json (find a valid time > that curent start_time_idx)
   // Find end_time_idx on xxx_timeline.json
   // end_time_idx is not on xxx_timeline.json (find a valid time < that curent end_time_idx)
-
+}
 
 // prepare SRS conversor that allows to go from lat/long to array projection system and then come back to lat/long
 // TODO: do this only if a transformation is needed!
-//  if(vparameters.geo_array->geo_extent.spatial.crs_code != 4326)
+tws::wtss::pixel_locator::pixel_locator(const tws::geoarray::geoarray_t& geo_array)
+  : geo_array_(geo_array),
+    srs_conv_(4326, geo_array.geo_extent.spatial.crs_code)
+{
+  grid_.reset(new te::rst::Grid(geo_array_.dimensions[0].max_idx - geo_array_.dimensions[0].min_idx + 1,
+                                geo_array_.dimensions[1].max_idx - geo_array_.dimensions[1].min_idx + 1,
+                                geo_array_.geo_extent.spatial.resolution.x,
+                                geo_array_.geo_extent.spatial.resolution.y,
+                                new te::gm::Envelope(geo_array_.geo_extent.spatial.extent.xmin,
+                                                     geo_array_.geo_extent.spatial.extent.ymin,
+                                                     geo_array_.geo_extent.spatial.extent.xmax,
+                                                     geo_array_.geo_extent.spatial.extent.ymax),
+                                geo_array_.geo_extent.spatial.crs_code));
+}
 
-  te::srs::Converter srs_conv(4326, vparameters.geo_array->geo_extent.spatial.crs_code);
+bool
+tws::wtss::pixel_locator::locate(double longitude, double latitude,
+                                 int64_t& pixel_col, int64_t& pixel_row,
+                                 double& pixel_center_longitude, double& pixel_center_latitude)
+{
+  double x = 0.0;
+  double y = 0.0;
 
-  srs_conv.convert(parameters.longitude, parameters.latitude, vparameters.pixel_center_longitude, vparameters.pixel_center_latitude);
+  srs_conv_.convert(longitude, latitude, x, y);
 
 // check if x and y values are within coverage boundary
-  if(!intersects(vparameters.pixel_center_longitude, vparameters.pixel_center_latitude, vparameters.geo_array->geo_extent.spatial.extent))
-  {
-    boost::format err_msg("Error on time_series operation: queried longitude '%1%' or latitude '%2%' is outof coverage '%3%' extent (%4%, %5%, %6%, %7%).");
-
-    throw tws::core::http_request_error() << tws::error_description((err_msg % parameters.longitude % parameters.latitude % parameters.cv_name
-                                                                     % vparameters.geo_array->geo_extent.spatial.extent.xmin
-                                                                     % vparameters.geo_array->geo_extent.spatial.extent.xmax
-                                                                     % vparameters.geo_array->geo_extent.spatial.extent.ymin
-                                                                     % vparameters.geo_array->geo_extent.spatial.extent.ymax).str());
-  }
-
-// compute pixel location from input Lat/Long WGS84 coordinate
-  te::rst::Grid array_grid(vparameters.geo_array->dimensions[0].max_idx - vparameters.geo_array->dimensions[0].min_idx + 1,
-                           vparameters.geo_array->dimensions[1].max_idx - vparameters.geo_array->dimensions[1].min_idx + 1,
-                           vparameters.geo_array->geo_extent.spatial.resolution.x,
-                           vparameters.geo_array->geo_extent.spatial.resolution.y,
-                           new te::gm::Envelope(vparameters.geo_array->geo_extent.spatial.extent.xmin,
-                                                vparameters.geo_array->geo_extent.spatial.extent.ymin,
-                                                vparameters.geo_array->geo_extent.spatial.extent.xmax,
-                                                vparameters.geo_array->geo_extent.spatial.extent.ymax),
-                           vparameters.geo_array->geo_extent.spatial.crs_code);
+  if(!intersects(x, y, geo_array_.geo_extent.spatial.extent))
+    return false;
 
   double dpixel_col = 0.0;
   double dpixel_row = 0.0;
 
-  array_grid.geoToGrid(vparameters.pixel_center_longitude, vparameters.pixel_center_latitude, dpixel_col, dpixel_row);
+  grid_->geoToGrid(x, y, dpixel_col, dpixel_row);
 
-  vparameters.pixel_col = static_cast<int64_t>(dpixel_col);
-  vparameters.pixel_row = static_cast<int64_t>(dpixel_row);
+  pixel_col = static_cast<int64_t>(dpixel_col);
+  pixel_row = static_cast<int64_t>(dpixel_row);
 
 // check if row and col are within array dimension ranges!
-  if(!is_in_spatial_range(vparameters.pixel_col, vparameters.pixel_row, vparameters.geo_array->dimensions))
-  {
-    boost::format err_msg("Error on timeseries operation: queried \"col\" (%1%) or \"row\" (%2%) are not within the array dimension ranges col=[%3%,%4%] or row=[%5%, %6%].");
-
-    throw tws::core::http_request_error() << tws::error_description((err_msg % vparameters.pixel_col % vparameters.pixel_row
-                                                                     % vparameters.geo_array->dimensions[0].min_idx
-                                                                     % vparameters.geo_array->dimensions[0].max_idx
-                                                                     % vparameters.geo_array->dimensions[1].min_idx
-                                                                     % vparameters.geo_array->dimensions[1].max_idx).str());
-  }
+  if(!is_in_spatial_range(pixel_col, pixel_row, geo_array_.dimensions))
+    return false;
 
 // then compute the location of the center of the pixel
-  array_grid.gridToGeo(vparameters.pixel_col, vparameters.pixel_row, vparameters.pixel_center_longitude, vparameters.pixel_center_latitude);
+  grid_->gridToGeo(pixel_col, pixel_row, pixel_center_longitude, pixel_center_latitude);
 
 // get back from sinu (or any other CRS) to lat/long
-  srs_conv.invert(vparameters.pixel_center_longitude, vparameters.pixel_center_latitude, vparameters.pixel_center_longitude, vparameters.pixel_center_latitude);
+  srs_conv_.invert(pixel_center_longitude, pixel_center_latitude, pixel_center_longitude, pixel_center_latitude);
 
-  return vparameters;
+  return true;
 }
 
 void
 tws::wtss::compute_time_series(const timeseries_request_parameters& parameters,
                                const timeseries_validated_parameters& vparameters,
-                               rapidjson::Document::AllocatorType& allocator,
-                               rapidjson::Value& jattributes)
+                               std::vector<time_series_cache::value_type>& values)
 {
   const std::size_t ntime_pts = vparameters.end_time_idx - vparameters.start_time_idx + 1;
 
   const std::size_t nattributes = parameters.queried_attributes.size();
 
-// get a connection from the pool in order to retrieve the time series data
-  std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
+// an attribute may be queried more than once but it is projected only once
+  std::vector<std::string> projected_attributes;
+
+  std::vector<std::size_t> projected_pos;
+
+  std::vector<const tws::geoarray::attribute_t*> projected_attrs;
 
-// iterate through each queried attribute
   for(std::size_t i = 0; i != nattributes; ++i)
   {
-    const auto& attr_name = parameters.queried_attributes[i];
+    const std::string& attr_name = parameters.queried_attributes[i];
+
+    std::vector<std::string>::const_iterator it = std::find(projected_attributes.begin(), projected_attributes.end(), attr_name);
+
+    projected_pos.push_back(std::distance(projected_attributes.cbegin(), it));
+
+    if(it == projected_attributes.end())
+    {
+      projected_attributes.push_back(attr_name);
+
+      projected_attrs.push_back(&(vparameters.geo_array->attributes[vparameters.attribute_positions[i]]));
+    }
+  }
+
+// look up the cache first: only the attributes not found there are queried
+  time_series_cache& cache = time_series_cache::instance();
+
+  std::vector<time_series_cache::value_type> projected_values(projected_attributes.size());
+
+  std::vector<std::size_t> uncached;
+
+  for(std::size_t i = 0; i != projected_attributes.size(); ++i)
+  {
+    time_series_key key = { vparameters.geo_array->name, projected_attributes[i],
+                            vparameters.pixel_col, vparameters.pixel_row,
+                            vparameters.start_time_idx, vparameters.end_time_idx };
 
-    const std::size_t& attr_pos = vparameters.attribute_positions[i];
+    projected_values[i] = cache.get(key);
+
+    if(projected_values[i] == nullptr)
+      uncached.push_back(i);
+  }
 
-// the scidb query string
-    std::string str_afl = "project( between(" + parameters.cv_name + ", "
+  if(!uncached.empty())
+  {
+// the series are decoded in the attribute datatype, starting with its missing value
+    std::vector<std::unique_ptr<time_series_values> > uncached_values;
+
+    for(std::size_t pos : uncached)
+      uncached_values.push_back(make_time_series_values(projected_attrs[pos]->datatype, ntime_pts, projected_attrs[pos]->missing_value));
+
+// the scidb query string: a single query for all attributes
+    std::string str_afl = "project( between(" + vparameters.geo_array->name + ", "
                           + std::to_string(vparameters.pixel_col) + "," + std::to_string(vparameters.pixel_row) + "," + std::to_string(vparameters.start_time_idx) + ","
-                          + std::to_string(vparameters.pixel_col) + "," + std::to_string(vparameters.pixel_row) + "," + std::to_string(vparameters.end_time_idx) + "), "
-                          + attr_name + ")";
+                          + std::to_string(vparameters.pixel_col) + "," + std::to_string(vparameters.pixel_row) + "," + std::to_string(vparameters.end_time_idx) + ")";
+
+    for(std::size_t pos : uncached)
+      str_afl += ", " + projected_attributes[pos];
+
+    str_afl += ")";
+
+// get a connection from the pool in order to retrieve the time series data
+    std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
 
     boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_afl, true);
 
-    if((qresult == nullptr) || (qresult->array == nullptr))
+    bool has_result = (qresult != nullptr) && (qresult->array != nullptr);
+
+    if(has_result)
     {
-      rapidjson::Value jattribute(rapidjson::kObjectType);
+      try
+      {
+        tws::scidb::cell_iterator it(qresult->array);
+
+        fill_time_series(uncached_values, ntime_pts, it, 2, -(vparameters.start_time_idx));
+      }
+      catch(...)
+      {
+        conn->completed(qresult->queryID);
+        throw;
+      }
+    }
 
-      jattribute.AddMember("attribute", attr_name.c_str(), allocator);
+    if(qresult != nullptr)
+      conn->completed(qresult->queryID);
 
-      rapidjson::Value jvalues(rapidjson::kArrayType);
+// no query result returned after querying database: values are left empty and nothing is cached
+    if(has_result)
+    {
+      for(std::size_t i = 0; i != uncached.size(); ++i)
+      {
+        std::size_t pos = uncached[i];
 
-      jattribute.AddMember("values", jvalues, allocator);
+        projected_values[pos] = std::move(uncached_values[i]);
 
-      jattributes.PushBack(jattribute, allocator);
+        time_series_key key = { vparameters.geo_array->name, projected_attributes[pos],
+                                vparameters.pixel_col, vparameters.pixel_row,
+                                vparameters.start_time_idx, vparameters.end_time_idx };
 
-      if(qresult != nullptr)
-        conn->completed(qresult->queryID);
+        cache.insert(key, projected_values[pos], vparameters.timeline_generation);
+      }
+    }
+  }
+
+// output the time series in the queried order
+  values.resize(nattributes);
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+    values[i] = projected_values[projected_pos[i]];
+}
+
+void
+tws::wtss::compute_time_series_batch(const timeseries_batch_request_parameters& parameters,
+                                     const timeseries_validated_parameters& vparameters,
+                                     const std::vector<batch_point_location>& locations,
+                                     std::size_t npixels,
+                                     std::vector<time_series_cache::value_type>& values)
+{
+  const std::size_t ntime_pts = vparameters.end_time_idx - vparameters.start_time_idx + 1;
+
+  const std::size_t nattributes = parameters.queried_attributes.size();
+
+// an attribute may be queried more than once but it is projected only once
+  std::vector<std::string> projected_attributes;
+
+  std::vector<std::size_t> projected_pos;
+
+// one buffer per projected attribute, in its datatype or in double values if they are scaled while decoded:
+// the time series of a pixel starts at pixel_pos * ntime_pts
+  std::vector<std::unique_ptr<time_series_values> > projected_values;
+
+  std::vector<value_scale_t> scales;
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+  {
+    const std::string& attr_name = parameters.queried_attributes[i];
+
+    std::vector<std::string>::const_iterator it = std::find(projected_attributes.begin(), projected_attributes.end(), attr_name);
+
+    projected_pos.push_back(std::distance(projected_attributes.cbegin(), it));
+
+    if(it != projected_attributes.end())
+      continue;
+
+    projected_attributes.push_back(attr_name);
+
+    const tws::geoarray::attribute_t& attr = vparameters.geo_array->attributes[vparameters.attribute_positions[i]];
+
+    scales.push_back(make_value_scale(attr));
+
+    if(parameters.scaled)
+      projected_values.emplace_back(new typed_time_series_values<double>(npixels * ntime_pts, std::numeric_limits<double>::quiet_NaN()));
+    else
+      projected_values.push_back(make_time_series_values(attr.datatype, npixels * ntime_pts, attr.missing_value));
+  }
+
+  if(npixels != 0)
+    fetch_time_series_batch(vparameters, locations, npixels, parameters.scaled,
+                            projected_attributes, scales, projected_values);
+
+// output the time series in the queried order
+  std::vector<time_series_cache::value_type> shared_values(std::make_move_iterator(projected_values.begin()),
+                                                           std::make_move_iterator(projected_values.end()));
+
+  values.resize(nattributes);
+
+  for(std::size_t i = 0; i != nattributes; ++i)
+    values[i] = shared_values[projected_pos[i]];
+}
+
+void
+tws::wtss::fetch_time_series_batch(const timeseries_validated_parameters& vparameters,
+                                   const std::vector<batch_point_location>& locations,
+                                   std::size_t npixels,
+                                   bool scaled,
+                                   const std::vector<std::string>& attributes,
+                                   const std::vector<value_scale_t>& scales,
+                                   std::vector<std::unique_ptr<time_series_values> >& values)
+{
+  const std::size_t ntime_pts = vparameters.end_time_idx - vparameters.start_time_idx + 1;
+
+// group the distinct pixels by tiles: each tile is retrieved by a single query
+  std::map<std::pair<int64_t, int64_t>, std::vector<const batch_point_location*> > tiles;
+
+  std::vector<bool> visited(npixels, false);
+
+  for(const batch_point_location& loc : locations)
+  {
+    if(!loc.valid || visited[loc.pixel_pos])
+      continue;
+
+    visited[loc.pixel_pos] = true;
+
+    std::pair<int64_t, int64_t> tile(loc.pixel_col / batch_tile_size, loc.pixel_row / batch_tile_size);
+
+    tiles[tile].push_back(&loc);
+  }
+
+  std::string projected_attributes;
+
+  for(const std::string& attr_name : attributes)
+    projected_attributes += ", " + attr_name;
+
+  const std::string& col_dim_name = vparameters.geo_array->dimensions[0].name;
+  const std::string& row_dim_name = vparameters.geo_array->dimensions[1].name;
+
+// get a connection from the pool in order to retrieve the time series data
+  std::unique_ptr<tws::scidb::connection> conn(tws::scidb::connection_pool::instance().get());
 
-      continue; // no query result returned after querying database.
+  for(const auto& tile : tiles)
+  {
+    const std::vector<const batch_point_location*>& tile_pixels = tile.second;
+
+    int64_t min_col = tile_pixels.front()->pixel_col;
+    int64_t max_col = min_col;
+    int64_t min_row = tile_pixels.front()->pixel_row;
+    int64_t max_row = min_row;
+
+    pixel_index_t pixel_idx;
+
+    for(const batch_point_location* loc : tile_pixels)
+    {
+      min_col = std::min(min_col, loc->pixel_col);
+      max_col = std::max(max_col, loc->pixel_col);
+      min_row = std::min(min_row, loc->pixel_row);
+      max_row = std::max(max_row, loc->pixel_row);
+
+      pixel_idx[pixel_key(loc->pixel_col, loc->pixel_row)] = loc->pixel_pos;
     }
 
-    try
+// the scidb query string: a bounding box of the tile pixels along the time interval
+    std::string str_afl = "between(" + vparameters.geo_array->name + ", "
+                          + std::to_string(min_col) + "," + std::to_string(min_row) + "," + std::to_string(vparameters.start_time_idx) + ","
+                          + std::to_string(max_col) + "," + std::to_string(max_row) + "," + std::to_string(vparameters.end_time_idx) + ")";
+
+// if a few pixels are sparse in the bounding box let the server discard the cells in between:
+// with many pixels the filter would cost more than sending the whole box, whose extra cells are skipped while decoded
+    const int64_t nbox_cells = (max_col - min_col + 1) * (max_row - min_row + 1);
+
+    if((tile_pixels.size() <= batch_max_filter_terms) &&
+       (nbox_cells > batch_sparse_factor * static_cast<int64_t>(tile_pixels.size())))
     {
-      std::vector<double> values(ntime_pts, vparameters.geo_array->attributes[attr_pos].missing_value);
+      std::string predicate;
 
-      const ::scidb::ArrayDesc& array_desc = qresult->array->getArrayDesc();
-      const ::scidb::Attributes& array_attributes = array_desc.getAttributes(true);
-      const ::scidb::AttributeDesc& attr = array_attributes.front();
+      for(const batch_point_location* loc : tile_pixels)
+      {
+        if(!predicate.empty())
+          predicate += " or ";
 
-      std::shared_ptr< ::scidb::ConstArrayIterator > array_it = qresult->array->getConstIterator(attr.getId());
+        predicate += "(" + col_dim_name + " = " + std::to_string(loc->pixel_col) + " and "
+                   + row_dim_name + " = " + std::to_string(loc->pixel_row) + ")";
+      }
 
-      fill_time_series(values, ntime_pts, array_it.get(), attr.getType(), 2, -(vparameters.start_time_idx));
+      str_afl = "filter(" + str_afl + ", " + predicate + ")";
+    }
 
-      rapidjson::Value jattribute(rapidjson::kObjectType);
+    str_afl = "project(" + str_afl + projected_attributes + ")";
 
-      jattribute.AddMember("attribute", attr_name.c_str(), allocator);
+    boost::shared_ptr< ::scidb::QueryResult > qresult = conn->execute(str_afl, true);
 
-      rapidjson::Value jvalues(rapidjson::kArrayType);
+    if((qresult == nullptr) || (qresult->array == nullptr))
+    {
+      if(qresult != nullptr)
+        conn->completed(qresult->queryID);
+
+      continue; // no query result: the time series remain filled with missing values.
+    }
 
-      tws::core::copy_numeric_array(values.begin(), values.end(), jvalues, allocator);
+    try
+    {
+      const ::scidb::ArrayDesc& array_desc = qresult->array->getArrayDesc();
+      const ::scidb::Attributes& array_attributes = array_desc.getAttributes(true);
 
-      jattribute.AddMember("values", jvalues, allocator);
+      for(std::size_t i = 0; i != attributes.size(); ++i)
+      {
+        const ::scidb::AttributeDesc& attr = array_attributes[i];
 
-      jattributes.PushBack(jattribute, allocator);
+        std::shared_ptr< ::scidb::ConstArrayIterator > array_it = qresult->array->getConstIterator(attr.getId());
+
+        if(scaled)
+          fill_scaled_time_series(static_cast<typed_time_series_values<double>&>(*values[i]), ntime_pts, pixel_idx,
+                                  array_it.get(), attr.getType(), 2, -(vparameters.start_time_idx), scales[i]);
+        else
+          fill_time_series(*values[i], ntime_pts, pixel_idx, array_it.get(), attr.getType(), 2, -(vparameters.start_time_idx));
+      }
     }
     catch(...)
     {
@@ -543,50 +1361,89 @@ tws::wtss::compute_time_series(const timeseries_request_parameters& parameters,
 }
 
 void
-tws::wtss::prepare_timeseries_response(const timeseries_request_parameters& parameters,
-                                       const timeseries_validated_parameters& vparameters,
-                                       rapidjson::Document& doc,
-                                       rapidjson::Value& jattributes,
-                                       rapidjson::Document::AllocatorType& allocator)
+tws::wtss::prepare_time_series_result(const std::string& cv_name,
+                                      const timeseries_validated_parameters& vparameters,
+                                      bool scaled,
+                                      time_series_result_t& result)
 {
-// prepare result part in response
-  rapidjson::Value jresult(rapidjson::kObjectType);
+  result.coverage = cv_name;
 
-  jresult.AddMember("attributes", jattributes, allocator);
+  for(std::size_t pos : vparameters.attribute_positions)
+  {
+    tws::geoarray::attribute_t attr = vparameters.geo_array->attributes[pos];
 
-// add timeline in the response
-  rapidjson::Value jtimeline(rapidjson::kArrayType);
+    if(scaled)
+    {
+      attr.valid_range.min_val *= attr.scale_factor;
+      attr.valid_range.max_val *= attr.scale_factor;
+      attr.scale_factor = 1.0;
+      attr.missing_value = std::numeric_limits<double>::quiet_NaN();
+      attr.datatype = tws::geoarray::datatype_t::double_dt;
+    }
+
+    result.attributes.push_back(attr);
+  }
 
   std::size_t init_pos = vparameters.timeline->pos(vparameters.start_time_idx);
   std::size_t fin_pos = vparameters.timeline->pos(vparameters.end_time_idx);
 
-  tws::core::copy_string_array(std::begin(vparameters.timeline->time_points()) + init_pos,
-                               std::begin(vparameters.timeline->time_points()) + (fin_pos + 1),
-                               jtimeline, allocator);
+  result.timeline.assign(vparameters.timeline->time_points().begin() + init_pos,
+                         vparameters.timeline->time_points().begin() + fin_pos + 1);
+}
 
-  jresult.AddMember("timeline", jtimeline, allocator);
+int
+tws::wtss::negotiate_output_format(const tws::core::http_request& request,
+                                   tws::core::http_response& response)
+{
+  const std::vector<std::string>& media_types = output_media_types();
+
+  std::size_t format = tws::core::negotiate_media_type(request.get_header("Accept"), media_types);
 
-// add the pixel center location in response
-  rapidjson::Value jcenter(rapidjson::kObjectType);
-  jcenter.AddMember("latitude", vparameters.pixel_center_latitude, allocator);
-  jcenter.AddMember("longitude", vparameters.pixel_center_longitude, allocator);
-  jresult.AddMember("center_coordinates", jcenter, allocator);
+  response.add_header("Content-Type", media_types[format].c_str());
+  response.add_header("Vary", "Accept");
+
+  return static_cast<int>(format);
+}
 
-// prepare the query part in response
-  rapidjson::Value jquery(rapidjson::kObjectType);
+void
+tws::wtss::write_time_series_response(const time_series_result_t& result,
+                                      int format, bool batch,
+                                      output_buffer& out)
+{
+  switch(format)
+  {
+    case output_format_t::msgpack:
+    {
+      msgpack_writer writer(out);
 
-  jquery.AddMember("coverage", parameters.cv_name.c_str(), allocator);
+      if(batch)
+        write_time_series_batch(result, writer);
+      else
+        write_time_series(result, writer);
 
-  rapidjson::Value jqattributes(rapidjson::kArrayType);
+      break;
+    }
 
-  tws::core::copy_string_array(parameters.queried_attributes.begin(), parameters.queried_attributes.end(), jqattributes, allocator);
+    case output_format_t::arrow:
+    {
+      arrow_stream_writer writer(out);
 
-  jquery.AddMember("attributes", jqattributes, allocator);
+      if(batch)
+        write_time_series_batch(result, writer);
+      else
+        write_time_series(result, writer);
 
-  jquery.AddMember("latitude", parameters.latitude, allocator);
+      break;
+    }
 
-  jquery.AddMember("longitude", parameters.longitude, allocator);
+    default:
+    {
+      json_writer writer(out, json_output().precision);
 
-  doc.AddMember("result", jresult, allocator);
-  doc.AddMember("query", jquery, allocator);
+      if(batch)
+        write_time_series_batch(result, writer);
+      else
+        write_time_series(result, writer);
+    }
+  }
 }
@@ -58,13 +58,37 @@ namespace tws
     };
 
     //! Retrieve the time series for a given coverage.
-    /*! http://chronos.dpi.inpe.br:6543/wtss/time_series?coverage=mod09q1&attributes=red,nir&longitude=-54.0&latitude=-12.0 */
+    /*!
+      http://chronos.dpi.inpe.br:6543/wtss/time_series?coverage=mod09q1&attributes=red,nir&longitude=-54.0&latitude=-12.0
+
+      The response is JSON unless the Accept header asks for application/x-msgpack
+      or application/vnd.apache.arrow.stream (see time_series_writers.hpp).
+
+      With scaled=true the values are clamped to the valid range of their attribute and
+      multiplied by its scale factor; the missing values are returned as null (NaN in the binary outputs).
+     */
     struct time_series_functor
     {
       void operator()(const tws::core::http_request& request,
                       tws::core::http_response& response);
     };
 
+    //! Retrieve the time series for a list of locations in a given coverage.
+    /*!
+      The locations may be informed in the query string or, for large lists, in a JSON document sent as the request body:
+
+      http://chronos.dpi.inpe.br:6543/wtss/time_series_batch?coverage=mod09q1&attributes=red,nir&points=-54.0,-12.0;-54.1,-12.1
+
+      {"coverage": "mod09q1", "attributes": ["red", "nir"], "points": [[-54.0, -12.0], [-54.1, -12.1]], "scaled": true}
+
+      The output format is negotiated and the values are scaled as in time_series.
+     */
+    struct time_series_batch_functor
+    {
+      void operator()(const tws::core::http_request& request,
+                      tws::core::http_response& response);
+    };
+
     //! Register all service operations.
     void register_operations();
 